@@ -0,0 +1,116 @@
+/* File: allocator_bench.c */
+/* Benchmark of node-heavy modules with the default allocator (malloc), a slab allocator and an arena allocator */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../modules/Allocator/Allocator.h"
+#include "../modules/AVLTree/AVLTree.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+#include "../modules/Queue/Queue.h"
+#include "../modules/SeparateChainingHashTable/ChainingHashTable.h"
+
+
+// Large enough for the nodes of every measured module (larger requests of the slab allocator go to malloc)
+#define SLAB_OBJECT_SIZE 48
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static int compare_ints(void *a, void *b) {
+    int x = *(int *)a, y = *(int *)b;
+    return (x > y) - (x < y);
+}
+
+
+static size_t hash_int(void *key) {
+    return (size_t)(*(int *)key) * 2654435761u;
+}
+
+
+static void destroy_nothing(void *data) {
+}
+
+
+// Insert the keys into a module and free it, returning the time of each phase
+static void run_module(const char *module, int *keys, size_t n, const Allocator *allocator, double *insert_ns, double *free_ns) {
+    double start = now_ns();
+    if (strcmp(module, "rbt") == 0) {
+        RBT_set_allocator(allocator);
+        RBTree root = NULL;
+        for (size_t i = 0; i < n; i++)
+            RBT_insert(&root, &keys[i], compare_ints);
+        *insert_ns = now_ns() - start;
+        start = now_ns();
+        RBT_destroy(root, NULL);
+        RBT_set_allocator(NULL);
+    } else if (strcmp(module, "avl") == 0) {
+        AVLTree_set_allocator(allocator);
+        AVLTree avl = NULL;
+        for (size_t i = 0; i < n; i++)
+            avl = AVLTree_insert(avl, &keys[i], compare_ints);
+        *insert_ns = now_ns() - start;
+        start = now_ns();
+        AVLTree_destroy(avl, destroy_nothing);
+        AVLTree_set_allocator(NULL);
+    } else if (strcmp(module, "sc") == 0) {
+        SCHashtable *h = SChashtable_create_with_allocator(compare_ints, NULL, NULL, NULL, hash_int, allocator);
+        for (size_t i = 0; i < n; i++)
+            SChashtable_insert(h, &keys[i], &keys[i]);
+        *insert_ns = now_ns() - start;
+        start = now_ns();
+        SChashtable_destroy(h);
+    } else {
+        Queue Q = Queue_create_with_allocator(NULL, NULL, allocator);
+        for (size_t i = 0; i < n; i++)
+            Queue_insert(Q, &keys[i]);
+        *insert_ns = now_ns() - start;
+        start = now_ns();
+        Queue_destroy(Q);
+    }
+    *free_ns = now_ns() - start;
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+    int *keys = malloc(n * sizeof(int));
+    srand(42);
+    for (size_t i = 0; i < n; i++)
+        keys[i] = rand();
+
+    const char *modules[] = {"rbt", "avl", "sc", "queue"};
+    printf("module,allocator,items,ns_per_insert,ns_per_free\n");
+    for (int m = 0; m < 4; m++) {
+        double insert_ns, free_ns;
+
+        run_module(modules[m], keys, n, NULL, &insert_ns, &free_ns);
+        printf("%s,malloc,%zu,%.2f,%.2f\n", modules[m], n, insert_ns / n, free_ns / n);
+
+        Slab slab = slab_create(SLAB_OBJECT_SIZE, 4096);
+        Allocator allocator = slab_allocator(slab);
+        run_module(modules[m], keys, n, &allocator, &insert_ns, &free_ns);
+        slab_destroy(slab);
+        printf("%s,slab,%zu,%.2f,%.2f\n", modules[m], n, insert_ns / n, free_ns / n);
+
+        // The arena gives its memory back all at once, so freeing includes arena_destroy
+        Arena arena = arena_create(1 << 20);
+        allocator = arena_allocator(arena);
+        run_module(modules[m], keys, n, &allocator, &insert_ns, &free_ns);
+        double start = now_ns();
+        arena_destroy(arena);
+        free_ns += now_ns() - start;
+        printf("%s,arena,%zu,%.2f,%.2f\n", modules[m], n, insert_ns / n, free_ns / n);
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,168 @@
+/* File: art_bench.c */
+/* Benchmark of the ordered maps on string keys: the adaptive radix tree against the red black tree, the AVL tree and
+   the skip list, which compare the keys with strcmp */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../modules/AdaptiveRadixTree/AdaptiveRadixTree.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+#include "../modules/AVLTree/AVLTree.h"
+#include "../modules/SkipList/SkipList.h"
+
+
+#define KEY_SIZE 64
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static int compare_strings(void *a, void *b) {
+    return strcmp(a, b);
+}
+
+
+static void destroy_nothing(void *data) {
+}
+
+
+static size_t scanned;
+
+static void count_item(void *data) {
+    scanned++;
+}
+
+static bool count_art_item(const unsigned char *key, size_t key_len, void *value, void *ctx) {
+    scanned++;
+    return true;
+}
+
+
+static void report(const char *container, const char *operation, size_t n, double ns) {
+    printf("%s,%s,%zu,%.2f\n", container, operation, n, ns / n);
+}
+
+
+// URL and metric name style keys, which share long prefixes
+static void make_key(char *key, size_t i) {
+    static const char *hosts[] = {"api.example.com", "cdn.example.com", "www.example.org", "metrics.internal"};
+    static const char *paths[] = {"users", "images", "orders", "cpu.user", "cpu.system", "memory.rss"};
+    snprintf(key, KEY_SIZE, "https://%s/%s/%zu", hosts[i % 4], paths[(i / 4) % 6], i * 2654435761u % 1000003);
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 100000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+
+    // Distinct keys in random order, and lookups of random keys
+    char (*keys)[KEY_SIZE] = malloc(n * KEY_SIZE);
+    size_t *order = malloc(n * sizeof(size_t));
+    size_t *lookups = malloc(n * sizeof(size_t));
+    srand(42);
+    for (size_t i = 0; i < n; i++) {
+        make_key(keys[i], i);
+        // The number in make_key repeats after 1000003 keys, so a suffix keeps the keys distinct
+        if (i >= 1000003)
+            snprintf(keys[i] + strlen(keys[i]), KEY_SIZE - strlen(keys[i]), "-%zu", i);
+        order[i] = i;
+    }
+    for (size_t i = n - 1; i > 0; i--) {
+        size_t j = ((size_t)rand() * RAND_MAX + rand()) % (i + 1);
+        size_t temp = order[i];
+        order[i] = order[j];
+        order[j] = temp;
+    }
+    for (size_t i = 0; i < n; i++)
+        lookups[i] = ((size_t)rand() * RAND_MAX + rand()) % n;
+
+    printf("container,operation,items,ns_per_op\n");
+    volatile size_t found = 0;
+
+    ART *art = ART_create(NULL);
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        ART_insert(art, keys[order[i]], strlen(keys[order[i]]), keys[order[i]]);
+    report("art", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += ART_search(art, keys[lookups[i]], strlen(keys[lookups[i]])) != NULL;
+    report("art", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    ART_iterate(art, count_art_item, NULL);
+    report("art", "scan", scanned, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    ART_prefix_iterate(art, "https://api.example.com/users/", 30, count_art_item, NULL);
+    report("art", "prefix_scan", scanned, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        ART_delete(art, keys[order[i]], strlen(keys[order[i]]));
+    report("art", "delete", n, now_ns() - start);
+    ART_destroy(art);
+
+    RBTree root = NULL;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        RBT_insert(&root, keys[order[i]], compare_strings);
+    report("rbt", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += RBT_search(root, keys[lookups[i]], compare_strings);
+    report("rbt", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    RBT_inorder_traversal(root, count_item);
+    report("rbt", "scan", scanned, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        RBT_delete(&root, keys[order[i]], compare_strings, NULL);
+    report("rbt", "delete", n, now_ns() - start);
+    RBT_destroy(root, NULL);
+
+    AVLTree avl = NULL;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        avl = AVLTree_insert(avl, keys[order[i]], compare_strings);
+    report("avl", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += AVLTree_search(avl, keys[lookups[i]], compare_strings);
+    report("avl", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    AVLTree_inorder_traversal(avl, count_item);
+    report("avl", "scan", scanned, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        avl = AVLTree_delete(avl, keys[order[i]], compare_strings, destroy_nothing);
+    report("avl", "delete", n, now_ns() - start);
+    AVLTree_destroy(avl, destroy_nothing);
+
+    skiplist *list = skiplist_initialize(compare_strings, NULL, NULL, NULL);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        skiplist_insert(list, keys[order[i]], keys[order[i]]);
+    report("skiplist", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += skiplist_search(list, keys[lookups[i]]) != NULL;
+    report("skiplist", "lookup", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        skiplist_delete(list, keys[order[i]]);
+    report("skiplist", "delete", n, now_ns() - start);
+    skiplist_destroy(list);
+
+    free(keys);
+    free(order);
+    free(lookups);
+    return 0;
+}
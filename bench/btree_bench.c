@@ -0,0 +1,212 @@
+/* File: btree_bench.c */
+/* Head-to-head benchmark of the ordered maps: the generated B+ tree against the red black tree and the AVL tree, with
+   nodes which are allocated one by one and in the compact (array) mode */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../modules/BTree/btree.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+#include "../modules/AVLTree/AVLTree.h"
+
+
+#define INT_LESS(a, b) ((a) < (b))
+
+DECLARE_BTREE(int, int, INT_LESS)
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static int compare_ints(void *a, void *b) {
+    int x = *(int *)a, y = *(int *)b;
+    return (x > y) - (x < y);
+}
+
+
+static void destroy_nothing(void *data) {
+}
+
+
+static size_t scanned;
+
+static void count_item(void *data) {
+    scanned++;
+}
+
+static void count_btree_item(int key, int *value, void *ctx) {
+    scanned++;
+}
+
+
+static bool count_range_item(void *data, void *ctx) {
+    scanned++;
+    return true;
+}
+
+
+static void report(const char *container, const char *operation, size_t n, double ns) {
+    printf("%s,%s,%zu,%.2f\n", container, operation, n, ns / n);
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+
+    // Distinct keys in random order (inserts, lookups and deletes) and in ascending order (bulk load)
+    int *sorted = malloc(n * sizeof(int));
+    int *keys = malloc(n * sizeof(int));
+    int *lookups = malloc(n * sizeof(int));
+    void **sorted_items = malloc(n * sizeof(void *));
+    srand(42);
+    for (size_t i = 0; i < n; i++)
+        sorted[i] = keys[i] = (int)(2 * i);
+    for (size_t i = 0; i < n; i++)
+        sorted_items[i] = &sorted[i];
+    for (size_t i = n - 1; i > 0; i--) {
+        size_t j = ((size_t)rand() * RAND_MAX + rand()) % (i + 1);
+        int temp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = temp;
+    }
+    for (size_t i = 0; i < n; i++)
+        lookups[i] = keys[((size_t)rand() * RAND_MAX + rand()) % n];
+
+    printf("container,operation,items,ns_per_op\n");
+    volatile size_t found = 0;
+
+    double start = now_ns();
+    btree_int_int *tree = btree_int_int_create();
+    for (size_t i = 0; i < n; i++)
+        btree_int_int_insert(tree, keys[i], keys[i]);
+    report("btree", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += btree_int_int_contains(tree, lookups[i]);
+    report("btree", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    btree_int_int_for_each(tree, count_btree_item, NULL);
+    report("btree", "scan", scanned, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        btree_int_int_remove(tree, keys[i]);
+    report("btree", "delete", n, now_ns() - start);
+    btree_int_int_free(tree);
+    start = now_ns();
+    tree = btree_int_int_build_sorted(sorted, sorted, n, NULL);
+    report("btree", "build_sorted", n, now_ns() - start);
+    btree_int_int_free(tree);
+
+    RBTree root = NULL;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        RBT_insert(&root, &keys[i], compare_ints);
+    report("rbt", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += RBT_search(root, &lookups[i], compare_ints);
+    report("rbt", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    RBT_inorder_traversal(root, count_item);
+    report("rbt", "scan", scanned, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        RBT_delete(&root, &keys[i], compare_ints, NULL);
+    report("rbt", "delete", n, now_ns() - start);
+    RBT_destroy(root, NULL);
+    start = now_ns();
+    root = RBT_build_sorted(sorted_items, n, compare_ints);
+    report("rbt", "build_sorted", n, now_ns() - start);
+    start = now_ns();
+    RBT_destroy(root, NULL);
+    report("rbt", "destroy", n, now_ns() - start);
+
+    CompactRBTree compact_rbt = RBT_compact_create(compare_ints);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        RBT_compact_insert(compact_rbt, &keys[i]);
+    report("rbt_compact", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += RBT_compact_search(compact_rbt, &lookups[i]);
+    report("rbt_compact", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    RBT_compact_range(compact_rbt, NULL, NULL, count_range_item, NULL);
+    report("rbt_compact", "scan", scanned, now_ns() - start);
+    start = now_ns();
+    RBT_compact_destroy(compact_rbt, NULL);
+    report("rbt_compact", "destroy", n, now_ns() - start);
+    compact_rbt = RBT_compact_create(compare_ints);
+    for (size_t i = 0; i < n; i++)
+        RBT_compact_insert(compact_rbt, &keys[i]);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        RBT_compact_delete(compact_rbt, &keys[i], NULL);
+    report("rbt_compact", "delete", n, now_ns() - start);
+    RBT_compact_destroy(compact_rbt, NULL);
+
+    AVLTree avl = NULL;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        avl = AVLTree_insert(avl, &keys[i], compare_ints);
+    report("avl", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += AVLTree_search(avl, &lookups[i], compare_ints);
+    report("avl", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    AVLTree_inorder_traversal(avl, count_item);
+    report("avl", "scan", scanned, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        avl = AVLTree_delete(avl, &keys[i], compare_ints, destroy_nothing);
+    report("avl", "delete", n, now_ns() - start);
+    AVLTree_destroy(avl, destroy_nothing);
+    start = now_ns();
+    avl = AVLTree_build_sorted(sorted_items, n, compare_ints);
+    report("avl", "build_sorted", n, now_ns() - start);
+    start = now_ns();
+    AVLTree_destroy(avl, NULL);
+    report("avl", "destroy", n, now_ns() - start);
+
+    CompactAVLTree compact_avl = AVLTree_compact_create(compare_ints);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        AVLTree_compact_insert(compact_avl, &keys[i]);
+    report("avl_compact", "insert", n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        found += AVLTree_compact_search(compact_avl, &lookups[i]);
+    report("avl_compact", "lookup", n, now_ns() - start);
+    scanned = 0;
+    start = now_ns();
+    AVLTree_compact_range(compact_avl, NULL, NULL, count_range_item, NULL);
+    report("avl_compact", "scan", scanned, now_ns() - start);
+    start = now_ns();
+    AVLTree_compact_destroy(compact_avl, NULL);
+    report("avl_compact", "destroy", n, now_ns() - start);
+    compact_avl = AVLTree_compact_create(compare_ints);
+    for (size_t i = 0; i < n; i++)
+        AVLTree_compact_insert(compact_avl, &keys[i]);
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        AVLTree_compact_delete(compact_avl, &keys[i], NULL);
+    report("avl_compact", "delete", n, now_ns() - start);
+    AVLTree_compact_destroy(compact_avl, NULL);
+
+    free(sorted);
+    free(keys);
+    free(lookups);
+    free(sorted_items);
+    return 0;
+}
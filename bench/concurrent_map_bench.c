@@ -0,0 +1,159 @@
+/* File: concurrent_map_bench.c */
+/* Throughput of the sharded concurrent hash map against a separate chaining hash table behind a single mutex, for 1
+   to 64 threads and different ratios of reads and writes */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "../modules/ConcurrentHashMap/ConcurrentHashMap.h"
+#include "../modules/SeparateChainingHashTable/ChainingHashTable.h"
+
+
+#define MAX_THREADS 64
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = (*state += 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+static int compare_ints(void *a, void *b) {
+    int x = *(int *)a, y = *(int *)b;
+    return (x > y) - (x < y);
+}
+
+
+static size_t hash_int(void *key) {
+    return (size_t)(*(int *)key * 2654435761u);
+}
+
+
+// The two maps which are measured, behind the same operations
+typedef struct {
+    ConcurrentHashMap *sharded;
+    SCHashtable *table;
+    pthread_mutex_t lock;
+} maps;
+
+static void *map_get(maps *m, int *key) {
+    if (m->sharded != NULL)
+        return CHM_get(m->sharded, key);
+    pthread_mutex_lock(&m->lock);
+    void *value = SChashtable_search(m->table, key);
+    pthread_mutex_unlock(&m->lock);
+    return value;
+}
+
+static void map_put(maps *m, int *key) {
+    if (m->sharded != NULL) {
+        CHM_put(m->sharded, key, key);
+        return;
+    }
+    pthread_mutex_lock(&m->lock);
+    SChashtable_insert(m->table, key, key);
+    pthread_mutex_unlock(&m->lock);
+}
+
+static void map_remove(maps *m, int *key) {
+    if (m->sharded != NULL) {
+        CHM_remove(m->sharded, key);
+        return;
+    }
+    pthread_mutex_lock(&m->lock);
+    SChashtable_remove(m->table, key);
+    pthread_mutex_unlock(&m->lock);
+}
+
+
+typedef struct {
+    maps *m;
+    int *keys;
+    size_t key_count;
+    size_t ops;
+    unsigned int read_percent;
+    uint64_t seed;
+    size_t found;
+} worker_args;
+
+// Reads look up a random key. Writes insert or remove a random key with the same probability, so the size of the map
+// stays about the same
+static void *worker(void *arg) {
+    worker_args *args = arg;
+    uint64_t state = args->seed;
+    for (size_t i = 0; i < args->ops; i++) {
+        uint64_t r = next_random(&state);
+        int *key = &args->keys[(r >> 8) % args->key_count];
+        if (r % 100 < args->read_percent)
+            args->found += map_get(args->m, key) != NULL;
+        else if ((r >> 7) & 1)
+            map_put(args->m, key);
+        else
+            map_remove(args->m, key);
+    }
+    return NULL;
+}
+
+
+static void run(const char *container, bool sharded, size_t n, size_t total_ops, unsigned int threads,
+                unsigned int read_percent, int *keys) {
+    maps m = {NULL, NULL, PTHREAD_MUTEX_INITIALIZER};
+    if (sharded)
+        m.sharded = CHM_create(0, compare_ints, NULL, NULL, hash_int);
+    else
+        m.table = SChashtable_create(compare_ints, NULL, NULL, NULL, hash_int);
+    // Half of the keys are in the map when the threads start
+    for (size_t i = 0; i < 2 * n; i += 2)
+        map_put(&m, &keys[i]);
+
+    pthread_t ids[MAX_THREADS];
+    worker_args args[MAX_THREADS];
+    double start = now_ns();
+    for (unsigned int t = 0; t < threads; t++) {
+        args[t] = (worker_args){&m, keys, 2 * n, total_ops / threads, read_percent, 42 + t, 0};
+        pthread_create(&ids[t], NULL, worker, &args[t]);
+    }
+    for (unsigned int t = 0; t < threads; t++)
+        pthread_join(ids[t], NULL);
+    double elapsed = now_ns() - start;
+    size_t ops = total_ops / threads * threads;
+    printf("%s,%u,%u,%zu,%.2f\n", container, threads, read_percent, n, ops / elapsed * 1e3);
+
+    if (sharded)
+        CHM_destroy(m.sharded);
+    else
+        SChashtable_destroy(m.table);
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+    size_t total_ops = 2 * n;
+    int *keys = malloc(2 * n * sizeof(int));
+    for (size_t i = 0; i < 2 * n; i++)
+        keys[i] = (int)i;
+
+    unsigned int read_percents[] = {50, 90, 99};
+    printf("container,threads,read_percent,items,mops_per_sec\n");
+    for (size_t r = 0; r < sizeof(read_percents) / sizeof(read_percents[0]); r++)
+        for (unsigned int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+            run("sharded", true, n, total_ops, threads, read_percents[r], keys);
+            run("global_lock", false, n, total_ops, threads, read_percents[r], keys);
+        }
+    free(keys);
+    return 0;
+}
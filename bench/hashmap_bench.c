@@ -0,0 +1,179 @@
+/* File: hashmap_bench.c */
+/* Benchmark of a uint64_t -> uint32_t map: the generated hashmap with inline keys and values against the double
+   hashing and the separate chaining hash tables with boxed keys and values, searched one key at a time and in batches */
+#define _POSIX_C_SOURCE 199309L
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "../modules/HashMap/hashmap.h"
+#include "../modules/DoubleHashingHashTable/DoubleHashingHashTable.h"
+#include "../modules/SeparateChainingHashTable/ChainingHashTable.h"
+
+
+#define U64_HASH(key) hashmap_hash_u64(key)
+#define U64_EQ(a, b) ((a) == (b))
+
+DECLARE_HASHMAP(uint64_t, uint32_t, U64_HASH, U64_EQ)
+
+
+// Keys which are given to every call of the batched searches
+#define BATCH 1024
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = (*state += 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+static int compare_u64(void *a, void *b) {
+    uint64_t x = *(uint64_t *)a, y = *(uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+
+static size_t hash_u64(void *key) {
+    return hashmap_hash_u64(*(uint64_t *)key);
+}
+
+
+static size_t hash_u64_2(void *key) {
+    return (size_t)((*(uint64_t *)key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+
+// Bytes taken by a block of the given size from malloc (with glibc this includes the rounding of malloc, but not its
+// 8-byte header)
+static size_t block_bytes(void *ptr, size_t size) {
+#ifdef __GLIBC__
+    return malloc_usable_size(ptr);
+#else
+    return size;
+#endif
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+    size_t lookups = 4 * n;
+
+    // Keys to insert, and a random order of lookups of which half hit and half miss
+    uint64_t state = 42;
+    uint64_t *keys = malloc(n * sizeof(uint64_t));
+    uint64_t *queries = malloc(lookups * sizeof(uint64_t));
+    for (size_t i = 0; i < n; i++)
+        keys[i] = next_random(&state);
+    for (size_t i = 0; i < lookups; i++)
+        queries[i] = i % 2 == 0 ? keys[next_random(&state) % n] : next_random(&state);
+    void **query_keys = malloc(lookups * sizeof(void *));
+    void *values[BATCH];
+    for (size_t i = 0; i < lookups; i++)
+        query_keys[i] = &queries[i];
+
+    printf("container,items,ns_per_insert,ns_per_lookup,bytes_per_item\n");
+    volatile uint64_t sink = 0;
+
+    double start = now_ns();
+    hashmap_uint64_t_uint32_t *map = hashmap_uint64_t_uint32_t_create(0);
+    for (size_t i = 0; i < n; i++)
+        hashmap_uint64_t_uint32_t_put(map, keys[i], (uint32_t)i);
+    double insert = now_ns() - start;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++) {
+        uint32_t *value = hashmap_uint64_t_uint32_t_get(map, queries[i]);
+        if (value != NULL)
+            sink += *value;
+    }
+    double lookup = now_ns() - start;
+    printf("hashmap,%zu,%.2f,%.2f,%.2f\n", n, insert / n, lookup / lookups,
+           (double)hashmap_uint64_t_uint32_t_memory(map) / n);
+    hashmap_uint64_t_uint32_t_free(map);
+
+    // The keys and the values of the double hashing hash table are allocated one by one, like its users do
+    size_t boxes = 0;
+    start = now_ns();
+    DHHashtable *h = DHhashtable_create(compare_u64, free, free, NULL, hash_u64, hash_u64_2);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t *key = malloc(sizeof(uint64_t));
+        uint32_t *value = malloc(sizeof(uint32_t));
+        *key = keys[i];
+        *value = (uint32_t)i;
+        boxes += block_bytes(key, sizeof(uint64_t)) + block_bytes(value, sizeof(uint32_t));
+        DHhashtable_insert(h, key, value);
+    }
+    insert = now_ns() - start;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++) {
+        uint32_t *value = DHhashtable_search(h, &queries[i]);
+        if (value != NULL)
+            sink += *value;
+    }
+    lookup = now_ns() - start;
+    double bytes = (double)(DHhashtable_get_stats(h).bytes_allocated + boxes) / n;
+    printf("dh_boxed,%zu,%.2f,%.2f,%.2f\n", n, insert / n, lookup / lookups, bytes);
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i += BATCH) {
+        size_t count = lookups - i < BATCH ? lookups - i : BATCH;
+        DHhashtable_search_batch(h, query_keys + i, count, values);
+        for (size_t j = 0; j < count; j++)
+            if (values[j] != NULL)
+                sink += *(uint32_t *)values[j];
+    }
+    lookup = now_ns() - start;
+    printf("dh_boxed_batch,%zu,%.2f,%.2f,%.2f\n", n, insert / n, lookup / lookups, bytes);
+    DHhashtable_destroy(h);
+
+    boxes = 0;
+    start = now_ns();
+    SCHashtable *sc = SChashtable_create(compare_u64, NULL, free, free, hash_u64);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t *key = malloc(sizeof(uint64_t));
+        uint32_t *value = malloc(sizeof(uint32_t));
+        *key = keys[i];
+        *value = (uint32_t)i;
+        boxes += block_bytes(key, sizeof(uint64_t)) + block_bytes(value, sizeof(uint32_t));
+        SChashtable_insert(sc, key, value);
+    }
+    insert = now_ns() - start;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++) {
+        uint32_t *value = SChashtable_search(sc, &queries[i]);
+        if (value != NULL)
+            sink += *value;
+    }
+    lookup = now_ns() - start;
+    bytes = (double)(SChashtable_get_stats(sc).bytes_allocated + boxes) / n;
+    printf("sc_boxed,%zu,%.2f,%.2f,%.2f\n", n, insert / n, lookup / lookups, bytes);
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i += BATCH) {
+        size_t count = lookups - i < BATCH ? lookups - i : BATCH;
+        SChashtable_search_batch(sc, query_keys + i, count, values);
+        for (size_t j = 0; j < count; j++)
+            if (values[j] != NULL)
+                sink += *(uint32_t *)values[j];
+    }
+    lookup = now_ns() - start;
+    printf("sc_boxed_batch,%zu,%.2f,%.2f,%.2f\n", n, insert / n, lookup / lookups, bytes);
+    SChashtable_destroy(sc);
+
+    free(query_keys);
+    free(keys);
+    free(queries);
+    return 0;
+}
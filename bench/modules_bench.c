@@ -0,0 +1,751 @@
+/* File: modules_bench.c */
+/* Benchmark suite which runs the same workloads (insert, lookup hit and miss, iteration, delete and a mixed workload) */
+/* on every module of the library, with uniform, Zipfian and sequential keys. Every (distribution, size, module) case */
+/* runs in its own child process, so the reported peak RSS belongs to that case only */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../modules/AVLTree/AVLTree.h"
+#include "../modules/BloomFilter/BloomFilter.h"
+#include "../modules/DoubleHashingHashTable/DoubleHashingHashTable.h"
+#include "../modules/DoubleLinkedList/DoubleLinkedList.h"
+#include "../modules/PriorityQueue/PriorityQueue.h"
+#include "../modules/Queue/Queue.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+#include "../modules/RedBlackTree/rbtree.h"
+#include "../modules/SeparateChainingHashTable/ChainingHashTable.h"
+#include "../modules/SkipList/SkipList.h"
+#include "../modules/Stack/Stack.h"
+#include "../modules/Vector/vector.h"
+
+
+DECLARE_VECTOR_ALL(int)
+
+#define INT_LESS(a, b) ((a) < (b))
+
+DECLARE_RBTREE(int, int, INT_LESS)
+
+
+#define MAX_SIZES 16
+#define ZIPF_THETA 0.99
+
+
+/* Command line options */
+static struct {
+    size_t sizes[MAX_SIZES];
+    int num_sizes;
+    const char *modules;
+    const char *distributions;
+    bool json;
+    uint64_t seed;
+    size_t linear_ops;
+} options = {
+    .sizes = {1000, 10000, 100000, 1000000},
+    .num_sizes = 4,
+    .modules = NULL,
+    .distributions = "uniform,zipfian,sequential",
+    .json = false,
+    .seed = 42,
+    .linear_ops = 1000
+};
+
+
+/* Keys and operation streams of a case. Every module of a case sees exactly the same streams */
+typedef struct {
+    const char *distribution;
+    size_t size;
+    int *keys;          // the keys which are inserted, in insertion order (all of them are even)
+    uint32_t *indices;  // indices into keys for lookups and the mixed workload, drawn from the distribution
+    uint64_t seed;
+} Workload;
+
+
+/* Thin adapter over the API of a module. Functions which the module does not support are NULL */
+typedef struct {
+    const char *name;
+    bool keyed;                           // false for containers (stack, queue, priority queue) whose remove takes no key
+    bool linear;                          // lookups and deletes take O(n) time, so at most linear_ops of them are measured
+    void *(*create)(size_t size);
+    void (*insert)(void *ds, int *key);
+    bool (*lookup)(void *ds, int *key);
+    void (*remove)(void *ds, int *key);
+    size_t (*iterate)(void *ds);
+    void (*destroy)(void *ds);
+} Module;
+
+
+// Random numbers (splitmix64), so the streams do not depend on the rand() of the C library
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double next_uniform(uint64_t *state) {
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+// Zipfian ranks in [0, n) with the method of Gray et al. ("Quickly generating billion-record synthetic databases")
+typedef struct {
+    size_t n;
+    double alpha, eta, zetan, half_pow_theta;
+} Zipf;
+
+static void zipf_init(Zipf *zipf, size_t n) {
+    double zeta2 = 1.0 + pow(0.5, ZIPF_THETA);
+    zipf->n = n;
+    zipf->zetan = 0;
+    for (size_t i = 1; i <= n; i++)
+        zipf->zetan += 1.0 / pow((double)i, ZIPF_THETA);
+    zipf->alpha = 1.0 / (1.0 - ZIPF_THETA);
+    zipf->eta = (1.0 - pow(2.0 / n, 1.0 - ZIPF_THETA)) / (1.0 - zeta2 / zipf->zetan);
+    zipf->half_pow_theta = 1.0 + pow(0.5, ZIPF_THETA);
+}
+
+static size_t zipf_next(Zipf *zipf, uint64_t *state) {
+    double u = next_uniform(state);
+    double uz = u * zipf->zetan;
+    if (uz < 1.0)
+        return 0;
+    if (uz < zipf->half_pow_theta)
+        return 1 < zipf->n ? 1 : 0;
+    size_t rank = zipf->n * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha);
+    return rank < zipf->n ? rank : zipf->n - 1;
+}
+
+
+static void workload_create(Workload *w, const char *distribution, size_t size, uint64_t seed) {
+    w->distribution = distribution;
+    w->size = size;
+    w->seed = seed;
+    w->keys = malloc(size * sizeof(int));
+    w->indices = malloc(size * sizeof(uint32_t));
+    if (w->keys == NULL || w->indices == NULL) {
+        fprintf(stderr, "Failed to allocate the keys of %zu items\n", size);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t state = seed;
+    bool sequential = strcmp(distribution, "sequential") == 0;
+
+    // The inserted keys are 0, 2, 4, ... (so key + 1 is always a miss), in ascending or in random order
+    for (size_t i = 0; i < size; i++)
+        w->keys[i] = 2 * i;
+    if (!sequential) {
+        for (size_t i = size - 1; i > 0; i--) {
+            size_t j = next_random(&state) % (i + 1);
+            int temp = w->keys[i];
+            w->keys[i] = w->keys[j];
+            w->keys[j] = temp;
+        }
+    }
+
+    if (sequential) {
+        for (size_t i = 0; i < size; i++)
+            w->indices[i] = i;
+    }
+    else if (strcmp(distribution, "zipfian") == 0) {
+        // The keys are shuffled, so the popular ranks are spread over the whole key space
+        Zipf zipf;
+        zipf_init(&zipf, size);
+        for (size_t i = 0; i < size; i++)
+            w->indices[i] = zipf_next(&zipf, &state);
+    }
+    else {
+        for (size_t i = 0; i < size; i++)
+            w->indices[i] = next_random(&state) % size;
+    }
+}
+
+static void workload_destroy(Workload *w) {
+    free(w->keys);
+    free(w->indices);
+}
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Print one result row. The peak RSS is the maximum resident set size of the case so far
+static void report(const Module *module, const char *workload, const Workload *w, size_t ops, double ns) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double ns_per_op = ops ? ns / ops : 0;
+    double ops_per_sec = ns > 0 ? ops * 1e9 / ns : 0;
+    if (options.json)
+        printf("{\"module\":\"%s\",\"workload\":\"%s\",\"distribution\":\"%s\",\"size\":%zu,\"ops\":%zu,"
+               "\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f,\"peak_rss_kb\":%ld}\n",
+               module->name, workload, w->distribution, w->size, ops, ns_per_op, ops_per_sec, usage.ru_maxrss);
+    else
+        printf("%s,%s,%s,%zu,%zu,%.2f,%.0f,%ld\n",
+               module->name, workload, w->distribution, w->size, ops, ns_per_op, ops_per_sec, usage.ru_maxrss);
+    fflush(stdout);
+}
+
+
+/* Adapters */
+
+static int compare_ints(void *a, void *b) {
+    int x = *(int *)a, y = *(int *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_int_values(const int *a, const int *b) {
+    return (*a > *b) - (*a < *b);
+}
+
+static size_t hash_int(void *key) {
+    uint64_t x = (uint32_t)*(int *)key;
+    x = (x ^ (x >> 16)) * 0x45D9F3BULL;
+    x = (x ^ (x >> 16)) * 0x45D9F3BULL;
+    return x ^ (x >> 16);
+}
+
+static size_t hash_int_2(void *key) {
+    uint64_t x = (uint32_t)*(int *)key * 0x9E3779B97F4A7C15ULL;
+    return x >> 32;
+}
+
+static void destroy_nothing(void *data) {
+    (void)data;
+}
+
+static size_t visited_items;
+
+static void visit_item(void *data) {
+    (void)data;
+    visited_items++;
+}
+
+
+// AVL tree
+typedef struct {
+    AVLTree root;
+} AVLBench;
+
+static void *avl_create(size_t size) {
+    return calloc(1, sizeof(AVLBench));
+}
+
+static void avl_insert(void *ds, int *key) {
+    AVLBench *b = ds;
+    b->root = AVLTree_insert(b->root, key, compare_ints);
+}
+
+static bool avl_lookup(void *ds, int *key) {
+    return AVLTree_search(((AVLBench *)ds)->root, key, compare_ints);
+}
+
+static void avl_remove(void *ds, int *key) {
+    AVLBench *b = ds;
+    b->root = AVLTree_delete(b->root, key, compare_ints, NULL);
+}
+
+static size_t avl_iterate(void *ds) {
+    visited_items = 0;
+    AVLTree_inorder_traversal(((AVLBench *)ds)->root, visit_item);
+    return visited_items;
+}
+
+static void avl_destroy(void *ds) {
+    AVLTree_destroy(((AVLBench *)ds)->root, destroy_nothing);
+    free(ds);
+}
+
+
+// Bloom filter with 10 bits per item and 4 hash functions
+#define BLOOM_HASH_COUNT 4
+
+static size_t bloom_hash_0(void *key) { return hash_int(key); }
+static size_t bloom_hash_1(void *key) { return hash_int_2(key); }
+static size_t bloom_hash_2(void *key) { return hash_int(key) + 3 * hash_int_2(key); }
+static size_t bloom_hash_3(void *key) { return hash_int(key) + 5 * hash_int_2(key); }
+static HashFunc bloom_hashes[BLOOM_HASH_COUNT] = {bloom_hash_0, bloom_hash_1, bloom_hash_2, bloom_hash_3};
+
+static void *bloom_create(size_t size) {
+    // The size of the filter must be a power of 2
+    unsigned int bits = 64;
+    while (bits < 10 * size)
+        bits <<= 1;
+    return bloom_filter_create(bits, BLOOM_HASH_COUNT, bloom_hashes);
+}
+
+static void bloom_insert(void *ds, int *key) {
+    bloom_filter_insert(ds, key);
+}
+
+static bool bloom_lookup(void *ds, int *key) {
+    return bloom_filter_check(ds, key);
+}
+
+static void bloom_destroy(void *ds) {
+    bloom_filter_destroy(ds);
+}
+
+
+// Double hashing hash table
+static void *dh_create(size_t size) {
+    return DHhashtable_create(compare_ints, NULL, NULL, NULL, hash_int, hash_int_2);
+}
+
+static void dh_insert(void *ds, int *key) {
+    DHhashtable_insert(ds, key, key);
+}
+
+static bool dh_lookup(void *ds, int *key) {
+    return DHhashtable_search(ds, key) != NULL;
+}
+
+static void dh_remove(void *ds, int *key) {
+    DHhashtable_remove(ds, key);
+}
+
+static void dh_destroy(void *ds) {
+    DHhashtable_destroy(ds);
+}
+
+
+// Double hashing hash table in the Robin Hood mode (shares the insert, lookup, remove and destroy of dh)
+static void *dh_robin_hood_create(size_t size) {
+    return DHhashtable_create_robin_hood(compare_ints, NULL, NULL, NULL, hash_int, NULL);
+}
+
+
+// Double linked list (items are appended at the end)
+typedef struct {
+    Listptr head;
+    Listptr tail;
+} DLLBench;
+
+static void *dll_create(size_t size) {
+    DLLBench *b = malloc(sizeof(*b));
+    DLL_Create(&b->head, &b->tail);
+    return b;
+}
+
+static void dll_insert(void *ds, int *key) {
+    DLLBench *b = ds;
+    DLL_AddLast(&b->tail, &b->head, key);
+}
+
+static bool dll_lookup(void *ds, int *key) {
+    return DLL_GetNode(((DLLBench *)ds)->head, key, compare_ints) != NULL;
+}
+
+static void dll_remove(void *ds, int *key) {
+    DLLBench *b = ds;
+    DLL_Remove(&b->head, &b->tail, key, compare_ints, NULL);
+}
+
+static void dll_destroy(void *ds) {
+    DLLBench *b = ds;
+    DLL_freelist(b->head, b->tail, NULL);
+    free(b);
+}
+
+
+// Priority queue (max heap of the keys)
+static void *pq_create(size_t size) {
+    return PQ_initialize(2 * size + 1, compare_ints, NULL, NULL);
+}
+
+static void pq_insert(void *ds, int *key) {
+    PQ_insert(ds, key);
+}
+
+static void pq_remove(void *ds, int *key) {
+    PQ_remove(ds);
+}
+
+static void pq_destroy(void *ds) {
+    PQ_destroy(ds);
+}
+
+
+// Queue
+static void *queue_create(size_t size) {
+    return Queue_create(NULL, NULL);
+}
+
+static void queue_insert(void *ds, int *key) {
+    Queue_insert(ds, key);
+}
+
+static void queue_remove(void *ds, int *key) {
+    Queue_remove(ds);
+}
+
+static void queue_destroy(void *ds) {
+    Queue_destroy(ds);
+}
+
+
+// Red black tree
+typedef struct {
+    RBTree root;
+} RBTBench;
+
+static void *rbt_create(size_t size) {
+    return calloc(1, sizeof(RBTBench));
+}
+
+static void rbt_insert(void *ds, int *key) {
+    RBT_insert(&((RBTBench *)ds)->root, key, compare_ints);
+}
+
+static bool rbt_lookup(void *ds, int *key) {
+    return RBT_search(((RBTBench *)ds)->root, key, compare_ints);
+}
+
+static void rbt_remove(void *ds, int *key) {
+    RBT_delete(&((RBTBench *)ds)->root, key, compare_ints, NULL);
+}
+
+static size_t rbt_iterate(void *ds) {
+    visited_items = 0;
+    RBT_inorder_traversal(((RBTBench *)ds)->root, visit_item);
+    return visited_items;
+}
+
+static void rbt_destroy(void *ds) {
+    RBT_destroy(((RBTBench *)ds)->root, NULL);
+    free(ds);
+}
+
+
+// Red black tree generated for int keys (rbtree.h)
+static void *rbtree_bench_create(size_t size) {
+    return rbtree_int_int_create();
+}
+
+static void rbtree_bench_insert(void *ds, int *key) {
+    rbtree_int_int_insert(ds, *key, *key);
+}
+
+static bool rbtree_bench_lookup(void *ds, int *key) {
+    return rbtree_int_int_contains(ds, *key);
+}
+
+static void rbtree_bench_remove(void *ds, int *key) {
+    rbtree_int_int_remove(ds, *key);
+}
+
+static size_t rbtree_bench_iterate(void *ds) {
+    volatile int sum = 0;
+    for (rbtree_int_int_node *node = rbtree_int_int_first(ds); node != NULL; node = rbtree_int_int_next(node))
+        sum += node->value;
+    return rbtree_int_int_size(ds);
+}
+
+static void rbtree_bench_destroy(void *ds) {
+    rbtree_int_int_free(ds);
+}
+
+
+// Separate chaining hash table
+static void *sc_create(size_t size) {
+    return SChashtable_create(compare_ints, NULL, NULL, NULL, hash_int);
+}
+
+static void sc_insert(void *ds, int *key) {
+    SChashtable_insert(ds, key, key);
+}
+
+static bool sc_lookup(void *ds, int *key) {
+    return SChashtable_search(ds, key) != NULL;
+}
+
+static void sc_remove(void *ds, int *key) {
+    SChashtable_remove(ds, key);
+}
+
+static void sc_destroy(void *ds) {
+    SChashtable_destroy(ds);
+}
+
+
+// Skip list
+static void *skiplist_create(size_t size) {
+    return skiplist_initialize(compare_ints, NULL, NULL, NULL);
+}
+
+static void skiplist_bench_insert(void *ds, int *key) {
+    skiplist_insert(ds, key, key);
+}
+
+static bool skiplist_lookup(void *ds, int *key) {
+    return skiplist_search(ds, key) != NULL;
+}
+
+static void skiplist_remove(void *ds, int *key) {
+    skiplist_delete(ds, key);
+}
+
+static void skiplist_bench_destroy(void *ds) {
+    skiplist_destroy(ds);
+}
+
+
+// Stack
+static void *stack_bench_create(size_t size) {
+    return stack_create(NULL, destroy_nothing);
+}
+
+static void stack_insert(void *ds, int *key) {
+    stack_push(ds, key);
+}
+
+static void stack_remove(void *ds, int *key) {
+    stack_pop(ds);
+}
+
+static void stack_bench_destroy(void *ds) {
+    stack_destroy(ds);
+}
+
+
+// Vector of the key values (searches and deletes are linear)
+static void *vector_create(size_t size) {
+    return vector_int_create(0);
+}
+
+static void vector_insert(void *ds, int *key) {
+    vector_int_push_back(ds, *key);
+}
+
+static bool vector_lookup(void *ds, int *key) {
+    return vector_int_search(ds, *key, compare_int_values) >= 0;
+}
+
+static void vector_remove(void *ds, int *key) {
+    vector_int_delete(ds, *key, NULL);
+}
+
+static size_t vector_iterate(void *ds) {
+    vector_int *vector = ds;
+    volatile int sum = 0;
+    for (size_t i = 0; i < vector_int_size(vector); i++)
+        sum += vector_int_at(vector, i);
+    return vector_int_size(vector);
+}
+
+static void vector_destroy(void *ds) {
+    vector_int_free(ds, NULL);
+}
+
+
+static const Module modules[] = {
+    {"avl", true, false, avl_create, avl_insert, avl_lookup, avl_remove, avl_iterate, avl_destroy},
+    {"bloom", true, false, bloom_create, bloom_insert, bloom_lookup, NULL, NULL, bloom_destroy},
+    {"dh", true, false, dh_create, dh_insert, dh_lookup, dh_remove, NULL, dh_destroy},
+    {"dh_rh", true, false, dh_robin_hood_create, dh_insert, dh_lookup, dh_remove, NULL, dh_destroy},
+    {"dll", true, true, dll_create, dll_insert, dll_lookup, dll_remove, NULL, dll_destroy},
+    {"pq", false, false, pq_create, pq_insert, NULL, pq_remove, NULL, pq_destroy},
+    {"queue", false, false, queue_create, queue_insert, NULL, queue_remove, NULL, queue_destroy},
+    {"rbt", true, false, rbt_create, rbt_insert, rbt_lookup, rbt_remove, rbt_iterate, rbt_destroy},
+    {"rbtree", true, false, rbtree_bench_create, rbtree_bench_insert, rbtree_bench_lookup, rbtree_bench_remove,
+     rbtree_bench_iterate, rbtree_bench_destroy},
+    {"sc", true, false, sc_create, sc_insert, sc_lookup, sc_remove, NULL, sc_destroy},
+    {"skiplist", true, false, skiplist_create, skiplist_bench_insert, skiplist_lookup, skiplist_remove, NULL,
+     skiplist_bench_destroy},
+    {"stack", false, false, stack_bench_create, stack_insert, NULL, stack_remove, NULL, stack_bench_destroy},
+    {"vector", true, true, vector_create, vector_insert, vector_lookup, vector_remove, vector_iterate, vector_destroy},
+};
+#define NUM_MODULES (sizeof(modules) / sizeof(modules[0]))
+
+
+/* Workloads */
+
+static void run_module(const Module *m, Workload *w) {
+    size_t n = w->size;
+    size_t limited = (m->linear && options.linear_ops < n) ? options.linear_ops : n;
+    size_t found = 0;
+    double start;
+    void *ds = m->create(n);
+
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        m->insert(ds, &w->keys[i]);
+    report(m, "insert", w, n, now_ns() - start);
+
+    if (m->lookup != NULL) {
+        start = now_ns();
+        for (size_t i = 0; i < limited; i++)
+            found += m->lookup(ds, &w->keys[w->indices[i]]);
+        report(m, "lookup_hit", w, limited, now_ns() - start);
+        if (found != limited)
+            fprintf(stderr, "%s: %zu of %zu inserted keys were not found\n", m->name, limited - found, limited);
+
+        int *misses = malloc(limited * sizeof(int));
+        for (size_t i = 0; i < limited; i++)
+            misses[i] = w->keys[w->indices[i]] + 1;
+        found = 0;
+        start = now_ns();
+        for (size_t i = 0; i < limited; i++)
+            found += m->lookup(ds, &misses[i]);
+        report(m, "lookup_miss", w, limited, now_ns() - start);
+        // Bloom filters may report false positives
+        if (found != 0 && m->remove != NULL)
+            fprintf(stderr, "%s: %zu keys which were never inserted were found\n", m->name, found);
+        free(misses);
+    }
+
+    if (m->iterate != NULL) {
+        start = now_ns();
+        size_t visited = m->iterate(ds);
+        report(m, "iterate", w, visited, now_ns() - start);
+    }
+
+    if (m->remove != NULL) {
+        // Delete in insertion order (ascending for sequential keys, random otherwise), then insert the keys again
+        size_t deletes = m->keyed ? limited : n;
+        start = now_ns();
+        for (size_t i = 0; i < deletes; i++)
+            m->remove(ds, &w->keys[i]);
+        report(m, "delete", w, deletes, now_ns() - start);
+        for (size_t i = 0; i < deletes; i++)
+            m->insert(ds, &w->keys[i]);
+
+        // Mixed: half lookups and half updates. An update deletes the key if it is present and inserts it otherwise
+        // (containers push or pop instead)
+        bool *present = malloc(n * sizeof(bool));
+        for (size_t i = 0; i < n; i++)
+            present[i] = true;
+        uint64_t state = w->seed ^ 0x5DEECE66DULL;
+        size_t items = n;
+        start = now_ns();
+        for (size_t i = 0; i < limited; i++) {
+            size_t index = w->indices[i];
+            bool update = next_random(&state) & 1;
+            if (!m->keyed) {
+                if (update || items == 0) {
+                    m->insert(ds, &w->keys[index]);
+                    items++;
+                }
+                else {
+                    m->remove(ds, NULL);
+                    items--;
+                }
+            }
+            else if (!update && m->lookup != NULL) {
+                found += m->lookup(ds, &w->keys[index]);
+            }
+            else if (present[index]) {
+                m->remove(ds, &w->keys[index]);
+                present[index] = false;
+            }
+            else {
+                m->insert(ds, &w->keys[index]);
+                present[index] = true;
+            }
+        }
+        report(m, "mixed", w, limited, now_ns() - start);
+        free(present);
+    }
+
+    m->destroy(ds);
+}
+
+
+/* Command line */
+
+static bool list_contains(const char *list, const char *name) {
+    if (list == NULL)
+        return true;
+    size_t length = strlen(name);
+    for (const char *p = list; *p; ) {
+        const char *end = strchr(p, ',');
+        size_t item = end ? (size_t)(end - p) : strlen(p);
+        if (item == length && strncmp(p, name, length) == 0)
+            return true;
+        if (end == NULL)
+            break;
+        p = end + 1;
+    }
+    return false;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--sizes 1000,1000000] [--modules avl,rbt,...] [--distributions uniform,zipfian,sequential]\n"
+                    "          [--format csv|json] [--seed N] [--linear-ops N]\n", program);
+    exit(EXIT_FAILURE);
+}
+
+static void parse_options(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc)
+            usage(argv[0]);
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "--sizes") == 0) {
+            options.num_sizes = 0;
+            for (char *end; *value && options.num_sizes < MAX_SIZES; value = *end ? end + 1 : end) {
+                options.sizes[options.num_sizes++] = strtod(value, &end);
+                if (end == value)
+                    usage(argv[0]);
+            }
+        }
+        else if (strcmp(argv[i - 1], "--modules") == 0)
+            options.modules = value;
+        else if (strcmp(argv[i - 1], "--distributions") == 0)
+            options.distributions = value;
+        else if (strcmp(argv[i - 1], "--format") == 0)
+            options.json = strcmp(value, "json") == 0;
+        else if (strcmp(argv[i - 1], "--seed") == 0)
+            options.seed = strtoull(value, NULL, 10);
+        else if (strcmp(argv[i - 1], "--linear-ops") == 0)
+            options.linear_ops = strtoull(value, NULL, 10);
+        else
+            usage(argv[0]);
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    static const char *distributions[] = {"uniform", "zipfian", "sequential"};
+    parse_options(argc, argv);
+
+    if (!options.json)
+        printf("module,workload,distribution,size,ops,ns_per_op,ops_per_sec,peak_rss_kb\n");
+    fflush(stdout);
+
+    int failures = 0;
+    for (int d = 0; d < 3; d++) {
+        if (!list_contains(options.distributions, distributions[d]))
+            continue;
+        for (int s = 0; s < options.num_sizes; s++) {
+            for (size_t m = 0; m < NUM_MODULES; m++) {
+                if (!list_contains(options.modules, modules[m].name))
+                    continue;
+                // The streams depend only on the seed, the distribution and the size, so they are the same for every module
+                uint64_t seed = options.seed * 0x100000001B3ULL ^ (options.sizes[s] << 2 | d);
+                pid_t pid = fork();
+                if (pid == 0) {
+                    Workload w;
+                    workload_create(&w, distributions[d], options.sizes[s], seed);
+                    run_module(&modules[m], &w);
+                    workload_destroy(&w);
+                    exit(EXIT_SUCCESS);
+                }
+                int status = 0;
+                if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                    fprintf(stderr, "%s failed with %s keys and %zu items\n", modules[m].name, distributions[d],
+                            options.sizes[s]);
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
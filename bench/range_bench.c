@@ -0,0 +1,172 @@
+/* File: range_bench.c */
+/* Benchmark of the range queries of the skip list, the red black tree and the AVL tree: narrow windows of consecutive
+   keys found with a seek and a sequential scan (with a callback, with an iterator and in batches), against filtering
+   a full in-order traversal */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../modules/SkipList/SkipList.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+#include "../modules/AVLTree/AVLTree.h"
+
+#define BATCH 64
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static int compare_ints(void *a, void *b) {
+    int x = *(int *)a, y = *(int *)b;
+    return (x > y) - (x < y);
+}
+
+
+static void report(const char *container, const char *operation, size_t items, size_t window, double ns) {
+    printf("%s,%s,%zu,%zu,%.1f\n", container, operation, items, window, ns);
+}
+
+
+// Sum of the keys of the windows, so that the scans cannot be optimized away
+static long long checksum;
+
+static bool sum_item(void *data, void *ctx) {
+    (void)ctx;
+    checksum += *(int *)data;
+    return true;
+}
+
+static bool sum_key(void *key, void *value, void *ctx) {
+    (void)value;
+    (void)ctx;
+    checksum += *(int *)key;
+    return true;
+}
+
+// The window of the traversal which filters every item
+static int traversal_low, traversal_high;
+
+static void sum_in_window(void *data) {
+    int key = *(int *)data;
+    if (key >= traversal_low && key < traversal_high)
+        checksum += key;
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+    size_t max_queries = 100000;
+
+    // The keys are the even numbers of [0, 2n), inserted in random order
+    int *values = malloc(n * sizeof(int));
+    for (size_t i = 0; i < n; i++)
+        values[i] = 2 * (int)i;
+    srand(42);
+    for (size_t i = n - 1; i > 0; i--) {
+        size_t j = (size_t)rand() % (i + 1);
+        int temp = values[i];
+        values[i] = values[j];
+        values[j] = temp;
+    }
+    int *lows = malloc(max_queries * sizeof(int));
+    for (size_t q = 0; q < max_queries; q++)
+        lows[q] = (int)((size_t)rand() % (2 * n));
+
+    skiplist *list = skiplist_initialize(compare_ints, NULL, NULL, NULL);
+    RBTree root = NULL;
+    AVLTree avl = NULL;
+    for (size_t i = 0; i < n; i++) {
+        skiplist_insert(list, &values[i], &values[i]);
+        RBT_insert(&root, &values[i], compare_ints);
+        avl = AVLTree_insert(avl, &values[i], compare_ints);
+    }
+
+    printf("container,operation,items,window,ns_per_query\n");
+    void *items[BATCH];
+    size_t windows[] = {16, 256, 4096};
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        // A window of the given number of keys. Wider windows run fewer queries, so that every case scans about as many
+        // items
+        int width = 2 * (int)windows[w];
+        size_t queries = max_queries * 16 / windows[w] < max_queries ? max_queries * 16 / windows[w] : max_queries;
+
+        double start = now_ns();
+        for (size_t q = 0; q < queries; q++)
+            skiplist_range(list, &lows[q], &(int){lows[q] + width}, sum_key, NULL);
+        report("skiplist", "range", n, windows[w], (now_ns() - start) / queries);
+
+        start = now_ns();
+        for (size_t q = 0; q < queries; q++) {
+            skiplist_cursor cursor = skiplist_seek(list, &lows[q]);
+            size_t count;
+            while ((count = skiplist_range_batch(list, &cursor, &(int){lows[q] + width}, items, NULL, BATCH)) > 0)
+                for (size_t i = 0; i < count; i++)
+                    checksum += *(int *)items[i];
+        }
+        report("skiplist", "range_batch", n, windows[w], (now_ns() - start) / queries);
+
+        start = now_ns();
+        for (size_t q = 0; q < queries; q++)
+            RBT_range(root, &lows[q], &(int){lows[q] + width}, compare_ints, sum_item, NULL);
+        report("rbt", "range", n, windows[w], (now_ns() - start) / queries);
+
+        start = now_ns();
+        for (size_t q = 0; q < queries; q++) {
+            int high = lows[q] + width;
+            for (RBTIterator it = RBT_lower_bound(root, &lows[q], compare_ints);
+                 RBT_iterator_valid(it) && *(int *)RBT_iterator_data(it) < high; it = RBT_next(it))
+                checksum += *(int *)RBT_iterator_data(it);
+        }
+        report("rbt", "iterator", n, windows[w], (now_ns() - start) / queries);
+
+        start = now_ns();
+        for (size_t q = 0; q < queries; q++) {
+            RBTIterator it = RBT_lower_bound(root, &lows[q], compare_ints);
+            size_t count;
+            while ((count = RBT_range_batch(&it, &(int){lows[q] + width}, compare_ints, items, BATCH)) > 0)
+                for (size_t i = 0; i < count; i++)
+                    checksum += *(int *)items[i];
+        }
+        report("rbt", "range_batch", n, windows[w], (now_ns() - start) / queries);
+
+        start = now_ns();
+        for (size_t q = 0; q < queries; q++)
+            AVLTree_range(avl, &lows[q], &(int){lows[q] + width}, compare_ints, sum_item, NULL);
+        report("avl", "range", n, windows[w], (now_ns() - start) / queries);
+
+        start = now_ns();
+        for (size_t q = 0; q < queries; q++) {
+            AVLTreeIterator it;
+            AVLTree_lower_bound(avl, &lows[q], compare_ints, &it);
+            size_t count;
+            while ((count = AVLTree_range_batch(&it, &(int){lows[q] + width}, compare_ints, items, BATCH)) > 0)
+                for (size_t i = 0; i < count; i++)
+                    checksum += *(int *)items[i];
+        }
+        report("avl", "range_batch", n, windows[w], (now_ns() - start) / queries);
+
+        // The same windows by filtering a full traversal, which visits all the n items for every query
+        size_t traversals = 10;
+        start = now_ns();
+        for (size_t q = 0; q < traversals; q++) {
+            traversal_low = lows[q];
+            traversal_high = lows[q] + width;
+            RBT_inorder_traversal(root, sum_in_window);
+        }
+        report("rbt", "traversal", n, windows[w], (now_ns() - start) / traversals);
+    }
+    fprintf(stderr, "checksum %lld\n", checksum);
+
+    skiplist_destroy(list);
+    RBT_destroy(root, NULL);
+    AVLTree_destroy(avl, NULL);
+    free(values);
+    free(lows);
+    return 0;
+}
@@ -0,0 +1,122 @@
+/* File: setops_bench.c */
+/* Benchmark of the set operations of the red black tree and the AVL tree: the join-based union, intersection and
+   difference (sequential and on a thread pool) against inserting the items of one tree into the other */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../modules/RedBlackTree/RedBlackTree.h"
+#include "../modules/AVLTree/AVLTree.h"
+#include "../modules/ThreadPool/ThreadPool.h"
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static int compare_ints(void *a, void *b) {
+    int x = *(int *)a, y = *(int *)b;
+    return (x > y) - (x < y);
+}
+
+
+static void report(const char *container, const char *operation, const char *mode, size_t n, size_t m, double ns) {
+    printf("%s,%s,%s,%zu,%zu,%.3f\n", container, operation, mode, n, m, ns / 1e6);
+}
+
+
+// The trees which the items of the traversal are inserted into
+static RBTree insert_root;
+static AVLTree insert_avl;
+
+static void insert_rbt_item(void *data) {
+    RBT_insert(&insert_root, data, compare_ints);
+}
+
+static void insert_avl_item(void *data) {
+    insert_avl = AVLTree_insert(insert_avl, data, compare_ints);
+}
+
+
+// Pick about wanted of the n values at random, in ascending order
+static size_t sample(int *values, size_t n, void **items, size_t wanted) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++)
+        if ((size_t)rand() % n < wanted)
+            items[count++] = &values[i];
+    return count;
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+
+    int *values = malloc(n * sizeof(int));
+    void **large = malloc(n * sizeof(void *));
+    void **small = malloc(n * sizeof(void *));
+    for (size_t i = 0; i < n; i++)
+        values[i] = (int)i;
+    srand(42);
+    ThreadPool pool = threadpool_create(0);
+    const char *operations[] = {"union", "intersection", "difference"};
+
+    printf("container,operation,mode,size1,size2,ms\n");
+    // The second tree has as many items as the first one, or 1% of them
+    for (size_t ratio = 1; ratio <= 100; ratio *= 100) {
+        size_t large_count = sample(values, n, large, n / 2);
+        size_t small_count = sample(values, n, small, n / 2 / ratio);
+
+        for (int operation = 0; operation < 3; operation++) {
+            for (int parallel = 0; parallel < 2; parallel++) {
+                ThreadPool p = parallel ? pool : NULL;
+                const char *mode = parallel ? "parallel" : "sequential";
+
+                RBTree root1 = RBT_build_sorted(large, large_count, compare_ints);
+                RBTree root2 = RBT_build_sorted(small, small_count, compare_ints);
+                double start = now_ns();
+                RBTree result = operation == 0 ? RBT_union(root1, root2, compare_ints, NULL, p)
+                              : operation == 1 ? RBT_intersection(root1, root2, compare_ints, NULL, p)
+                              : RBT_difference(root1, root2, compare_ints, NULL, p);
+                report("rbt", operations[operation], mode, large_count, small_count, now_ns() - start);
+                RBT_destroy(result, NULL);
+
+                AVLTree avl1 = AVLTree_build_sorted(large, large_count, compare_ints);
+                AVLTree avl2 = AVLTree_build_sorted(small, small_count, compare_ints);
+                start = now_ns();
+                AVLTree avl = operation == 0 ? AVLTree_union(avl1, avl2, compare_ints, NULL, p)
+                            : operation == 1 ? AVLTree_intersection(avl1, avl2, compare_ints, NULL, p)
+                            : AVLTree_difference(avl1, avl2, compare_ints, NULL, p);
+                report("avl", operations[operation], mode, large_count, small_count, now_ns() - start);
+                AVLTree_destroy(avl, NULL);
+            }
+        }
+
+        // The union by inserting every item of the second tree into the first one
+        insert_root = RBT_build_sorted(large, large_count, compare_ints);
+        RBTree root2 = RBT_build_sorted(small, small_count, compare_ints);
+        double start = now_ns();
+        RBT_inorder_traversal(root2, insert_rbt_item);
+        report("rbt", "union", "insert", large_count, small_count, now_ns() - start);
+        RBT_destroy(insert_root, NULL);
+        RBT_destroy(root2, NULL);
+
+        insert_avl = AVLTree_build_sorted(large, large_count, compare_ints);
+        AVLTree avl2 = AVLTree_build_sorted(small, small_count, compare_ints);
+        start = now_ns();
+        AVLTree_inorder_traversal(avl2, insert_avl_item);
+        report("avl", "union", "insert", large_count, small_count, now_ns() - start);
+        AVLTree_destroy(insert_avl, NULL);
+        AVLTree_destroy(avl2, NULL);
+    }
+
+    threadpool_destroy(pool);
+    free(values);
+    free(large);
+    free(small);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/* File: small_vector_bench.c */
+/* Benchmark of short-lived vectors: a heap allocated vector_TYPE against a small vector on the stack */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../modules/Vector/vector.h"
+#include "../modules/Vector/small_vector.h"
+
+
+DECLARE_VECTOR_ALL(int)
+DECLARE_SMALL_VECTOR(int, 8)
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t rounds = 10000000;
+    if (argc > 1)
+        rounds = strtoul(argv[1], NULL, 10);
+    // Number of items pushed in each vector (up to 8 stay inline, more spill to the heap)
+    int lengths[] = {2, 6, 8, 16};
+
+    printf("items,container,ns_per_vector\n");
+    for (int l = 0; l < 4; l++) {
+        int length = lengths[l];
+        volatile int sink = 0;
+
+        double start = now_ns();
+        for (size_t r = 0; r < rounds; r++) {
+            vector_int *vector = vector_int_create(8);
+            for (int i = 0; i < length; i++)
+                vector_int_push_back(vector, i);
+            sink += vector_int_at(vector, length - 1);
+            vector_int_free(vector, NULL);
+        }
+        double heap = now_ns() - start;
+
+        start = now_ns();
+        for (size_t r = 0; r < rounds; r++) {
+            small_vector_int vector;
+            small_vector_int_init(&vector);
+            for (int i = 0; i < length; i++)
+                small_vector_int_push_back(&vector, i);
+            sink += small_vector_int_at(&vector, length - 1);
+            small_vector_int_release(&vector, NULL);
+        }
+        double small = now_ns() - start;
+
+        printf("%d,vector,%.2f\n", length, heap / rounds);
+        printf("%d,small_vector,%.2f\n", length, small / rounds);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/* File: static_tree_bench.c */
+/* Lookups in the static Eytzinger tree, one by one and in batches, against the binary search of a sorted vector and
+   the red black tree, for every number of keys given on the command line */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../modules/StaticTree/static_tree.h"
+#include "../modules/Vector/vector.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+
+
+#define UNSIGNED_LESS(a, b) ((a) < (b))
+
+DECLARE_STATIC_TREE(unsigned, UNSIGNED_LESS)
+DECLARE_VECTOR_ALL(unsigned)
+DECLARE_VECTOR_ORDERED(unsigned, UNSIGNED_LESS)
+
+
+// The lookups are capped, so that the largest trees are measured in about the time which it takes to build them
+#define MAX_LOOKUPS 10000000
+
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static int compare_unsigned(void *a, void *b) {
+    unsigned x = *(unsigned *)a, y = *(unsigned *)b;
+    return (x > y) - (x < y);
+}
+
+
+static void report(const char *container, const char *operation, size_t n, size_t ops, double ns) {
+    printf("%s,%s,%zu,%.2f\n", container, operation, n, ns / ops);
+}
+
+
+static size_t random_index(size_t n) {
+    return ((size_t)rand() * RAND_MAX + rand()) % n;
+}
+
+
+static void run(size_t n) {
+    // The keys are the even numbers below 2n and half of the lookups are odd numbers, which are not in the trees
+    size_t lookups_count = n < MAX_LOOKUPS ? n : MAX_LOOKUPS;
+    unsigned *sorted = malloc(n * sizeof(unsigned));
+    unsigned *lookups = malloc(lookups_count * sizeof(unsigned));
+    const unsigned **results = malloc(lookups_count * sizeof(unsigned *));
+    void **sorted_items = malloc(n * sizeof(void *));
+    if (sorted == NULL || lookups == NULL || results == NULL || sorted_items == NULL) {
+        fprintf(stderr, "Not enough memory for %zu keys\n", n);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = (unsigned)(2 * i);
+        sorted_items[i] = &sorted[i];
+    }
+    srand(42);
+    for (size_t i = 0; i < lookups_count; i++)
+        lookups[i] = (unsigned)(2 * random_index(n) + (i & 1));
+    volatile size_t found = 0;
+
+    double start = now_ns();
+    static_tree_unsigned *tree = static_tree_unsigned_build(sorted, n);
+    report("static_tree", "build", n, n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < lookups_count; i++)
+        found += static_tree_unsigned_contains(tree, lookups[i]);
+    report("static_tree", "lookup", n, lookups_count, now_ns() - start);
+    start = now_ns();
+    static_tree_unsigned_search_batch(tree, lookups, lookups_count, results);
+    for (size_t i = 0; i < lookups_count; i++)
+        found += results[i] != NULL;
+    report("static_tree", "lookup_batch", n, lookups_count, now_ns() - start);
+    static_tree_unsigned_free(tree);
+
+    vector_unsigned vector = {sorted, n, n};
+    start = now_ns();
+    for (size_t i = 0; i < lookups_count; i++)
+        found += vector_unsigned_binary_search(&vector, lookups[i]) >= 0;
+    report("vector", "lookup", n, lookups_count, now_ns() - start);
+
+    start = now_ns();
+    RBTree root = RBT_build_sorted(sorted_items, n, compare_unsigned);
+    report("rbt", "build", n, n, now_ns() - start);
+    start = now_ns();
+    for (size_t i = 0; i < lookups_count; i++)
+        found += RBT_search(root, &lookups[i], compare_unsigned);
+    report("rbt", "lookup", n, lookups_count, now_ns() - start);
+    RBT_destroy(root, NULL);
+
+    free(sorted);
+    free(lookups);
+    free(results);
+    free(sorted_items);
+}
+
+
+int main(int argc, char *argv[]) {
+    printf("container,operation,items,ns_per_op\n");
+    if (argc == 1)
+        run(1000000);
+    for (int i = 1; i < argc; i++)
+        run((size_t)strtod(argv[i], NULL));
+    return 0;
+}
@@ -0,0 +1,99 @@
+/* File: vector_parallel_bench.c */
+/* Benchmark of the parallel vector operations for 1, 2, 4, ... threads up to the number of online processors. */
+/* The speedup is measured against vector_TYPE_sort and a sequential loop over the items */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../modules/Vector/vector_parallel.h"
+
+
+DECLARE_VECTOR_ALL(int)
+DECLARE_VECTOR_PARALLEL(int)
+
+
+static int compare_int(const int *a, const int *b) {
+    return (*a > *b) - (*a < *b);
+}
+
+static void scale_int(int *item) {
+    *item = *item * 3 + 1;
+}
+
+static int add_ints(int a, int b) {
+    return a + b;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill(vector_int *vector, int *input, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        vector_int_set_at(vector, i, input[i]);
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t n = 10000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+    unsigned int max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    int *input = malloc(n * sizeof(int));
+    srand(42);
+    for (size_t i = 0; i < n; i++)
+        input[i] = rand();
+    vector_int *vector = vector_int_create(n);
+    for (size_t i = 0; i < n; i++)
+        vector_int_push_back(vector, input[i]);
+
+    // Sequential baselines
+    double start = now_ns();
+    vector_int_sort(vector, compare_int);
+    double sort_base = now_ns() - start;
+
+    start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        scale_int(&vector->array[i]);
+    double for_each_base = now_ns() - start;
+
+    start = now_ns();
+    volatile int sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum = add_ints(sum, vector->array[i]);
+    double reduce_base = now_ns() - start;
+
+    printf("operation,size,threads,ms,speedup\n");
+    for (unsigned int threads = 1; ; threads = (threads * 2 > max_threads && threads < max_threads) ? max_threads : threads * 2) {
+        ThreadPool pool = threadpool_create(threads);
+
+        fill(vector, input, n);
+        start = now_ns();
+        vector_int_parallel_sort(vector, compare_int, pool);
+        double sort_time = now_ns() - start;
+
+        start = now_ns();
+        vector_int_parallel_for_each(vector, scale_int, pool);
+        double for_each_time = now_ns() - start;
+
+        start = now_ns();
+        sum = vector_int_parallel_reduce(vector, 0, add_ints, pool);
+        double reduce_time = now_ns() - start;
+
+        printf("sort,%zu,%u,%.2f,%.2f\n", n, threads, sort_time / 1e6, sort_base / sort_time);
+        printf("for_each,%zu,%u,%.2f,%.2f\n", n, threads, for_each_time / 1e6, for_each_base / for_each_time);
+        printf("reduce,%zu,%u,%.2f,%.2f\n", n, threads, reduce_time / 1e6, reduce_base / reduce_time);
+
+        threadpool_destroy(pool);
+        if (threads >= max_threads)
+            break;
+    }
+
+    vector_int_free(vector, NULL);
+    free(input);
+    return 0;
+}
@@ -0,0 +1,83 @@
+/* File: vector_search_bench.c */
+/* Benchmark of the vectorized vector_TYPE_find against vector_TYPE_search which calls a compare function */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../modules/Vector/vector.h"
+
+
+DECLARE_VECTOR_ALL(unsigned)
+DECLARE_VECTOR_PRIMITIVE(unsigned, U32)
+DECLARE_VECTOR_ALL(double)
+DECLARE_VECTOR_PRIMITIVE(double, F64)
+
+
+static int compare_unsigned(const unsigned *a, const unsigned *b) {
+    return (*a > *b) - (*a < *b);
+}
+
+static int compare_double(const double *a, const double *b) {
+    return (*a > *b) - (*a < *b);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t sizes[] = {1000, 100000, 10000000};
+    int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    if (argc > 1) {
+        sizes[0] = strtoul(argv[1], NULL, 10);
+        num_sizes = 1;
+    }
+
+    printf("type,size,algorithm,ns_per_item\n");
+    for (int s = 0; s < num_sizes; s++) {
+        size_t n = sizes[s];
+        // Search a missing item, so every search scans the whole vector
+        int repeats = n < 1000000 ? 10000000 / n : 1;
+        vector_unsigned *vector_u = vector_unsigned_create(n);
+        vector_double *vector_d = vector_double_create(n);
+        for (size_t i = 0; i < n; i++) {
+            vector_unsigned_push_back(vector_u, i);
+            vector_double_push_back(vector_d, i);
+        }
+
+        volatile int sink = 0;
+        double start = now_ns();
+        for (int r = 0; r < repeats; r++)
+            sink += vector_unsigned_search(vector_u, n, compare_unsigned);
+        double search_u = now_ns() - start;
+
+        start = now_ns();
+        for (int r = 0; r < repeats; r++)
+            sink += vector_unsigned_find(vector_u, n);
+        double find_u = now_ns() - start;
+
+        start = now_ns();
+        for (int r = 0; r < repeats; r++)
+            sink += vector_double_search(vector_d, -1.0, compare_double);
+        double search_d = now_ns() - start;
+
+        start = now_ns();
+        for (int r = 0; r < repeats; r++)
+            sink += vector_double_find(vector_d, -1.0);
+        double find_d = now_ns() - start;
+        (void)sink;
+
+        double items = (double)n * repeats;
+        printf("unsigned,%zu,vector_search,%.3f\n", n, search_u / items);
+        printf("unsigned,%zu,vector_find,%.3f\n", n, find_u / items);
+        printf("double,%zu,vector_search,%.3f\n", n, search_d / items);
+        printf("double,%zu,vector_find,%.3f\n", n, find_d / items);
+
+        vector_unsigned_free(vector_u, NULL);
+        vector_double_free(vector_d, NULL);
+    }
+    return 0;
+}
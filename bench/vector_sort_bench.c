@@ -0,0 +1,128 @@
+/* File: vector_sort_bench.c */
+/* Benchmark of vector_TYPE_sort (pdqsort), vector_TYPE_sort_inline and vector_TYPE_radix_sort against the qsort */
+/* of the C library on several input distributions */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../modules/Vector/vector.h"
+
+
+#define INT_LESS(a, b) ((a) < (b))
+#define DOUBLE_LESS(a, b) ((a) < (b))
+
+DECLARE_VECTOR_ALL(int)
+DECLARE_VECTOR_ORDERED(int, INT_LESS)
+DECLARE_VECTOR_PRIMITIVE(int, I32)
+DECLARE_VECTOR_ALL(double)
+DECLARE_VECTOR_ORDERED(double, DOUBLE_LESS)
+DECLARE_VECTOR_PRIMITIVE(double, F64)
+
+
+static int compare_int(const int *a, const int *b) {
+    return (*a > *b) - (*a < *b);
+}
+
+static int compare_double(const double *a, const double *b) {
+    return (*a > *b) - (*a < *b);
+}
+
+static int qsort_compare_int(const void *a, const void *b) {
+    return compare_int(a, b);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static const char *distributions[] = {"random", "sorted", "reversed", "sawtooth", "few_unique"};
+
+static void fill(int *array, size_t n, int distribution) {
+    for (size_t i = 0; i < n; i++) {
+        switch (distribution) {
+            case 0: array[i] = rand(); break;
+            case 1: array[i] = i; break;
+            case 2: array[i] = n - i; break;
+            case 3: array[i] = i % 1000; break;
+            default: array[i] = rand() % 16; break;
+        }
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t sizes[] = {1000, 100000, 10000000};
+    int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    if (argc > 1) {
+        sizes[0] = strtoul(argv[1], NULL, 10);
+        num_sizes = 1;
+    }
+
+    printf("distribution,size,algorithm,ns_per_item\n");
+    for (int s = 0; s < num_sizes; s++) {
+        size_t n = sizes[s];
+        int *input = malloc(n * sizeof(int));
+        vector_int *vector = vector_int_create(n);
+        vector_double *vector_double = vector_double_create(n);
+        for (int d = 0; d < (int)(sizeof(distributions) / sizeof(distributions[0])); d++) {
+            srand(42);
+            fill(input, n, d);
+
+            memcpy(vector->array, input, n * sizeof(int));
+            vector->size = n;
+            double start = now_ns();
+            vector_int_sort(vector, compare_int);
+            double pdq = now_ns() - start;
+
+            memcpy(vector->array, input, n * sizeof(int));
+            start = now_ns();
+            vector_int_sort_inline(vector);
+            double pdq_inline = now_ns() - start;
+
+            memcpy(vector->array, input, n * sizeof(int));
+            start = now_ns();
+            vector_int_radix_sort(vector);
+            double radix = now_ns() - start;
+
+            memcpy(vector->array, input, n * sizeof(int));
+            start = now_ns();
+            qsort(vector->array, n, sizeof(int), qsort_compare_int);
+            double libc = now_ns() - start;
+
+            for (size_t i = 0; i < n; i++)
+                vector_double->array[i] = input[i] * 0.5;
+            vector_double->size = n;
+            start = now_ns();
+            vector_double_sort(vector_double, compare_double);
+            double pdq_double = now_ns() - start;
+
+            for (size_t i = 0; i < n; i++)
+                vector_double->array[i] = input[i] * 0.5;
+            start = now_ns();
+            vector_double_sort_inline(vector_double);
+            double pdq_inline_double = now_ns() - start;
+
+            for (size_t i = 0; i < n; i++)
+                vector_double->array[i] = input[i] * 0.5;
+            start = now_ns();
+            vector_double_radix_sort(vector_double);
+            double radix_double = now_ns() - start;
+
+            printf("%s,%zu,vector_int_sort,%.2f\n", distributions[d], n, pdq / n);
+            printf("%s,%zu,vector_int_sort_inline,%.2f\n", distributions[d], n, pdq_inline / n);
+            printf("%s,%zu,vector_int_radix_sort,%.2f\n", distributions[d], n, radix / n);
+            printf("%s,%zu,qsort_int,%.2f\n", distributions[d], n, libc / n);
+            printf("%s,%zu,vector_double_sort,%.2f\n", distributions[d], n, pdq_double / n);
+            printf("%s,%zu,vector_double_sort_inline,%.2f\n", distributions[d], n, pdq_inline_double / n);
+            printf("%s,%zu,vector_double_radix_sort,%.2f\n", distributions[d], n, radix_double / n);
+        }
+        vector_int_free(vector, NULL);
+        vector_double_free(vector_double, NULL);
+        free(input);
+    }
+    return 0;
+}
@@ -2,8 +2,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include "AVLTree.h"
-#define MAX(A, B) ((A) > (B)) ? (A) : (B)
+#define MAX(A, B) (((A) > (B)) ? (A) : (B))
 
 struct avl_node {
     void *data;
@@ -19,105 +21,85 @@ static AVLTree avl_right_rotate(AVLTree y);
 static AVLTree avl_left_rotate(AVLTree x);
 static int avl_balance(AVLTree node);
 static int avl_height(AVLTree avl);
+static AVLTree avl_build(void **items, size_t count);
+static AVLTree avl_join_right(AVLTree left, AVLTree node, AVLTree right);
+static void avl_fix_path(AVLTree **path, int depth);
+static AVLTree avl_rebalance(AVLTree avl);
+static AVLTree avl_join_left(AVLTree left, AVLTree node, AVLTree right);
 
 
-// Function to insert a node in an AVL tree
-AVLTree AVLTree_insert(AVLTree node, void *data, CompareFunc compare) {
-    assert(compare != NULL);
-    if(node == NULL)
-        // Found the place to insert the node
-        return avl_create_node(data);
-    if(compare(data, node->data) > 0)
-        // The data we want to insert is greater than
-        // current node's data, so we should look for it
-        // in the right subtree of the node
-        node->right = AVLTree_insert(node->right, data, compare);
-    else if(compare(data, node->data) < 0)
-        // The data we want to insert is smaller than
-        // current node's data, so we should look for it
-        // in the left subtree of the node
-        node->left = AVLTree_insert(node->left, data, compare);
-    else
-        // Found node with the same data, just return it
-        return node;
-    // Update node's height
-    node->height = 1 + MAX(avl_height(node->right), avl_height(node->left));
-    // Get balance of the node (it is valid that |Balance| <= 1)
-    int balance = avl_balance(node);
-    // Fix the balance of the avl tree by rotating the nodes that have wrong balance
-    
-    // There are 4 cases
-    if(balance > 1 && compare(data, node->left->data) < 0)
-        // Left-Left case
-        return avl_right_rotate(node);
-    else if(balance > 1 && compare(data, node->left->data) > 0) {
-        // Left-Right case
-        node->left = avl_left_rotate(node->left);
-        return avl_right_rotate(node);
-    }
-    else if(balance < -1 && compare(data, node->right->data) > 0)
-        // Right-Right Case
-        return avl_left_rotate(node);
-    else if(balance < -1 && compare(data, node->right->data) < 0) {
-        // Right-Left Case
-        node->right = avl_right_rotate(node->right);
-        return avl_left_rotate(node);
-    }
-    return node;
-}
+// Instrumentation counters are compiled in only when the library is built with -DDS_STATS
+// They are shared by all the AVL trees, because a tree is just a pointer to its root
+// The counters are atomic, because the parallel set operations update them from the threads of their pool
+#ifdef DS_STATS
+static struct {
+    atomic_size_t compares;
+    atomic_size_t rotations;
+    atomic_size_t bytes_allocated;
+} stats;
+#define AVL_STATS_ADD(counter, n) atomic_fetch_add_explicit(&stats.counter, (n), memory_order_relaxed)
+#define AVL_STATS_SUB(counter, n) atomic_fetch_sub_explicit(&stats.counter, (n), memory_order_relaxed)
+#else
+#define AVL_STATS_ADD(counter, n)
+#define AVL_STATS_SUB(counter, n)
+#endif
 
-// Helper function to find the node with the maximum value in an AVL tree
-static AVLTree AVLTree_max_node(AVLTree avl) {
-    if (avl == NULL)
-        return NULL;
 
-    while (avl->right != NULL)
-        avl = avl->right;
+// Allocator of the nodes of all the AVL trees (zeroed means malloc and free)
+static Allocator allocator;
 
-    return avl;
+
+// Set the allocator of the nodes of all the AVL trees (NULL restores malloc and free)
+void AVLTree_set_allocator(const Allocator *new_allocator) {
+    allocator = new_allocator != NULL ? *new_allocator : (Allocator){0};
 }
 
-AVLTree AVLTree_delete(AVLTree avl, void *data, CompareFunc compare, DestroyFunc destroy) {
-    if (avl == NULL)
-        return NULL;
 
-    if (compare(data, avl->data) < 0)
-        avl->left = AVLTree_delete(avl->left, data, compare, destroy);
-    else if (compare(data, avl->data) > 0)
-        avl->right = AVLTree_delete(avl->right, data, compare, destroy);
-    else {
-        if ((avl->left == NULL) || (avl->right == NULL)) {
-            AVLTree temp = avl->left ? avl->left : avl->right;
-
-            if (temp == NULL) {
-                // No child case
-                if (destroy)
-                    destroy(avl->data);
-                free(avl);
-                avl = NULL;
-            } else {
-                // One child case
-                if (destroy)
-                    destroy(avl->data);
-                *avl = *temp;
-                free(temp);
-            }
-        } else {
-            // node with two children: Get the inorder predecessor (the maximum value in the left subtree)
-            AVLTree tempNode = AVLTree_max_node(avl->left);
+// Call the compare function of the tree
+static inline int avl_compare(CompareFunc compare, void *data1, void *data2) {
+    AVL_STATS_ADD(compares, 1);
+    return compare(data1, data2);
+}
 
-            // Swap the data between avl and tempNode
-            void *tempData = avl->data;
-            avl->data = tempNode->data;
-            tempNode->data = tempData;
 
-            avl->left = AVLTree_delete(avl->left, data, compare, destroy);
-        }
+// Function to insert a node in an AVL tree
+// The place of the new node is found top-down, remembering the links (the pointers to the child pointers) on the path
+// from the root, and the path is then walked back up to update the heights and fix the balance
+AVLTree AVLTree_insert(AVLTree avl, void *data, CompareFunc compare) {
+    assert(compare != NULL);
+    AVLTree *path[AVLTREE_MAX_HEIGHT];
+    int depth = 0;
+    AVLTree *link = &avl;
+    while(*link != NULL) {
+        int result = avl_compare(compare, data, (*link)->data);
+        if(result == 0)
+            // Found node with the same data, so the tree does not change
+            return avl;
+        path[depth++] = link;
+        link = result < 0 ? &(*link)->left : &(*link)->right;
+    }
+    // Found the place to insert the node
+    *link = avl_create_node(data);
+    avl_fix_path(path, depth);
+    return avl;
+}
+
+
+// Update the heights and fix the balance of the nodes of a path, from the bottom up. Once a subtree keeps its height
+// the nodes above it do not change, so the walk stops there
+static void avl_fix_path(AVLTree **path, int depth) {
+    while(depth > 0) {
+        AVLTree *link = path[--depth];
+        int height = (*link)->height;
+        *link = avl_rebalance(*link);
+        if((*link)->height == height)
+            break;
     }
+}
 
-    if (avl == NULL)
-        return NULL;
 
+// Update the height of a node whose subtrees are balanced, and rotate it if its balance is wrong
+static AVLTree avl_rebalance(AVLTree avl) {
     // Update node's height
     avl->height = 1 + MAX(avl_height(avl->right), avl_height(avl->left));
 
@@ -144,18 +126,82 @@ AVLTree AVLTree_delete(AVLTree avl, void *data, CompareFunc compare, DestroyFunc
     return avl;
 }
 
+// Build a perfectly balanced AVL tree from sorted items
+AVLTree AVLTree_build_sorted(void **items, size_t count, CompareFunc compare) {
+    assert(compare != NULL);
+    for (size_t i = 1; i < count; i++)
+        if (avl_compare(compare, items[i - 1], items[i]) >= 0)
+            return NULL;
+    return avl_build(items, count);
+}
+
+
+// Make the middle item the root and build its subtrees from the two halves. The sizes of the two subtrees differ by
+// at most one, so the heights of every node's children differ by at most one too and no rotation is needed. The nodes
+// are allocated in preorder, so a parent is usually next to its left child in memory
+static AVLTree avl_build(void **items, size_t count) {
+    if (count == 0)
+        return NULL;
+    size_t middle = count / 2;
+    AVLTree node = avl_create_node(items[middle]);
+    node->left = avl_build(items, middle);
+    node->right = avl_build(items + middle + 1, count - middle - 1);
+    node->height = 1 + MAX(avl_height(node->left), avl_height(node->right));
+    return node;
+}
+
+
+// Remove given item (if it exists) from the AVL tree and return the new root
+AVLTree AVLTree_delete(AVLTree avl, void *data, CompareFunc compare, DestroyFunc destroy) {
+    assert(compare != NULL);
+    AVLTree *path[AVLTREE_MAX_HEIGHT];
+    int depth = 0;
+    AVLTree *link = &avl;
+    while(*link != NULL) {
+        int result = avl_compare(compare, data, (*link)->data);
+        if(result == 0)
+            break;
+        path[depth++] = link;
+        link = result < 0 ? &(*link)->left : &(*link)->right;
+    }
+    if(*link == NULL)
+        return avl;
+
+    AVLTree node = *link;
+    if(destroy)
+        destroy(node->data);
+    if(node->left != NULL && node->right != NULL) {
+        // node with two children: it takes the data of its inorder predecessor (the maximum value in the left
+        // subtree), whose node is removed instead
+        path[depth++] = link;
+        link = &node->left;
+        while((*link)->right != NULL) {
+            path[depth++] = link;
+            link = &(*link)->right;
+        }
+        node->data = (*link)->data;
+        node = *link;
+    }
+    // The removed node has at most one child, which takes its place
+    *link = node->left != NULL ? node->left : node->right;
+    allocator_free(&allocator, node, sizeof(*node));
+    AVL_STATS_SUB(bytes_allocated, sizeof(struct avl_node));
+
+    avl_fix_path(path, depth);
+    return avl;
+}
+
 
 // Search given data in the AVL tree and returns a corresponding boolean value if it finds it or not
 bool AVLTree_search(AVLTree avl, void *data, CompareFunc compare) {
     assert(compare != NULL);
-    if(avl == NULL)
-        return false;
-    else if(compare(avl->data, data) == 0)
-        return true;
-    else if(compare(avl->data, data) > 0)
-        return AVLTree_search(avl->left, data, compare);
-    else
-        return AVLTree_search(avl->right, data, compare);
+    while(avl != NULL) {
+        int result = avl_compare(compare, data, avl->data);
+        if(result == 0)
+            return true;
+        avl = result < 0 ? avl->left : avl->right;
+    }
+    return false;
 }
 
 
@@ -207,6 +253,130 @@ void *AVLTree_select_k_th_item(AVLTree avl, int k) {
 }
 
 
+// Move the iterator down to the leftmost (or the rightmost) node of a subtree
+static void avl_iterator_descend(AVLTreeIterator *it, AVLTree avl, bool leftmost) {
+    for(; avl != NULL; avl = leftmost ? avl->left : avl->right) {
+        assert(it->depth < AVLTREE_MAX_HEIGHT);
+        it->path[it->depth++] = avl;
+    }
+}
+
+
+// Set the iterator to the first item of the AVL tree
+void AVLTree_begin(AVLTree avl, AVLTreeIterator *it) {
+    it->root = avl;
+    it->depth = 0;
+    avl_iterator_descend(it, avl, true);
+}
+
+
+// Set the iterator to the end of the AVL tree
+void AVLTree_end(AVLTree avl, AVLTreeIterator *it) {
+    it->root = avl;
+    it->depth = 0;
+}
+
+
+// Set the iterator to the first item of the AVL tree which is not less than data
+void AVLTree_lower_bound(AVLTree avl, void *data, CompareFunc compare, AVLTreeIterator *it) {
+    assert(compare != NULL);
+    it->root = avl;
+    it->depth = 0;
+    // The path to the last node which is not less than data is a prefix of the search path
+    int found = 0;
+    while(avl != NULL) {
+        assert(it->depth < AVLTREE_MAX_HEIGHT);
+        it->path[it->depth++] = avl;
+        if(avl_compare(compare, avl->data, data) < 0)
+            avl = avl->right;
+        else {
+            found = it->depth;
+            avl = avl->left;
+        }
+    }
+    it->depth = found;
+}
+
+
+// Check if the iterator points to an item (and not to the end)
+bool AVLTree_iterator_valid(const AVLTreeIterator *it) {
+    return it->depth > 0;
+}
+
+
+// Returns the item of the iterator, or NULL at the end
+void *AVLTree_iterator_data(const AVLTreeIterator *it) {
+    return it->depth > 0 ? it->path[it->depth - 1]->data : NULL;
+}
+
+
+// Move the iterator to the next item
+void AVLTree_next(AVLTreeIterator *it) {
+    if(it->depth == 0)
+        return;
+    AVLTree node = it->path[it->depth - 1];
+    if(node->right != NULL) {
+        avl_iterator_descend(it, node->right, true);
+        return;
+    }
+    // Go up until the iterator leaves a left subtree (or the whole tree, which is the end)
+    do {
+        node = it->path[--it->depth];
+    } while(it->depth > 0 && it->path[it->depth - 1]->right == node);
+}
+
+
+// Move the iterator to the previous item. The end moves to the last item, and the first item moves to the end
+void AVLTree_prev(AVLTreeIterator *it) {
+    if(it->depth == 0) {
+        avl_iterator_descend(it, it->root, false);
+        return;
+    }
+    AVLTree node = it->path[it->depth - 1];
+    if(node->left != NULL) {
+        avl_iterator_descend(it, node->left, false);
+        return;
+    }
+    do {
+        node = it->path[--it->depth];
+    } while(it->depth > 0 && it->path[it->depth - 1]->left == node);
+}
+
+
+// Visit the items of [low, high) in order, until visit returns false
+size_t AVLTree_range(AVLTree avl, void *low, void *high, CompareFunc compare, AVLTreeRangeFunc visit, void *ctx) {
+    AVLTreeIterator it;
+    if(low != NULL)
+        AVLTree_lower_bound(avl, low, compare, &it);
+    else
+        AVLTree_begin(avl, &it);
+    size_t count = 0;
+    for(; AVLTree_iterator_valid(&it) ; AVLTree_next(&it)) {
+        void *data = AVLTree_iterator_data(&it);
+        if(high != NULL && avl_compare(compare, data, high) >= 0)
+            break;
+        count++;
+        if(!visit(data, ctx))
+            break;
+    }
+    return count;
+}
+
+
+// Copy up to capacity items which are less than high from the iterator, and move the iterator after them
+size_t AVLTree_range_batch(AVLTreeIterator *it, void *high, CompareFunc compare, void **items, size_t capacity) {
+    size_t count = 0;
+    while(count < capacity && AVLTree_iterator_valid(it)) {
+        void *data = AVLTree_iterator_data(it);
+        if(high != NULL && avl_compare(compare, data, high) >= 0)
+            break;
+        items[count++] = data;
+        AVLTree_next(it);
+    }
+    return count;
+}
+
+
 // Check if the AVL tree is empty
 bool AVLTree_empty(AVLTree avl) {
     return (avl == NULL) || (AVL_count_items(avl) == 0);
@@ -244,8 +414,9 @@ void *AVLTree_max_value(AVLTree avl) {
 // A function to create a new node
 // Height of node is initially 1, since the simple bst insertion, inserts the node as a leaf
 static AVLTree avl_create_node(void *data) {
-    AVLTree node = malloc(sizeof(*node));
+    AVLTree node = allocator_alloc(&allocator, sizeof(*node));
     assert(node != NULL);
+    AVL_STATS_ADD(bytes_allocated, sizeof(*node));
     node->data = data;
     node->left = node->right = NULL;
     node->height = 1;
@@ -265,6 +436,7 @@ static int avl_height(AVLTree avl) {
 static AVLTree avl_right_rotate(AVLTree y) {
     if(y->left == NULL)
         return y;
+    AVL_STATS_ADD(rotations, 1);
     AVLTree x = y->left;
     AVLTree T2 = x->right;
     x->right = y;
@@ -279,6 +451,7 @@ static AVLTree avl_right_rotate(AVLTree y) {
 static AVLTree avl_left_rotate(AVLTree x) {
     if(x->right == NULL)
         return x;
+    AVL_STATS_ADD(rotations, 1);
     AVLTree y = x->right;
     AVLTree T2 = y->left;
     y->left = x;
@@ -301,7 +474,677 @@ void AVLTree_destroy(AVLTree node, DestroyFunc destroy) {
     if(node != NULL) {
         AVLTree_destroy(node->left, destroy);
         AVLTree_destroy(node->right, destroy);
+        if(destroy)
+            destroy(node->data);
+        allocator_free(&allocator, node, sizeof(*node));
+        AVL_STATS_SUB(bytes_allocated, sizeof(struct avl_node));
+    }
+}
+
+
+// Join two subtrees and a node whose item is between their items. The subtree with the greater height is descended
+// until a subtree of about the height of the other one is found, so it takes O(|height(left) - height(right)| + 1)
+static AVLTree avl_join(AVLTree left, AVLTree node, AVLTree right) {
+    if(avl_height(left) > avl_height(right) + 1)
+        return avl_join_right(left, node, right);
+    if(avl_height(right) > avl_height(left) + 1)
+        return avl_join_left(left, node, right);
+    node->left = left;
+    node->right = right;
+    node->height = 1 + MAX(avl_height(left), avl_height(right));
+    return node;
+}
+
+
+// Join when the left subtree is higher: descend its right spine
+static AVLTree avl_join_right(AVLTree left, AVLTree node, AVLTree right) {
+    AVLTree child = left->right;
+    if(avl_height(child) <= avl_height(right) + 1) {
+        node->left = child;
+        node->right = right;
+        node->height = 1 + MAX(avl_height(child), avl_height(right));
+        if(node->height <= avl_height(left->left) + 1) {
+            left->right = node;
+            left->height = 1 + MAX(avl_height(left->left), avl_height(left->right));
+            return left;
+        }
+        // Right-Left case
+        left->right = avl_right_rotate(node);
+        return avl_left_rotate(left);
+    }
+    left->right = avl_join_right(child, node, right);
+    left->height = 1 + MAX(avl_height(left->left), avl_height(left->right));
+    if(avl_height(left->right) <= avl_height(left->left) + 1)
+        return left;
+    // Right-Right case
+    return avl_left_rotate(left);
+}
+
+
+// Join when the right subtree is higher: descend its left spine
+static AVLTree avl_join_left(AVLTree left, AVLTree node, AVLTree right) {
+    AVLTree child = right->left;
+    if(avl_height(child) <= avl_height(left) + 1) {
+        node->left = left;
+        node->right = child;
+        node->height = 1 + MAX(avl_height(left), avl_height(child));
+        if(node->height <= avl_height(right->right) + 1) {
+            right->left = node;
+            right->height = 1 + MAX(avl_height(right->left), avl_height(right->right));
+            return right;
+        }
+        // Left-Right case
+        right->left = avl_left_rotate(node);
+        return avl_right_rotate(right);
+    }
+    right->left = avl_join_left(left, node, child);
+    right->height = 1 + MAX(avl_height(right->left), avl_height(right->right));
+    if(avl_height(right->left) <= avl_height(right->right) + 1)
+        return right;
+    // Left-Left case
+    return avl_right_rotate(right);
+}
+
+
+// Split a subtree into the items which are less and greater than data, and return the node which holds data (or NULL)
+static AVLTree avl_split(AVLTree avl, void *data, CompareFunc compare, AVLTree *left, AVLTree *right) {
+    if(avl == NULL) {
+        *left = *right = NULL;
+        return NULL;
+    }
+    int result = avl_compare(compare, data, avl->data);
+    if(result == 0) {
+        *left = avl->left;
+        *right = avl->right;
+        avl->left = avl->right = NULL;
+        return avl;
+    }
+    AVLTree found;
+    if(result < 0) {
+        AVLTree greater;
+        found = avl_split(avl->left, data, compare, left, &greater);
+        *right = avl_join(greater, avl, avl->right);
+    }
+    else {
+        AVLTree less;
+        found = avl_split(avl->right, data, compare, &less, right);
+        *left = avl_join(avl->left, avl, less);
+    }
+    return found;
+}
+
+
+// Remove the node with the greatest item of a non empty subtree and return it
+static AVLTree avl_split_last(AVLTree avl, AVLTree *rest) {
+    if(avl->right == NULL) {
+        *rest = avl->left;
+        avl->left = NULL;
+        return avl;
+    }
+    AVLTree rest_right;
+    AVLTree last = avl_split_last(avl->right, &rest_right);
+    *rest = avl_join(avl->left, avl, rest_right);
+    return last;
+}
+
+
+// Join two subtrees whose items are all less (left) and all greater (right) than each other
+static AVLTree avl_join2(AVLTree left, AVLTree right) {
+    if(left == NULL)
+        return right;
+    AVLTree rest;
+    AVLTree last = avl_split_last(left, &rest);
+    return avl_join(rest, last, right);
+}
+
+
+// Free a node which is dropped by a set operation and destroy its item
+static void avl_free_node(AVLTree node, DestroyFunc destroy) {
+    if(node == NULL)
+        return;
+    if(destroy)
         destroy(node->data);
-        free(node);
+    allocator_free(&allocator, node, sizeof(*node));
+    AVL_STATS_SUB(bytes_allocated, sizeof(struct avl_node));
+}
+
+
+// Join two AVL trees and an item which is greater than every item of left and less than every item of right
+AVLTree AVLTree_join(AVLTree left, void *data, AVLTree right) {
+    return avl_join(left, avl_create_node(data), right);
+}
+
+
+// Split the AVL tree into the items which are less and the items which are greater than data
+void *AVLTree_split(AVLTree avl, void *data, CompareFunc compare, AVLTree *left, AVLTree *right) {
+    assert(compare != NULL);
+    AVLTree found = avl_split(avl, data, compare, left, right);
+    if(found == NULL)
+        return NULL;
+    void *found_data = found->data;
+    avl_free_node(found, NULL);
+    return found_data;
+}
+
+
+// A set operation is divided by splitting one tree with the root item of the other one, so the two halves of the
+// problem are independent. It needs O(m log(n/m + 1)) compares, where m and n are the sizes of the smaller and the
+// larger tree
+typedef enum { AVL_UNION, AVL_INTERSECTION, AVL_DIFFERENCE } AVLSetOperation;
+
+// A set operation after it has been divided: the two halves and the nodes which are combined with their results
+typedef struct {
+    AVLTree left1, left2;   // The halves of the two trees with the smaller items
+    AVLTree right1, right2; // The halves of the two trees with the greater items
+    AVLTree root;           // The root whose item divided the operation
+    AVLTree found;          // The node of the other tree with the same item (or NULL)
+} AVLSetSplit;
+
+
+// Divide a set operation of two non empty trees
+static AVLSetSplit avl_set_divide(AVLSetOperation operation, AVLTree avl1, AVLTree avl2, CompareFunc compare) {
+    AVLSetSplit split;
+    if(operation == AVL_DIFFERENCE) {
+        // The items of avl2 are removed from avl1, so avl1 is split with the root of avl2
+        split.root = avl2;
+        split.found = avl_split(avl1, avl2->data, compare, &split.left1, &split.right1);
+        split.left2 = avl2->left;
+        split.right2 = avl2->right;
+    }
+    else {
+        split.root = avl1;
+        split.found = avl_split(avl2, avl1->data, compare, &split.left2, &split.right2);
+        split.left1 = avl1->left;
+        split.right1 = avl1->right;
+    }
+    split.root->left = split.root->right = NULL;
+    return split;
+}
+
+
+// Combine the results of the two halves of a set operation
+static AVLTree avl_set_combine(AVLSetOperation operation, AVLSetSplit *split, AVLTree left, AVLTree right,
+                               DestroyFunc destroy) {
+    switch(operation) {
+        case AVL_UNION:
+            // The item of avl1 is kept
+            avl_free_node(split->found, destroy);
+            return avl_join(left, split->root, right);
+        case AVL_INTERSECTION:
+            if(split->found != NULL) {
+                avl_free_node(split->found, destroy);
+                return avl_join(left, split->root, right);
+            }
+            avl_free_node(split->root, destroy);
+            return avl_join2(left, right);
+        default:
+            avl_free_node(split->found, destroy);
+            avl_free_node(split->root, destroy);
+            return avl_join2(left, right);
+    }
+}
+
+
+// Set operation when at least one of the trees is empty
+static AVLTree avl_set_base(AVLSetOperation operation, AVLTree avl1, AVLTree avl2, DestroyFunc destroy) {
+    if(operation == AVL_UNION)
+        return avl1 != NULL ? avl1 : avl2;
+    if(operation == AVL_DIFFERENCE && avl2 == NULL)
+        return avl1;
+    AVLTree_destroy(avl1, destroy);
+    AVLTree_destroy(avl2, destroy);
+    return NULL;
+}
+
+
+static AVLTree avl_set_operation(AVLSetOperation operation, AVLTree avl1, AVLTree avl2, CompareFunc compare,
+                                 DestroyFunc destroy) {
+    if(avl1 == NULL || avl2 == NULL)
+        return avl_set_base(operation, avl1, avl2, destroy);
+    AVLSetSplit split = avl_set_divide(operation, avl1, avl2, compare);
+    AVLTree left = avl_set_operation(operation, split.left1, split.left2, compare, destroy);
+    AVLTree right = avl_set_operation(operation, split.right1, split.right2, compare, destroy);
+    return avl_set_combine(operation, &split, left, right, destroy);
+}
+
+
+// A part of a set operation which is executed by a thread of the pool
+typedef struct {
+    AVLSetOperation operation;
+    AVLTree avl1, avl2, result;
+    CompareFunc compare;
+    DestroyFunc destroy;
+} AVLSetTask;
+
+static void avl_set_task_run(void *arg) {
+    AVLSetTask *task = arg;
+    task->result = avl_set_operation(task->operation, task->avl1, task->avl2, task->compare, task->destroy);
+}
+
+
+// Run a set operation on the threads of the pool (or sequentially if pool is NULL). The first levels of the recursion
+// are divided by the calling thread into about 4 parts per thread, which form a complete binary tree: part i is
+// divided into the parts 2i and 2i + 1. The parts of the last level run in parallel, and then the results are combined
+// bottom-up by the calling thread
+static AVLTree avl_set_operation_parallel(AVLSetOperation operation, AVLTree avl1, AVLTree avl2, CompareFunc compare,
+                                          DestroyFunc destroy, ThreadPool pool) {
+    assert(compare != NULL);
+    if(pool == NULL || avl1 == NULL || avl2 == NULL)
+        return avl_set_operation(operation, avl1, avl2, compare, destroy);
+    size_t parts = 1;
+    while(parts < 4 * (size_t)threadpool_size(pool))
+        parts *= 2;
+    AVLSetSplit *splits = malloc(parts * sizeof(AVLSetSplit));
+    AVLSetTask *tasks = malloc(2 * parts * sizeof(AVLSetTask));
+    assert(splits != NULL && tasks != NULL);
+    tasks[1] = (AVLSetTask){ operation, avl1, avl2, NULL, compare, destroy };
+    for(size_t i = 1; i < parts; i++) {
+        tasks[2 * i] = tasks[2 * i + 1] = tasks[i];
+        if(tasks[i].avl1 == NULL || tasks[i].avl2 == NULL) {
+            // Nothing to divide, so the left part does the whole operation and the right part is empty
+            splits[i].root = NULL;
+            tasks[2 * i + 1].avl1 = tasks[2 * i + 1].avl2 = NULL;
+            continue;
+        }
+        splits[i] = avl_set_divide(operation, tasks[i].avl1, tasks[i].avl2, compare);
+        tasks[2 * i].avl1 = splits[i].left1;
+        tasks[2 * i].avl2 = splits[i].left2;
+        tasks[2 * i + 1].avl1 = splits[i].right1;
+        tasks[2 * i + 1].avl2 = splits[i].right2;
+    }
+    for(size_t i = parts; i < 2 * parts; i++)
+        threadpool_submit(pool, avl_set_task_run, &tasks[i]);
+    threadpool_wait(pool);
+    for(size_t i = parts - 1; i >= 1; i--) {
+        if(splits[i].root == NULL)
+            tasks[i].result = tasks[2 * i].result;
+        else
+            tasks[i].result = avl_set_combine(operation, &splits[i], tasks[2 * i].result, tasks[2 * i + 1].result, destroy);
+    }
+    AVLTree result = tasks[1].result;
+    free(splits);
+    free(tasks);
+    return result;
+}
+
+
+// Return the union of two AVL trees
+AVLTree AVLTree_union(AVLTree avl1, AVLTree avl2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool) {
+    return avl_set_operation_parallel(AVL_UNION, avl1, avl2, compare, destroy, pool);
+}
+
+
+// Return the intersection of two AVL trees
+AVLTree AVLTree_intersection(AVLTree avl1, AVLTree avl2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool) {
+    return avl_set_operation_parallel(AVL_INTERSECTION, avl1, avl2, compare, destroy, pool);
+}
+
+
+// Return the difference of two AVL trees
+AVLTree AVLTree_difference(AVLTree avl1, AVLTree avl2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool) {
+    return avl_set_operation_parallel(AVL_DIFFERENCE, avl1, avl2, compare, destroy, pool);
+}
+
+
+// Compact AVL trees. The nodes are stored in one array and linked by 31-bit indices, and the balance of a node is kept
+// in the top bits of its two links: the top bit of the link to the higher subtree is set. Index 0 is the empty subtree
+
+
+#define AVLC_HIGHER 0x80000000u
+#define AVLC_INDEX(link) ((link) & ~AVLC_HIGHER)
+#define AVLC_MAX_NODES 0x7fffffffu
+
+struct avl_compact_node {
+    void *data;
+    uint32_t left;
+    uint32_t right;
+};
+
+struct avl_compact {
+    struct avl_compact_node *nodes; // nodes[0] is never used, so that index 0 is the empty subtree
+    uint32_t capacity;              // Nodes of the array, including nodes[0]
+    uint32_t used;                  // Nodes which have been handed out, including nodes[0]
+    uint32_t free_list;             // Deleted nodes, linked by their left index
+    uint32_t root;
+    size_t size;
+    CompareFunc compare;
+};
+
+
+// Returns the node of an index
+#define AVLC_NODE(tree, index) (&(tree)->nodes[index])
+
+
+// The balance of a node: the height of its right subtree minus the height of its left subtree
+static inline int avlc_balance(struct avl_compact_node *node) {
+    return (node->right >> 31) - (node->left >> 31);
+}
+
+
+static inline void avlc_set_balance(struct avl_compact_node *node, int balance) {
+    node->left = AVLC_INDEX(node->left) | (balance < 0 ? AVLC_HIGHER : 0);
+    node->right = AVLC_INDEX(node->right) | (balance > 0 ? AVLC_HIGHER : 0);
+}
+
+
+// Returns the child of a node (0 is the left and 1 the right one)
+static inline uint32_t avlc_child(struct avl_compact_node *node, int dir) {
+    return AVLC_INDEX(dir ? node->right : node->left);
+}
+
+
+// Set the child of a node, keeping its balance
+static inline void avlc_set_child(struct avl_compact_node *node, int dir, uint32_t child) {
+    uint32_t *link = dir ? &node->right : &node->left;
+    *link = (*link & AVLC_HIGHER) | child;
+}
+
+
+// Create an empty compact AVL tree
+CompactAVLTree AVLTree_compact_create(CompareFunc compare) {
+    assert(compare != NULL);
+    CompactAVLTree tree = malloc(sizeof(*tree));
+    assert(tree != NULL);
+    tree->nodes = NULL;
+    tree->capacity = tree->used = 0;
+    tree->free_list = tree->root = 0;
+    tree->size = 0;
+    tree->compare = compare;
+    AVLTree_compact_reserve(tree, 16);
+    return tree;
+}
+
+
+// Make sure that the tree can hold at least capacity items without growing its array
+void AVLTree_compact_reserve(CompactAVLTree tree, size_t capacity) {
+    assert(capacity < AVLC_MAX_NODES);
+    if(capacity + 1 <= tree->capacity)
+        return;
+    struct avl_compact_node *nodes = realloc(tree->nodes, (capacity + 1) * sizeof(struct avl_compact_node));
+    assert(nodes != NULL);
+    AVL_STATS_ADD(bytes_allocated, (capacity + 1 - tree->capacity) * sizeof(struct avl_compact_node));
+    if(tree->capacity == 0)
+        nodes[0] = (struct avl_compact_node){ NULL, 0, 0 };
+    tree->nodes = nodes;
+    tree->capacity = (uint32_t)(capacity + 1);
+    if(tree->used == 0)
+        tree->used = 1;
+}
+
+
+// Hand out a node, reusing a deleted one first. The array may move, so no node pointer is valid after this
+static uint32_t avlc_alloc_node(CompactAVLTree tree, void *data) {
+    uint32_t index = tree->free_list;
+    if(index != 0)
+        tree->free_list = tree->nodes[index].left;
+    else {
+        if(tree->used == tree->capacity) {
+            size_t capacity = (size_t)tree->capacity * 2;
+            AVLTree_compact_reserve(tree, capacity < AVLC_MAX_NODES ? capacity : AVLC_MAX_NODES - 1);
+            assert(tree->used < tree->capacity);
+        }
+        index = tree->used++;
+    }
+    tree->nodes[index] = (struct avl_compact_node){ data, 0, 0 };
+    return index;
+}
+
+
+// Rotate the subtree of x towards dir (a left rotation when dir is 0) and return its new root. The balances are fixed
+// by the caller
+static uint32_t avlc_rotate(CompactAVLTree tree, uint32_t x, int dir) {
+    AVL_STATS_ADD(rotations, 1);
+    struct avl_compact_node *node = AVLC_NODE(tree, x);
+    uint32_t z = avlc_child(node, !dir);
+    struct avl_compact_node *child = AVLC_NODE(tree, z);
+    avlc_set_child(node, !dir, avlc_child(child, dir));
+    avlc_set_child(child, dir, x);
+    return z;
+}
+
+
+// Rebalance the subtree of x, whose !dir subtree is two levels higher than its dir subtree, and return its new root.
+// *shorter tells if the height of the subtree went down by one (it always does after an insert)
+static uint32_t avlc_rebalance(CompactAVLTree tree, uint32_t x, int dir, bool *shorter) {
+    int heavy = dir ? -1 : 1; // The balance of x towards its higher subtree
+    uint32_t z = avlc_child(AVLC_NODE(tree, x), !dir);
+    int z_balance = avlc_balance(AVLC_NODE(tree, z));
+    if(z_balance == -heavy) {
+        // Double rotation: the inner child y of z becomes the root
+        uint32_t y = avlc_child(AVLC_NODE(tree, z), dir);
+        int y_balance = avlc_balance(AVLC_NODE(tree, y));
+        avlc_set_child(AVLC_NODE(tree, x), !dir, avlc_rotate(tree, z, !dir));
+        avlc_rotate(tree, x, dir);
+        avlc_set_balance(AVLC_NODE(tree, x), y_balance == heavy ? -heavy : 0);
+        avlc_set_balance(AVLC_NODE(tree, z), y_balance == -heavy ? heavy : 0);
+        avlc_set_balance(AVLC_NODE(tree, y), 0);
+        *shorter = true;
+        return y;
+    }
+    avlc_rotate(tree, x, dir);
+    if(z_balance == 0) {
+        // Only after a delete: the height does not change
+        avlc_set_balance(AVLC_NODE(tree, x), heavy);
+        avlc_set_balance(AVLC_NODE(tree, z), -heavy);
+        *shorter = false;
+    }
+    else {
+        avlc_set_balance(AVLC_NODE(tree, x), 0);
+        avlc_set_balance(AVLC_NODE(tree, z), 0);
+        *shorter = true;
+    }
+    return z;
+}
+
+
+// Insert data into the tree. Returns false (and leaves the tree unchanged) if it is already in the tree
+bool AVLTree_compact_insert(CompactAVLTree tree, void *data) {
+    uint32_t path[AVLTREE_MAX_HEIGHT];
+    int dirs[AVLTREE_MAX_HEIGHT], depth = 0;
+    for(uint32_t index = tree->root ; index != 0 ; ) {
+        struct avl_compact_node *node = AVLC_NODE(tree, index);
+        int result = avl_compare(tree->compare, data, node->data);
+        if(result == 0)
+            return false;
+        path[depth] = index;
+        dirs[depth++] = result > 0;
+        index = avlc_child(node, result > 0);
+    }
+    uint32_t index = avlc_alloc_node(tree, data);
+    tree->size++;
+    if(depth == 0) {
+        tree->root = index;
+        return true;
+    }
+    avlc_set_child(AVLC_NODE(tree, path[depth - 1]), dirs[depth - 1], index);
+
+    // Walk up while the subtrees grow: a node which was balanced leans to the grown side, a node which leaned to the
+    // other side becomes balanced and the retracing stops, and a node which already leaned to it is rotated
+    for(int i = depth - 1 ; i >= 0 ; i--) {
+        struct avl_compact_node *node = AVLC_NODE(tree, path[i]);
+        int grown = dirs[i] ? 1 : -1, balance = avlc_balance(node);
+        if(balance == 0) {
+            avlc_set_balance(node, grown);
+            continue;
+        }
+        if(balance == -grown)
+            avlc_set_balance(node, 0);
+        else {
+            bool shorter;
+            uint32_t root = avlc_rebalance(tree, path[i], !dirs[i], &shorter);
+            if(i == 0)
+                tree->root = root;
+            else
+                avlc_set_child(AVLC_NODE(tree, path[i - 1]), dirs[i - 1], root);
+        }
+        break;
     }
+    return true;
+}
+
+
+// Delete data from the tree and destroy it (if destroy is not NULL). Returns true if data was in the tree
+bool AVLTree_compact_delete(CompactAVLTree tree, void *data, DestroyFunc destroy) {
+    uint32_t path[AVLTREE_MAX_HEIGHT];
+    int dirs[AVLTREE_MAX_HEIGHT], depth = 0;
+    uint32_t index = tree->root;
+    while(index != 0) {
+        struct avl_compact_node *node = AVLC_NODE(tree, index);
+        int result = avl_compare(tree->compare, data, node->data);
+        if(result == 0)
+            break;
+        path[depth] = index;
+        dirs[depth++] = result > 0;
+        index = avlc_child(node, result > 0);
+    }
+    if(index == 0)
+        return false;
+    struct avl_compact_node *node = AVLC_NODE(tree, index);
+    if(destroy != NULL)
+        destroy(node->data);
+    if(AVLC_INDEX(node->left) != 0 && AVLC_INDEX(node->right) != 0) {
+        // Move the item of the successor here, and remove the successor instead
+        path[depth] = index;
+        dirs[depth++] = 1;
+        uint32_t successor = AVLC_INDEX(node->right);
+        while(AVLC_INDEX(tree->nodes[successor].left) != 0) {
+            path[depth] = successor;
+            dirs[depth++] = 0;
+            successor = AVLC_INDEX(tree->nodes[successor].left);
+        }
+        node->data = tree->nodes[successor].data;
+        index = successor;
+        node = AVLC_NODE(tree, index);
+    }
+    uint32_t child = AVLC_INDEX(node->left) != 0 ? AVLC_INDEX(node->left) : AVLC_INDEX(node->right);
+    if(depth == 0)
+        tree->root = child;
+    else
+        avlc_set_child(AVLC_NODE(tree, path[depth - 1]), dirs[depth - 1], child);
+    node->left = tree->free_list;
+    tree->free_list = index;
+    tree->size--;
+
+    // Walk up while the subtrees get shorter: a node which was balanced leans to the other side and the retracing
+    // stops, a node which leaned to the shorter side becomes balanced, and a node which leaned to the other side is
+    // rotated
+    for(int i = depth - 1 ; i >= 0 ; i--) {
+        struct avl_compact_node *parent = AVLC_NODE(tree, path[i]);
+        int shrunk = dirs[i] ? 1 : -1, balance = avlc_balance(parent);
+        if(balance == 0) {
+            avlc_set_balance(parent, -shrunk);
+            break;
+        }
+        if(balance == shrunk) {
+            avlc_set_balance(parent, 0);
+            continue;
+        }
+        bool shorter;
+        uint32_t root = avlc_rebalance(tree, path[i], dirs[i], &shorter);
+        if(i == 0)
+            tree->root = root;
+        else
+            avlc_set_child(AVLC_NODE(tree, path[i - 1]), dirs[i - 1], root);
+        if(!shorter)
+            break;
+    }
+    return true;
+}
+
+
+// Search data in the tree
+bool AVLTree_compact_search(CompactAVLTree tree, void *data) {
+    for(uint32_t index = tree->root ; index != 0 ; ) {
+        struct avl_compact_node *node = AVLC_NODE(tree, index);
+        int result = avl_compare(tree->compare, data, node->data);
+        if(result == 0)
+            return true;
+        index = avlc_child(node, result > 0);
+    }
+    return false;
+}
+
+
+// Returns the number of items in the tree
+size_t AVLTree_compact_size(CompactAVLTree tree) {
+    return tree->size;
+}
+
+
+// Returns the bytes of the array of the nodes
+size_t AVLTree_compact_bytes(CompactAVLTree tree) {
+    return (size_t)tree->capacity * sizeof(struct avl_compact_node);
+}
+
+
+// Visit the items of [low, high) of a subtree in order. Returns false if visit stopped the range
+static bool avlc_range(CompactAVLTree tree, uint32_t index, void *low, void *high, AVLTreeRangeFunc visit, void *ctx,
+                       size_t *count) {
+    while(index != 0) {
+        struct avl_compact_node *node = AVLC_NODE(tree, index);
+        bool above_low = low == NULL || avl_compare(tree->compare, node->data, low) >= 0;
+        bool below_high = high == NULL || avl_compare(tree->compare, node->data, high) < 0;
+        if(above_low && !avlc_range(tree, AVLC_INDEX(node->left), low, below_high ? NULL : high, visit, ctx, count))
+            return false;
+        if(above_low && below_high) {
+            (*count)++;
+            if(!visit(node->data, ctx))
+                return false;
+        }
+        if(!below_high)
+            return true;
+        // Every item of the right subtree is greater than low when this node is not less than it
+        if(above_low)
+            low = NULL;
+        index = AVLC_INDEX(node->right);
+    }
+    return true;
+}
+
+
+// Visit the items of [low, high) in order, until visit returns false
+size_t AVLTree_compact_range(CompactAVLTree tree, void *low, void *high, AVLTreeRangeFunc visit, void *ctx) {
+    size_t count = 0;
+    avlc_range(tree, tree->root, low, high, visit, ctx, &count);
+    return count;
+}
+
+
+// Destroy the tree. Without a destroy function the nodes are freed at once with their array
+void AVLTree_compact_destroy(CompactAVLTree tree, DestroyFunc destroy) {
+    if(destroy != NULL) {
+        // The deleted nodes are marked first, so that only the items of the tree are destroyed
+        for(uint32_t index = tree->free_list ; index != 0 ; ) {
+            uint32_t next = tree->nodes[index].left;
+            tree->nodes[index].data = NULL;
+            index = next;
+        }
+        for(uint32_t index = 1 ; index < tree->used ; index++)
+            if(tree->nodes[index].data != NULL)
+                destroy(tree->nodes[index].data);
+    }
+    AVL_STATS_SUB(bytes_allocated, (size_t)tree->capacity * sizeof(struct avl_compact_node));
+    free(tree->nodes);
+    free(tree);
+}
+
+
+// Return a snapshot of the instrumentation counters of the AVL trees
+AVLTree_stats AVLTree_get_stats(void) {
+    AVLTree_stats snapshot = {0};
+#ifdef DS_STATS
+    snapshot.compares = atomic_load_explicit(&stats.compares, memory_order_relaxed);
+    snapshot.rotations = atomic_load_explicit(&stats.rotations, memory_order_relaxed);
+    snapshot.bytes_allocated = atomic_load_explicit(&stats.bytes_allocated, memory_order_relaxed);
+#endif
+    return snapshot;
+}
+
+
+// Reset the instrumentation counters of the AVL trees (bytes_allocated keeps describing the allocated nodes)
+void AVLTree_reset_stats(void) {
+#ifdef DS_STATS
+    atomic_store_explicit(&stats.compares, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats.rotations, 0, memory_order_relaxed);
+#endif
 }
\ No newline at end of file
@@ -2,10 +2,19 @@
 #ifndef AVLTREE_H
 #define AVLTREE_H
 
+#include <stddef.h>
 #include <stdbool.h>
+#include "../Allocator/Allocator.h"
+#include "../ThreadPool/ThreadPool.h"
 
 typedef struct avl_node *AVLTree;
 
+// An AVL tree whose nodes are stored in one array and linked by 32-bit indices
+typedef struct avl_compact *CompactAVLTree;
+
+// An AVL tree of n nodes is at most about 1.44 log2(n) high, so no tree which fits in memory is higher than this
+#define AVLTREE_MAX_HEIGHT 96
+
 // Compare functions for the different data type
 typedef int (*CompareFunc)(void *, void *);
 
@@ -15,12 +24,64 @@ typedef void (*DestroyFunc)(void *);
 // Functions to visit nodes printing their data
 typedef void (*PrintFunc)(void *);
 
+// Functions which visit the items of a range. Returning false stops the range
+typedef bool (*AVLTreeRangeFunc)(void *data, void *ctx);
+
+// Counters of the hot paths of all the AVL trees. They are only updated when the library is built with -DDS_STATS
+// (make STATS=1 in lib), so they cost nothing otherwise and stay zero.
+// The counters are updated atomically, so they stay exact when the parallel set operations update them from the
+// threads of their pool.
+typedef struct {
+    size_t compares;        // Calls of the compare function
+    size_t rotations;       // Left and right rotations
+    size_t bytes_allocated; // Bytes currently allocated by the nodes of the trees (the data is not included)
+} AVLTree_stats;
+
+// Iterator over the items of an AVL tree in order. The nodes have no parent pointers, so it keeps the path from the
+// root to its node. It is invalidated by any change of the tree
+typedef struct {
+    AVLTree root;
+    AVLTree path[AVLTREE_MAX_HEIGHT];
+    int depth; // The number of nodes in path, 0 at the end
+} AVLTreeIterator;
+
 /* The AVL tree should be initialized to NULL before starting to insert data */
 
+// Set the allocator of the nodes of all the AVL trees (NULL restores malloc and free). A tree is just a pointer to its
+// root, so the allocator is shared by the whole module and it should only be changed while no tree has nodes
+void AVLTree_set_allocator(const Allocator *allocator);
+
 // Function to insert a node in an AVL tree
 AVLTree AVLTree_insert(AVLTree node, void *data, CompareFunc compare);
 
-// Remove given item (if it exists) from the AVL tree and return a boolean value which demonstrates if the deletion occurred
+// Build a perfectly balanced AVL tree from count items which are sorted in strictly ascending order, in O(count). The
+// order is only checked (with count - 1 calls of compare), and NULL is returned if it is wrong
+AVLTree AVLTree_build_sorted(void **items, size_t count, CompareFunc compare);
+
+// Join two AVL trees and an item which is greater than every item of left and less than every item of right, in
+// O(|height(left) - height(right)| + 1). The trees are consumed by the join
+AVLTree AVLTree_join(AVLTree left, void *data, AVLTree right);
+
+// Split the AVL tree into the items which are less than data (left) and the items which are greater than data (right),
+// in O(log n). The tree is consumed by the split. Returns the item which equals data (whose node is freed) or NULL
+void *AVLTree_split(AVLTree avl, void *data, CompareFunc compare, AVLTree *left, AVLTree *right);
+
+/* The set operations consume both trees and return the result, in O(m log(n/m + 1)) where m and n are the sizes of
+   the smaller and the larger tree. The items which are not in the result (for the union, the items of avl2 which are
+   also in avl1) are destroyed with destroy if it is not NULL. If pool is not NULL, the operation runs on the threads
+   of the pool, which should then only be used by one caller at a time, and the allocator of the module must be
+   thread safe (malloc is) */
+
+// Return the union of two AVL trees
+AVLTree AVLTree_union(AVLTree avl1, AVLTree avl2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool);
+
+// Return the intersection of two AVL trees (the items of avl1 are kept)
+AVLTree AVLTree_intersection(AVLTree avl1, AVLTree avl2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool);
+
+// Return the items of avl1 which are not in avl2
+AVLTree AVLTree_difference(AVLTree avl1, AVLTree avl2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool);
+
+// Remove given item (if it exists) from the AVL tree and return the new root
 AVLTree AVLTree_delete(AVLTree avl, void *data, CompareFunc compare, DestroyFunc destroy);
 
 // Search given data in the AVL tree and returns a corresponding boolean value if it finds it or not
@@ -38,6 +99,35 @@ void AVLTree_postorder_traversal(AVLTree avl, PrintFunc print);
 // Returns the data of the k-th item of in the AVL tree
 void *AVLTree_select_k_th_item(AVLTree avl, int k);
 
+// Set the iterator to the first item of the AVL tree
+void AVLTree_begin(AVLTree avl, AVLTreeIterator *it);
+
+// Set the iterator to the end of the AVL tree (after the last item)
+void AVLTree_end(AVLTree avl, AVLTreeIterator *it);
+
+// Set the iterator to the first item of the AVL tree which is not less than data (or to the end)
+void AVLTree_lower_bound(AVLTree avl, void *data, CompareFunc compare, AVLTreeIterator *it);
+
+// Check if the iterator points to an item (and not to the end)
+bool AVLTree_iterator_valid(const AVLTreeIterator *it);
+
+// Returns the item of the iterator, or NULL at the end
+void *AVLTree_iterator_data(const AVLTreeIterator *it);
+
+// Move the iterator to the next item, in O(1) amortized
+void AVLTree_next(AVLTreeIterator *it);
+
+// Move the iterator to the previous item. The end moves to the last item and the first item moves to the end
+void AVLTree_prev(AVLTreeIterator *it);
+
+// Visit the items of [low, high) in order, until visit returns false. A NULL low starts from the first item and a NULL
+// high goes up to the last one. Returns the number of visited items
+size_t AVLTree_range(AVLTree avl, void *low, void *high, CompareFunc compare, AVLTreeRangeFunc visit, void *ctx);
+
+// Copy up to capacity items which are less than high (NULL for no bound), starting from the iterator, and move the
+// iterator after them. Returns the number of copied items, which is 0 at the end of the range
+size_t AVLTree_range_batch(AVLTreeIterator *it, void *high, CompareFunc compare, void **items, size_t capacity);
+
 // Check if the AVL tree is empty
 bool AVLTree_empty(AVLTree avl);
 
@@ -50,7 +140,44 @@ void *AVLTree_min_value(AVLTree avl);
 // Find the maximum value of an AVL tree
 void *AVLTree_max_value(AVLTree avl);
 
-// Function to destroy an AVL tree
+// Function to destroy an AVL tree (destroy may be NULL when the tree does not own its items)
 void AVLTree_destroy(AVLTree node, DestroyFunc destroy);
 
+/* Compact AVL trees: the nodes (an item and two 32-bit links which also hold the balance) take 16 bytes and are stored
+   in one array, which grows by doubling, instead of being allocated one by one. A tree holds up to 2^31 - 2 items */
+
+// Create an empty compact AVL tree which orders its items with compare
+CompactAVLTree AVLTree_compact_create(CompareFunc compare);
+
+// Make sure that the tree can hold at least capacity items without growing its array
+void AVLTree_compact_reserve(CompactAVLTree tree, size_t capacity);
+
+// Insert data into the tree. Returns false (and leaves the tree unchanged) if it is already in the tree
+bool AVLTree_compact_insert(CompactAVLTree tree, void *data);
+
+// Delete data from the tree and destroy it (if destroy is not NULL). Returns true if data was in the tree
+bool AVLTree_compact_delete(CompactAVLTree tree, void *data, DestroyFunc destroy);
+
+// Search data in the tree
+bool AVLTree_compact_search(CompactAVLTree tree, void *data);
+
+// Returns the number of items in the tree
+size_t AVLTree_compact_size(CompactAVLTree tree);
+
+// Returns the bytes of the array of the nodes
+size_t AVLTree_compact_bytes(CompactAVLTree tree);
+
+// Visit the items of [low, high) in order, until visit returns false. A NULL low starts from the first item and a NULL
+// high goes up to the last one. Returns the number of visited items
+size_t AVLTree_compact_range(CompactAVLTree tree, void *low, void *high, AVLTreeRangeFunc visit, void *ctx);
+
+// Destroy the tree and its items (destroy may be NULL). Without a destroy function the nodes are freed at once
+void AVLTree_compact_destroy(CompactAVLTree tree, DestroyFunc destroy);
+
+// Return a snapshot of the instrumentation counters of the AVL trees
+AVLTree_stats AVLTree_get_stats(void);
+
+// Reset the instrumentation counters of the AVL trees (bytes_allocated keeps describing the allocated nodes)
+void AVLTree_reset_stats(void);
+
 #endif
\ No newline at end of file
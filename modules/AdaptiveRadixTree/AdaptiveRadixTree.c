@@ -0,0 +1,742 @@
+/* File: AdaptiveRadixTree.c */
+/* This file contains an implementation of the adaptive radix tree (Leis, Kemper and Neumann, ICDE 2013) */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "AdaptiveRadixTree.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+// Bytes of a compressed path which are stored in a node. Longer paths keep only their length and the rest of their
+// bytes is read from a leaf below the node (hybrid path compression)
+#define ART_MAX_PREFIX 10
+
+
+typedef enum {
+    NODE4, NODE16, NODE48, NODE256
+} NodeType;
+
+
+// Leaves hold a copy of the whole key, so a path can end at a leaf as soon as no other key shares it (lazy expansion)
+typedef struct art_leaf {
+    void *value;
+    size_t key_len;
+    unsigned char key[];
+} ARTLeaf;
+
+
+// Header of the inner nodes. end is the leaf of the key which ends at this node (e.g. "ab" in a node which also leads
+// to "abc"), so no key has to be a prefix-free string
+typedef struct art_node {
+    uint8_t type;
+    uint16_t count;
+    uint32_t prefix_len;
+    unsigned char prefix[ART_MAX_PREFIX];
+    ARTLeaf *end;
+} ARTNode;
+
+// Up to 4 and 16 children with their key bytes in ascending order
+typedef struct {
+    ARTNode n;
+    unsigned char keys[4];
+    void *children[4];
+} ARTNode4;
+
+typedef struct {
+    ARTNode n;
+    unsigned char keys[16];
+    void *children[16];
+} ARTNode16;
+
+// Up to 48 children, found through an index of 256 bytes (0 means no child, otherwise the position + 1)
+typedef struct {
+    ARTNode n;
+    unsigned char index[256];
+    void *children[48];
+} ARTNode48;
+
+// One child per byte
+typedef struct {
+    ARTNode n;
+    void *children[256];
+} ARTNode256;
+
+
+/* Adaptive Radix Tree */
+struct art {
+    void *root;
+    size_t size;
+    DestroyFunc destroy_value;
+    Allocator allocator;
+};
+
+
+// Children are tagged pointers: leaves have their lowest bit set
+#define IS_LEAF(ptr) (((uintptr_t)(ptr)) & 1)
+#define TO_LEAF(ptr) ((ARTLeaf *)((uintptr_t)(ptr) & ~(uintptr_t)1))
+#define FROM_LEAF(leaf) ((void *)((uintptr_t)(leaf) | 1))
+
+
+static const size_t node_sizes[] = {sizeof(ARTNode4), sizeof(ARTNode16), sizeof(ARTNode48), sizeof(ARTNode256)};
+
+
+// Static - Local functions
+static ARTNode *alloc_node(ART *art, NodeType type);
+static ARTLeaf *create_leaf(ART *art, const unsigned char *key, size_t key_len, void *value);
+static void free_leaf(ART *art, ARTLeaf *leaf);
+static void **find_child(ARTNode *node, unsigned char byte);
+static void add_child(ART *art, void **ref, ARTNode *node, unsigned char byte, void *child);
+static void remove_child(ART *art, void **ref, ARTNode *node, unsigned char byte);
+static ARTLeaf *minimum_leaf(void *ptr);
+static size_t prefix_mismatch(ARTNode *node, const unsigned char *key, size_t key_len, size_t depth);
+static bool insert_at(ART *art, void **ref, const unsigned char *key, size_t key_len, size_t depth, void *value);
+static bool delete_at(ART *art, void **ref, const unsigned char *key, size_t key_len, size_t depth);
+static bool iterate(void *ptr, ARTVisitFunc visit, void *ctx);
+static void destroy(ART *art, void *ptr);
+
+
+ART *ART_create(DestroyFunc destroy_value) {
+    return ART_create_with_allocator(destroy_value, NULL);
+}
+
+
+// Create an adaptive radix tree which allocates its memory with the given allocator (NULL uses malloc and free)
+ART *ART_create_with_allocator(DestroyFunc destroy_value, const Allocator *allocator) {
+    ART *art = allocator_alloc(allocator, sizeof(*art));
+    assert(art != NULL);
+    art->allocator = allocator != NULL ? *allocator : (Allocator){0};
+    art->root = NULL;
+    art->size = 0;
+    art->destroy_value = destroy_value;
+    return art;
+}
+
+
+// Returns the number of keys in the tree
+size_t ART_size(ART *art) {
+    assert(art != NULL);
+    return art->size;
+}
+
+
+static ARTNode *alloc_node(ART *art, NodeType type) {
+    ARTNode *node = allocator_calloc(&art->allocator, 1, node_sizes[type]);
+    assert(node != NULL);
+    node->type = type;
+    return node;
+}
+
+
+static void free_node(ART *art, ARTNode *node) {
+    allocator_free(&art->allocator, node, node_sizes[node->type]);
+}
+
+
+static ARTLeaf *create_leaf(ART *art, const unsigned char *key, size_t key_len, void *value) {
+    ARTLeaf *leaf = allocator_alloc(&art->allocator, sizeof(ARTLeaf) + key_len);
+    assert(leaf != NULL);
+    leaf->value = value;
+    leaf->key_len = key_len;
+    memcpy(leaf->key, key, key_len);
+    return leaf;
+}
+
+
+static void free_leaf(ART *art, ARTLeaf *leaf) {
+    if (art->destroy_value != NULL)
+        art->destroy_value(leaf->value);
+    allocator_free(&art->allocator, leaf, sizeof(ARTLeaf) + leaf->key_len);
+}
+
+
+static inline bool leaf_matches(const ARTLeaf *leaf, const unsigned char *key, size_t key_len) {
+    return leaf->key_len == key_len && memcmp(leaf->key, key, key_len) == 0;
+}
+
+
+// Copy the header (everything but the type) of a node into a node of another type
+static void copy_header(ARTNode *dest, const ARTNode *src) {
+    dest->count = src->count;
+    dest->prefix_len = src->prefix_len;
+    memcpy(dest->prefix, src->prefix, ART_MAX_PREFIX);
+    dest->end = src->end;
+}
+
+
+// Return the slot of the child of the given byte, or NULL if there is none
+static void **find_child(ARTNode *node, unsigned char byte) {
+    switch (node->type) {
+        case NODE4: {
+            ARTNode4 *n = (ARTNode4 *)node;
+            for (int i = 0; i < n->n.count; i++) {
+                if (n->keys[i] == byte)
+                    return &n->children[i];
+            }
+            return NULL;
+        }
+        case NODE16: {
+            ARTNode16 *n = (ARTNode16 *)node;
+#if defined(__SSE2__)
+            // Compare the byte with the 16 keys at once
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)byte), _mm_loadu_si128((const __m128i *)n->keys));
+            int mask = _mm_movemask_epi8(cmp) & ((1 << n->n.count) - 1);
+            return mask != 0 ? &n->children[__builtin_ctz(mask)] : NULL;
+#else
+            for (int i = 0; i < n->n.count; i++) {
+                if (n->keys[i] == byte)
+                    return &n->children[i];
+            }
+            return NULL;
+#endif
+        }
+        case NODE48: {
+            ARTNode48 *n = (ARTNode48 *)node;
+            return n->index[byte] != 0 ? &n->children[n->index[byte] - 1] : NULL;
+        }
+        default: {
+            ARTNode256 *n = (ARTNode256 *)node;
+            return n->children[byte] != NULL ? &n->children[byte] : NULL;
+        }
+    }
+}
+
+
+// Add a child to a node which does not have one for the given byte. A full node is replaced (in *ref) by a node of the
+// next larger type
+static void add_child(ART *art, void **ref, ARTNode *node, unsigned char byte, void *child) {
+    switch (node->type) {
+        case NODE4: {
+            ARTNode4 *n = (ARTNode4 *)node;
+            if (n->n.count < 4) {
+                int i = 0;
+                while (i < n->n.count && n->keys[i] < byte)
+                    i++;
+                memmove(n->keys + i + 1, n->keys + i, n->n.count - i);
+                memmove(n->children + i + 1, n->children + i, (n->n.count - i) * sizeof(void *));
+                n->keys[i] = byte;
+                n->children[i] = child;
+                n->n.count++;
+                return;
+            }
+            ARTNode16 *grown = (ARTNode16 *)alloc_node(art, NODE16);
+            copy_header(&grown->n, &n->n);
+            memcpy(grown->keys, n->keys, 4);
+            memcpy(grown->children, n->children, 4 * sizeof(void *));
+            *ref = grown;
+            free_node(art, node);
+            add_child(art, ref, &grown->n, byte, child);
+            return;
+        }
+        case NODE16: {
+            ARTNode16 *n = (ARTNode16 *)node;
+            if (n->n.count < 16) {
+                int i = 0;
+                while (i < n->n.count && n->keys[i] < byte)
+                    i++;
+                memmove(n->keys + i + 1, n->keys + i, n->n.count - i);
+                memmove(n->children + i + 1, n->children + i, (n->n.count - i) * sizeof(void *));
+                n->keys[i] = byte;
+                n->children[i] = child;
+                n->n.count++;
+                return;
+            }
+            ARTNode48 *grown = (ARTNode48 *)alloc_node(art, NODE48);
+            copy_header(&grown->n, &n->n);
+            for (int i = 0; i < 16; i++) {
+                grown->children[i] = n->children[i];
+                grown->index[n->keys[i]] = i + 1;
+            }
+            *ref = grown;
+            free_node(art, node);
+            add_child(art, ref, &grown->n, byte, child);
+            return;
+        }
+        case NODE48: {
+            ARTNode48 *n = (ARTNode48 *)node;
+            if (n->n.count < 48) {
+                // Removals leave holes in the children, so look for a free position
+                int i = 0;
+                while (n->children[i] != NULL)
+                    i++;
+                n->children[i] = child;
+                n->index[byte] = i + 1;
+                n->n.count++;
+                return;
+            }
+            ARTNode256 *grown = (ARTNode256 *)alloc_node(art, NODE256);
+            copy_header(&grown->n, &n->n);
+            for (int b = 0; b < 256; b++) {
+                if (n->index[b] != 0)
+                    grown->children[b] = n->children[n->index[b] - 1];
+            }
+            *ref = grown;
+            free_node(art, node);
+            add_child(art, ref, &grown->n, byte, child);
+            return;
+        }
+        default: {
+            ARTNode256 *n = (ARTNode256 *)node;
+            n->children[byte] = child;
+            n->n.count++;
+        }
+    }
+}
+
+
+// Replace a Node4 which is left with a single child (and no key ends at it) by that child. An inner child takes the
+// path of the node, the byte of the child and its own path as its compressed path
+static void collapse(ART *art, void **ref, ARTNode4 *n) {
+    void *child = n->children[0];
+    if (!IS_LEAF(child)) {
+        ARTNode *c = child;
+        unsigned char prefix[ART_MAX_PREFIX];
+        size_t len = n->n.prefix_len < ART_MAX_PREFIX ? n->n.prefix_len : ART_MAX_PREFIX;
+        memcpy(prefix, n->n.prefix, len);
+        if (len < ART_MAX_PREFIX)
+            prefix[len++] = n->keys[0];
+        size_t rest = c->prefix_len < ART_MAX_PREFIX - len ? c->prefix_len : ART_MAX_PREFIX - len;
+        memcpy(prefix + len, c->prefix, rest);
+        memcpy(c->prefix, prefix, len + rest);
+        c->prefix_len += n->n.prefix_len + 1;
+    }
+    *ref = child;
+    free_node(art, &n->n);
+}
+
+
+// Remove the child of the given byte from a node. A node which becomes sparse enough is replaced (in *ref) by a node
+// of the next smaller type
+static void remove_child(ART *art, void **ref, ARTNode *node, unsigned char byte) {
+    switch (node->type) {
+        case NODE4:
+        case NODE16: {
+            unsigned char *keys = node->type == NODE4 ? ((ARTNode4 *)node)->keys : ((ARTNode16 *)node)->keys;
+            void **children = node->type == NODE4 ? ((ARTNode4 *)node)->children : ((ARTNode16 *)node)->children;
+            int i = 0;
+            while (keys[i] != byte)
+                i++;
+            memmove(keys + i, keys + i + 1, node->count - i - 1);
+            memmove(children + i, children + i + 1, (node->count - i - 1) * sizeof(void *));
+            node->count--;
+            if (node->type == NODE16 && node->count == 3) {
+                ARTNode4 *shrunk = (ARTNode4 *)alloc_node(art, NODE4);
+                copy_header(&shrunk->n, node);
+                memcpy(shrunk->keys, keys, 3);
+                memcpy(shrunk->children, children, 3 * sizeof(void *));
+                *ref = shrunk;
+                free_node(art, node);
+            } else if (node->type == NODE4 && node->count == 1 && node->end == NULL) {
+                collapse(art, ref, (ARTNode4 *)node);
+            } else if (node->type == NODE4 && node->count == 0) {
+                // Only the key which ends at the node is left
+                *ref = FROM_LEAF(node->end);
+                free_node(art, node);
+            }
+            return;
+        }
+        case NODE48: {
+            ARTNode48 *n = (ARTNode48 *)node;
+            n->children[n->index[byte] - 1] = NULL;
+            n->index[byte] = 0;
+            n->n.count--;
+            if (n->n.count == 12) {
+                ARTNode16 *shrunk = (ARTNode16 *)alloc_node(art, NODE16);
+                copy_header(&shrunk->n, node);
+                int j = 0;
+                for (int b = 0; b < 256; b++) {
+                    if (n->index[b] != 0) {
+                        shrunk->keys[j] = b;
+                        shrunk->children[j++] = n->children[n->index[b] - 1];
+                    }
+                }
+                *ref = shrunk;
+                free_node(art, node);
+            }
+            return;
+        }
+        default: {
+            ARTNode256 *n = (ARTNode256 *)node;
+            n->children[byte] = NULL;
+            n->n.count--;
+            if (n->n.count == 37) {
+                ARTNode48 *shrunk = (ARTNode48 *)alloc_node(art, NODE48);
+                copy_header(&shrunk->n, node);
+                int j = 0;
+                for (int b = 0; b < 256; b++) {
+                    if (n->children[b] != NULL) {
+                        shrunk->children[j] = n->children[b];
+                        shrunk->index[b] = ++j;
+                    }
+                }
+                *ref = shrunk;
+                free_node(art, node);
+            }
+        }
+    }
+}
+
+
+// Return the leaf with the smallest key below the given child
+static ARTLeaf *minimum_leaf(void *ptr) {
+    while (!IS_LEAF(ptr)) {
+        ARTNode *node = ptr;
+        if (node->end != NULL)
+            return node->end;
+        switch (node->type) {
+            case NODE4:
+                ptr = ((ARTNode4 *)node)->children[0];
+                break;
+            case NODE16:
+                ptr = ((ARTNode16 *)node)->children[0];
+                break;
+            case NODE48: {
+                ARTNode48 *n = (ARTNode48 *)node;
+                int b = 0;
+                while (n->index[b] == 0)
+                    b++;
+                ptr = n->children[n->index[b] - 1];
+                break;
+            }
+            default: {
+                ARTNode256 *n = (ARTNode256 *)node;
+                int b = 0;
+                while (n->children[b] == NULL)
+                    b++;
+                ptr = n->children[b];
+            }
+        }
+    }
+    return TO_LEAF(ptr);
+}
+
+
+// Return how many bytes of the compressed path of the node match the key from the given depth (the length of the
+// path if it all matches, or less if the key ends first). Bytes past the ones stored in the node are read from a leaf
+static size_t prefix_mismatch(ARTNode *node, const unsigned char *key, size_t key_len, size_t depth) {
+    size_t max = node->prefix_len < key_len - depth ? node->prefix_len : key_len - depth;
+    size_t stored = max < ART_MAX_PREFIX ? max : ART_MAX_PREFIX;
+    size_t i;
+    for (i = 0; i < stored; i++) {
+        if (node->prefix[i] != key[depth + i])
+            return i;
+    }
+    if (max > ART_MAX_PREFIX) {
+        ARTLeaf *leaf = minimum_leaf(node);
+        for (; i < max; i++) {
+            if (leaf->key[depth + i] != key[depth + i])
+                return i;
+        }
+    }
+    return max;
+}
+
+
+// Search the given key and return its value, or NULL if the key is not in the tree
+void *ART_search(ART *art, const void *key, size_t key_len) {
+    assert(art != NULL);
+    const unsigned char *bytes = key;
+    void *ptr = art->root;
+    size_t depth = 0;
+    while (ptr != NULL) {
+        if (IS_LEAF(ptr)) {
+            ARTLeaf *leaf = TO_LEAF(ptr);
+            return leaf_matches(leaf, bytes, key_len) ? leaf->value : NULL;
+        }
+        ARTNode *node = ptr;
+        if (node->prefix_len > 0) {
+            // Only the stored bytes of the path are checked here. The leaf holds the whole key and is compared at the end
+            if (node->prefix_len > key_len - depth)
+                return NULL;
+            size_t stored = node->prefix_len < ART_MAX_PREFIX ? node->prefix_len : ART_MAX_PREFIX;
+            if (memcmp(node->prefix, bytes + depth, stored) != 0)
+                return NULL;
+            depth += node->prefix_len;
+        }
+        if (depth == key_len)
+            return node->end != NULL && leaf_matches(node->end, bytes, key_len) ? node->end->value : NULL;
+        void **child = find_child(node, bytes[depth]);
+        ptr = child != NULL ? *child : NULL;
+        depth++;
+    }
+    return NULL;
+}
+
+
+static bool insert_at(ART *art, void **ref, const unsigned char *key, size_t key_len, size_t depth, void *value) {
+    void *ptr = *ref;
+    if (ptr == NULL) {
+        *ref = FROM_LEAF(create_leaf(art, key, key_len, value));
+        return true;
+    }
+    if (IS_LEAF(ptr)) {
+        ARTLeaf *leaf = TO_LEAF(ptr);
+        if (leaf_matches(leaf, key, key_len)) {
+            if (art->destroy_value != NULL && leaf->value != value)
+                art->destroy_value(leaf->value);
+            leaf->value = value;
+            return false;
+        }
+        // Expand the leaf into a node with the common part of the two keys as its path
+        ARTNode4 *n = (ARTNode4 *)alloc_node(art, NODE4);
+        size_t common = 0;
+        while (depth + common < key_len && depth + common < leaf->key_len &&
+               key[depth + common] == leaf->key[depth + common])
+            common++;
+        n->n.prefix_len = common;
+        memcpy(n->n.prefix, key + depth, common < ART_MAX_PREFIX ? common : ART_MAX_PREFIX);
+        depth += common;
+        *ref = n;
+        ARTLeaf *new_leaf = create_leaf(art, key, key_len, value);
+        if (leaf->key_len == depth)
+            n->n.end = leaf;
+        else
+            add_child(art, ref, &n->n, leaf->key[depth], ptr);
+        if (key_len == depth)
+            n->n.end = new_leaf;
+        else
+            add_child(art, ref, &n->n, key[depth], FROM_LEAF(new_leaf));
+        return true;
+    }
+    ARTNode *node = ptr;
+    if (node->prefix_len > 0) {
+        size_t match = prefix_mismatch(node, key, key_len, depth);
+        if (match < node->prefix_len) {
+            // Split the path: a new node takes the matching part and the old node keeps the rest after the next byte
+            ARTNode4 *n = (ARTNode4 *)alloc_node(art, NODE4);
+            n->n.prefix_len = match;
+            memcpy(n->n.prefix, node->prefix, match < ART_MAX_PREFIX ? match : ART_MAX_PREFIX);
+            size_t rest = node->prefix_len - match - 1;
+            unsigned char byte;
+            if (node->prefix_len <= ART_MAX_PREFIX) {
+                byte = node->prefix[match];
+                memmove(node->prefix, node->prefix + match + 1, rest);
+            } else {
+                ARTLeaf *leaf = minimum_leaf(node);
+                byte = leaf->key[depth + match];
+                memcpy(node->prefix, leaf->key + depth + match + 1, rest < ART_MAX_PREFIX ? rest : ART_MAX_PREFIX);
+            }
+            node->prefix_len = rest;
+            *ref = n;
+            add_child(art, ref, &n->n, byte, node);
+            ARTLeaf *new_leaf = create_leaf(art, key, key_len, value);
+            if (depth + match == key_len)
+                n->n.end = new_leaf;
+            else
+                add_child(art, ref, &n->n, key[depth + match], FROM_LEAF(new_leaf));
+            return true;
+        }
+        depth += node->prefix_len;
+    }
+    if (depth == key_len) {
+        if (node->end == NULL) {
+            node->end = create_leaf(art, key, key_len, value);
+            return true;
+        }
+        if (art->destroy_value != NULL && node->end->value != value)
+            art->destroy_value(node->end->value);
+        node->end->value = value;
+        return false;
+    }
+    void **child = find_child(node, key[depth]);
+    if (child != NULL)
+        return insert_at(art, child, key, key_len, depth + 1, value);
+    add_child(art, ref, node, key[depth], FROM_LEAF(create_leaf(art, key, key_len, value)));
+    return true;
+}
+
+
+// Insert the key of key_len bytes with the given value, or replace the value if the key already exists
+bool ART_insert(ART *art, const void *key, size_t key_len, void *value) {
+    assert(art != NULL && (key != NULL || key_len == 0));
+    bool inserted = insert_at(art, &art->root, key, key_len, 0, value);
+    if (inserted)
+        art->size++;
+    return inserted;
+}
+
+
+static bool delete_at(ART *art, void **ref, const unsigned char *key, size_t key_len, size_t depth) {
+    void *ptr = *ref;
+    if (IS_LEAF(ptr)) {
+        if (!leaf_matches(TO_LEAF(ptr), key, key_len))
+            return false;
+        free_leaf(art, TO_LEAF(ptr));
+        *ref = NULL;
+        return true;
+    }
+    ARTNode *node = ptr;
+    if (node->prefix_len > 0) {
+        if (prefix_mismatch(node, key, key_len, depth) != node->prefix_len)
+            return false;
+        depth += node->prefix_len;
+    }
+    if (depth == key_len) {
+        if (node->end == NULL || !leaf_matches(node->end, key, key_len))
+            return false;
+        free_leaf(art, node->end);
+        node->end = NULL;
+        if (node->type == NODE4 && node->count == 1)
+            collapse(art, ref, (ARTNode4 *)node);
+        return true;
+    }
+    void **child = find_child(node, key[depth]);
+    if (child == NULL)
+        return false;
+    if (IS_LEAF(*child)) {
+        if (!leaf_matches(TO_LEAF(*child), key, key_len))
+            return false;
+        free_leaf(art, TO_LEAF(*child));
+        remove_child(art, ref, node, key[depth]);
+        return true;
+    }
+    // An inner child never becomes empty: when it is left with a single entry it is replaced by that entry
+    return delete_at(art, child, key, key_len, depth + 1);
+}
+
+
+// Delete the given key from the tree
+bool ART_delete(ART *art, const void *key, size_t key_len) {
+    assert(art != NULL && (key != NULL || key_len == 0));
+    if (art->root == NULL || !delete_at(art, &art->root, key, key_len, 0))
+        return false;
+    art->size--;
+    return true;
+}
+
+
+// Visit the leaves below a child in order. Returns false if the visit function stopped the iteration
+static bool iterate(void *ptr, ARTVisitFunc visit, void *ctx) {
+    if (IS_LEAF(ptr)) {
+        ARTLeaf *leaf = TO_LEAF(ptr);
+        return visit(leaf->key, leaf->key_len, leaf->value, ctx);
+    }
+    ARTNode *node = ptr;
+    if (node->end != NULL && !visit(node->end->key, node->end->key_len, node->end->value, ctx))
+        return false;
+    switch (node->type) {
+        case NODE4:
+        case NODE16: {
+            void **children = node->type == NODE4 ? ((ARTNode4 *)node)->children : ((ARTNode16 *)node)->children;
+            for (int i = 0; i < node->count; i++) {
+                if (!iterate(children[i], visit, ctx))
+                    return false;
+            }
+            return true;
+        }
+        case NODE48: {
+            ARTNode48 *n = (ARTNode48 *)node;
+            for (int b = 0; b < 256; b++) {
+                if (n->index[b] != 0 && !iterate(n->children[n->index[b] - 1], visit, ctx))
+                    return false;
+            }
+            return true;
+        }
+        default: {
+            ARTNode256 *n = (ARTNode256 *)node;
+            for (int b = 0; b < 256; b++) {
+                if (n->children[b] != NULL && !iterate(n->children[b], visit, ctx))
+                    return false;
+            }
+            return true;
+        }
+    }
+}
+
+
+// Visit every key in lexicographic order
+void ART_iterate(ART *art, ARTVisitFunc visit, void *ctx) {
+    assert(art != NULL && visit != NULL);
+    if (art->root != NULL)
+        iterate(art->root, visit, ctx);
+}
+
+
+// Visit the keys which start with the given prefix in lexicographic order
+void ART_prefix_iterate(ART *art, const void *prefix, size_t prefix_len, ARTVisitFunc visit, void *ctx) {
+    assert(art != NULL && visit != NULL && (prefix != NULL || prefix_len == 0));
+    const unsigned char *bytes = prefix;
+    void *ptr = art->root;
+    size_t depth = 0;
+    while (ptr != NULL) {
+        if (IS_LEAF(ptr)) {
+            ARTLeaf *leaf = TO_LEAF(ptr);
+            if (leaf->key_len >= prefix_len && memcmp(leaf->key, bytes, prefix_len) == 0)
+                visit(leaf->key, leaf->key_len, leaf->value, ctx);
+            return;
+        }
+        ARTNode *node = ptr;
+        if (node->prefix_len > 0) {
+            // The whole path is checked, so once the prefix is used up every key below the node starts with it
+            size_t match = prefix_mismatch(node, bytes, prefix_len, depth);
+            if (depth + match == prefix_len)
+                break;
+            if (match < node->prefix_len)
+                return;
+            depth += node->prefix_len;
+        }
+        if (depth == prefix_len)
+            break;
+        void **child = find_child(node, bytes[depth]);
+        ptr = child != NULL ? *child : NULL;
+        depth++;
+    }
+    if (ptr != NULL)
+        iterate(ptr, visit, ctx);
+}
+
+
+// Write an integer as an 8-byte big endian key
+void ART_encode_u64(uint64_t key, unsigned char buffer[8]) {
+    for (int i = 7; i >= 0; i--) {
+        buffer[i] = key & 0xFF;
+        key >>= 8;
+    }
+}
+
+
+static void destroy(ART *art, void *ptr) {
+    if (IS_LEAF(ptr)) {
+        free_leaf(art, TO_LEAF(ptr));
+        return;
+    }
+    ARTNode *node = ptr;
+    if (node->end != NULL)
+        free_leaf(art, node->end);
+    switch (node->type) {
+        case NODE4:
+            for (int i = 0; i < node->count; i++)
+                destroy(art, ((ARTNode4 *)node)->children[i]);
+            break;
+        case NODE16:
+            for (int i = 0; i < node->count; i++)
+                destroy(art, ((ARTNode16 *)node)->children[i]);
+            break;
+        case NODE48:
+            for (int i = 0; i < 48; i++) {
+                if (((ARTNode48 *)node)->children[i] != NULL)
+                    destroy(art, ((ARTNode48 *)node)->children[i]);
+            }
+            break;
+        default:
+            for (int b = 0; b < 256; b++) {
+                if (((ARTNode256 *)node)->children[b] != NULL)
+                    destroy(art, ((ARTNode256 *)node)->children[b]);
+            }
+    }
+    free_node(art, node);
+}
+
+
+// Destroy the tree - free the memory which is allocated by the tree and destroy the values
+void ART_destroy(ART *art) {
+    if (art == NULL)
+        return;
+    if (art->root != NULL)
+        destroy(art, art->root);
+    Allocator allocator = art->allocator;
+    allocator_free(&allocator, art, sizeof(*art));
+}
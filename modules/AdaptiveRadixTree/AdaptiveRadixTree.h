@@ -0,0 +1,52 @@
+/* File: AdaptiveRadixTree.h */
+#ifndef ADAPTIVE_RADIX_TREE_H
+#define ADAPTIVE_RADIX_TREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../Allocator/Allocator.h"
+
+
+typedef struct art ART;
+
+//Functions to destroy values inserted in the tree
+typedef void (*DestroyFunc)(void *);
+
+// Functions which visit the keys (which are not NUL-terminated) and the values of the tree. Returning false stops the
+// iteration
+typedef bool (*ARTVisitFunc)(const unsigned char *key, size_t key_len, void *value, void *ctx);
+
+// Create an adaptive radix tree. Keys are arbitrary byte strings which are copied into the tree, so the caller keeps
+// ownership of them. Values are destroyed with destroy_value (if it is not NULL) when they are replaced or deleted
+ART *ART_create(DestroyFunc destroy_value);
+
+// Create an adaptive radix tree which allocates its memory with the given allocator (NULL uses malloc and free)
+ART *ART_create_with_allocator(DestroyFunc destroy_value, const Allocator *allocator);
+
+// Returns the number of keys in the tree
+size_t ART_size(ART *art);
+
+// Insert the key of key_len bytes with the given value, or replace the value if the key already exists. Returns true
+// if the key was inserted
+bool ART_insert(ART *art, const void *key, size_t key_len, void *value);
+
+// Search the given key and return its value, or NULL if the key is not in the tree
+void *ART_search(ART *art, const void *key, size_t key_len);
+
+// Delete the given key from the tree. Returns true if the key was in the tree
+bool ART_delete(ART *art, const void *key, size_t key_len);
+
+// Visit every key in lexicographic order (a key comes before the longer keys which start with it)
+void ART_iterate(ART *art, ARTVisitFunc visit, void *ctx);
+
+// Visit the keys which start with the given prefix in lexicographic order
+void ART_prefix_iterate(ART *art, const void *prefix, size_t prefix_len, ARTVisitFunc visit, void *ctx);
+
+// Write an integer as an 8-byte big endian key, so that the order of the keys is the numeric order
+void ART_encode_u64(uint64_t key, unsigned char buffer[8]);
+
+// Destroy the tree - free the memory which is allocated by the tree and destroy the values
+void ART_destroy(ART *art);
+
+#endif
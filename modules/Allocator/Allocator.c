@@ -0,0 +1,256 @@
+/* File: Allocator.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <assert.h>
+#include "Allocator.h"
+
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define SLAB_DEFAULT_OBJECTS_PER_BLOCK 256
+
+// Every allocation of the arena is aligned for any type
+#define ARENA_ALIGNMENT (_Alignof(max_align_t))
+#define ALIGN_UP(size, alignment) (((size) + (alignment) - 1) / (alignment) * (alignment))
+
+
+/* Arena: bump allocation from a list of blocks */
+typedef struct arena_block arena_block;
+
+struct arena_block {
+    arena_block *next;
+    size_t size;
+    max_align_t data[];
+};
+
+struct arena {
+    arena_block *blocks; // The block which is currently used is the first one
+    size_t offset;       // Bytes of the current block which have been handed out
+    size_t block_size;
+    size_t used;
+};
+
+
+/* Slab: fixed-size objects with a free list */
+typedef struct slab_block slab_block;
+
+struct slab_block {
+    slab_block *next;
+    max_align_t data[];
+};
+
+struct slab {
+    size_t object_size;
+    size_t objects_per_block;
+    slab_block *blocks;
+    char *next_object;   // Next object of the current block which has never been handed out
+    size_t remaining;    // Objects of the current block which have never been handed out
+    void *free_list;     // Freed objects, each one holds a pointer to the next
+};
+
+
+// Create an arena which hands out memory from blocks of block_size bytes (0 uses 64 KB)
+Arena arena_create(size_t block_size) {
+    Arena arena = malloc(sizeof(*arena));
+    assert(arena != NULL);
+    arena->blocks = NULL;
+    arena->offset = 0;
+    arena->block_size = ALIGN_UP(block_size != 0 ? block_size : ARENA_DEFAULT_BLOCK_SIZE, ARENA_ALIGNMENT);
+    arena->used = 0;
+    return arena;
+}
+
+
+// Allocate a new block of the arena with the given usable size
+static arena_block *arena_new_block(size_t size) {
+    arena_block *block = malloc(sizeof(*block) + size);
+    if (block == NULL) {
+        fprintf(stderr, "Failed to allocate a block of %zu bytes for the arena\n", size);
+        return NULL;
+    }
+    block->size = size;
+    return block;
+}
+
+
+// Allocate size bytes from the arena. The memory is only given back by arena_reset or arena_destroy
+void *arena_alloc(Arena arena, size_t size) {
+    size = ALIGN_UP(size != 0 ? size : 1, ARENA_ALIGNMENT);
+
+    if (size > arena->block_size) {
+        // Large allocations get a block of their own, which is linked behind the current one so that the rest of the
+        // current block is not wasted
+        arena_block *block = arena_new_block(size);
+        if (block == NULL)
+            return NULL;
+        if (arena->blocks == NULL) {
+            block->next = NULL;
+            arena->blocks = block;
+            arena->offset = size;
+        } else {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        }
+        arena->used += size;
+        return block->data;
+    }
+
+    if (arena->blocks == NULL || arena->offset + size > arena->blocks->size) {
+        arena_block *block = arena_new_block(arena->block_size);
+        if (block == NULL)
+            return NULL;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->offset = 0;
+    }
+    void *ptr = (char *)arena->blocks->data + arena->offset;
+    arena->offset += size;
+    arena->used += size;
+    return ptr;
+}
+
+
+// Give back every allocation of the arena at once, keeping its first block for reuse
+void arena_reset(Arena arena) {
+    arena_block *kept = NULL, *block = arena->blocks;
+    while (block != NULL) {
+        arena_block *next = block->next;
+        if (kept == NULL && block->size == arena->block_size) {
+            kept = block;
+            kept->next = NULL;
+        } else {
+            free(block);
+        }
+        block = next;
+    }
+    arena->blocks = kept;
+    arena->offset = 0;
+    arena->used = 0;
+}
+
+
+// Return the number of bytes which have been allocated from the arena since it was created or reset
+size_t arena_used(Arena arena) {
+    return arena->used;
+}
+
+
+// Free the arena and every allocation made from it
+void arena_destroy(Arena arena) {
+    if (arena == NULL)
+        return;
+    while (arena->blocks != NULL) {
+        arena_block *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+    free(arena);
+}
+
+
+static void *arena_allocator_alloc(void *ctx, size_t size) {
+    return arena_alloc(ctx, size);
+}
+
+
+static void arena_allocator_free(void *ctx, void *ptr, size_t size) {
+    // The memory of an arena is given back all at once
+}
+
+
+// Return an allocator which allocates from the given arena. Its free does nothing
+Allocator arena_allocator(Arena arena) {
+    return (Allocator){ .alloc = arena_allocator_alloc, .free = arena_allocator_free, .ctx = arena };
+}
+
+
+// Create a slab which hands out objects of object_size bytes, carving them from blocks of objects_per_block objects
+Slab slab_create(size_t object_size, size_t objects_per_block) {
+    Slab slab = malloc(sizeof(*slab));
+    assert(slab != NULL);
+    // Objects are pointer aligned and large enough to hold the link of the free list
+    if (object_size < sizeof(void *))
+        object_size = sizeof(void *);
+    slab->object_size = ALIGN_UP(object_size, sizeof(void *));
+    slab->objects_per_block = objects_per_block != 0 ? objects_per_block : SLAB_DEFAULT_OBJECTS_PER_BLOCK;
+    slab->blocks = NULL;
+    slab->next_object = NULL;
+    slab->remaining = 0;
+    slab->free_list = NULL;
+    return slab;
+}
+
+
+// Allocate an object from the slab (a freed object is reused first)
+void *slab_alloc(Slab slab) {
+    if (slab->free_list != NULL) {
+        void *ptr = slab->free_list;
+        slab->free_list = *(void **)ptr;
+        return ptr;
+    }
+    if (slab->remaining == 0) {
+        slab_block *block = malloc(sizeof(*block) + slab->object_size * slab->objects_per_block);
+        if (block == NULL) {
+            fprintf(stderr, "Failed to allocate a block of %zu objects for the slab\n", slab->objects_per_block);
+            return NULL;
+        }
+        block->next = slab->blocks;
+        slab->blocks = block;
+        slab->next_object = (char *)block->data;
+        slab->remaining = slab->objects_per_block;
+    }
+    void *ptr = slab->next_object;
+    slab->next_object += slab->object_size;
+    slab->remaining--;
+    return ptr;
+}
+
+
+// Give an object back to the slab
+void slab_free(Slab slab, void *ptr) {
+    if (ptr == NULL)
+        return;
+    *(void **)ptr = slab->free_list;
+    slab->free_list = ptr;
+}
+
+
+// Return the size of the objects of the slab
+size_t slab_object_size(Slab slab) {
+    return slab->object_size;
+}
+
+
+// Free the slab and every object allocated from it
+void slab_destroy(Slab slab) {
+    if (slab == NULL)
+        return;
+    while (slab->blocks != NULL) {
+        slab_block *next = slab->blocks->next;
+        free(slab->blocks);
+        slab->blocks = next;
+    }
+    free(slab);
+}
+
+
+static void *slab_allocator_alloc(void *ctx, size_t size) {
+    Slab slab = ctx;
+    return size <= slab->object_size ? slab_alloc(slab) : malloc(size);
+}
+
+
+static void slab_allocator_free(void *ctx, void *ptr, size_t size) {
+    Slab slab = ctx;
+    if (size <= slab->object_size)
+        slab_free(slab, ptr);
+    else
+        free(ptr);
+}
+
+
+// Return an allocator which allocates from the given slab. Requests larger than the object size of the slab
+// (e.g. the handle or the table of a module) are served by malloc
+Allocator slab_allocator(Slab slab) {
+    return (Allocator){ .alloc = slab_allocator_alloc, .free = slab_allocator_free, .ctx = slab };
+}
@@ -0,0 +1,90 @@
+/* File: Allocator.h */
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Allocator which is used by the modules for their nodes, tables and handles. free receives the size which was
+// requested when the block was allocated, so fixed-size and bump allocators need no headers. ctx is passed to both.
+// A zeroed Allocator (or NULL where a module expects a pointer) means malloc and free.
+typedef struct allocator {
+    void *(*alloc)(void *ctx, size_t size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} Allocator;
+
+typedef struct arena *Arena;
+
+typedef struct slab *Slab;
+
+
+// Allocate size bytes with the given allocator
+static inline void *allocator_alloc(const Allocator *allocator, size_t size) {
+    if (allocator == NULL || allocator->alloc == NULL)
+        return malloc(size);
+    return allocator->alloc(allocator->ctx, size);
+}
+
+// Allocate count zeroed items of the given size with the given allocator
+static inline void *allocator_calloc(const Allocator *allocator, size_t count, size_t size) {
+    if (allocator == NULL || allocator->alloc == NULL)
+        return calloc(count, size);
+    void *ptr = allocator->alloc(allocator->ctx, count * size);
+    if (ptr != NULL)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+// Give a block of the given size back to the allocator which allocated it
+static inline void allocator_free(const Allocator *allocator, void *ptr, size_t size) {
+    if (ptr == NULL)
+        return;
+    if (allocator == NULL || allocator->free == NULL)
+        free(ptr);
+    else
+        allocator->free(allocator->ctx, ptr, size);
+}
+
+
+// Create an arena which hands out memory from blocks of block_size bytes (0 uses 64 KB)
+Arena arena_create(size_t block_size);
+
+// Allocate size bytes from the arena. The memory is only given back by arena_reset or arena_destroy
+void *arena_alloc(Arena arena, size_t size);
+
+// Give back every allocation of the arena at once, keeping its first block for reuse
+void arena_reset(Arena arena);
+
+// Return the number of bytes which have been allocated from the arena since it was created or reset
+size_t arena_used(Arena arena);
+
+// Free the arena and every allocation made from it
+void arena_destroy(Arena arena);
+
+// Return an allocator which allocates from the given arena. Its free does nothing
+Allocator arena_allocator(Arena arena);
+
+
+// Create a slab which hands out objects of object_size bytes, carving them from blocks of objects_per_block objects
+// (0 uses 256)
+Slab slab_create(size_t object_size, size_t objects_per_block);
+
+// Allocate an object from the slab (a freed object is reused first)
+void *slab_alloc(Slab slab);
+
+// Give an object back to the slab
+void slab_free(Slab slab, void *ptr);
+
+// Return the size of the objects of the slab
+size_t slab_object_size(Slab slab);
+
+// Free the slab and every object allocated from it
+void slab_destroy(Slab slab);
+
+// Return an allocator which allocates from the given slab. Requests larger than the object size of the slab
+// (e.g. the handle or the table of a module) are served by malloc
+Allocator slab_allocator(Slab slab);
+
+#endif
@@ -0,0 +1,676 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../Allocator/Allocator.h"
+
+// B+ tree which stores its keys and values in wide nodes, generated for a key and a value type:
+//     #define INT_LESS(a, b) ((a) < (b))
+//     DECLARE_BTREE(int, int, INT_LESS)
+//     btree_int_int *tree = btree_int_int_create();
+//     btree_int_int_insert(tree, 42, 7);
+//     int *value = btree_int_int_search(tree, 42);
+// LESS(a, b) receives two keys and returns true when a is strictly less than b. It can be a function-like macro or a
+// static inline function. The items live in the leaves, which are linked in key order, and the internal nodes only
+// hold separator keys, child pointers and the number of items under every child (which makes select O(log n)). Every
+// node takes about BTREE_NODE_BYTES bytes, so a lookup costs a few cache misses per level instead of one per key like
+// a binary tree, and the tree is much shallower. Nodes are searched with a branchless binary search. KEY and VALUE must
+// be single-token type names (use a typedef for e.g. unsigned long or char *).
+#define DECLARE_BTREE(KEY, VALUE, LESS)                                                                                         \
+DECLARE_BTREE_STRUCT(KEY, VALUE)                                                                                                \
+DEFINE_BTREE_CREATE(KEY, VALUE)                                                                                                 \
+DEFINE_BTREE_NODE_SEARCH(KEY, VALUE, LESS)                                                                                      \
+DEFINE_BTREE_SEARCH(KEY, VALUE, LESS)                                                                                           \
+DEFINE_BTREE_INSERT(KEY, VALUE, LESS)                                                                                           \
+DEFINE_BTREE_REMOVE(KEY, VALUE, LESS)                                                                                           \
+DEFINE_BTREE_BUILD(KEY, VALUE, LESS)                                                                                            \
+DEFINE_BTREE_ITERATE(KEY, VALUE, LESS)
+
+
+// Size of the key and value (or key and child) arrays of a node. 512 bytes (8 cache lines) give 64 int keys and values
+// per leaf, or 32 of 8-byte keys and values. A node holds at least 4 items whatever the size of the types.
+#ifndef BTREE_NODE_BYTES
+#define BTREE_NODE_BYTES 512
+#endif
+
+#define BTREE_CAPACITY(ITEM_SIZE) (BTREE_NODE_BYTES / (ITEM_SIZE) < 4 ? 4 : BTREE_NODE_BYTES / (ITEM_SIZE))
+
+
+// A leaf holds up to LEAF items and an internal node up to INNER keys and INNER + 1 children. Every node except the
+// root is at least half full. Internal nodes have room for one more key and child, which is used while a child split
+// is inserted just before the node itself splits.
+#define DECLARE_BTREE_STRUCT(KEY, VALUE)                                                                                        \
+enum {                                                                                                                          \
+    btree_##KEY##_##VALUE##_LEAF = BTREE_CAPACITY(sizeof(KEY) + sizeof(VALUE)),                                                 \
+    btree_##KEY##_##VALUE##_INNER = BTREE_CAPACITY(sizeof(KEY) + sizeof(void *) + sizeof(size_t))                               \
+};                                                                                                                              \
+                                                                                                                                \
+typedef struct btree_##KEY##_##VALUE##_leaf {                                                                                   \
+    unsigned int count;                                                                                                         \
+    struct btree_##KEY##_##VALUE##_leaf *prev;                                                                                  \
+    struct btree_##KEY##_##VALUE##_leaf *next;                                                                                  \
+    KEY keys[btree_##KEY##_##VALUE##_LEAF];                                                                                     \
+    VALUE values[btree_##KEY##_##VALUE##_LEAF];                                                                                 \
+} btree_##KEY##_##VALUE##_leaf;                                                                                                 \
+                                                                                                                                \
+typedef struct btree_##KEY##_##VALUE##_inner {                                                                                  \
+    unsigned int count;                                                                                                         \
+    KEY keys[btree_##KEY##_##VALUE##_INNER + 1];                                                                                \
+    void *children[btree_##KEY##_##VALUE##_INNER + 2];                                                                          \
+    size_t sizes[btree_##KEY##_##VALUE##_INNER + 2];                                                                            \
+} btree_##KEY##_##VALUE##_inner;                                                                                                \
+                                                                                                                                \
+typedef struct btree_##KEY##_##VALUE {                                                                                          \
+    void *root;                                                                                                                 \
+    size_t height;                                                                                                              \
+    size_t size;                                                                                                                \
+    btree_##KEY##_##VALUE##_leaf *first;                                                                                        \
+    btree_##KEY##_##VALUE##_leaf *last;                                                                                         \
+    Allocator allocator;                                                                                                        \
+} btree_##KEY##_##VALUE;                                                                                                        \
+                                                                                                                                \
+/* Position of an item in the linked leaves. It is invalid (leaf == NULL) past the last item */                                 \
+typedef struct btree_##KEY##_##VALUE##_iterator {                                                                               \
+    btree_##KEY##_##VALUE##_leaf *leaf;                                                                                         \
+    unsigned int index;                                                                                                         \
+} btree_##KEY##_##VALUE##_iterator;
+
+
+// Create an empty tree whose nodes are allocated with the given allocator (NULL uses malloc and free). Freeing the
+// tree frees its nodes, but keys and values which own memory have to be freed by the caller first (e.g. in for_each).
+#define DEFINE_BTREE_CREATE(KEY, VALUE)                                                                                         \
+static inline btree_##KEY##_##VALUE##_leaf *btree_##KEY##_##VALUE##_new_leaf(btree_##KEY##_##VALUE *tree) {                     \
+    btree_##KEY##_##VALUE##_leaf *leaf = allocator_alloc(&tree->allocator, sizeof(*leaf));                                      \
+    if (leaf == NULL) {                                                                                                         \
+        fprintf(stderr, "Failed to allocate a leaf of the B+ tree\n");                                                          \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    leaf->count = 0;                                                                                                            \
+    leaf->prev = leaf->next = NULL;                                                                                             \
+    return leaf;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE##_inner *btree_##KEY##_##VALUE##_new_inner(btree_##KEY##_##VALUE *tree) {                   \
+    btree_##KEY##_##VALUE##_inner *inner = allocator_alloc(&tree->allocator, sizeof(*inner));                                   \
+    if (inner == NULL) {                                                                                                        \
+        fprintf(stderr, "Failed to allocate an internal node of the B+ tree\n");                                                \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    inner->count = 0;                                                                                                           \
+    return inner;                                                                                                               \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE *btree_##KEY##_##VALUE##_create_with_allocator(const Allocator *allocator) {                \
+    btree_##KEY##_##VALUE *tree = allocator_alloc(allocator, sizeof(*tree));                                                    \
+    if (tree == NULL) {                                                                                                         \
+        fprintf(stderr, "Failed to allocate the B+ tree\n");                                                                    \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    tree->allocator = allocator != NULL ? *allocator : (Allocator){0};                                                          \
+    tree->height = 0;                                                                                                           \
+    tree->size = 0;                                                                                                             \
+    tree->first = tree->last = btree_##KEY##_##VALUE##_new_leaf(tree);                                                          \
+    tree->root = tree->first;                                                                                                   \
+    if (tree->root == NULL) {                                                                                                   \
+        Allocator copy = tree->allocator;                                                                                       \
+        allocator_free(&copy, tree, sizeof(*tree));                                                                             \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    return tree;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE *btree_##KEY##_##VALUE##_create(void) {                                                     \
+    return btree_##KEY##_##VALUE##_create_with_allocator(NULL);                                                                 \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void btree_##KEY##_##VALUE##_free_nodes(btree_##KEY##_##VALUE *tree, void *node, size_t level) {                  \
+    if (level == 0) {                                                                                                           \
+        allocator_free(&tree->allocator, node, sizeof(btree_##KEY##_##VALUE##_leaf));                                           \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    btree_##KEY##_##VALUE##_inner *inner = node;                                                                                \
+    for (unsigned int i = 0; i <= inner->count; i++)                                                                            \
+        btree_##KEY##_##VALUE##_free_nodes(tree, inner->children[i], level - 1);                                                \
+    allocator_free(&tree->allocator, inner, sizeof(*inner));                                                                    \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void btree_##KEY##_##VALUE##_free(btree_##KEY##_##VALUE *tree) {                                                  \
+    if (tree == NULL)                                                                                                           \
+        return;                                                                                                                 \
+    btree_##KEY##_##VALUE##_free_nodes(tree, tree->root, tree->height);                                                         \
+    Allocator allocator = tree->allocator;                                                                                      \
+    allocator_free(&allocator, tree, sizeof(*tree));                                                                            \
+}                                                                                                                               \
+                                                                                                                                \
+static inline size_t btree_##KEY##_##VALUE##_size(const btree_##KEY##_##VALUE *tree) {                                          \
+    return tree->size;                                                                                                          \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool btree_##KEY##_##VALUE##_empty(const btree_##KEY##_##VALUE *tree) {                                           \
+    return tree->size == 0;                                                                                                     \
+}                                                                                                                               \
+                                                                                                                                \
+/* Number of levels below the root (0 when the root is a leaf) */                                                               \
+static inline size_t btree_##KEY##_##VALUE##_height(const btree_##KEY##_##VALUE *tree) {                                        \
+    return tree->height;                                                                                                        \
+}
+
+
+// Branchless binary searches in the sorted keys of a node: lower returns the index of the first key which is not less
+// than key and upper the index of the first key which is greater than key (count if there is none). The loop halves
+// the range with a conditional move, so it has no unpredictable branches and always runs log2(count) times.
+#define DEFINE_BTREE_NODE_SEARCH(KEY, VALUE, LESS)                                                                              \
+static inline unsigned int btree_##KEY##_##VALUE##_lower(const KEY *keys, unsigned int count, KEY key) {                        \
+    if (count == 0)                                                                                                             \
+        return 0;                                                                                                               \
+    const KEY *base = keys;                                                                                                     \
+    while (count > 1) {                                                                                                         \
+        unsigned int half = count / 2;                                                                                          \
+        base = LESS(base[half], key) ? base + half : base;                                                                      \
+        count -= half;                                                                                                          \
+    }                                                                                                                           \
+    return (unsigned int)(base - keys) + (LESS(*base, key) ? 1 : 0);                                                            \
+}                                                                                                                               \
+                                                                                                                                \
+static inline unsigned int btree_##KEY##_##VALUE##_upper(const KEY *keys, unsigned int count, KEY key) {                        \
+    if (count == 0)                                                                                                             \
+        return 0;                                                                                                               \
+    const KEY *base = keys;                                                                                                     \
+    while (count > 1) {                                                                                                         \
+        unsigned int half = count / 2;                                                                                          \
+        base = LESS(key, base[half]) ? base : base + half;                                                                      \
+        count -= half;                                                                                                          \
+    }                                                                                                                           \
+    return (unsigned int)(base - keys) + (LESS(key, *base) ? 0 : 1);                                                            \
+}
+
+
+// Return a pointer to the value of the given key, or NULL if the key is not in the tree. The pointer is valid until the
+// tree is modified. The separator of two children is the smallest key of the right one, so keys which are equal to a
+// separator are searched on its right.
+#define DEFINE_BTREE_SEARCH(KEY, VALUE, LESS)                                                                                   \
+static inline btree_##KEY##_##VALUE##_leaf *btree_##KEY##_##VALUE##_find_leaf(const btree_##KEY##_##VALUE *tree, KEY key) {     \
+    void *node = tree->root;                                                                                                    \
+    for (size_t level = tree->height; level > 0; level--) {                                                                     \
+        btree_##KEY##_##VALUE##_inner *inner = node;                                                                            \
+        node = inner->children[btree_##KEY##_##VALUE##_upper(inner->keys, inner->count, key)];                                  \
+    }                                                                                                                           \
+    return node;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline VALUE *btree_##KEY##_##VALUE##_search(const btree_##KEY##_##VALUE *tree, KEY key) {                               \
+    btree_##KEY##_##VALUE##_leaf *leaf = btree_##KEY##_##VALUE##_find_leaf(tree, key);                                          \
+    unsigned int i = btree_##KEY##_##VALUE##_lower(leaf->keys, leaf->count, key);                                               \
+    return i < leaf->count && !LESS(key, leaf->keys[i]) ? &leaf->values[i] : NULL;                                              \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool btree_##KEY##_##VALUE##_contains(const btree_##KEY##_##VALUE *tree, KEY key) {                               \
+    return btree_##KEY##_##VALUE##_search(tree, key) != NULL;                                                                   \
+}
+
+
+// Insert the given key with the given value, or replace the value if the key is already in the tree. Return true if
+// the key was inserted. A full leaf is split in two halves and the separator of the halves is inserted into the parent,
+// which may split in turn; when the root splits the tree grows by one level. If a node cannot be allocated, false is
+// returned and the tree is left unchanged.
+#define DEFINE_BTREE_INSERT(KEY, VALUE, LESS)                                                                                   \
+/* Whether the node is full, so that an insert into it splits it */                                                             \
+static inline bool btree_##KEY##_##VALUE##_full(void *node, size_t level) {                                                     \
+    if (level == 0)                                                                                                             \
+        return ((btree_##KEY##_##VALUE##_leaf *)node)->count == btree_##KEY##_##VALUE##_LEAF;                                   \
+    return ((btree_##KEY##_##VALUE##_inner *)node)->count == btree_##KEY##_##VALUE##_INNER;                                     \
+}                                                                                                                               \
+                                                                                                                                \
+/* Split an internal node which has overflowed by one key, moving its upper half to right, which was allocated before */        \
+/* the insert, so that the node is never left over its capacity when the allocation fails */                                    \
+static inline void btree_##KEY##_##VALUE##_split_inner(btree_##KEY##_##VALUE##_inner *inner,                                    \
+                                                      btree_##KEY##_##VALUE##_inner *right, KEY *separator,                     \
+                                                      size_t *right_size) {                                                     \
+    unsigned int mid = inner->count / 2;                                                                                        \
+    *separator = inner->keys[mid];                                                                                              \
+    right->count = inner->count - mid - 1;                                                                                      \
+    memcpy(right->keys, inner->keys + mid + 1, right->count * sizeof(KEY));                                                     \
+    memcpy(right->children, inner->children + mid + 1, (right->count + 1) * sizeof(void *));                                    \
+    memcpy(right->sizes, inner->sizes + mid + 1, (right->count + 1) * sizeof(size_t));                                          \
+    inner->count = mid;                                                                                                         \
+    *right_size = 0;                                                                                                            \
+    for (unsigned int i = 0; i <= right->count; i++)                                                                            \
+        *right_size += right->sizes[i];                                                                                         \
+}                                                                                                                               \
+                                                                                                                                \
+/* Insert into the subtree of node. If node splits, its new right sibling is returned through split */                          \
+static inline bool btree_##KEY##_##VALUE##_insert_at(btree_##KEY##_##VALUE *tree, void *node, size_t level, KEY key,            \
+                                                    VALUE value, void **split, KEY *separator, size_t *split_size) {            \
+    *split = NULL;                                                                                                              \
+    if (level == 0) {                                                                                                           \
+        btree_##KEY##_##VALUE##_leaf *leaf = node;                                                                              \
+        unsigned int i = btree_##KEY##_##VALUE##_lower(leaf->keys, leaf->count, key);                                           \
+        if (i < leaf->count && !LESS(key, leaf->keys[i])) {                                                                     \
+            leaf->values[i] = value;                                                                                            \
+            return false;                                                                                                       \
+        }                                                                                                                       \
+        if (leaf->count == btree_##KEY##_##VALUE##_LEAF) {                                                                      \
+            btree_##KEY##_##VALUE##_leaf *right = btree_##KEY##_##VALUE##_new_leaf(tree);                                       \
+            if (right == NULL)                                                                                                  \
+                return false;                                                                                                   \
+            unsigned int mid = btree_##KEY##_##VALUE##_LEAF / 2;                                                                \
+            right->count = leaf->count - mid;                                                                                   \
+            memcpy(right->keys, leaf->keys + mid, right->count * sizeof(KEY));                                                  \
+            memcpy(right->values, leaf->values + mid, right->count * sizeof(VALUE));                                            \
+            leaf->count = mid;                                                                                                  \
+            right->prev = leaf;                                                                                                 \
+            right->next = leaf->next;                                                                                           \
+            if (leaf->next != NULL)                                                                                             \
+                leaf->next->prev = right;                                                                                       \
+            else                                                                                                                \
+                tree->last = right;                                                                                             \
+            leaf->next = right;                                                                                                 \
+            if (i > mid) {                                                                                                      \
+                leaf = right;                                                                                                   \
+                i -= mid;                                                                                                       \
+            }                                                                                                                   \
+            *split = right;                                                                                                     \
+        }                                                                                                                       \
+        memmove(leaf->keys + i + 1, leaf->keys + i, (leaf->count - i) * sizeof(KEY));                                           \
+        memmove(leaf->values + i + 1, leaf->values + i, (leaf->count - i) * sizeof(VALUE));                                     \
+        leaf->keys[i] = key;                                                                                                    \
+        leaf->values[i] = value;                                                                                                \
+        leaf->count++;                                                                                                          \
+        if (*split != NULL) {                                                                                                   \
+            *separator = ((btree_##KEY##_##VALUE##_leaf *)*split)->keys[0];                                                     \
+            *split_size = ((btree_##KEY##_##VALUE##_leaf *)*split)->count;                                                      \
+        }                                                                                                                       \
+        return true;                                                                                                            \
+    }                                                                                                                           \
+    btree_##KEY##_##VALUE##_inner *inner = node;                                                                                \
+    unsigned int i = btree_##KEY##_##VALUE##_upper(inner->keys, inner->count, key);                                             \
+    void *child_split;                                                                                                          \
+    KEY child_separator;                                                                                                        \
+    size_t child_size;                                                                                                          \
+    /* Only a full child can split, and then a full node splits too, so its new sibling is allocated before anything */         \
+    /* is changed */                                                                                                            \
+    btree_##KEY##_##VALUE##_inner *spare = NULL;                                                                                \
+    if (inner->count == btree_##KEY##_##VALUE##_INNER && btree_##KEY##_##VALUE##_full(inner->children[i], level - 1)) {         \
+        spare = btree_##KEY##_##VALUE##_new_inner(tree);                                                                        \
+        if (spare == NULL)                                                                                                      \
+            return false;                                                                                                       \
+    }                                                                                                                           \
+    if (!btree_##KEY##_##VALUE##_insert_at(tree, inner->children[i], level - 1, key, value, &child_split,                       \
+                                           &child_separator, &child_size)) {                                                    \
+        allocator_free(&tree->allocator, spare, sizeof(*spare));                                                                \
+        return false;                                                                                                           \
+    }                                                                                                                           \
+    inner->sizes[i]++;                                                                                                          \
+    if (child_split != NULL) {                                                                                                  \
+        memmove(inner->keys + i + 1, inner->keys + i, (inner->count - i) * sizeof(KEY));                                        \
+        memmove(inner->children + i + 2, inner->children + i + 1, (inner->count - i) * sizeof(void *));                         \
+        memmove(inner->sizes + i + 2, inner->sizes + i + 1, (inner->count - i) * sizeof(size_t));                               \
+        inner->keys[i] = child_separator;                                                                                       \
+        inner->children[i + 1] = child_split;                                                                                   \
+        inner->sizes[i + 1] = child_size;                                                                                       \
+        inner->sizes[i] -= child_size;                                                                                          \
+        inner->count++;                                                                                                         \
+        if (inner->count > btree_##KEY##_##VALUE##_INNER) {                                                                     \
+            btree_##KEY##_##VALUE##_split_inner(inner, spare, separator, split_size);                                           \
+            *split = spare;                                                                                                     \
+            spare = NULL;                                                                                                       \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    allocator_free(&tree->allocator, spare, sizeof(*spare));                                                                    \
+    return true;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool btree_##KEY##_##VALUE##_insert(btree_##KEY##_##VALUE *tree, KEY key, VALUE value) {                          \
+    void *split;                                                                                                                \
+    KEY separator;                                                                                                              \
+    size_t split_size;                                                                                                          \
+    /* The new root of a full root is allocated before the insert as well */                                                    \
+    btree_##KEY##_##VALUE##_inner *root = NULL;                                                                                 \
+    if (btree_##KEY##_##VALUE##_full(tree->root, tree->height)) {                                                               \
+        root = btree_##KEY##_##VALUE##_new_inner(tree);                                                                         \
+        if (root == NULL)                                                                                                       \
+            return false;                                                                                                       \
+    }                                                                                                                           \
+    if (!btree_##KEY##_##VALUE##_insert_at(tree, tree->root, tree->height, key, value, &split, &separator,                      \
+                                           &split_size)) {                                                                      \
+        allocator_free(&tree->allocator, root, sizeof(*root));                                                                  \
+        return false;                                                                                                           \
+    }                                                                                                                           \
+    tree->size++;                                                                                                               \
+    if (split == NULL)                                                                                                          \
+        allocator_free(&tree->allocator, root, sizeof(*root));                                                                  \
+    else {                                                                                                                      \
+        root->count = 1;                                                                                                        \
+        root->keys[0] = separator;                                                                                              \
+        root->children[0] = tree->root;                                                                                         \
+        root->children[1] = split;                                                                                              \
+        root->sizes[0] = tree->size - split_size;                                                                               \
+        root->sizes[1] = split_size;                                                                                            \
+        tree->root = root;                                                                                                      \
+        tree->height++;                                                                                                         \
+    }                                                                                                                           \
+    return true;                                                                                                                \
+}
+
+
+// Remove the given key from the tree and return true if it was in the tree. A child which falls below half full
+// borrows an item from a sibling, or is merged with it when the sibling is half full too; when the root is left with a
+// single child the tree shrinks by one level.
+#define DEFINE_BTREE_REMOVE(KEY, VALUE, LESS)                                                                                   \
+/* Merge child j + 1 of an internal node into child j and remove their separator */                                             \
+static inline void btree_##KEY##_##VALUE##_merge(btree_##KEY##_##VALUE *tree, btree_##KEY##_##VALUE##_inner *parent,            \
+                                                unsigned int j, size_t level) {                                                 \
+    if (level == 0) {                                                                                                           \
+        btree_##KEY##_##VALUE##_leaf *left = parent->children[j], *right = parent->children[j + 1];                             \
+        memcpy(left->keys + left->count, right->keys, right->count * sizeof(KEY));                                              \
+        memcpy(left->values + left->count, right->values, right->count * sizeof(VALUE));                                        \
+        left->count += right->count;                                                                                            \
+        left->next = right->next;                                                                                               \
+        if (right->next != NULL)                                                                                                \
+            right->next->prev = left;                                                                                           \
+        else                                                                                                                    \
+            tree->last = left;                                                                                                  \
+        allocator_free(&tree->allocator, right, sizeof(*right));                                                                \
+    } else {                                                                                                                    \
+        btree_##KEY##_##VALUE##_inner *left = parent->children[j], *right = parent->children[j + 1];                            \
+        left->keys[left->count] = parent->keys[j];                                                                              \
+        memcpy(left->keys + left->count + 1, right->keys, right->count * sizeof(KEY));                                          \
+        memcpy(left->children + left->count + 1, right->children, (right->count + 1) * sizeof(void *));                         \
+        memcpy(left->sizes + left->count + 1, right->sizes, (right->count + 1) * sizeof(size_t));                               \
+        left->count += right->count + 1;                                                                                        \
+        allocator_free(&tree->allocator, right, sizeof(*right));                                                                \
+    }                                                                                                                           \
+    parent->sizes[j] += parent->sizes[j + 1];                                                                                   \
+    memmove(parent->keys + j, parent->keys + j + 1, (parent->count - j - 1) * sizeof(KEY));                                     \
+    memmove(parent->children + j + 1, parent->children + j + 2, (parent->count - j - 1) * sizeof(void *));                      \
+    memmove(parent->sizes + j + 1, parent->sizes + j + 2, (parent->count - j - 1) * sizeof(size_t));                            \
+    parent->count--;                                                                                                            \
+}                                                                                                                               \
+                                                                                                                                \
+/* Refill child i of an internal node if it has fallen below half full */                                                       \
+static inline void btree_##KEY##_##VALUE##_rebalance(btree_##KEY##_##VALUE *tree, btree_##KEY##_##VALUE##_inner *parent,        \
+                                                    unsigned int i, size_t level) {                                             \
+    if (level == 0) {                                                                                                           \
+        btree_##KEY##_##VALUE##_leaf *child = parent->children[i];                                                              \
+        if (child->count >= btree_##KEY##_##VALUE##_LEAF / 2)                                                                   \
+            return;                                                                                                             \
+        btree_##KEY##_##VALUE##_leaf *left = i > 0 ? parent->children[i - 1] : NULL;                                            \
+        btree_##KEY##_##VALUE##_leaf *right = i < parent->count ? parent->children[i + 1] : NULL;                               \
+        if (left != NULL && left->count > btree_##KEY##_##VALUE##_LEAF / 2) {                                                   \
+            memmove(child->keys + 1, child->keys, child->count * sizeof(KEY));                                                  \
+            memmove(child->values + 1, child->values, child->count * sizeof(VALUE));                                            \
+            left->count--;                                                                                                      \
+            child->keys[0] = left->keys[left->count];                                                                           \
+            child->values[0] = left->values[left->count];                                                                       \
+            child->count++;                                                                                                     \
+            parent->keys[i - 1] = child->keys[0];                                                                               \
+            parent->sizes[i - 1]--;                                                                                             \
+            parent->sizes[i]++;                                                                                                 \
+        } else if (right != NULL && right->count > btree_##KEY##_##VALUE##_LEAF / 2) {                                          \
+            child->keys[child->count] = right->keys[0];                                                                         \
+            child->values[child->count] = right->values[0];                                                                     \
+            child->count++;                                                                                                     \
+            right->count--;                                                                                                     \
+            memmove(right->keys, right->keys + 1, right->count * sizeof(KEY));                                                  \
+            memmove(right->values, right->values + 1, right->count * sizeof(VALUE));                                            \
+            parent->keys[i] = right->keys[0];                                                                                   \
+            parent->sizes[i + 1]--;                                                                                             \
+            parent->sizes[i]++;                                                                                                 \
+        } else {                                                                                                                \
+            btree_##KEY##_##VALUE##_merge(tree, parent, left != NULL ? i - 1 : i, level);                                       \
+        }                                                                                                                       \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    btree_##KEY##_##VALUE##_inner *child = parent->children[i];                                                                 \
+    if (child->count >= btree_##KEY##_##VALUE##_INNER / 2)                                                                      \
+        return;                                                                                                                 \
+    btree_##KEY##_##VALUE##_inner *left = i > 0 ? parent->children[i - 1] : NULL;                                               \
+    btree_##KEY##_##VALUE##_inner *right = i < parent->count ? parent->children[i + 1] : NULL;                                  \
+    if (left != NULL && left->count > btree_##KEY##_##VALUE##_INNER / 2) {                                                      \
+        /* Rotate the last child of the left sibling through the separator */                                                   \
+        memmove(child->keys + 1, child->keys, child->count * sizeof(KEY));                                                      \
+        memmove(child->children + 1, child->children, (child->count + 1) * sizeof(void *));                                     \
+        memmove(child->sizes + 1, child->sizes, (child->count + 1) * sizeof(size_t));                                           \
+        child->keys[0] = parent->keys[i - 1];                                                                                   \
+        child->children[0] = left->children[left->count];                                                                       \
+        child->sizes[0] = left->sizes[left->count];                                                                             \
+        child->count++;                                                                                                         \
+        parent->keys[i - 1] = left->keys[left->count - 1];                                                                      \
+        parent->sizes[i - 1] -= child->sizes[0];                                                                                \
+        parent->sizes[i] += child->sizes[0];                                                                                    \
+        left->count--;                                                                                                          \
+    } else if (right != NULL && right->count > btree_##KEY##_##VALUE##_INNER / 2) {                                             \
+        /* Rotate the first child of the right sibling through the separator */                                                 \
+        child->keys[child->count] = parent->keys[i];                                                                            \
+        child->children[child->count + 1] = right->children[0];                                                                 \
+        child->sizes[child->count + 1] = right->sizes[0];                                                                       \
+        child->count++;                                                                                                         \
+        parent->keys[i] = right->keys[0];                                                                                       \
+        parent->sizes[i + 1] -= right->sizes[0];                                                                                \
+        parent->sizes[i] += right->sizes[0];                                                                                    \
+        memmove(right->keys, right->keys + 1, (right->count - 1) * sizeof(KEY));                                                \
+        memmove(right->children, right->children + 1, right->count * sizeof(void *));                                           \
+        memmove(right->sizes, right->sizes + 1, right->count * sizeof(size_t));                                                 \
+        right->count--;                                                                                                         \
+    } else {                                                                                                                    \
+        btree_##KEY##_##VALUE##_merge(tree, parent, left != NULL ? i - 1 : i, level);                                           \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool btree_##KEY##_##VALUE##_remove_at(btree_##KEY##_##VALUE *tree, void *node, size_t level, KEY key) {          \
+    if (level == 0) {                                                                                                           \
+        btree_##KEY##_##VALUE##_leaf *leaf = node;                                                                              \
+        unsigned int i = btree_##KEY##_##VALUE##_lower(leaf->keys, leaf->count, key);                                           \
+        if (i == leaf->count || LESS(key, leaf->keys[i]))                                                                       \
+            return false;                                                                                                       \
+        leaf->count--;                                                                                                          \
+        memmove(leaf->keys + i, leaf->keys + i + 1, (leaf->count - i) * sizeof(KEY));                                           \
+        memmove(leaf->values + i, leaf->values + i + 1, (leaf->count - i) * sizeof(VALUE));                                     \
+        return true;                                                                                                            \
+    }                                                                                                                           \
+    btree_##KEY##_##VALUE##_inner *inner = node;                                                                                \
+    unsigned int i = btree_##KEY##_##VALUE##_upper(inner->keys, inner->count, key);                                             \
+    if (!btree_##KEY##_##VALUE##_remove_at(tree, inner->children[i], level - 1, key))                                           \
+        return false;                                                                                                           \
+    inner->sizes[i]--;                                                                                                          \
+    btree_##KEY##_##VALUE##_rebalance(tree, inner, i, level - 1);                                                               \
+    return true;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool btree_##KEY##_##VALUE##_remove(btree_##KEY##_##VALUE *tree, KEY key) {                                       \
+    if (!btree_##KEY##_##VALUE##_remove_at(tree, tree->root, tree->height, key))                                                \
+        return false;                                                                                                           \
+    tree->size--;                                                                                                               \
+    if (tree->height > 0 && ((btree_##KEY##_##VALUE##_inner *)tree->root)->count == 0) {                                        \
+        btree_##KEY##_##VALUE##_inner *root = tree->root;                                                                       \
+        tree->root = root->children[0];                                                                                         \
+        tree->height--;                                                                                                         \
+        allocator_free(&tree->allocator, root, sizeof(*root));                                                                  \
+    }                                                                                                                           \
+    return true;                                                                                                                \
+}
+
+
+// Create a tree from count keys in strictly ascending order and their values, filling the leaves and the internal
+// nodes bottom-up in O(n) instead of inserting the keys one by one. Return NULL if the keys are not sorted.
+#define DEFINE_BTREE_BUILD(KEY, VALUE, LESS)                                                                                    \
+/* Number of the items (or children) of the i-th of parts nodes when count of them are spread evenly */                         \
+static inline size_t btree_##KEY##_##VALUE##_share(size_t count, size_t parts, size_t i) {                                      \
+    return count / parts + (i < count % parts ? 1 : 0);                                                                         \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE *btree_##KEY##_##VALUE##_build_sorted(const KEY *keys, const VALUE *values,                 \
+                                                                        size_t count, const Allocator *allocator) {             \
+    for (size_t i = 1; i < count; i++) {                                                                                        \
+        if (!LESS(keys[i - 1], keys[i])) {                                                                                      \
+            fprintf(stderr, "The keys of the B+ tree are not in strictly ascending order\n");                                   \
+            return NULL;                                                                                                        \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    btree_##KEY##_##VALUE *tree = btree_##KEY##_##VALUE##_create_with_allocator(allocator);                                     \
+    if (tree == NULL || count == 0)                                                                                             \
+        return tree;                                                                                                            \
+    /* The nodes of the current level, the smallest key under each of them and the number of items under them */                \
+    size_t nodes = (count + btree_##KEY##_##VALUE##_LEAF - 1) / btree_##KEY##_##VALUE##_LEAF;                                   \
+    void **level = malloc(nodes * sizeof(void *));                                                                              \
+    KEY *mins = malloc(nodes * sizeof(KEY));                                                                                    \
+    size_t *sizes = malloc(nodes * sizeof(size_t));                                                                             \
+    if (level == NULL || mins == NULL || sizes == NULL) {                                                                       \
+        fprintf(stderr, "Failed to allocate memory for building the B+ tree\n");                                                \
+        free(level);                                                                                                            \
+        free(mins);                                                                                                             \
+        free(sizes);                                                                                                            \
+        return tree;                                                                                                            \
+    }                                                                                                                           \
+    btree_##KEY##_##VALUE##_leaf *leaf = tree->first, *prev = NULL;                                                             \
+    for (size_t n = 0, start = 0; n < nodes; n++) {                                                                             \
+        if (n > 0 && (leaf = btree_##KEY##_##VALUE##_new_leaf(tree)) == NULL) {                                                 \
+            /* Every leaf so far is linked from the first one */                                                                \
+            for (leaf = tree->first; leaf != NULL; leaf = prev) {                                                               \
+                prev = leaf->next;                                                                                              \
+                allocator_free(&tree->allocator, leaf, sizeof(*leaf));                                                          \
+            }                                                                                                                   \
+            Allocator copy = tree->allocator;                                                                                   \
+            allocator_free(&copy, tree, sizeof(*tree));                                                                         \
+            free(level);                                                                                                        \
+            free(mins);                                                                                                         \
+            free(sizes);                                                                                                        \
+            return NULL;                                                                                                        \
+        }                                                                                                                       \
+        leaf->count = (unsigned int)btree_##KEY##_##VALUE##_share(count, nodes, n);                                             \
+        memcpy(leaf->keys, keys + start, leaf->count * sizeof(KEY));                                                            \
+        memcpy(leaf->values, values + start, leaf->count * sizeof(VALUE));                                                      \
+        leaf->prev = prev;                                                                                                      \
+        if (prev != NULL)                                                                                                       \
+            prev->next = leaf;                                                                                                  \
+        tree->last = prev = leaf;                                                                                               \
+        level[n] = leaf;                                                                                                        \
+        mins[n] = leaf->keys[0];                                                                                                \
+        sizes[n] = leaf->count;                                                                                                 \
+        start += leaf->count;                                                                                                   \
+        tree->size += leaf->count;                                                                                              \
+    }                                                                                                                           \
+    while (nodes > 1) {                                                                                                         \
+        size_t parents = (nodes + btree_##KEY##_##VALUE##_INNER) / (btree_##KEY##_##VALUE##_INNER + 1);                         \
+        for (size_t p = 0, child = 0; p < parents; p++) {                                                                       \
+            btree_##KEY##_##VALUE##_inner *inner = btree_##KEY##_##VALUE##_new_inner(tree);                                     \
+            if (inner == NULL) {                                                                                                \
+                /* Free the parents built so far and the nodes which have no parent yet */                                      \
+                for (size_t q = 0; q < p; q++)                                                                                  \
+                    btree_##KEY##_##VALUE##_free_nodes(tree, level[q], tree->height + 1);                                       \
+                for (; child < nodes; child++)                                                                                  \
+                    btree_##KEY##_##VALUE##_free_nodes(tree, level[child], tree->height);                                       \
+                Allocator copy = tree->allocator;                                                                               \
+                allocator_free(&copy, tree, sizeof(*tree));                                                                     \
+                free(level);                                                                                                    \
+                free(mins);                                                                                                     \
+                free(sizes);                                                                                                    \
+                return NULL;                                                                                                    \
+            }                                                                                                                   \
+            size_t children = btree_##KEY##_##VALUE##_share(nodes, parents, p), total = 0;                                      \
+            KEY min = mins[child];                                                                                              \
+            inner->count = (unsigned int)children - 1;                                                                          \
+            for (size_t c = 0; c < children; c++, child++) {                                                                    \
+                if (c > 0)                                                                                                      \
+                    inner->keys[c - 1] = mins[child];                                                                           \
+                inner->children[c] = level[child];                                                                              \
+                inner->sizes[c] = sizes[child];                                                                                 \
+                total += sizes[child];                                                                                          \
+            }                                                                                                                   \
+            level[p] = inner;                                                                                                   \
+            mins[p] = min;                                                                                                      \
+            sizes[p] = total;                                                                                                   \
+        }                                                                                                                       \
+        nodes = parents;                                                                                                        \
+        tree->height++;                                                                                                         \
+    }                                                                                                                           \
+    tree->root = level[0];                                                                                                      \
+    free(level);                                                                                                                \
+    free(mins);                                                                                                                 \
+    free(sizes);                                                                                                                \
+    return tree;                                                                                                                \
+}
+
+
+// Walk the items in ascending order of their keys through the linked leaves. begin returns the first item,
+// lower_bound the first item whose key is not less than key and select_k_th_item the k-th smallest item (k starts at
+// 1 like RBT_select_k_th_item); they return an invalid iterator if there is no such item. range calls visit for every
+// key in [low, high) and (a pointer to) its value, and for_each for every item. visit may change the value, but it
+// must not insert or remove keys.
+#define DEFINE_BTREE_ITERATE(KEY, VALUE, LESS)                                                                                  \
+static inline btree_##KEY##_##VALUE##_iterator btree_##KEY##_##VALUE##_iterator_at(btree_##KEY##_##VALUE##_leaf *leaf,          \
+                                                                                  unsigned int index) {                         \
+    /* A position past the end of a leaf moves to the start of the next one */                                                  \
+    if (index == leaf->count) {                                                                                                 \
+        leaf = leaf->next;                                                                                                      \
+        index = 0;                                                                                                              \
+    }                                                                                                                           \
+    return (btree_##KEY##_##VALUE##_iterator){ .leaf = leaf, .index = index };                                                  \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE##_iterator btree_##KEY##_##VALUE##_begin(const btree_##KEY##_##VALUE *tree) {               \
+    return btree_##KEY##_##VALUE##_iterator_at(tree->first, 0);                                                                 \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE##_iterator btree_##KEY##_##VALUE##_lower_bound(const btree_##KEY##_##VALUE *tree,           \
+                                                                                  KEY key) {                                    \
+    btree_##KEY##_##VALUE##_leaf *leaf = btree_##KEY##_##VALUE##_find_leaf(tree, key);                                          \
+    return btree_##KEY##_##VALUE##_iterator_at(leaf, btree_##KEY##_##VALUE##_lower(leaf->keys, leaf->count, key));              \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE##_iterator btree_##KEY##_##VALUE##_select_k_th_item(const btree_##KEY##_##VALUE *tree,      \
+                                                                                       size_t k) {                              \
+    if (k == 0 || k > tree->size)                                                                                               \
+        return (btree_##KEY##_##VALUE##_iterator){ .leaf = NULL, .index = 0 };                                                  \
+    k--;                                                                                                                        \
+    void *node = tree->root;                                                                                                    \
+    for (size_t level = tree->height; level > 0; level--) {                                                                     \
+        btree_##KEY##_##VALUE##_inner *inner = node;                                                                            \
+        unsigned int i = 0;                                                                                                     \
+        while (k >= inner->sizes[i])                                                                                            \
+            k -= inner->sizes[i++];                                                                                             \
+        node = inner->children[i];                                                                                              \
+    }                                                                                                                           \
+    return (btree_##KEY##_##VALUE##_iterator){ .leaf = node, .index = (unsigned int)k };                                        \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool btree_##KEY##_##VALUE##_iterator_valid(btree_##KEY##_##VALUE##_iterator it) {                                \
+    return it.leaf != NULL;                                                                                                     \
+}                                                                                                                               \
+                                                                                                                                \
+static inline KEY btree_##KEY##_##VALUE##_iterator_key(btree_##KEY##_##VALUE##_iterator it) {                                   \
+    return it.leaf->keys[it.index];                                                                                             \
+}                                                                                                                               \
+                                                                                                                                \
+static inline VALUE *btree_##KEY##_##VALUE##_iterator_value(btree_##KEY##_##VALUE##_iterator it) {                              \
+    return &it.leaf->values[it.index];                                                                                          \
+}                                                                                                                               \
+                                                                                                                                \
+static inline btree_##KEY##_##VALUE##_iterator btree_##KEY##_##VALUE##_iterator_next(btree_##KEY##_##VALUE##_iterator it) {     \
+    return btree_##KEY##_##VALUE##_iterator_at(it.leaf, it.index + 1);                                                          \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void btree_##KEY##_##VALUE##_range(const btree_##KEY##_##VALUE *tree, KEY low, KEY high,                          \
+                                                void (*visit)(KEY key, VALUE *value, void *ctx), void *ctx) {                   \
+    btree_##KEY##_##VALUE##_iterator it = btree_##KEY##_##VALUE##_lower_bound(tree, low);                                       \
+    for (btree_##KEY##_##VALUE##_leaf *leaf = it.leaf; leaf != NULL; leaf = leaf->next, it.index = 0) {                         \
+        for (unsigned int i = it.index; i < leaf->count; i++) {                                                                 \
+            if (!LESS(leaf->keys[i], high))                                                                                     \
+                return;                                                                                                         \
+            visit(leaf->keys[i], &leaf->values[i], ctx);                                                                        \
+        }                                                                                                                       \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void btree_##KEY##_##VALUE##_for_each(const btree_##KEY##_##VALUE *tree,                                          \
+                                                   void (*visit)(KEY key, VALUE *value, void *ctx), void *ctx) {                \
+    for (btree_##KEY##_##VALUE##_leaf *leaf = tree->first; leaf != NULL; leaf = leaf->next) {                                   \
+        for (unsigned int i = 0; i < leaf->count; i++)                                                                          \
+            visit(leaf->keys[i], &leaf->values[i], ctx);                                                                        \
+    }                                                                                                                           \
+}
+
+#endif
@@ -11,15 +11,30 @@ struct bloom_filter{
     unsigned int size;
     HashFunc *hash;
     unsigned int hash_count;
+    Allocator allocator;
 };
 
 
 
 //Function to create a bloom filter
 BloomFilter bloom_filter_create(unsigned int size, unsigned int hash_count, HashFunc *hash) {
+    return bloom_filter_create_with_allocator(size, hash_count, hash, NULL);
+}
+
+
+// Size in bytes of the bit array of a bloom filter of the given size
+static inline size_t bit_array_size(unsigned int size) {
+    return (size << 3) | 1;
+}
+
+
+//Function to create a bloom filter which allocates its memory with the given allocator (NULL uses malloc and free)
+BloomFilter bloom_filter_create_with_allocator(unsigned int size, unsigned int hash_count, HashFunc *hash, const Allocator *allocator) {
     
-    BloomFilter bf = malloc(sizeof(*bf));
-    bf->bit_array = calloc((size << 3) | 1, sizeof(unsigned char));
+    BloomFilter bf = allocator_alloc(allocator, sizeof(*bf));
+    assert(bf != NULL);
+    bf->allocator = allocator != NULL ? *allocator : (Allocator){0};
+    bf->bit_array = allocator_calloc(&bf->allocator, bit_array_size(size), sizeof(unsigned char));
     assert(bf->bit_array != NULL);
     bf->size = size;
     bf->hash_count = hash_count;
@@ -70,6 +85,7 @@ void bloom_filter_reset(BloomFilter bf) {
 
 //Function to destroy the bloom filter
 void bloom_filter_destroy(BloomFilter bf) {
-    free(bf->bit_array);
-    free(bf);
+    allocator_free(&bf->allocator, bf->bit_array, bit_array_size(bf->size));
+    Allocator allocator = bf->allocator;
+    allocator_free(&allocator, bf, sizeof(*bf));
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define CODE_HASHTABLE_H
 
 #include <stdbool.h>
+#include "../Allocator/Allocator.h"
 
 
 typedef struct bloom_filter *BloomFilter;
@@ -13,6 +14,9 @@ typedef size_t (*HashFunc)(void *);
 //Function to create a bloom filter
 BloomFilter bloom_filter_create(unsigned int size, unsigned int hash_count, HashFunc *hash);
 
+// Function to create a bloom filter which allocates its memory with the given allocator (NULL uses malloc and free)
+BloomFilter bloom_filter_create_with_allocator(unsigned int size, unsigned int hash_count, HashFunc *hash, const Allocator *allocator);
+
 // Function to insert a key into the bloom filter
 void bloom_filter_insert(BloomFilter bf, void *key);
 
@@ -0,0 +1,151 @@
+/* File: ConcurrentHashMap.c */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "ConcurrentHashMap.h"
+#include "../SeparateChainingHashTable/ChainingHashTable.h"
+
+
+// The locks of neighbouring shards are on different cache lines, so threads which lock different shards do not make
+// the line bounce between their cores (false sharing)
+#define CACHE_LINE 64
+
+#define SHARDS_PER_PROCESSOR 16
+
+
+typedef struct {
+    _Alignas(CACHE_LINE) pthread_mutex_t lock;
+    SCHashtable *table;
+} shard;
+
+
+struct concurrent_hash_map {
+    shard *shards;
+    size_t num_shards;   // A power of two
+    HashFunc hash_function;
+};
+
+
+// Create a hash map whose keys are spread over the given number of shards
+ConcurrentHashMap *CHM_create(size_t shards, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, HashFunc hash) {
+    if(shards == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        shards = (online > 0 ? online : 1) * SHARDS_PER_PROCESSOR;
+    }
+    ConcurrentHashMap *map = malloc(sizeof(*map));
+    assert(map != NULL);
+    map->num_shards = 1;
+    while(map->num_shards < shards)
+        map->num_shards *= 2;
+    map->hash_function = hash;
+
+    map->shards = aligned_alloc(CACHE_LINE, map->num_shards * sizeof(shard));
+    assert(map->shards != NULL);
+    for(size_t i = 0 ; i < map->num_shards ; i++) {
+        pthread_mutex_init(&map->shards[i].lock, NULL);
+        map->shards[i].table = SChashtable_create(compare, NULL, destroy_key, destroy_value, hash);
+    }
+    return map;
+}
+
+
+// Returns the number of shards of the map
+size_t CHM_shards(ConcurrentHashMap *map) {
+    return map->num_shards;
+}
+
+
+// Returns the shard of the given key. The shard is taken from the high bits of the hash multiplied by a large odd
+// constant, so it does not depend on the low bits which choose the bucket inside the table of the shard
+static inline shard *CHM_shard(ConcurrentHashMap *map, void *key) {
+    uint64_t hash = (uint64_t)map->hash_function(key) * 0x9E3779B97F4A7C15ULL;
+    return &map->shards[(hash >> 32) & (map->num_shards - 1)];
+}
+
+
+// Returns the number of keys of the map
+size_t CHM_size(ConcurrentHashMap *map) {
+    size_t size = 0;
+    for(size_t i = 0 ; i < map->num_shards ; i++) {
+        pthread_mutex_lock(&map->shards[i].lock);
+        size += SChashtable_size(map->shards[i].table);
+        pthread_mutex_unlock(&map->shards[i].lock);
+    }
+    return size;
+}
+
+
+// Insert the key with the given value, or replace the value if the key already exists
+void CHM_put(ConcurrentHashMap *map, void *key, void *value) {
+    shard *s = CHM_shard(map, key);
+    pthread_mutex_lock(&s->lock);
+    SChashtable_insert(s->table, key, value);
+    pthread_mutex_unlock(&s->lock);
+}
+
+
+// Search the given key and return its value, or NULL if the key is not in the map
+void *CHM_get(ConcurrentHashMap *map, void *key) {
+    shard *s = CHM_shard(map, key);
+    pthread_mutex_lock(&s->lock);
+    void *value = SChashtable_search(s->table, key);
+    pthread_mutex_unlock(&s->lock);
+    return value;
+}
+
+
+// Search the given key and call visit with its value while the shard of the key is locked
+bool CHM_get_with(ConcurrentHashMap *map, void *key, VisitValueFunc visit, void *ctx) {
+    shard *s = CHM_shard(map, key);
+    pthread_mutex_lock(&s->lock);
+    void *value = SChashtable_search(s->table, key);
+    // The values of the map are never NULL
+    bool found = value != NULL;
+    if(found)
+        visit(value, ctx);
+    pthread_mutex_unlock(&s->lock);
+    return found;
+}
+
+
+// Remove the given key from the map. Returns true if the key was in the map
+bool CHM_remove(ConcurrentHashMap *map, void *key) {
+    shard *s = CHM_shard(map, key);
+    pthread_mutex_lock(&s->lock);
+    size_t size = SChashtable_size(s->table);
+    SChashtable_remove(s->table, key);
+    bool removed = SChashtable_size(s->table) < size;
+    pthread_mutex_unlock(&s->lock);
+    return removed;
+}
+
+
+// Return the value of the given key, computing and inserting it if the key is not in the map
+void *CHM_compute_if_absent(ConcurrentHashMap *map, void *key, ComputeFunc compute, void *ctx) {
+    shard *s = CHM_shard(map, key);
+    pthread_mutex_lock(&s->lock);
+    void *value = SChashtable_search(s->table, key);
+    if(value == NULL) {
+        value = compute(key, ctx);
+        if(value != NULL)
+            SChashtable_insert(s->table, key, value);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return value;
+}
+
+
+// Destroy the map - free the memory which is allocated by the map and destroy the keys and the values
+void CHM_destroy(ConcurrentHashMap *map) {
+    for(size_t i = 0 ; i < map->num_shards ; i++) {
+        SChashtable_destroy(map->shards[i].table);
+        pthread_mutex_destroy(&map->shards[i].lock);
+    }
+    free(map->shards);
+    free(map);
+}
@@ -0,0 +1,70 @@
+/* File: ConcurrentHashMap.h */
+#ifndef CONCURRENT_HASH_MAP_H
+#define CONCURRENT_HASH_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+typedef struct concurrent_hash_map ConcurrentHashMap;
+
+// Compare functions for the different data type
+typedef int (*CompareFunc)(void *, void *);
+
+//Functions to destroy values inserted in the hash map
+typedef void (*DestroyFunc)(void *);
+
+// Functions to visit nodes printing their data
+typedef void (*PrintFunc)(void *);
+
+// Function which returns a hash value according to the given key
+typedef size_t (*HashFunc)(void *);
+
+// Functions which compute the value of a key which is not in the map (compute_if_absent)
+typedef void *(*ComputeFunc)(void *key, void *ctx);
+
+// Functions which visit the value of a key while its shard is locked (get_with)
+typedef void (*VisitValueFunc)(void *value, void *ctx);
+
+
+// Create a hash map which can be used by many threads at the same time. The keys are spread over the given number of
+// shards (rounded up to a power of two, 0 uses 16 shards per online processor), and every shard is a separate chaining
+// hash table with its own lock, so threads which use different shards never wait for each other. A shard grows on its
+// own while only its lock is held, so a resize never stops the other shards. Keys and values are destroyed with
+// destroy_key and destroy_value (if they are not NULL) when they are removed or replaced
+ConcurrentHashMap *CHM_create(size_t shards, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, HashFunc hash);
+
+// Returns the number of shards of the map
+size_t CHM_shards(ConcurrentHashMap *map);
+
+// Returns the number of keys of the map. Every shard is counted while it is locked, but the shards are not locked
+// together, so with concurrent updates the result is only a snapshot of each shard
+size_t CHM_size(ConcurrentHashMap *map);
+
+// Insert the key with the given value, or replace the value if the key already exists. The value must not be NULL,
+// which CHM_get returns for missing keys
+void CHM_put(ConcurrentHashMap *map, void *key, void *value);
+
+// Search the given key and return its value, or NULL if the key is not in the map. If other threads may remove or
+// replace the key while its values are destroyed by the map, use CHM_get_with instead, since the returned value may be
+// destroyed at any time
+void *CHM_get(ConcurrentHashMap *map, void *key);
+
+// Search the given key and call visit with its value while the shard of the key is locked. Returns false (without
+// calling visit) if the key is not in the map
+bool CHM_get_with(ConcurrentHashMap *map, void *key, VisitValueFunc visit, void *ctx);
+
+// Remove the given key from the map. Returns true if the key was in the map
+bool CHM_remove(ConcurrentHashMap *map, void *key);
+
+// Return the value of the given key. If the key is not in the map, compute(key, ctx) is called and its result is
+// inserted with the key and returned (unless it is NULL, in which case nothing is inserted). The shard of the key is
+// locked during the call, so compute is called at most once for a key even if many threads ask for it together, and
+// it must not use the map
+void *CHM_compute_if_absent(ConcurrentHashMap *map, void *key, ComputeFunc compute, void *ctx);
+
+// Destroy the map - free the memory which is allocated by the map and destroy the keys and the values. No other
+// thread may use the map during or after this call
+void CHM_destroy(ConcurrentHashMap *map);
+
+#endif
@@ -11,17 +11,42 @@
 
 #define MAX_LOAD_FACTOR 0.7
 
+// Robin Hood tables keep their probe sequences short without tombstones, so they can be filled much more
+#define ROBIN_HOOD_MAX_LOAD_FACTOR 0.9
+
+// A remove which leaves fewer items than this share of the slots shrinks the table, so that its load factor becomes
+// about half of the maximum. The gap between the two keeps a table whose size moves around a boundary from growing
+// and shrinking again and again
+#define MIN_LOAD_FACTOR 0.1
+
+// Number of lookups of DHhashtable_search_batch whose cache misses overlap
+#define BATCH_GROUP 16
+
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+
+// Instrumentation counters are compiled in only when the library is built with -DDS_STATS
+#ifdef DS_STATS
+#define DH_STATS(statement) statement
+#else
+#define DH_STATS(statement)
+#endif
+
 
 // The numbers in the following array are considered to be good hash table primes (https://planetmath.org/goodDHhashtableprimes)
 static int prime_numbers[] = {53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593, 49157, 98317, 196613, 393241,
 	786433, 1572869, 3145739, 6291469, 12582917, 25165843, 50331653, 100663319, 201326611, 402653189, 805306457, 1610612741};
 
-
-static int primes_index = 0;
+#define PRIMES (sizeof(prime_numbers) / sizeof(prime_numbers[0]))
 
 
 typedef enum {
-    EMPTY, OCCUPIED, DELETED
+    EMPTY, OCCUPIED, DELETED,
+    MOVING // Occupied slot whose item has not been placed yet by DHhashtable_compact
 } State;
 
 
@@ -29,6 +54,7 @@ typedef struct {
     void *key;
     void *value;
     State state;
+    unsigned int distance; // Robin Hood mode: distance of the slot from the home slot of the key
 } DHhashtable_node;
 
 
@@ -44,16 +70,30 @@ struct DHhashtable {
     DestroyFunc destroy_value;
     HashFunc hash_function; // First hash
     HashFunc hash_function_2; // Second hash
+    bool robin_hood; // Linear probing with Robin Hood insertion and backward shift deletion instead of double hashing
+    double max_load_factor;
+    size_t min_capacity; // The table does not shrink below the capacity which was reserved
+    Allocator allocator;
+#ifdef DS_STATS
+    DHhashtable_stats stats;
+#endif
 };
 
 
 DHHashtable *DHhashtable_create(CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, PrintFunc print, HashFunc hash, HashFunc hash2) {
-    DHHashtable *h = malloc(sizeof(*h));
+    return DHhashtable_create_with_allocator(compare, destroy_key, destroy_value, print, hash, hash2, NULL);
+}
+
+
+// Create and initialize a hash table which allocates its memory with the given allocator (NULL uses malloc and free)
+DHHashtable *DHhashtable_create_with_allocator(CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, PrintFunc print, HashFunc hash, HashFunc hash2, const Allocator *allocator) {
+    DHHashtable *h = allocator_alloc(allocator, sizeof(*h));
     assert(h != NULL);
+    h->allocator = allocator != NULL ? *allocator : (Allocator){0};
 
-    h->capacity = prime_numbers[primes_index];
+    h->capacity = h->min_capacity = prime_numbers[0];
 
-    h->table = calloc(h->capacity, sizeof(*h->table));
+    h->table = allocator_calloc(&h->allocator, h->capacity, sizeof(*h->table));
     assert(h->table != NULL);
 
     h->size = h->deleted_items = 0;
@@ -64,7 +104,21 @@ DHHashtable *DHhashtable_create(CompareFunc compare, DestroyFunc destroy_key, De
     h->print = print;
     h->hash_function = hash;
     h->hash_function_2 = hash2;
+    h->robin_hood = false;
+    h->max_load_factor = MAX_LOAD_FACTOR;
+
+    DH_STATS(memset(&h->stats, 0, sizeof(h->stats)));
+
+    return h;
+}
 
+
+// Create and initialize a hash table in the Robin Hood mode, which probes linearly from the home slot of a key and
+// keeps the keys of every probe sequence ordered by their distance from their home slots
+DHHashtable *DHhashtable_create_robin_hood(CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, PrintFunc print, HashFunc hash, const Allocator *allocator) {
+    DHHashtable *h = DHhashtable_create_with_allocator(compare, destroy_key, destroy_value, print, hash, NULL, allocator);
+    h->robin_hood = true;
+    h->max_load_factor = ROBIN_HOOD_MAX_LOAD_FACTOR;
     return h;
 }
 
@@ -89,11 +143,20 @@ static size_t DHhashtable_hash(DHHashtable *h, void *key) {
 // Hash function : returns the secondary hash value according to the given key
 size_t DHhashtable_secondary_hash(DHHashtable *h, void *key) {
     assert(h != NULL && key != NULL);
+    if(h->robin_hood)
+        return 1;
     size_t hash_value = h->capacity - (h->hash_function_2(key) % h->capacity);
     return hash_value != 0 ? hash_value : 1;
 }
 
 
+// Call the compare function of the hash table
+static inline int DHhashtable_compare(DHHashtable *h, void *key1, void *key2) {
+    DH_STATS(h->stats.compares++);
+    return h->compare(key1, key2);
+}
+
+
 // Check if given number is prime 
 static bool isprime(size_t n) {
 	if((n % 2 == 0 && n != 2) || (n % 3 == 0 && n != 3))
@@ -106,55 +169,176 @@ static bool isprime(size_t n) {
 }
 
 
-// Resizes the hash table and rehashes the keys of the nodes which are currently occupied
-static DHHashtable *DHhashtable_resize(DHHashtable *h) {
+// Returns the smallest capacity which is at least n: a prime of the array, or after its last prime the next prime number
+static size_t DHhashtable_prime_capacity(size_t n) {
+    for(size_t i = 0 ; i < PRIMES ; i++)
+        if((size_t)prime_numbers[i] >= n)
+            return prime_numbers[i];
+    while(!isprime(n))
+        n++;
+    return n;
+}
+
+
+// Returns the capacity in which the given number of items stay below the given load factor
+static size_t DHhashtable_capacity_for(size_t items, double load_factor) {
+    return DHhashtable_prime_capacity((size_t)(items / load_factor) + 1);
+}
+
+
+// Resizes the hash table to the given capacity and rehashes the keys of the nodes which are currently occupied
+static DHHashtable *DHhashtable_resize(DHHashtable *h, size_t capacity) {
     size_t old_capacity = h->capacity;
     DHhashtable_node *old_table = h->table;
 
-    // Update the capacity of the hash table
-    if(++primes_index < sizeof(prime_numbers) / sizeof(int))
-        h->capacity = prime_numbers[primes_index];
-    else
-        // If the primes index has exceeded the size of the array which holds the prime numbers, we should find the next prime number manually
-        while(!isprime(++(h->capacity)));
-
-    h->table = calloc(h->capacity , sizeof(*h->table));
+    h->capacity = capacity;
+    h->table = allocator_calloc(&h->allocator, h->capacity, sizeof(*h->table));
     assert(h->table != NULL);
 
-    h->size = 0;
+    // The tombstones are not copied into the new table
+    h->size = h->deleted_items = 0;
+
+    // Rehashing is not counted as lookups, only as a resize
+    DH_STATS(DHhashtable_stats stats = h->stats);
+    DH_STATS(stats.resizes++);
 
     // We insert only entries which store indeed an element (eliminate deleted nodes)
     for(int i = 0 ; i < old_capacity ; i++)
         if(old_table[i].state == OCCUPIED)
             DHhashtable_insert(h, old_table[i].key, old_table[i].value);
 
-    free(old_table);
+    DH_STATS(h->stats = stats);
+
+    allocator_free(&h->allocator, old_table, old_capacity * sizeof(*old_table));
     return h;
 }
 
 
+// Grow the hash table to the next prime capacity (about twice the current one)
+static DHHashtable *DHhashtable_grow(DHHashtable *h) {
+    size_t last_prime = prime_numbers[PRIMES - 1];
+    return DHhashtable_resize(h, DHhashtable_prime_capacity(h->capacity < last_prime ? h->capacity + 1 : 2 * h->capacity));
+}
+
+
+// Shrink the hash table after a remove if its items fill less than MIN_LOAD_FACTOR of the slots. The new capacity is
+// the one with a load factor of about half of the maximum, but not less than the reserved capacity
+static void DHhashtable_shrink_if_sparse(DHHashtable *h) {
+    if(h->capacity <= h->min_capacity || (double)h->size >= MIN_LOAD_FACTOR * h->capacity)
+        return;
+    size_t capacity = DHhashtable_capacity_for(h->size, h->max_load_factor / 2);
+    if(capacity < h->min_capacity)
+        capacity = h->min_capacity;
+    if(capacity < h->capacity)
+        DHhashtable_resize(h, capacity);
+}
+
+
+// Robin Hood mode: return the position of the key (capacity if the key is not in the hash table). The keys of a
+// probe sequence are ordered by their distance from their home slots, so the search stops at the first key which is
+// closer to its home slot than the searched key would be, and only the keys with the same home slot are compared
+static size_t DHhashtable_robin_hood_find(DHHashtable *h, void *key) {
+    size_t pos = DHhashtable_hash(h, key);
+    DH_STATS(h->stats.operations++);
+    for (unsigned int distance = 0 ; ; distance++) {
+        DHhashtable_node *node = &h->table[pos];
+        DH_STATS(h->stats.probes++);
+        if (node->state == EMPTY || node->distance < distance)
+            return h->capacity;
+        if (node->distance == distance && DHhashtable_compare(h, node->key, key) == 0)
+            return pos;
+        pos = pos + 1 < h->capacity ? pos + 1 : 0;
+    }
+}
+
+
+// Robin Hood mode: insert the key or replace its value. On the way to an empty slot, the item which is carried takes
+// the slot of every item which is closer to its home slot (a "richer" item), and that item is carried on instead
+static void DHhashtable_robin_hood_insert(DHHashtable *h, void *key, void *value) {
+    size_t pos = DHhashtable_hash(h, key);
+    DHhashtable_node carried = {key, value, OCCUPIED, 0};
+    bool displaced = false;
+    DH_STATS(h->stats.operations++);
+    for ( ; ; carried.distance++) {
+        DHhashtable_node *node = &h->table[pos];
+        DH_STATS(h->stats.probes++);
+        if (node->state == EMPTY) {
+            *node = carried;
+            h->size++;
+            return;
+        }
+        // Once an item has been displaced, the given key cannot be further in the table
+        if (!displaced && node->distance == carried.distance && DHhashtable_compare(h, node->key, key) == 0) {
+            if(h->destroy_value)
+                h->destroy_value(node->value);
+            node->value = value;
+            return;
+        }
+        if (node->distance < carried.distance) {
+            DHhashtable_node richer = *node;
+            *node = carried;
+            carried = richer;
+            displaced = true;
+        }
+        pos = pos + 1 < h->capacity ? pos + 1 : 0;
+    }
+}
+
+
+// Robin Hood mode: delete the key and shift the following items of its probe sequence one slot back, so that no
+// tombstone is left and every shifted item gets one slot closer to its home slot
+static bool DHhashtable_robin_hood_remove(DHHashtable *h, void *key) {
+    size_t pos = DHhashtable_robin_hood_find(h, key);
+    if (pos == h->capacity)
+        return false;
+    if (h->destroy_key != NULL)
+        h->destroy_key(h->table[pos].key);
+    if (h->destroy_value != NULL)
+        h->destroy_value(h->table[pos].value);
+    size_t next = pos + 1 < h->capacity ? pos + 1 : 0;
+    while (h->table[next].state == OCCUPIED && h->table[next].distance > 0) {
+        h->table[pos] = h->table[next];
+        h->table[pos].distance--;
+        pos = next;
+        next = next + 1 < h->capacity ? next + 1 : 0;
+    }
+    h->table[pos].state = EMPTY;
+    h->size--;
+    return true;
+}
+
+
 // Inserts a [key - value] pair into the hash table (Implementing ADT Map)
 DHHashtable *DHhashtable_insert(DHHashtable *h, void *key, void *value) {
     if(h == NULL){
         fprintf(stderr, "Given hash table does not exist\n");
         return NULL;
     }
+    if(h->robin_hood) {
+        DHhashtable_robin_hood_insert(h, key, value);
+        if((double)h->size / (double)h->capacity > h->max_load_factor)
+            DHhashtable_grow(h);
+        return h;
+    }
     bool already_in_hashtable = false, first_probe = true;
     DHhashtable_node *node = NULL;
     size_t pos, step_size = DHhashtable_secondary_hash(h, key);
+    DH_STATS(h->stats.operations++);
 
     // Search until we find empty position to nsert the given data
     for(pos = DHhashtable_hash(h, key) ; h->table[pos].state != EMPTY ; pos = (pos + step_size) % h->capacity) {
-        
+        DH_STATS(h->stats.probes++);
+
         // Found position in which an item has been deleted
         // Do not end the loop, because the given data might already exist in the hash table
         // Continue until the next empty position, or until you find that a node with the same key is already inserted into the hash table 
         if(h->table[pos].state == DELETED) {
+            DH_STATS(h->stats.tombstones++);
             if(node == NULL)
                 node = &h->table[pos];
         }
         // Found item eith the same key
-        else if(h->compare(h->table[pos].key, key) == 0) {
+        else if(DHhashtable_compare(h, h->table[pos].key, key) == 0) {
             already_in_hashtable = true;
             node = &h->table[pos];
             break;
@@ -170,6 +354,8 @@ DHHashtable *DHhashtable_insert(DHHashtable *h, void *key, void *value) {
                step_size = 1;
         }
     }
+    // The empty position which ended the probing
+    DH_STATS(if(!already_in_hashtable) h->stats.probes++);
 
     if(node == NULL)
         node = &h->table[pos];
@@ -193,47 +379,160 @@ DHHashtable *DHhashtable_insert(DHHashtable *h, void *key, void *value) {
 
     // Check if the hash table needs to be resized
     double load_factor = ((double)(h->size + h->deleted_items)) / ((double) h->capacity);
-    if(load_factor > MAX_LOAD_FACTOR)
-        DHhashtable_resize(h);
+    if(load_factor > h->max_load_factor)
+        DHhashtable_grow(h);
 
     return h;
 }
 
 
-// Function which searches a value according to the given key and returns the value if it finds the key, otherwise it returns NULL 
-void *DHhashtable_search(DHHashtable *h, void *key) {
-    if (h == NULL) {
-        fprintf(stderr, "Given hash table does not exist\n");
-        return NULL;
-    }
+// Walk the probe sequence of the given key, which starts at position start with the given step, and return its value
+// (NULL if the key is not in the hash table)
+static void *DHhashtable_probe(DHHashtable *h, void *key, size_t start, size_t step_size) {
     bool first_probe = true;
-    size_t step_size = DHhashtable_secondary_hash(h, key);
-    for (size_t i = DHhashtable_hash(h, key) ; h->table[i].state != EMPTY ; i = (i + step_size) % h->capacity) {
-        if ((h->table[i].state == OCCUPIED) && (h->compare(h->table[i].key, key) == 0))
+    DH_STATS(h->stats.operations++);
+    for (size_t i = start ; h->table[i].state != EMPTY ; i = (i + step_size) % h->capacity) {
+        DH_STATS(h->stats.probes++);
+        DH_STATS(if(h->table[i].state == DELETED) h->stats.tombstones++);
+        if ((h->table[i].state == OCCUPIED) && (DHhashtable_compare(h, h->table[i].key, key) == 0))
             return h->table[i].value;
-        if (i == DHhashtable_hash(h, key)) {
+        if (i == start) {
             if(first_probe)
                 first_probe = false;
             else
                step_size = 1;
         }
     }
+    DH_STATS(h->stats.probes++);
     return NULL;
 }
 
 
+// Function which searches a value according to the given key and returns the value if it finds the key, otherwise it returns NULL 
+void *DHhashtable_search(DHHashtable *h, void *key) {
+    if (h == NULL) {
+        fprintf(stderr, "Given hash table does not exist\n");
+        return NULL;
+    }
+    if (h->robin_hood) {
+        size_t pos = DHhashtable_robin_hood_find(h, key);
+        return pos < h->capacity ? h->table[pos].value : NULL;
+    }
+    return DHhashtable_probe(h, key, DHhashtable_hash(h, key), DHhashtable_secondary_hash(h, key));
+}
+
+
+// State of a lookup of DHhashtable_search_batch: the slot which it waits for, its probe sequence (in the Robin Hood
+// mode the distance of the slot from the home slot) and whether the key of the slot has been prefetched and can be
+// compared
+typedef struct {
+    void *key;
+    size_t pos;
+    size_t start;
+    size_t step_size;
+    unsigned int distance;
+    bool first_probe;
+    bool key_ready;
+    bool done;
+} DHhashtable_lookup;
+
+
+// Move the lookup to the next slot of its probe sequence (the same sequence as DHhashtable_probe) and prefetch it
+static inline void DHhashtable_lookup_advance(DHHashtable *h, DHhashtable_lookup *lookup) {
+    if (lookup->pos == lookup->start) {
+        if(lookup->first_probe)
+            lookup->first_probe = false;
+        else
+            lookup->step_size = 1;
+    }
+    lookup->pos = (lookup->pos + lookup->step_size) % h->capacity;
+    lookup->distance++;
+    PREFETCH(&h->table[lookup->pos]);
+}
+
+
+// Search the given keys in groups of BATCH_GROUP lookups, which are interleaved (asynchronous memory access chaining).
+// A probe is split in the load of the slot and the load of its key (which is compared through a pointer), and each
+// load misses the cache. In every round each unfinished lookup uses the memory which it prefetched in the previous
+// round and prefetches the next slot or key, so the misses of the whole group are in flight together, also for the
+// lookups which walk over collisions and tombstones
+void DHhashtable_search_batch(DHHashtable *h, void **keys, size_t count, void **values) {
+    if (h == NULL) {
+        fprintf(stderr, "Given hash table does not exist\n");
+        return;
+    }
+    DHhashtable_lookup lookups[BATCH_GROUP];
+    for (size_t first = 0 ; first < count ; first += BATCH_GROUP) {
+        size_t group = count - first < BATCH_GROUP ? count - first : BATCH_GROUP;
+        for (size_t j = 0 ; j < group ; j++) {
+            DHhashtable_lookup *lookup = &lookups[j];
+            lookup->key = keys[first + j];
+            lookup->pos = lookup->start = DHhashtable_hash(h, lookup->key);
+            lookup->step_size = DHhashtable_secondary_hash(h, lookup->key);
+            lookup->distance = 0;
+            lookup->first_probe = true;
+            lookup->key_ready = lookup->done = false;
+            values[first + j] = NULL;
+            PREFETCH(&h->table[lookup->pos]);
+            DH_STATS(h->stats.operations++);
+        }
+        for (size_t active = group ; active > 0 ; ) {
+            active = 0;
+            for (size_t j = 0 ; j < group ; j++) {
+                DHhashtable_lookup *lookup = &lookups[j];
+                if (lookup->done)
+                    continue;
+                DHhashtable_node *node = &h->table[lookup->pos];
+                if (node->state == EMPTY || (h->robin_hood && node->distance < lookup->distance)) {
+                    DH_STATS(h->stats.probes++);
+                    lookup->done = true;
+                    continue;
+                }
+                // Robin Hood tables only compare the keys with the same home slot
+                bool candidate = node->state == OCCUPIED && (!h->robin_hood || node->distance == lookup->distance);
+                if (candidate && !lookup->key_ready) {
+                    PREFETCH(node->key);
+                    lookup->key_ready = true;
+                    active++;
+                    continue;
+                }
+                DH_STATS(h->stats.probes++);
+                DH_STATS(if(node->state == DELETED) h->stats.tombstones++);
+                if (lookup->key_ready && DHhashtable_compare(h, node->key, lookup->key) == 0) {
+                    values[first + j] = node->value;
+                    lookup->done = true;
+                    continue;
+                }
+                lookup->key_ready = false;
+                DHhashtable_lookup_advance(h, lookup);
+                active++;
+            }
+        }
+    }
+}
+
+
 // Deletes node with given key from the hash table using double hashing for probing
 bool DHhashtable_remove(DHHashtable *h, void *key) {
     if (h == NULL) {
         fprintf(stderr, "Given hash table does not exist\n");
         return false;
     }
+    if (h->robin_hood) {
+        if (!DHhashtable_robin_hood_remove(h, key))
+            return false;
+        DHhashtable_shrink_if_sparse(h);
+        return true;
+    }
 
     size_t step_size = DHhashtable_secondary_hash(h, key);
     bool first_probe = true;
+    DH_STATS(h->stats.operations++);
 
     for (size_t i = DHhashtable_hash(h, key) ; h->table[i].state != EMPTY ; i = (i + step_size) % h->capacity) {
-        if ((h->table[i].state == OCCUPIED) && (h->compare(h->table[i].key, key) == 0)) {
+        DH_STATS(h->stats.probes++);
+        DH_STATS(if(h->table[i].state == DELETED) h->stats.tombstones++);
+        if ((h->table[i].state == OCCUPIED) && (DHhashtable_compare(h, h->table[i].key, key) == 0)) {
             if (h->destroy_key != NULL)
                 h->destroy_key(h->table[i].key);
             if (h->destroy_value != NULL)
@@ -242,6 +541,7 @@ bool DHhashtable_remove(DHHashtable *h, void *key) {
 
             h->deleted_items++;
             h->size--;
+            DHhashtable_shrink_if_sparse(h);
             return true;
         }
 
@@ -252,11 +552,79 @@ bool DHhashtable_remove(DHHashtable *h, void *key) {
                step_size = 1;
         }
     }
+    DH_STATS(h->stats.probes++);
 
     return false;
 }
 
 
+// Make room for the given number of items, so that inserting them does not resize the hash table. The table does not
+// shrink below this capacity afterwards
+void DHhashtable_reserve(DHHashtable *h, size_t items) {
+    if(h == NULL){
+        fprintf(stderr, "Given hash table does not exist\n");
+        return;
+    }
+    h->min_capacity = items > 0 ? DHhashtable_capacity_for(items, h->max_load_factor) : (size_t)prime_numbers[0];
+    if(h->capacity < h->min_capacity)
+        DHhashtable_resize(h, h->min_capacity);
+}
+
+
+// Returns the first slot of the probe sequence of the key which is not occupied (the same sequence as the inserts)
+static size_t DHhashtable_compact_slot(DHHashtable *h, void *key) {
+    size_t start = DHhashtable_hash(h, key), step_size = DHhashtable_secondary_hash(h, key), pos = start;
+    bool first_probe = true;
+    while(h->table[pos].state == OCCUPIED) {
+        if(pos == start) {
+            if(first_probe)
+                first_probe = false;
+            else
+                step_size = 1;
+        }
+        pos = (pos + step_size) % h->capacity;
+    }
+    return pos;
+}
+
+
+// Remove the tombstones without changing the capacity. The tombstones become empty slots and the items are marked as
+// moving. Then every moving item is taken out of its slot and put in the first slot of its probe sequence which is not
+// occupied. If that slot holds another moving item, the two are swapped and the other item is placed next, so every
+// step places one item for good. The slots before the slot of a placed item stay occupied, so it can always be found
+void DHhashtable_compact(DHHashtable *h) {
+    if(h == NULL){
+        fprintf(stderr, "Given hash table does not exist\n");
+        return;
+    }
+    // The Robin Hood mode does not leave tombstones
+    if(h->robin_hood || h->deleted_items == 0)
+        return;
+    for(size_t i = 0 ; i < h->capacity ; i++) {
+        if(h->table[i].state == DELETED)
+            h->table[i].state = EMPTY;
+        else if(h->table[i].state == OCCUPIED)
+            h->table[i].state = MOVING;
+    }
+    for(size_t i = 0 ; i < h->capacity ; i++) {
+        if(h->table[i].state != MOVING)
+            continue;
+        DHhashtable_node carried = h->table[i];
+        h->table[i].state = EMPTY;
+        for( ; ; ) {
+            size_t pos = DHhashtable_compact_slot(h, carried.key);
+            DHhashtable_node displaced = h->table[pos];
+            h->table[pos] = carried;
+            h->table[pos].state = OCCUPIED;
+            if(displaced.state == EMPTY)
+                break;
+            carried = displaced;
+        }
+    }
+    h->deleted_items = 0;
+}
+
+
 // Function which prints the values of the hash table
 void DHhashtable_print(DHHashtable *h) {
     if(h == NULL){
@@ -278,6 +646,28 @@ void DHhashtable_print(DHHashtable *h) {
 }
 
 
+// Return a snapshot of the instrumentation counters of the hash table
+DHhashtable_stats DHhashtable_get_stats(DHHashtable *h) {
+    DHhashtable_stats stats = {0};
+    if(h == NULL)
+        return stats;
+#ifdef DS_STATS
+    stats = h->stats;
+#endif
+    stats.bytes_allocated = sizeof(*h) + h->capacity * sizeof(*h->table);
+    return stats;
+}
+
+
+// Reset the instrumentation counters of the hash table
+void DHhashtable_reset_stats(DHHashtable *h) {
+#ifdef DS_STATS
+    if(h != NULL)
+        memset(&h->stats, 0, sizeof(h->stats));
+#endif
+}
+
+
 // Destroy hash table - free the memory which is allocated by the hash table
 void DHhashtable_destroy(DHHashtable *h) {
     for(int i = 0 ; i < h->capacity ; i++) {
@@ -288,6 +678,7 @@ void DHhashtable_destroy(DHHashtable *h) {
                 h->destroy_value(h->table[i].value);
         }
     }
-    free(h->table);
-    free(h);
+    allocator_free(&h->allocator, h->table, h->capacity * sizeof(*h->table));
+    Allocator allocator = h->allocator;
+    allocator_free(&allocator, h, sizeof(*h));
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #ifndef DHHASHTABLE_H
 #define DHHASHTABLE_H
 
+#include "../Allocator/Allocator.h"
+
 
 typedef struct DHhashtable DHHashtable;
 
@@ -17,9 +19,31 @@ typedef void (*PrintFunc)(void *);
 // Function which returns a hash value according to the given key
 typedef size_t (*HashFunc)(void *);
 
+// Counters of the hot paths of a hash table. They are only updated when the library is built with -DDS_STATS
+// (make STATS=1 in lib), so they cost nothing otherwise and stay zero. bytes_allocated is always filled in.
+// The average number of probes per lookup is probes / operations.
+typedef struct {
+    size_t operations;      // Searches, inserts and removes (each one walks a probe sequence)
+    size_t probes;          // Slots visited by the probe sequences
+    size_t tombstones;      // Deleted slots visited by the probe sequences
+    size_t compares;        // Calls of the compare function
+    size_t resizes;         // Times the table has grown or shrunk
+    size_t bytes_allocated; // Bytes currently allocated by the table itself (keys and values are not included)
+} DHhashtable_stats;
+
 // Create and initialize hash table
 DHHashtable *DHhashtable_create(CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, PrintFunc print, HashFunc hash, HashFunc hash2);
 
+// Create and initialize a hash table which allocates its memory with the given allocator (NULL uses malloc and free)
+DHHashtable *DHhashtable_create_with_allocator(CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, PrintFunc print, HashFunc hash, HashFunc hash2, const Allocator *allocator);
+
+// Create and initialize a hash table in the Robin Hood mode (NULL allocator uses malloc and free). It probes linearly
+// from the home slot of a key instead of using a second hash, moves the keys which are far from their home slots ahead
+// of the keys which are close to theirs, and removes keys by shifting the next keys back instead of leaving tombstones.
+// Searches for missing keys stop early, the table can be filled up to a load factor of 0.9, and tables with constant
+// inserts and removes do not grow because of deleted slots
+DHHashtable *DHhashtable_create_robin_hood(CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, PrintFunc print, HashFunc hash, const Allocator *allocator);
+
 // Function which returns the size of the hash table (how many items does it currently store) or -1 if given hash table does not exist
 size_t DHhashtable_size(DHHashtable *h);
 
@@ -30,12 +54,32 @@ DHHashtable *DHhashtable_insert(DHHashtable *h, void *key, void *value);
 // Function which searches a value according to the given key and returns the value if it finds the key, otherwise it returns NULL 
 void *DHhashtable_search(DHHashtable *h, void *key);
 
-// Deletes node with given key from the hash table
+// Search count keys at once and store the value of keys[i] (NULL if it is not in the hash table) in values[i]. The
+// lookups are interleaved, so it is much faster than count calls of DHhashtable_search when the table does not fit
+// in the cache
+void DHhashtable_search_batch(DHHashtable *h, void **keys, size_t count, void **values);
+
+// Deletes node with given key from the hash table. If fewer than a tenth of the slots are left occupied, the table
+// shrinks to a load factor of about half of the maximum (but not below the reserved capacity)
 bool DHhashtable_remove(DHHashtable *h, void *key);
 
+// Make room for the given number of items before a bulk load, so that inserting them does not resize the hash table
+// again and again. Removes do not shrink the table below this capacity afterwards (reserving 0 items lifts the limit)
+void DHhashtable_reserve(DHHashtable *h, size_t items);
+
+// Purge the tombstones (deleted slots) in place, without changing the capacity, so lookups no longer probe over them
+// and they no longer count in the load factor. The Robin Hood mode has no tombstones, so it does nothing there
+void DHhashtable_compact(DHHashtable *h);
+
 // Function which prints the values of the hash table
 void DHhashtable_print(DHHashtable *h);
 
+// Return a snapshot of the instrumentation counters of the hash table
+DHhashtable_stats DHhashtable_get_stats(DHHashtable *h);
+
+// Reset the instrumentation counters of the hash table
+void DHhashtable_reset_stats(DHHashtable *h);
+
 // Destroy hash table - free the memory which is allocated by the hash table
 void DHhashtable_destroy(DHHashtable *h);
 
@@ -9,6 +9,17 @@ struct listnode{
     Listptr prev;
 };
 
+
+//Allocator of the nodes of all the lists (zeroed means malloc and free)
+static Allocator allocator;
+
+
+//Set the allocator of the nodes of all the lists (NULL restores malloc and free)
+void DLL_set_allocator(const Allocator *new_allocator) {
+    allocator = new_allocator != NULL ? *new_allocator : (Allocator){0};
+}
+
+
 //Initialize list (and return the pointers of the head and the tail of it)
 void DLL_Create(Listptr *head, Listptr *tail) {
    *head = *tail = NULL;
@@ -100,7 +111,7 @@ void DLL_AddBefore(Listptr *node, void *i, Listptr *head) {
         fprintf(stderr, "Fail to add the node");
         return;
     }
-    Listptr new_node = malloc(sizeof(struct listnode));
+    Listptr new_node = allocator_alloc(&allocator, sizeof(struct listnode));
     if(new_node == NULL) { /*The given node is not appropriate*/
         fprintf(stderr, "Error while allocating memory\n");
         return;
@@ -124,7 +135,7 @@ void DLL_AddAfter(Listptr *node, void *i, Listptr *tail) {
         fprintf(stderr, "Fail to add the node. The given node does not exists.\n");
         return;
     }
-    Listptr new_node = malloc(sizeof(struct listnode));
+    Listptr new_node = allocator_alloc(&allocator, sizeof(struct listnode));
     if(new_node == NULL) { /*The given node is not appropriate*/
         fprintf(stderr, "Error while allocating memory\n");
         return;
@@ -145,7 +156,7 @@ void DLL_AddAfter(Listptr *node, void *i, Listptr *tail) {
 //add a node with data-item "i" at the beginning of the list
 void DLL_AddFirst(Listptr *head, Listptr *tail, void *i) {
     Listptr templist = *head; /*Save the head of the list*/
-    *head = malloc(sizeof(struct listnode));
+    *head = allocator_alloc(&allocator, sizeof(struct listnode));
     if(*head == NULL) { /*The given node is not appropriate*/
         fprintf(stderr, "Error while allocating memory\n");
         return;
@@ -165,7 +176,7 @@ void DLL_AddFirst(Listptr *head, Listptr *tail, void *i) {
 //add a node with data-item "i" at the end of the list
 void DLL_AddLast(Listptr *tail, Listptr *head, void *i) {
     Listptr templist = *tail;
-    *tail = malloc(sizeof(struct listnode));
+    *tail = allocator_alloc(&allocator, sizeof(struct listnode));
     if(*tail == NULL) {
         fprintf(stderr, "Error while allocating memory\n");
         return;
@@ -192,67 +203,23 @@ static inline void DLL_delete_node(Listptr node, DestroyFunc destroy) {
     if (destroy) {
         destroy(node->data);
     }
-    free(node); /* free the memory allocated for the node */
+    allocator_free(&allocator, node, sizeof(*node)); /* free the memory allocated for the node */
 }
 
 
 //removes all the nodes with data "i" from the list
 void DLL_Remove(Listptr *head, Listptr *tail, void *i, CompareFunc compare, DestroyFunc destroy) {
-    Listptr tempnode;
-    bool onlyonenode = true;
-    while((*head != *tail) && (*head != NULL) && ((*head)->prev != *tail)) {
-        onlyonenode = false;
-        if((*head)->data == i) {
-            if((*head)->prev == NULL) {
-                tempnode = *head;
-                *head = (*head)->next;
-                tempnode->next->prev = NULL; /*update the next node's previous pointer*/
-                if(destroy)
-                    destroy(tempnode->data);
-                free(tempnode); /*free the memory allocated for the node*/
-            }
-            else {
-                tempnode = *head;
-                head = &((*head)->next);
-                DLL_delete_node(tempnode, destroy);
-            }
-        }
-        else {
-            head = &((*head)->next);
-        }
-        if((*tail)->data == i) {
-            if((*tail)->next == NULL) {
-                tempnode = *tail;
-                *tail = (*tail)->prev;
-                tempnode->prev->next = NULL; /*update the previous node's next pointer*/
-                if(destroy)
-                    destroy(tempnode->data);
-                free(tempnode); /*free the memory allocated for the node*/
-            }
-            else {
-                tempnode = *tail;
-                tail = &((*tail)->prev);
-                DLL_delete_node(tempnode, destroy);
-            }
-        }
-        else {
-            tail = &((*tail)->prev);
-        }
-    }
-    if(*head == *tail) {
-        if((*head)->data == i) {
-            if(onlyonenode) {
-                if(destroy)
-                    destroy((*head)->data);
-                free(*head);
-                *head = *tail = NULL;
-            }
-            else {
-                tempnode = *head;
-                head = &((*head)->next);
-                DLL_delete_node(tempnode, destroy);
-            }
+    Listptr node = *head;
+    while(node != NULL) {
+        Listptr next = node->next; /*the node might be freed, so keep its next node*/
+        if(node->data == i) {
+            if(node == *head)
+                *head = node->next;
+            if(node == *tail)
+                *tail = node->prev;
+            DLL_delete_node(node, destroy);
         }
+        node = next;
     }
 }
 
@@ -276,19 +243,11 @@ void DLL_print(Listptr head, PrintFunc print) {
 
 //free the double linked list
 void DLL_freelist(Listptr head, Listptr tail, DestroyFunc destroy) {
-    while((head != tail) && (head != NULL) && (head->prev != tail)) {
+    while(head != NULL) {
         Listptr temp = head;
         head = head->next;
         if(destroy)
             destroy(temp->data);
-        free(temp);
-        temp = tail;
-        tail = tail->prev;
-        if(destroy)
-            destroy(temp->data);
-        free(temp);
+        allocator_free(&allocator, temp, sizeof(*temp));
     }
-    if(destroy)
-        destroy(head->data);
-    free(head);
 }
\ No newline at end of file
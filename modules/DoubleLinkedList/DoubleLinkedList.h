@@ -5,6 +5,7 @@
 typedef struct listnode *Listptr;
 
 #include <stdbool.h>
+#include "../Allocator/Allocator.h"
 
 typedef struct {
     Listptr head;
@@ -20,6 +21,10 @@ typedef void (*DestroyFunc)(void *);
 // Functions to visit nodes printing their data
 typedef void (*PrintFunc)(void *);
 
+//Set the allocator of the nodes of all the lists (NULL restores malloc and free). A list is just a pair of pointers, so
+//the allocator is shared by the whole module and it should only be changed while no list has nodes
+void DLL_set_allocator(const Allocator *allocator);
+
 //Initialize list (and return the pointers of the head and the tail of it)
 void DLL_Create(Listptr *head, Listptr *tail);
 
@@ -0,0 +1,285 @@
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "../Allocator/Allocator.h"
+
+// Open addressing hash map which stores its keys and values inline, generated for a key and a value type:
+//     #define U64_HASH(k) hashmap_hash_u64(k)
+//     #define U64_EQ(a, b) ((a) == (b))
+//     DECLARE_HASHMAP(uint64_t, uint32_t, U64_HASH, U64_EQ)
+//     hashmap_uint64_t_uint32_t *map = hashmap_uint64_t_uint32_t_create(0);
+//     hashmap_uint64_t_uint32_t_put(map, 42, 7);
+//     uint32_t *value = hashmap_uint64_t_uint32_t_get(map, 42);
+// HASH(key) returns a size_t and EQ(a, b) returns true when two keys are equal. Both are called with keys (not
+// pointers) and can be function-like macros or static inline functions, so no call goes through a function pointer.
+// Keys, values and one control byte per slot live in three flat arrays. The control byte is 0 for an empty slot and
+// holds 7 bits of the hash of the key otherwise, so a lookup calls EQ only for keys whose bits match. Collisions are
+// resolved with linear probing and removals shift the following keys back, so there are no tombstones. KEY and VALUE
+// must be single-token type names (use a typedef for e.g. unsigned long or char *).
+#define DECLARE_HASHMAP(KEY, VALUE, HASH, EQ)                                                                                   \
+DECLARE_HASHMAP_STRUCT(KEY, VALUE)                                                                                              \
+DEFINE_HASHMAP_CREATE(KEY, VALUE)                                                                                               \
+DEFINE_HASHMAP_SLOT(KEY, VALUE, HASH)                                                                                           \
+DEFINE_HASHMAP_GET(KEY, VALUE, EQ)                                                                                              \
+DEFINE_HASHMAP_RESERVE(KEY, VALUE)                                                                                              \
+DEFINE_HASHMAP_PUT(KEY, VALUE, EQ)                                                                                              \
+DEFINE_HASHMAP_REMOVE(KEY, VALUE, EQ)                                                                                           \
+DEFINE_HASHMAP_ITERATE(KEY, VALUE)
+
+
+// A map grows when more than 3/4 of its slots would be occupied
+#define HASHMAP_MAX_LOAD_NUMERATOR 3
+#define HASHMAP_MAX_LOAD_DENOMINATOR 4
+#define HASHMAP_MIN_CAPACITY 16
+
+
+// Hash functions for common keys. HASH does not have to mix its bits, because the map multiplies every hash by a
+// 64-bit odd constant and uses the high bits of the product, but these give a well distributed hash on their own.
+static inline size_t hashmap_hash_u64(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+static inline size_t hashmap_hash_string(const char *key) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    while (*key != '\0') {
+        hash ^= (unsigned char)*key++;
+        hash *= 0x100000001B3ULL;
+    }
+    return (size_t)hash;
+}
+
+
+#define DECLARE_HASHMAP_STRUCT(KEY, VALUE)                                                                                      \
+typedef struct hashmap_##KEY##_##VALUE {                                                                                        \
+    uint8_t *control;                                                                                                           \
+    KEY *keys;                                                                                                                  \
+    VALUE *values;                                                                                                              \
+    size_t size;                                                                                                                \
+    size_t capacity;                                                                                                            \
+    unsigned int shift;                                                                                                         \
+    Allocator allocator;                                                                                                        \
+} hashmap_##KEY##_##VALUE;
+
+
+// Create a map which can hold at least capacity items without growing (0 uses the minimum capacity). The arrays of the
+// map are allocated with the given allocator (NULL uses malloc and free).
+#define DEFINE_HASHMAP_CREATE(KEY, VALUE)                                                                                       \
+static inline bool hashmap_##KEY##_##VALUE##_allocate(hashmap_##KEY##_##VALUE *map, size_t capacity) {                          \
+    map->control = allocator_calloc(&map->allocator, capacity, sizeof(uint8_t));                                                \
+    map->keys = allocator_alloc(&map->allocator, capacity * sizeof(KEY));                                                       \
+    map->values = allocator_alloc(&map->allocator, capacity * sizeof(VALUE));                                                   \
+    if (map->control == NULL || map->keys == NULL || map->values == NULL) {                                                     \
+        allocator_free(&map->allocator, map->control, capacity * sizeof(uint8_t));                                              \
+        allocator_free(&map->allocator, map->keys, capacity * sizeof(KEY));                                                     \
+        allocator_free(&map->allocator, map->values, capacity * sizeof(VALUE));                                                 \
+        fprintf(stderr, "Failed to allocate %zu slots for the hash map\n", capacity);                                           \
+        return false;                                                                                                           \
+    }                                                                                                                           \
+    map->capacity = capacity;                                                                                                   \
+    map->shift = 64;                                                                                                            \
+    while (capacity > 1) {                                                                                                      \
+        capacity >>= 1;                                                                                                         \
+        map->shift--;                                                                                                           \
+    }                                                                                                                           \
+    return true;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void hashmap_##KEY##_##VALUE##_deallocate(hashmap_##KEY##_##VALUE *map) {                                         \
+    allocator_free(&map->allocator, map->control, map->capacity * sizeof(uint8_t));                                             \
+    allocator_free(&map->allocator, map->keys, map->capacity * sizeof(KEY));                                                    \
+    allocator_free(&map->allocator, map->values, map->capacity * sizeof(VALUE));                                                \
+}                                                                                                                               \
+                                                                                                                                \
+/* Smallest power of two number of slots which holds count items under the maximum load factor */                               \
+static inline size_t hashmap_##KEY##_##VALUE##_slots_for(size_t count) {                                                        \
+    size_t capacity = HASHMAP_MIN_CAPACITY;                                                                                     \
+    while (capacity / HASHMAP_MAX_LOAD_DENOMINATOR * HASHMAP_MAX_LOAD_NUMERATOR < count)                                        \
+        capacity <<= 1;                                                                                                         \
+    return capacity;                                                                                                            \
+}                                                                                                                               \
+                                                                                                                                \
+static inline hashmap_##KEY##_##VALUE *hashmap_##KEY##_##VALUE##_create_with_allocator(size_t capacity,                         \
+                                                                                     const Allocator *allocator) {              \
+    hashmap_##KEY##_##VALUE *map = allocator_alloc(allocator, sizeof(*map));                                                    \
+    if (map == NULL) {                                                                                                          \
+        fprintf(stderr, "Failed to allocate the hash map\n");                                                                   \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    map->allocator = allocator != NULL ? *allocator : (Allocator){0};                                                           \
+    map->size = 0;                                                                                                              \
+    if (!hashmap_##KEY##_##VALUE##_allocate(map, hashmap_##KEY##_##VALUE##_slots_for(capacity))) {                              \
+        Allocator copy = map->allocator;                                                                                        \
+        allocator_free(&copy, map, sizeof(*map));                                                                               \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    return map;                                                                                                                 \
+}                                                                                                                               \
+                                                                                                                                \
+static inline hashmap_##KEY##_##VALUE *hashmap_##KEY##_##VALUE##_create(size_t capacity) {                                      \
+    return hashmap_##KEY##_##VALUE##_create_with_allocator(capacity, NULL);                                                     \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void hashmap_##KEY##_##VALUE##_free(hashmap_##KEY##_##VALUE *map) {                                               \
+    if (map == NULL)                                                                                                            \
+        return;                                                                                                                 \
+    hashmap_##KEY##_##VALUE##_deallocate(map);                                                                                  \
+    Allocator allocator = map->allocator;                                                                                       \
+    allocator_free(&allocator, map, sizeof(*map));                                                                              \
+}                                                                                                                               \
+                                                                                                                                \
+static inline size_t hashmap_##KEY##_##VALUE##_size(const hashmap_##KEY##_##VALUE *map) {                                       \
+    return map->size;                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline size_t hashmap_##KEY##_##VALUE##_capacity(const hashmap_##KEY##_##VALUE *map) {                                   \
+    return map->capacity;                                                                                                       \
+}                                                                                                                               \
+                                                                                                                                \
+/* Bytes allocated by the map (its struct and its three arrays) */                                                              \
+static inline size_t hashmap_##KEY##_##VALUE##_memory(const hashmap_##KEY##_##VALUE *map) {                                     \
+    return sizeof(*map) + map->capacity * (sizeof(uint8_t) + sizeof(KEY) + sizeof(VALUE));                                      \
+}
+
+
+// Home slot and control byte of a key. The hash is multiplied by 2^64 / golden ratio, the high bits of the product
+// select the slot and the next 7 bits (with the high bit set, so that it is never 0) become the control byte.
+#define DEFINE_HASHMAP_SLOT(KEY, VALUE, HASH)                                                                                   \
+static inline size_t hashmap_##KEY##_##VALUE##_home(const hashmap_##KEY##_##VALUE *map, KEY key, uint8_t *control) {            \
+    uint64_t hash = (uint64_t)(HASH(key)) * 0x9E3779B97F4A7C15ULL;                                                              \
+    *control = (uint8_t)(0x80 | ((hash << (64 - map->shift)) >> 57));                                                           \
+    return map->shift == 64 ? 0 : (size_t)(hash >> map->shift);                                                                 \
+}
+
+
+// Return a pointer to the value of the given key, or NULL if the key is not in the map. The pointer is valid until the
+// map is modified.
+#define DEFINE_HASHMAP_GET(KEY, VALUE, EQ)                                                                                      \
+static inline size_t hashmap_##KEY##_##VALUE##_find(const hashmap_##KEY##_##VALUE *map, KEY key) {                              \
+    uint8_t control;                                                                                                            \
+    size_t mask = map->capacity - 1;                                                                                            \
+    for (size_t i = hashmap_##KEY##_##VALUE##_home(map, key, &control); ; i = (i + 1) & mask) {                                 \
+        if (map->control[i] == 0)                                                                                               \
+            return SIZE_MAX;                                                                                                    \
+        if (map->control[i] == control && EQ(map->keys[i], key))                                                                \
+            return i;                                                                                                           \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline VALUE *hashmap_##KEY##_##VALUE##_get(const hashmap_##KEY##_##VALUE *map, KEY key) {                               \
+    size_t i = hashmap_##KEY##_##VALUE##_find(map, key);                                                                        \
+    return i == SIZE_MAX ? NULL : &map->values[i];                                                                              \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool hashmap_##KEY##_##VALUE##_contains(const hashmap_##KEY##_##VALUE *map, KEY key) {                            \
+    return hashmap_##KEY##_##VALUE##_find(map, key) != SIZE_MAX;                                                                \
+}
+
+
+// Make sure that the map can hold at least count items without growing. Every key is moved to its slot in the new
+// arrays, keeping its control byte, so HASH is called once per key.
+#define DEFINE_HASHMAP_RESERVE(KEY, VALUE)                                                                                      \
+static inline void hashmap_##KEY##_##VALUE##_reserve(hashmap_##KEY##_##VALUE *map, size_t count) {                              \
+    size_t capacity = hashmap_##KEY##_##VALUE##_slots_for(count);                                                               \
+    if (capacity <= map->capacity)                                                                                              \
+        return;                                                                                                                 \
+    hashmap_##KEY##_##VALUE old = *map;                                                                                         \
+    if (!hashmap_##KEY##_##VALUE##_allocate(map, capacity)) {                                                                   \
+        *map = old;                                                                                                             \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    size_t mask = map->capacity - 1;                                                                                            \
+    for (size_t j = 0; j < old.capacity; j++) {                                                                                 \
+        if (old.control[j] == 0)                                                                                                \
+            continue;                                                                                                           \
+        uint8_t control;                                                                                                        \
+        size_t i = hashmap_##KEY##_##VALUE##_home(map, old.keys[j], &control);                                                  \
+        while (map->control[i] != 0)                                                                                            \
+            i = (i + 1) & mask;                                                                                                 \
+        map->control[i] = control;                                                                                              \
+        map->keys[i] = old.keys[j];                                                                                             \
+        map->values[i] = old.values[j];                                                                                         \
+    }                                                                                                                           \
+    hashmap_##KEY##_##VALUE##_deallocate(&old);                                                                                 \
+}
+
+
+// Insert the given key with the given value, or replace the value if the key is already in the map. Return true if
+// the key was inserted.
+#define DEFINE_HASHMAP_PUT(KEY, VALUE, EQ)                                                                                      \
+static inline bool hashmap_##KEY##_##VALUE##_put(hashmap_##KEY##_##VALUE *map, KEY key, VALUE value) {                          \
+    if ((map->size + 1) * HASHMAP_MAX_LOAD_DENOMINATOR > map->capacity * HASHMAP_MAX_LOAD_NUMERATOR)                            \
+        hashmap_##KEY##_##VALUE##_reserve(map, map->size + 1);                                                                  \
+    uint8_t control;                                                                                                            \
+    size_t mask = map->capacity - 1;                                                                                            \
+    size_t i = hashmap_##KEY##_##VALUE##_home(map, key, &control);                                                              \
+    for (; map->control[i] != 0; i = (i + 1) & mask) {                                                                          \
+        if (map->control[i] == control && EQ(map->keys[i], key)) {                                                              \
+            map->values[i] = value;                                                                                             \
+            return false;                                                                                                       \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    if (map->size + 1 == map->capacity) {                                                                                       \
+        /* Growing has failed and this is the last empty slot, which has to stay empty to terminate the probes */               \
+        fprintf(stderr, "Failed to insert into the hash map\n");                                                                \
+        return false;                                                                                                           \
+    }                                                                                                                           \
+    map->control[i] = control;                                                                                                  \
+    map->keys[i] = key;                                                                                                         \
+    map->values[i] = value;                                                                                                     \
+    map->size++;                                                                                                                \
+    return true;                                                                                                                \
+}
+
+
+// Remove the given key from the map and return true if it was in the map. The keys which follow it in its probe
+// sequence are shifted back, so lookups never have to skip deleted slots.
+#define DEFINE_HASHMAP_REMOVE(KEY, VALUE, EQ)                                                                                   \
+static inline bool hashmap_##KEY##_##VALUE##_remove(hashmap_##KEY##_##VALUE *map, KEY key) {                                    \
+    size_t i = hashmap_##KEY##_##VALUE##_find(map, key);                                                                        \
+    if (i == SIZE_MAX)                                                                                                          \
+        return false;                                                                                                           \
+    size_t mask = map->capacity - 1;                                                                                            \
+    for (size_t j = (i + 1) & mask; map->control[j] != 0; j = (j + 1) & mask) {                                                 \
+        uint8_t control;                                                                                                        \
+        size_t home = hashmap_##KEY##_##VALUE##_home(map, map->keys[j], &control);                                              \
+        /* The key at j can fill the hole at i if its home is not in the cyclic range (i, j] */                                 \
+        if (((j - home) & mask) >= ((j - i) & mask)) {                                                                          \
+            map->control[i] = map->control[j];                                                                                  \
+            map->keys[i] = map->keys[j];                                                                                        \
+            map->values[i] = map->values[j];                                                                                    \
+            i = j;                                                                                                              \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    map->control[i] = 0;                                                                                                        \
+    map->size--;                                                                                                                \
+    return true;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void hashmap_##KEY##_##VALUE##_clear(hashmap_##KEY##_##VALUE *map) {                                              \
+    memset(map->control, 0, map->capacity * sizeof(uint8_t));                                                                   \
+    map->size = 0;                                                                                                              \
+}
+
+
+// Call visit for every key and (a pointer to) its value, in no particular order. visit may change the value, but it
+// must not insert or remove keys.
+#define DEFINE_HASHMAP_ITERATE(KEY, VALUE)                                                                                      \
+static inline void hashmap_##KEY##_##VALUE##_for_each(hashmap_##KEY##_##VALUE *map,                                             \
+                                                    void (*visit)(KEY key, VALUE *value, void *ctx), void *ctx) {               \
+    for (size_t i = 0; i < map->capacity; i++) {                                                                                \
+        if (map->control[i] != 0)                                                                                               \
+            visit(map->keys[i], &map->values[i], ctx);                                                                          \
+    }                                                                                                                           \
+}
+
+#endif
@@ -13,18 +13,26 @@ struct priority_queue {
     CompareFunc compare;
     PrintFunc print;
     DestroyFunc destroy;
+    Allocator allocator;
 };
 
 
 // Initialize the priority queue
 PriorityQueue PQ_initialize(size_t capacity, CompareFunc compare, DestroyFunc destroy, PrintFunc print) {
+    return PQ_initialize_with_allocator(capacity, compare, destroy, print, NULL);
+}
+
+
+// Initialize a priority queue which allocates its memory with the given allocator (NULL uses malloc and free)
+PriorityQueue PQ_initialize_with_allocator(size_t capacity, CompareFunc compare, DestroyFunc destroy, PrintFunc print, const Allocator *allocator) {
     
-    PriorityQueue PQ = malloc(sizeof(*PQ));
+    PriorityQueue PQ = allocator_alloc(allocator, sizeof(*PQ));
     assert(PQ != NULL);
+    PQ->allocator = allocator != NULL ? *allocator : (Allocator){0};
     
     PQ->capacity = capacity + 1;
     
-    PQ->array = calloc(PQ->capacity, sizeof(*PQ->array));
+    PQ->array = allocator_calloc(&PQ->allocator, PQ->capacity, sizeof(*PQ->array));
     assert(PQ->array != NULL);
 
     PQ->size = 0;
@@ -145,6 +153,7 @@ void PQ_destroy(PriorityQueue PQ) {
     for(int i = 1 ; i <= PQ->size ; i++)
         if(PQ->destroy)
             PQ->destroy(PQ->array[i]);
-    free(PQ->array);
-    free(PQ);
+    allocator_free(&PQ->allocator, PQ->array, PQ->capacity * sizeof(*PQ->array));
+    Allocator allocator = PQ->allocator;
+    allocator_free(&allocator, PQ, sizeof(*PQ));
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define PRIORITY_QUEUE_H
 
 #include <stdbool.h>
+#include "../Allocator/Allocator.h"
 
 // Compare functions for the different data type
 typedef int (*CompareFunc)(void *, void *);
@@ -21,6 +22,9 @@ typedef struct priority_queue *PriorityQueue;
 // Initialize the priority queue
 PriorityQueue PQ_initialize(size_t capacity, CompareFunc compare, DestroyFunc destroy, PrintFunc print);
 
+// Initialize a priority queue which allocates its memory with the given allocator (NULL uses malloc and free)
+PriorityQueue PQ_initialize_with_allocator(size_t capacity, CompareFunc compare, DestroyFunc destroy, PrintFunc print, const Allocator *allocator);
+
 // Check if the priority queue is empty
 bool PQ_empty(const PriorityQueue PQ);
 
@@ -19,13 +19,21 @@ struct queue {
     unsigned int size;
     PrintFunc print;
     DestroyFunc destroy;
+    Allocator allocator;
 };
 
 
 // Create a Queue
 Queue Queue_create(const DestroyFunc destroy, const PrintFunc print) {
-    Queue Q = malloc(sizeof(*Q));
+    return Queue_create_with_allocator(destroy, print, NULL);
+}
+
+
+// Create a Queue which allocates its memory with the given allocator (NULL uses malloc and free)
+Queue Queue_create_with_allocator(const DestroyFunc destroy, const PrintFunc print, const Allocator *allocator) {
+    Queue Q = allocator_alloc(allocator, sizeof(*Q));
     assert(Q != NULL);
+    Q->allocator = allocator != NULL ? *allocator : (Allocator){0};
     Q->head = Q->tail = NULL;
     Q->size = 0;
     Q->print = print;
@@ -57,7 +65,7 @@ void Queue_insert(Queue Q, void *data) {
         return;
     }
 
-    queue_node *new_node = malloc(sizeof(*new_node));
+    queue_node *new_node = allocator_alloc(&Q->allocator, sizeof(*new_node));
     assert(new_node != NULL);
 
     new_node->data = data;
@@ -80,13 +88,13 @@ void *Queue_remove(Queue Q) {
         return NULL;
     queue_node *data = Q->head->data;
     if(Q->size == 1) {
-        free(Q->head);
+        allocator_free(&Q->allocator, Q->head, sizeof(*Q->head));
         Q->head = Q->tail = NULL;
     }
     else {
         queue_node *temp = Q->head;
         Q->head = Q->head->next;
-        free(temp);
+        allocator_free(&Q->allocator, temp, sizeof(*temp));
     }
     Q->size--;
     return data;
@@ -117,7 +125,8 @@ void Queue_destroy(Queue Q) {
         Q->head = Q->head->next;
         if(Q->destroy)
             Q->destroy(temp->data);
-        free(temp);
+        allocator_free(&Q->allocator, temp, sizeof(*temp));
     }
-    free(Q);
+    Allocator allocator = Q->allocator;
+    allocator_free(&allocator, Q, sizeof(*Q));
 }
\ No newline at end of file
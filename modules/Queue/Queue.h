@@ -4,6 +4,7 @@
 
 
 #include <stdbool.h>
+#include "../Allocator/Allocator.h"
 
 typedef struct queue *Queue;
 
@@ -16,6 +17,9 @@ typedef void (*PrintFunc)(void *);
 // Create a Queue
 Queue Queue_create(const DestroyFunc destroy, const PrintFunc print);
 
+// Create a Queue which allocates its memory with the given allocator (NULL uses malloc and free)
+Queue Queue_create_with_allocator(const DestroyFunc destroy, const PrintFunc print, const Allocator *allocator);
+
 // Return the number of items that the Queue holds
 unsigned int Queue_size(Queue Q);
 
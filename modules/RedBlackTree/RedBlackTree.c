@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include "RedBlackTree.h"
 
 
@@ -9,6 +11,8 @@ typedef enum { RED, BLACK } Color;
 
 typedef struct RBTNode RBTNode;
 
+typedef struct PRBTNode PRBTNode;
+
 
 struct RBTNode {
     void *data;
@@ -19,6 +23,28 @@ struct RBTNode {
 };
 
 
+// Instrumentation counters are compiled in only when the library is built with -DDS_STATS
+// They are shared by all the red black trees, because a tree is just a pointer to its root
+// The counters are atomic, because the parallel set operations and the versions of the persistent trees update them
+// from several threads
+#ifdef DS_STATS
+static struct {
+    atomic_size_t compares;
+    atomic_size_t rotations;
+    atomic_size_t bytes_allocated;
+} stats;
+#define RBT_STATS_ADD(counter, n) atomic_fetch_add_explicit(&stats.counter, (n), memory_order_relaxed)
+#define RBT_STATS_SUB(counter, n) atomic_fetch_sub_explicit(&stats.counter, (n), memory_order_relaxed)
+#else
+#define RBT_STATS_ADD(counter, n)
+#define RBT_STATS_SUB(counter, n)
+#endif
+
+
+// Allocator of the nodes of all the red black trees (zeroed means malloc and free)
+static Allocator allocator;
+
+
 // Dummy (leaf) node - NIL
 static RBTNode NIL = { .data = NULL, .left = NULL, .right = NULL, .parent = NULL, .color = BLACK };
 
@@ -26,16 +52,31 @@ static RBTNode NIL = { .data = NULL, .left = NULL, .right = NULL, .parent = NULL
 // Static - Local funtions
 static void RBT_left_rotate(RBTNode **root, RBTNode *x);
 static void RBT_right_rotate(RBTNode **root, RBTNode *x);
-static RBTNode *binary_search_tree_insert(RBTNode *root, RBTNode *node, CompareFunc compare);
 static RBTNode *find_successor(RBTNode *node);
-static void RBT_delete_fixup(RBTNode **root, RBTNode **node);
+static void RBT_delete_fixup(RBTNode **root, RBTNode *node);
 static void *RBT_select(RBTNode *root, size_t k);
+static RBTNode *RBT_build(void **items, size_t count, RBTNode *parent, int depth, int red_depth);
+static RBTNode *RBT_extreme_node(RBTNode *node, bool minimum);
+
+
+// Set the allocator of the nodes of all the red black trees (NULL restores malloc and free)
+void RBT_set_allocator(const Allocator *new_allocator) {
+    allocator = new_allocator != NULL ? *new_allocator : (Allocator){0};
+}
+
+
+// Call the compare function of the tree
+static inline int RBT_compare(CompareFunc compare, void *data1, void *data2) {
+    RBT_STATS_ADD(compares, 1);
+    return compare(data1, data2);
+}
 
 
 // Create a red node
 static RBTNode *create_node(void *data) {
-    RBTNode *node = malloc(sizeof(RBTNode));
+    RBTNode *node = allocator_alloc(&allocator, sizeof(RBTNode));
     assert(node != NULL);
+    RBT_STATS_ADD(bytes_allocated, sizeof(RBTNode));
     node->data = data;
     node->left = node->right = &NIL;
     node->color = RED;
@@ -44,19 +85,38 @@ static RBTNode *create_node(void *data) {
 }
 
 
-// Insert the node into the binary search tree
-static RBTNode *binary_search_tree_insert(RBTNode *root, RBTNode *new_node, CompareFunc compare) {
-    if(root == &NIL)
-        return new_node;
-    if(compare(new_node->data, root->data) < 0) {
-        root->left = binary_search_tree_insert(root->left, new_node, compare);
-        root->left->parent = root;
-    }
-    else if(compare(new_node->data, root->data) > 0) {
-        root->right = binary_search_tree_insert(root->right, new_node, compare);
-        root->right->parent = root;
-    }
-    return root;
+// Build a perfectly balanced red black tree from sorted items
+RBTree RBT_build_sorted(void **items, size_t count, CompareFunc compare) {
+    assert(compare != NULL);
+    for (size_t i = 1; i < count; i++)
+        if (RBT_compare(compare, items[i - 1], items[i]) >= 0)
+            return NULL;
+    if (count == 0)
+        return NULL;
+    // The deepest level of the tree is floor(log2(count)). When it is not full, its nodes are colored red and every
+    // other node black, so every path from the root to a leaf passes through the same number of black nodes
+    int red_depth = 0;
+    while (((size_t)2 << red_depth) <= count)
+        red_depth++;
+    if (((count + 1) & count) == 0)
+        red_depth = -1;
+    return RBT_build(items, count, NULL, 0, red_depth);
+}
+
+
+// Make the middle item the root and build its subtrees from the two halves. The sizes of the two subtrees differ by
+// at most one, so all the leaves are on the last two levels. The nodes are allocated in preorder, so a parent is
+// usually next to its left child in memory
+static RBTNode *RBT_build(void **items, size_t count, RBTNode *parent, int depth, int red_depth) {
+    if (count == 0)
+        return &NIL;
+    size_t middle = count / 2;
+    RBTNode *node = create_node(items[middle]);
+    node->parent = parent;
+    node->color = depth == red_depth ? RED : BLACK;
+    node->left = RBT_build(items, middle, node, depth + 1, red_depth);
+    node->right = RBT_build(items + middle + 1, count - middle - 1, node, depth + 1, red_depth);
+    return node;
 }
 
 
@@ -72,8 +132,22 @@ void RBT_insert(RBTree *root, void *data, CompareFunc compare) {
         return;
     }
     assert(compare != NULL);
+    // Find the parent of the new node top-down. If the data is already in the tree, the tree does not change
+    RBTNode *parent = NULL, *current = *root;
+    int result = 0;
+    while(current != &NIL) {
+        parent = current;
+        result = RBT_compare(compare, data, current->data);
+        if(result == 0)
+            return;
+        current = result < 0 ? current->left : current->right;
+    }
     RBTNode *node = create_node(data);
-    *root = binary_search_tree_insert(*root, node, compare);
+    node->parent = parent;
+    if(result < 0)
+        parent->left = node;
+    else
+        parent->right = node;
     while(node != *root && node->parent->color == RED) {
         RBTNode *grandparent = node->parent->parent;
         if(node->parent == grandparent->left) { // parent is the left child of grandparent
@@ -151,31 +225,29 @@ static RBTNode *find_successor(RBTNode *node) {
 
 
 // Function which fixes the violations that might occur when we delete an item from the red black tree
-static void RBT_delete_fixup(RBTNode **root, RBTNode **node) {
-    while(((*node)->parent != NULL) && ((*node)->color == BLACK)) {
+// node is the child which took the place of the deleted black node, so the paths through it miss one black node
+static void RBT_delete_fixup(RBTNode **root, RBTNode *node) {
+    while((node != *root) && (node->color == BLACK)) {
         RBTNode *node_sibling;
-        if(*node == (*node)->parent->left) {
-            // node is the left sibling of it's parent
-            node_sibling = (*node)->parent->right;
-
-            if(node_sibling == &NIL)
-                break;
+        if(node == node->parent->left) {
+            // node is the left child of it's parent
+            node_sibling = node->parent->right;
 
             if(node_sibling->color == RED) {
                 // Case1: When the sibling color is RED, we should recolor sibling and parent and rotate left the parent
                 // The new sibling of the node is one of their sibling's children and it is black. Thus we have converted case 1
                 // into a 2, 3 or 4 case
                 node_sibling->color = BLACK;
-                (*node)->parent->color = RED;
-                RBT_left_rotate(root, (*node)->parent);
-                node_sibling = (*node)->parent->right;
+                node->parent->color = RED;
+                RBT_left_rotate(root, node->parent);
+                node_sibling = node->parent->right;
             }
 
             if((node_sibling->left->color == BLACK) && (node_sibling->right->color == BLACK)) {
                 // Case2: When the sibling node is black and both of it's children are black we should recolor sibling
                 // and set given node to it's parent. Then we fix up the parent of given node
                 node_sibling->color = RED;
-                node = &((*node)->parent);
+                node = node->parent;
             }
             else {
                 if(node_sibling->right->color == BLACK) {
@@ -185,37 +257,34 @@ static void RBT_delete_fixup(RBTNode **root, RBTNode **node) {
                     node_sibling->left->color = BLACK;
                     node_sibling->color = RED;
                     RBT_right_rotate(root, node_sibling);
-                    node_sibling = (*node)->parent->right;
+                    node_sibling = node->parent->right;
                 }
                 // Case4: When right child of the sibling are red we set node's parent black as well as siblings right child,
                 // we do a left rotation on node's parent and set given node to be the root of the tree
-                node_sibling->color = (*node)->parent->color;
-                (*node)->parent->color = BLACK;
+                node_sibling->color = node->parent->color;
+                node->parent->color = BLACK;
                 node_sibling->right->color = BLACK;
-                RBT_left_rotate(root, (*node)->parent);
-                (*node) = *root;
+                RBT_left_rotate(root, node->parent);
+                node = *root;
             }
         }
         else {
             // node is the right child of it's parent
             // Cases are handled accordingly
-            node_sibling = (*node)->parent->left;
-
-            if(node_sibling == &NIL)
-                break;
+            node_sibling = node->parent->left;
 
             if(node_sibling->color == RED) {
                 // Case1
                 node_sibling->color = BLACK;
-                (*node)->parent->color = RED;
-                RBT_right_rotate(root, (*node)->parent);
-                node_sibling = (*node)->parent->left;
+                node->parent->color = RED;
+                RBT_right_rotate(root, node->parent);
+                node_sibling = node->parent->left;
             }
 
             if((node_sibling->left->color == BLACK) && (node_sibling->right->color == BLACK)) {
                 // Case2
                 node_sibling->color = RED;
-                node = &((*node)->parent);
+                node = node->parent;
             }
             else {
                 if(node_sibling->left->color == BLACK) {
@@ -223,38 +292,39 @@ static void RBT_delete_fixup(RBTNode **root, RBTNode **node) {
                     node_sibling->right->color = BLACK;
                     node_sibling->color = RED;
                     RBT_left_rotate(root, node_sibling);
-                    node_sibling = (*node)->parent->left;
+                    node_sibling = node->parent->left;
                 }
                 // Case4
-                node_sibling->color = (*node)->parent->color;
-                (*node)->parent->color = BLACK;
+                node_sibling->color = node->parent->color;
+                node->parent->color = BLACK;
                 node_sibling->left->color = BLACK;
-                RBT_right_rotate(root, (*node)->parent);
-                *node = *root;
+                RBT_right_rotate(root, node->parent);
+                node = *root;
             }
         } 
     }
-    (*node)->color = BLACK;
-    (*root)->parent = NULL;
+    node->color = BLACK;
 }
 
 
 // Remove node with given data from the red black tree
 bool RBT_delete(RBTree *root, void *data, CompareFunc compare, DestroyFunc destroy) {
     assert(compare != NULL);
+    if(*root == NULL)
+        return false;
     RBTNode *old_node, *next_node, *node = *root;
     while(node != &NIL) {
-        if(compare(data, node->data) == 0) {
+        if(RBT_compare(compare, data, node->data) == 0) {
             // Found the node with the data we want to delete 
+            if(destroy)
+                destroy(node->data);
             if((node->left == &NIL) || (node->right == &NIL))
                 // if the node has not two children then it is the one we are deleting
                 old_node = node;
             else{
-                // Otherwise we find it's successor which is going to be the one we will delete (successor is a leaf node)
+                // Otherwise we find it's successor which is going to be the one we will delete (successor has no left child)
                 old_node = find_successor(node);
                 // in case that the node has two children we should replace the old data with the successor's data because we do not want them to get lost
-                if(destroy)
-                    destroy(node->data);
                 node->data = old_node->data;
             }
             
@@ -264,7 +334,7 @@ bool RBT_delete(RBTree *root, void *data, CompareFunc compare, DestroyFunc destr
             else
                 next_node = old_node->right;
             
-            // Update next node's parent
+            // Update next node's parent (this is done even for the NIL node, because the fix up starts from it)
             next_node->parent = old_node->parent;
 
             // Update parent of the old node
@@ -277,13 +347,20 @@ bool RBT_delete(RBTree *root, void *data, CompareFunc compare, DestroyFunc destr
             
             if(old_node->color == BLACK)
                 // Violations occur, when we delete a black node. When the node we delete is red there is nothing to do
-                RBT_delete_fixup(root, &node);
+                RBT_delete_fixup(root, next_node);
+
+            if(*root == &NIL)
+                // The tree is empty again
+                *root = NULL;
+            else
+                (*root)->parent = NULL;
             
-            free(old_node);
+            allocator_free(&allocator, old_node, sizeof(RBTNode));
+            RBT_STATS_SUB(bytes_allocated, sizeof(RBTNode));
             
             return true;
         }
-        else if(compare(data, node->data) < 0) {
+        else if(RBT_compare(compare, data, node->data) < 0) {
             node = node->left;
         }
         else {
@@ -297,14 +374,15 @@ bool RBT_delete(RBTree *root, void *data, CompareFunc compare, DestroyFunc destr
 // Search given data in the red black tree and return true if it finds it, else return false
 bool RBT_search(RBTree root, void *data, CompareFunc compare) {
     assert(compare != NULL);
-    if((root == &NIL) || (root == NULL))
+    if(root == NULL)
         return false;
-    else if(compare(root->data, data) == 0)
-        return true;
-    else if(compare(root->data, data) > 0)
-        return RBT_search(root->left, data, compare);
-    else
-        return RBT_search(root->right, data, compare);
+    while(root != &NIL) {
+        int result = RBT_compare(compare, data, root->data);
+        if(result == 0)
+            return true;
+        root = result < 0 ? root->left : root->right;
+    }
+    return false;
 }
 
 
@@ -326,6 +404,121 @@ void *RBT_select_k_th_item(RBTree root, size_t k) {
 }
 
 
+// Returns the node with the minimum (or the maximum) item of a non empty subtree
+static RBTNode *RBT_extreme_node(RBTNode *node, bool minimum) {
+    while((minimum ? node->left : node->right) != &NIL)
+        node = minimum ? node->left : node->right;
+    return node;
+}
+
+
+// Returns an iterator to the first item of the red black tree
+RBTIterator RBT_begin(RBTree root) {
+    return (RBTIterator){ root, root != NULL ? RBT_extreme_node(root, true) : NULL };
+}
+
+
+// Returns an iterator to the end of the red black tree
+RBTIterator RBT_end(RBTree root) {
+    return (RBTIterator){ root, NULL };
+}
+
+
+// Returns an iterator to the first item of the red black tree which is not less than data
+RBTIterator RBT_lower_bound(RBTree root, void *data, CompareFunc compare) {
+    assert(compare != NULL);
+    RBTIterator it = { root, NULL };
+    for(RBTNode *node = root != NULL ? root : &NIL; node != &NIL; ) {
+        if(RBT_compare(compare, node->data, data) < 0)
+            node = node->right;
+        else {
+            it.node = node;
+            node = node->left;
+        }
+    }
+    return it;
+}
+
+
+// Check if the iterator points to an item (and not to the end)
+bool RBT_iterator_valid(RBTIterator it) {
+    return it.node != NULL;
+}
+
+
+// Returns the item of the iterator, or NULL at the end
+void *RBT_iterator_data(RBTIterator it) {
+    return it.node != NULL ? it.node->data : NULL;
+}
+
+
+// Returns an iterator to the next item, following the parent pointers up when the node has no right subtree
+RBTIterator RBT_next(RBTIterator it) {
+    RBTNode *node = it.node;
+    if(node == NULL)
+        return it;
+    if(node->right != &NIL)
+        it.node = RBT_extreme_node(node->right, true);
+    else {
+        while(node->parent != NULL && node->parent->right == node)
+            node = node->parent;
+        it.node = node->parent;
+    }
+    return it;
+}
+
+
+// Returns an iterator to the previous item. The end moves to the last item, and the first item moves to the end.
+// Rebalancing after inserts may have moved the root of the iterator down, but inserts never free a node, so the current
+// root is found by following its parent pointers up
+RBTIterator RBT_prev(RBTIterator it) {
+    RBTNode *node = it.node;
+    if(node == NULL) {
+        if(it.root != NULL) {
+            while(it.root->parent != NULL)
+                it.root = it.root->parent;
+            it.node = RBT_extreme_node(it.root, false);
+        }
+    }
+    else if(node->left != &NIL)
+        it.node = RBT_extreme_node(node->left, false);
+    else {
+        while(node->parent != NULL && node->parent->left == node)
+            node = node->parent;
+        it.node = node->parent;
+    }
+    return it;
+}
+
+
+// Visit the items of [low, high) in order, until visit returns false
+size_t RBT_range(RBTree root, void *low, void *high, CompareFunc compare, RBTRangeFunc visit, void *ctx) {
+    size_t count = 0;
+    RBTIterator it = low != NULL ? RBT_lower_bound(root, low, compare) : RBT_begin(root);
+    for(; RBT_iterator_valid(it) ; it = RBT_next(it)) {
+        if(high != NULL && RBT_compare(compare, it.node->data, high) >= 0)
+            break;
+        count++;
+        if(!visit(it.node->data, ctx))
+            break;
+    }
+    return count;
+}
+
+
+// Copy up to capacity items which are less than high from the iterator, and move the iterator after them
+size_t RBT_range_batch(RBTIterator *it, void *high, CompareFunc compare, void **items, size_t capacity) {
+    size_t count = 0;
+    while(count < capacity && RBT_iterator_valid(*it)) {
+        if(high != NULL && RBT_compare(compare, it->node->data, high) >= 0)
+            break;
+        items[count++] = it->node->data;
+        *it = RBT_next(*it);
+    }
+    return count;
+}
+
+
 // Check if the red black tree is empty
 bool RBT_empty(RBTree root) {
     return RBT_count_items(root) == 0;
@@ -393,6 +586,7 @@ void *RBT_max_value(RBTree root) {
 static void RBT_left_rotate(RBTNode **root, RBTNode *x) {
     if(x->right == &NIL)
         return;
+    RBT_STATS_ADD(rotations, 1);
     RBTNode *y = x->right;
     x->right = y->left;
     if(y->left != &NIL)
@@ -416,10 +610,12 @@ static void RBT_left_rotate(RBTNode **root, RBTNode *x) {
 static void RBT_right_rotate(RBTNode **root, RBTNode *x) {
     if(x->left == &NIL)
         return;
+    RBT_STATS_ADD(rotations, 1);
     RBTNode *y = x->left;
     x->left = y->right;
     if(y->right != &NIL)
         y->right->parent = x;
+    y->parent = x->parent;
     if(x->parent == NULL){
         *root = y;
         (*root)->parent = NULL;
@@ -436,11 +632,1128 @@ static void RBT_right_rotate(RBTNode **root, RBTNode *x) {
 
 // Function which is used to destroy a red black tree
 void RBT_destroy(RBTree node, DestroyFunc destroy) {
-    if(node != &NIL) {
+    if((node != NULL) && (node != &NIL)) {
         RBT_destroy(node->left, destroy);
         RBT_destroy(node->right, destroy);
         if(destroy)
             destroy(node->data);
-        free(node);
+        allocator_free(&allocator, node, sizeof(RBTNode));
+        RBT_STATS_SUB(bytes_allocated, sizeof(RBTNode));
+    }
+}
+
+
+// Set the children of a node and their parent pointers (the parent of the NIL node is never changed)
+static void set_children(RBTNode *node, RBTNode *left, RBTNode *right) {
+    node->left = left;
+    node->right = right;
+    if(left != &NIL)
+        left->parent = node;
+    if(right != &NIL)
+        right->parent = node;
+}
+
+
+// Return the black height of a subtree: the number of black nodes in every path from its root to a leaf, including
+// the root if it is black
+static int black_height(RBTNode *node) {
+    int black_height = 0;
+    for(; node != &NIL; node = node->left)
+        black_height += node->color == BLACK;
+    return black_height;
+}
+
+
+// Rotations of a subtree whose parent is fixed by the caller
+static RBTNode *join_rotate_left(RBTNode *x) {
+    RBT_STATS_ADD(rotations, 1);
+    RBTNode *y = x->right;
+    set_children(x, x->left, y->left);
+    set_children(y, x, y->right);
+    return y;
+}
+
+static RBTNode *join_rotate_right(RBTNode *x) {
+    RBT_STATS_ADD(rotations, 1);
+    RBTNode *y = x->left;
+    set_children(x, y->right, x->right);
+    set_children(y, y->left, x);
+    return y;
+}
+
+
+// Join when the left subtree has the greater black height: descend its right spine to the first black node with the
+// black height of the right subtree and put the node there as a red node. A red violation is fixed by a rotation at
+// the grandparent, which moves it two levels up
+static RBTNode *join_right(RBTNode *left, int left_height, RBTNode *node, RBTNode *right, int right_height) {
+    if(left->color == BLACK && left_height == right_height) {
+        node->color = RED;
+        set_children(node, left, right);
+        return node;
+    }
+    RBTNode *child = join_right(left->right, left_height - (left->color == BLACK), node, right, right_height);
+    set_children(left, left->left, child);
+    if(left->color == BLACK && child->color == RED && child->right->color == RED) {
+        child->right->color = BLACK;
+        return join_rotate_left(left);
+    }
+    return left;
+}
+
+
+// Join when the right subtree has the greater black height: descend its left spine
+static RBTNode *join_left(RBTNode *left, int left_height, RBTNode *node, RBTNode *right, int right_height) {
+    if(right->color == BLACK && left_height == right_height) {
+        node->color = RED;
+        set_children(node, left, right);
+        return node;
+    }
+    RBTNode *child = join_left(left, left_height, node, right->left, right_height - (right->color == BLACK));
+    set_children(right, child, right->right);
+    if(right->color == BLACK && child->color == RED && child->left->color == RED) {
+        child->left->color = BLACK;
+        return join_rotate_right(right);
     }
+    return right;
+}
+
+
+// Join two subtrees of the given black heights and a node whose item is between their items, in
+// O(|left_height - right_height| + 1), and store the black height of the result
+static RBTNode *join_nodes(RBTNode *left, int left_height, RBTNode *node, RBTNode *right, int right_height, int *height) {
+    // Red roots are colored black first, so the node is never put under a red root
+    if(left->color == RED) {
+        left->color = BLACK;
+        left_height++;
+    }
+    if(right->color == RED) {
+        right->color = BLACK;
+        right_height++;
+    }
+    RBTNode *root;
+    if(left_height > right_height) {
+        root = join_right(left, left_height, node, right, right_height);
+        *height = left_height;
+    }
+    else if(right_height > left_height) {
+        root = join_left(left, left_height, node, right, right_height);
+        *height = right_height;
+    }
+    else {
+        node->color = RED;
+        set_children(node, left, right);
+        *height = left_height;
+        return node;
+    }
+    // A red root with a red child is the only violation which can be left
+    if(root->color == RED && (root->left->color == RED || root->right->color == RED)) {
+        root->color = BLACK;
+        (*height)++;
+    }
+    return root;
+}
+
+
+// Split a subtree of the given black height into the items which are less and greater than data, and return the node
+// which holds data (or NULL)
+static RBTNode *split_nodes(RBTNode *node, int height, void *data, CompareFunc compare, RBTNode **left,
+                            int *left_height, RBTNode **right, int *right_height) {
+    if(node == &NIL) {
+        *left = *right = &NIL;
+        *left_height = *right_height = 0;
+        return NULL;
+    }
+    int child_height = height - (node->color == BLACK);
+    int result = RBT_compare(compare, data, node->data);
+    if(result == 0) {
+        *left = node->left;
+        *right = node->right;
+        *left_height = *right_height = child_height;
+        node->left = node->right = &NIL;
+        return node;
+    }
+    RBTNode *found, *half;
+    int half_height;
+    if(result < 0) {
+        found = split_nodes(node->left, child_height, data, compare, left, left_height, &half, &half_height);
+        *right = join_nodes(half, half_height, node, node->right, child_height, right_height);
+    }
+    else {
+        found = split_nodes(node->right, child_height, data, compare, &half, &half_height, right, right_height);
+        *left = join_nodes(node->left, child_height, node, half, half_height, left_height);
+    }
+    return found;
+}
+
+
+// Remove the node with the greatest item of a non empty subtree and return it
+static RBTNode *split_last(RBTNode *node, int height, RBTNode **rest, int *rest_height) {
+    int child_height = height - (node->color == BLACK);
+    if(node->right == &NIL) {
+        *rest = node->left;
+        *rest_height = child_height;
+        node->left = &NIL;
+        return node;
+    }
+    RBTNode *rest_right;
+    int rest_right_height;
+    RBTNode *last = split_last(node->right, child_height, &rest_right, &rest_right_height);
+    *rest = join_nodes(node->left, child_height, node, rest_right, rest_right_height, rest_height);
+    return last;
+}
+
+
+// Join two subtrees whose items are all less (left) and all greater (right) than each other
+static RBTNode *join2(RBTNode *left, int left_height, RBTNode *right, int right_height, int *height) {
+    if(left == &NIL) {
+        *height = right_height;
+        return right;
+    }
+    RBTNode *rest;
+    int rest_height;
+    RBTNode *last = split_last(left, left_height, &rest, &rest_height);
+    return join_nodes(rest, rest_height, last, right, right_height, height);
+}
+
+
+// Free a node which is dropped by a set operation and destroy its item
+static void free_node(RBTNode *node, DestroyFunc destroy) {
+    if(node == NULL)
+        return;
+    if(destroy)
+        destroy(node->data);
+    allocator_free(&allocator, node, sizeof(RBTNode));
+    RBT_STATS_SUB(bytes_allocated, sizeof(RBTNode));
+}
+
+
+// Turn the root of a subtree into the root of a red black tree
+static RBTree make_root(RBTNode *node) {
+    if(node == &NIL)
+        return NULL;
+    node->parent = NULL;
+    node->color = BLACK;
+    return node;
+}
+
+
+// Join two red black trees and an item which is greater than every item of left and less than every item of right
+RBTree RBT_join(RBTree left, void *data, RBTree right) {
+    RBTNode *left_root = left != NULL ? left : &NIL;
+    RBTNode *right_root = right != NULL ? right : &NIL;
+    int height;
+    RBTNode *root = join_nodes(left_root, black_height(left_root), create_node(data), right_root,
+                               black_height(right_root), &height);
+    return make_root(root);
+}
+
+
+// Split the red black tree into the items which are less and the items which are greater than data
+void *RBT_split(RBTree root, void *data, CompareFunc compare, RBTree *left, RBTree *right) {
+    assert(compare != NULL);
+    RBTNode *node = root != NULL ? root : &NIL;
+    RBTNode *left_root, *right_root;
+    int left_height, right_height;
+    RBTNode *found = split_nodes(node, black_height(node), data, compare, &left_root, &left_height, &right_root,
+                                 &right_height);
+    *left = make_root(left_root);
+    *right = make_root(right_root);
+    if(found == NULL)
+        return NULL;
+    void *found_data = found->data;
+    free_node(found, NULL);
+    return found_data;
+}
+
+
+// A set operation is divided by splitting one tree with the root item of the other one, so the two halves of the
+// problem are independent. It needs O(m log(n/m + 1)) compares, where m and n are the sizes of the smaller and the
+// larger tree. The black heights of the subtrees are passed down, so a join never has to compute them
+typedef enum { RBT_UNION, RBT_INTERSECTION, RBT_DIFFERENCE } RBTSetOperation;
+
+// A subtree and its black height
+typedef struct {
+    RBTNode *root;
+    int height;
+} RBTSubtree;
+
+// A set operation after it has been divided: the two halves and the nodes which are combined with their results
+typedef struct {
+    RBTSubtree left1, left2;   // The halves of the two trees with the smaller items
+    RBTSubtree right1, right2; // The halves of the two trees with the greater items
+    RBTNode *root;             // The root whose item divided the operation
+    RBTNode *found;            // The node of the other tree with the same item (or NULL)
+} RBTSetSplit;
+
+
+// Divide a set operation of two non empty trees
+static RBTSetSplit set_divide(RBTSetOperation operation, RBTSubtree tree1, RBTSubtree tree2, CompareFunc compare) {
+    RBTSetSplit split;
+    if(operation == RBT_DIFFERENCE) {
+        // The items of tree2 are removed from tree1, so tree1 is split with the root of tree2
+        split.root = tree2.root;
+        split.found = split_nodes(tree1.root, tree1.height, split.root->data, compare, &split.left1.root,
+                                  &split.left1.height, &split.right1.root, &split.right1.height);
+        split.left2 = (RBTSubtree){ split.root->left, tree2.height - (split.root->color == BLACK) };
+        split.right2 = (RBTSubtree){ split.root->right, split.left2.height };
+    }
+    else {
+        split.root = tree1.root;
+        split.found = split_nodes(tree2.root, tree2.height, split.root->data, compare, &split.left2.root,
+                                  &split.left2.height, &split.right2.root, &split.right2.height);
+        split.left1 = (RBTSubtree){ split.root->left, tree1.height - (split.root->color == BLACK) };
+        split.right1 = (RBTSubtree){ split.root->right, split.left1.height };
+    }
+    split.root->left = split.root->right = &NIL;
+    return split;
+}
+
+
+// Combine the results of the two halves of a set operation
+static RBTSubtree set_combine(RBTSetOperation operation, RBTSetSplit *split, RBTSubtree left, RBTSubtree right,
+                              DestroyFunc destroy) {
+    RBTSubtree result;
+    if(operation == RBT_UNION || (operation == RBT_INTERSECTION && split->found != NULL)) {
+        // The item of tree1 is kept
+        free_node(split->found, destroy);
+        result.root = join_nodes(left.root, left.height, split->root, right.root, right.height, &result.height);
+    }
+    else {
+        free_node(split->found, destroy);
+        free_node(split->root, destroy);
+        result.root = join2(left.root, left.height, right.root, right.height, &result.height);
+    }
+    return result;
+}
+
+
+// Free the nodes of a subtree which is dropped by a set operation and destroy their items
+static void free_subtree(RBTNode *node, DestroyFunc destroy) {
+    if(node != &NIL) {
+        free_subtree(node->left, destroy);
+        free_subtree(node->right, destroy);
+        free_node(node, destroy);
+    }
+}
+
+
+// Set operation when at least one of the trees is empty
+static RBTSubtree set_base(RBTSetOperation operation, RBTSubtree tree1, RBTSubtree tree2, DestroyFunc destroy) {
+    if(operation == RBT_UNION)
+        return tree1.root != &NIL ? tree1 : tree2;
+    if(operation == RBT_DIFFERENCE && tree2.root == &NIL)
+        return tree1;
+    free_subtree(tree1.root, destroy);
+    free_subtree(tree2.root, destroy);
+    return (RBTSubtree){ &NIL, 0 };
+}
+
+
+static RBTSubtree set_operation(RBTSetOperation operation, RBTSubtree tree1, RBTSubtree tree2, CompareFunc compare,
+                                DestroyFunc destroy) {
+    if(tree1.root == &NIL || tree2.root == &NIL)
+        return set_base(operation, tree1, tree2, destroy);
+    RBTSetSplit split = set_divide(operation, tree1, tree2, compare);
+    RBTSubtree left = set_operation(operation, split.left1, split.left2, compare, destroy);
+    RBTSubtree right = set_operation(operation, split.right1, split.right2, compare, destroy);
+    return set_combine(operation, &split, left, right, destroy);
+}
+
+
+// A part of a set operation which is executed by a thread of the pool
+typedef struct {
+    RBTSetOperation operation;
+    RBTSubtree tree1, tree2, result;
+    CompareFunc compare;
+    DestroyFunc destroy;
+} RBTSetTask;
+
+static void set_task_run(void *arg) {
+    RBTSetTask *task = arg;
+    task->result = set_operation(task->operation, task->tree1, task->tree2, task->compare, task->destroy);
+}
+
+
+// Run a set operation on the threads of the pool (or sequentially if pool is NULL). The first levels of the recursion
+// are divided by the calling thread into about 4 parts per thread, which form a complete binary tree: part i is
+// divided into the parts 2i and 2i + 1. The parts of the last level run in parallel, and then the results are combined
+// bottom-up by the calling thread
+static RBTree set_operation_parallel(RBTSetOperation operation, RBTree root1, RBTree root2, CompareFunc compare,
+                                     DestroyFunc destroy, ThreadPool pool) {
+    assert(compare != NULL);
+    RBTSubtree tree1 = { root1 != NULL ? root1 : &NIL, black_height(root1 != NULL ? root1 : &NIL) };
+    RBTSubtree tree2 = { root2 != NULL ? root2 : &NIL, black_height(root2 != NULL ? root2 : &NIL) };
+    if(pool == NULL || tree1.root == &NIL || tree2.root == &NIL)
+        return make_root(set_operation(operation, tree1, tree2, compare, destroy).root);
+    size_t parts = 1;
+    while(parts < 4 * (size_t)threadpool_size(pool))
+        parts *= 2;
+    RBTSetSplit *splits = malloc(parts * sizeof(RBTSetSplit));
+    RBTSetTask *tasks = malloc(2 * parts * sizeof(RBTSetTask));
+    assert(splits != NULL && tasks != NULL);
+    tasks[1] = (RBTSetTask){ operation, tree1, tree2, { &NIL, 0 }, compare, destroy };
+    for(size_t i = 1; i < parts; i++) {
+        tasks[2 * i] = tasks[2 * i + 1] = tasks[i];
+        if(tasks[i].tree1.root == &NIL || tasks[i].tree2.root == &NIL) {
+            // Nothing to divide, so the left part does the whole operation and the right part is empty
+            splits[i].root = NULL;
+            tasks[2 * i + 1].tree1 = tasks[2 * i + 1].tree2 = (RBTSubtree){ &NIL, 0 };
+            continue;
+        }
+        splits[i] = set_divide(operation, tasks[i].tree1, tasks[i].tree2, compare);
+        tasks[2 * i].tree1 = splits[i].left1;
+        tasks[2 * i].tree2 = splits[i].left2;
+        tasks[2 * i + 1].tree1 = splits[i].right1;
+        tasks[2 * i + 1].tree2 = splits[i].right2;
+    }
+    for(size_t i = parts; i < 2 * parts; i++)
+        threadpool_submit(pool, set_task_run, &tasks[i]);
+    threadpool_wait(pool);
+    for(size_t i = parts - 1; i >= 1; i--) {
+        if(splits[i].root == NULL)
+            tasks[i].result = tasks[2 * i].result;
+        else
+            tasks[i].result = set_combine(operation, &splits[i], tasks[2 * i].result, tasks[2 * i + 1].result, destroy);
+    }
+    RBTree result = make_root(tasks[1].result.root);
+    free(splits);
+    free(tasks);
+    return result;
+}
+
+
+// Return the union of two red black trees
+RBTree RBT_union(RBTree root1, RBTree root2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool) {
+    return set_operation_parallel(RBT_UNION, root1, root2, compare, destroy, pool);
+}
+
+
+// Return the intersection of two red black trees
+RBTree RBT_intersection(RBTree root1, RBTree root2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool) {
+    return set_operation_parallel(RBT_INTERSECTION, root1, root2, compare, destroy, pool);
+}
+
+
+// Return the difference of two red black trees
+RBTree RBT_difference(RBTree root1, RBTree root2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool) {
+    return set_operation_parallel(RBT_DIFFERENCE, root1, root2, compare, destroy, pool);
+}
+
+
+// Persistent red black trees. Every update copies the nodes of its search path (and the few siblings which are
+// recolored or rotated) and returns a new root, so all the older roots stay valid. A node is reference counted by the
+// nodes and the roots which point to it, and it is freed when the last one is released. The counts are atomic, so
+// versions can be created and released by different threads, while readers of a version never write to it
+
+
+// The height of a red black tree is at most 2 log2(n + 1), so no tree which fits in memory is higher than this
+#define PRBT_MAX_HEIGHT 128
+
+
+struct PRBTNode {
+    void *data;
+    PRBTNode *left;
+    PRBTNode *right;
+    atomic_size_t references;
+    Color color;
+};
+
+
+// Create a node with one reference, which takes the references of its children
+static PRBTNode *prbt_create_node(void *data, Color color, PRBTNode *left, PRBTNode *right) {
+    PRBTNode *node = allocator_alloc(&allocator, sizeof(PRBTNode));
+    assert(node != NULL);
+    RBT_STATS_ADD(bytes_allocated, sizeof(PRBTNode));
+    node->data = data;
+    node->left = left;
+    node->right = right;
+    node->color = color;
+    atomic_init(&node->references, 1);
+    return node;
+}
+
+
+// Add a reference to a node
+static PRBTNode *prbt_retain(PRBTNode *node) {
+    if(node != NULL)
+        atomic_fetch_add_explicit(&node->references, 1, memory_order_relaxed);
+    return node;
+}
+
+
+// Free a node which was created by the current update and is not referenced by any other node (its children are
+// not released)
+static void prbt_free_node(PRBTNode *node) {
+    RBT_STATS_SUB(bytes_allocated, sizeof(PRBTNode));
+    allocator_free(&allocator, node, sizeof(PRBTNode));
+}
+
+
+// Drop a reference to a node, and free the node and release its children if it was the last one
+static void prbt_release(PRBTNode *node) {
+    while(node != NULL && atomic_fetch_sub_explicit(&node->references, 1, memory_order_acq_rel) == 1) {
+        PRBTNode *right = node->right;
+        prbt_release(node->left);
+        prbt_free_node(node);
+        node = right;
+    }
+}
+
+
+// Replace the node of a link with a copy which can be changed by the current update. The copy shares the children of
+// the node, and the link drops its reference to the node
+static PRBTNode *prbt_unshare(PRBTNode **link) {
+    PRBTNode *node = *link;
+    *link = prbt_create_node(node->data, node->color, prbt_retain(node->left), prbt_retain(node->right));
+    prbt_release(node);
+    return *link;
+}
+
+
+static inline bool prbt_is_red(PRBTNode *node) {
+    return node != NULL && node->color == RED;
+}
+
+
+// Rotations of nodes which were created by the current update. They return the new root of the subtree, whose link
+// is fixed by the caller
+static PRBTNode *prbt_rotate_left(PRBTNode *node) {
+    RBT_STATS_ADD(rotations, 1);
+    PRBTNode *right = node->right;
+    node->right = right->left;
+    right->left = node;
+    return right;
+}
+
+static PRBTNode *prbt_rotate_right(PRBTNode *node) {
+    RBT_STATS_ADD(rotations, 1);
+    PRBTNode *left = node->left;
+    node->left = left->right;
+    left->right = node;
+    return left;
+}
+
+
+// The link of path[i] in its parent (or the root)
+static PRBTNode **prbt_link(PRBTNode **path, int i, PRBTNode **root) {
+    if(i == 0)
+        return root;
+    return path[i - 1]->left == path[i] ? &path[i - 1]->left : &path[i - 1]->right;
+}
+
+
+// Copy the search path of data from root. The copies are stored in path, and the function returns the number of
+// copied nodes. Every copy shares the child which is not on the path, and *link is the empty link at the end
+static int prbt_copy_path(PRBTree root, void *data, CompareFunc compare, PRBTNode **path, PRBTNode **new_root,
+                          PRBTNode ***link) {
+    int depth = 0;
+    *link = new_root;
+    for(PRBTNode *node = root ; node != NULL ; ) {
+        PRBTNode *copy = prbt_create_node(node->data, node->color, NULL, NULL);
+        **link = copy;
+        path[depth++] = copy;
+        if(RBT_compare(compare, data, node->data) < 0) {
+            copy->right = prbt_retain(node->right);
+            *link = &copy->left;
+            node = node->left;
+        }
+        else {
+            copy->left = prbt_retain(node->left);
+            *link = &copy->right;
+            node = node->right;
+        }
+    }
+    return depth;
+}
+
+
+// Returns a new version of the tree which also holds data (or the same root, with a new reference, if data is already
+// in the tree)
+PRBTree PRBT_insert(PRBTree root, void *data, CompareFunc compare) {
+    assert(compare != NULL);
+    if(PRBT_search(root, data, compare))
+        return prbt_retain(root);
+    PRBTNode *path[PRBT_MAX_HEIGHT + 1], *new_root = NULL, **link;
+    int depth = prbt_copy_path(root, data, compare, path, &new_root, &link);
+    *link = path[depth++] = prbt_create_node(data, RED, NULL, NULL);
+
+    // Fix a red node with a red parent, as RBT_insert does. Only the uncle is not a copy yet
+    int i = depth - 1;
+    while(i >= 2 && path[i - 1]->color == RED) {
+        PRBTNode *parent = path[i - 1], *grandparent = path[i - 2];
+        bool left = grandparent->left == parent;
+        PRBTNode **uncle_link = left ? &grandparent->right : &grandparent->left;
+        if(prbt_is_red(*uncle_link)) {
+            prbt_unshare(uncle_link)->color = BLACK;
+            parent->color = BLACK;
+            grandparent->color = RED;
+            i -= 2;
+            continue;
+        }
+        PRBTNode **grandparent_link = prbt_link(path, i - 2, &new_root);
+        if(left) {
+            if(parent->right == path[i])
+                grandparent->left = prbt_rotate_left(parent);
+            *grandparent_link = prbt_rotate_right(grandparent);
+        }
+        else {
+            if(parent->left == path[i])
+                grandparent->right = prbt_rotate_right(parent);
+            *grandparent_link = prbt_rotate_left(grandparent);
+        }
+        (*grandparent_link)->color = BLACK;
+        grandparent->color = RED;
+        break;
+    }
+    new_root->color = BLACK;
+    return new_root;
+}
+
+
+// Fix a missing black node on one side of path[k] after a delete, as RBT_delete_fixup does. The sibling and its
+// children are copied before they are recolored
+static void prbt_delete_fixup(PRBTNode **path, int k, bool left, PRBTNode **new_root) {
+    while(k >= 0) {
+        PRBTNode *parent = path[k];
+        PRBTNode **parent_link = prbt_link(path, k, new_root);
+        PRBTNode *sibling = prbt_unshare(left ? &parent->right : &parent->left);
+        if(sibling->color == RED) {
+            sibling->color = BLACK;
+            parent->color = RED;
+            *parent_link = left ? prbt_rotate_left(parent) : prbt_rotate_right(parent);
+            parent_link = left ? &sibling->left : &sibling->right;
+            sibling = prbt_unshare(left ? &parent->right : &parent->left);
+        }
+        PRBTNode *near = left ? sibling->left : sibling->right, *far = left ? sibling->right : sibling->left;
+        if(!prbt_is_red(near) && !prbt_is_red(far)) {
+            sibling->color = RED;
+            if(parent->color == RED) {
+                parent->color = BLACK;
+                return;
+            }
+            left = k > 0 && path[k - 1]->left == parent;
+            k--;
+            continue;
+        }
+        if(!prbt_is_red(far)) {
+            near = prbt_unshare(left ? &sibling->left : &sibling->right);
+            near->color = BLACK;
+            sibling->color = RED;
+            if(left)
+                parent->right = prbt_rotate_right(sibling);
+            else
+                parent->left = prbt_rotate_left(sibling);
+            far = sibling;
+            sibling = near;
+        }
+        else
+            far = prbt_unshare(left ? &sibling->right : &sibling->left);
+        sibling->color = parent->color;
+        parent->color = BLACK;
+        far->color = BLACK;
+        *parent_link = left ? prbt_rotate_left(parent) : prbt_rotate_right(parent);
+        return;
+    }
+}
+
+
+// Returns a new version of the tree without data (or the same root, with a new reference, if data is not in the tree)
+PRBTree PRBT_delete(PRBTree root, void *data, CompareFunc compare) {
+    assert(compare != NULL);
+    if(!PRBT_search(root, data, compare))
+        return prbt_retain(root);
+    // Copy the path to the node of data, and then to its successor if the node has two children
+    PRBTNode *path[PRBT_MAX_HEIGHT], *new_root = NULL, **link;
+    PRBTNode *node = root;
+    int depth = 0;
+    for(link = &new_root ; ; ) {
+        int result = RBT_compare(compare, data, node->data);
+        PRBTNode *copy = prbt_create_node(node->data, node->color, NULL, NULL);
+        *link = path[depth++] = copy;
+        if(result == 0)
+            break;
+        if(result < 0) {
+            copy->right = prbt_retain(node->right);
+            link = &copy->left;
+            node = node->left;
+        }
+        else {
+            copy->left = prbt_retain(node->left);
+            link = &copy->right;
+            node = node->right;
+        }
+    }
+    PRBTNode *target = path[depth - 1];
+    if(node->left != NULL && node->right != NULL) {
+        target->left = prbt_retain(node->left);
+        link = &target->right;
+        for(node = node->right ; node != NULL ; node = node->left) {
+            PRBTNode *copy = prbt_create_node(node->data, node->color, NULL, prbt_retain(node->right));
+            *link = path[depth++] = copy;
+            link = &copy->left;
+        }
+        target->data = path[depth - 1]->data;
+        node = NULL;
+    }
+    else {
+        // The copy of the node takes the reference of its only child (or none)
+        target->left = prbt_retain(node->left);
+        target->right = prbt_retain(node->right);
+    }
+
+    // Remove the last node of the path, which has at most one child. Its link takes the reference of the child
+    PRBTNode *removed = path[--depth];
+    PRBTNode *child = removed->left != NULL ? removed->left : removed->right;
+    PRBTNode **removed_link = prbt_link(path, depth, &new_root);
+    bool left = removed_link != &new_root && path[depth - 1]->left == removed;
+    *removed_link = child;
+    Color color = removed->color;
+    prbt_free_node(removed);
+
+    if(color == BLACK) {
+        if(prbt_is_red(child))
+            prbt_unshare(removed_link)->color = BLACK;
+        else
+            prbt_delete_fixup(path, depth - 1, left, &new_root);
+    }
+    if(prbt_is_red(new_root))
+        new_root->color = BLACK;
+    return new_root;
+}
+
+
+// Search data in a version of the tree
+bool PRBT_search(PRBTree root, void *data, CompareFunc compare) {
+    assert(compare != NULL);
+    while(root != NULL) {
+        int result = RBT_compare(compare, data, root->data);
+        if(result == 0)
+            return true;
+        root = result < 0 ? root->left : root->right;
+    }
+    return false;
+}
+
+
+// Returns a snapshot of a version of the tree, in O(1)
+PRBTree PRBT_retain(PRBTree root) {
+    return prbt_retain(root);
+}
+
+
+// Release a version of the tree. The nodes which are not shared with another version are freed
+void PRBT_release(PRBTree root) {
+    prbt_release(root);
+}
+
+
+// Visit the items of [low, high) of a subtree in order. Returns false if visit stopped the range
+static bool prbt_range(PRBTNode *node, void *low, void *high, CompareFunc compare, RBTRangeFunc visit, void *ctx,
+                       size_t *count) {
+    while(node != NULL) {
+        bool above_low = low == NULL || RBT_compare(compare, node->data, low) >= 0;
+        bool below_high = high == NULL || RBT_compare(compare, node->data, high) < 0;
+        if(above_low && !prbt_range(node->left, low, below_high ? NULL : high, compare, visit, ctx, count))
+            return false;
+        if(above_low && below_high) {
+            (*count)++;
+            if(!visit(node->data, ctx))
+                return false;
+        }
+        if(!below_high)
+            return true;
+        // Every item of the right subtree is greater than low when this node is not less than it
+        if(above_low)
+            low = NULL;
+        node = node->right;
+    }
+    return true;
+}
+
+
+// Visit the items of [low, high) of a version of the tree in order, until visit returns false
+size_t PRBT_range(PRBTree root, void *low, void *high, CompareFunc compare, RBTRangeFunc visit, void *ctx) {
+    size_t count = 0;
+    prbt_range(root, low, high, compare, visit, ctx, &count);
+    return count;
+}
+
+
+// Returns the number of items in a version of the tree
+size_t PRBT_count_items(PRBTree root) {
+    if(root == NULL)
+        return 0;
+    return 1 + PRBT_count_items(root->left) + PRBT_count_items(root->right);
+}
+
+
+// Compact red black trees. The nodes are stored in one array and linked by 31-bit indices, and the color of a node is
+// kept in the top bit of its left link. There are no parent pointers, so the updates remember their search path. Index
+// 0 is the empty subtree (a black leaf)
+
+
+#define RBTC_RED 0x80000000u
+#define RBTC_INDEX(link) ((link) & ~RBTC_RED)
+#define RBTC_MAX_NODES 0x7fffffffu
+
+// The height of a red black tree of fewer than 2^31 nodes is at most 62
+#define RBTC_MAX_HEIGHT 64
+
+struct rbt_compact_node {
+    void *data;
+    uint32_t left;  // The top bit is set if the node is red
+    uint32_t right;
+};
+
+struct rbt_compact {
+    struct rbt_compact_node *nodes; // nodes[0] is never used, so that index 0 is the empty subtree
+    uint32_t capacity;              // Nodes of the array, including nodes[0]
+    uint32_t used;                  // Nodes which have been handed out, including nodes[0]
+    uint32_t free_list;             // Deleted nodes, linked by their left index
+    uint32_t root;
+    size_t size;
+    CompareFunc compare;
+};
+
+
+// Returns the node of an index
+#define RBTC_NODE(tree, index) (&(tree)->nodes[index])
+
+
+static inline bool rbtc_is_red(CompactRBTree tree, uint32_t index) {
+    return (tree->nodes[index].left & RBTC_RED) != 0;
+}
+
+
+static inline void rbtc_set_color(CompactRBTree tree, uint32_t index, Color color) {
+    uint32_t *left = &tree->nodes[index].left;
+    *left = RBTC_INDEX(*left) | (color == RED ? RBTC_RED : 0);
+}
+
+
+// Returns the child of a node (0 is the left and 1 the right one)
+static inline uint32_t rbtc_child(CompactRBTree tree, uint32_t index, int dir) {
+    struct rbt_compact_node *node = RBTC_NODE(tree, index);
+    return dir ? node->right : RBTC_INDEX(node->left);
+}
+
+
+// Set the child of a node, keeping its color
+static inline void rbtc_set_child(CompactRBTree tree, uint32_t index, int dir, uint32_t child) {
+    struct rbt_compact_node *node = RBTC_NODE(tree, index);
+    if(dir)
+        node->right = child;
+    else
+        node->left = (node->left & RBTC_RED) | child;
+}
+
+
+// Create an empty compact red black tree
+CompactRBTree RBT_compact_create(CompareFunc compare) {
+    assert(compare != NULL);
+    CompactRBTree tree = malloc(sizeof(*tree));
+    assert(tree != NULL);
+    tree->nodes = NULL;
+    tree->capacity = tree->used = 0;
+    tree->free_list = tree->root = 0;
+    tree->size = 0;
+    tree->compare = compare;
+    RBT_compact_reserve(tree, 16);
+    return tree;
+}
+
+
+// Make sure that the tree can hold at least capacity items without growing its array
+void RBT_compact_reserve(CompactRBTree tree, size_t capacity) {
+    assert(capacity < RBTC_MAX_NODES);
+    if(capacity + 1 <= tree->capacity)
+        return;
+    struct rbt_compact_node *nodes = realloc(tree->nodes, (capacity + 1) * sizeof(struct rbt_compact_node));
+    assert(nodes != NULL);
+    RBT_STATS_ADD(bytes_allocated, (capacity + 1 - tree->capacity) * sizeof(struct rbt_compact_node));
+    if(tree->capacity == 0)
+        nodes[0] = (struct rbt_compact_node){ NULL, 0, 0 };
+    tree->nodes = nodes;
+    tree->capacity = (uint32_t)(capacity + 1);
+    if(tree->used == 0)
+        tree->used = 1;
+}
+
+
+// Hand out a red node, reusing a deleted one first. The array may move, so no node pointer is valid after this
+static uint32_t rbtc_alloc_node(CompactRBTree tree, void *data) {
+    uint32_t index = tree->free_list;
+    if(index != 0)
+        tree->free_list = tree->nodes[index].left;
+    else {
+        if(tree->used == tree->capacity) {
+            size_t capacity = (size_t)tree->capacity * 2;
+            RBT_compact_reserve(tree, capacity < RBTC_MAX_NODES ? capacity : RBTC_MAX_NODES - 1);
+            assert(tree->used < tree->capacity);
+        }
+        index = tree->used++;
+    }
+    tree->nodes[index] = (struct rbt_compact_node){ data, RBTC_RED, 0 };
+    return index;
+}
+
+
+// Rotate the subtree of x towards dir (a left rotation when dir is 0) and return its new root, whose link is fixed by
+// the caller
+static uint32_t rbtc_rotate(CompactRBTree tree, uint32_t x, int dir) {
+    RBT_STATS_ADD(rotations, 1);
+    uint32_t z = rbtc_child(tree, x, !dir);
+    rbtc_set_child(tree, x, !dir, rbtc_child(tree, z, dir));
+    rbtc_set_child(tree, z, dir, x);
+    return z;
+}
+
+
+// Set the link of path[i] in its parent (or the root)
+static void rbtc_set_link(CompactRBTree tree, uint32_t *path, int *dirs, int i, uint32_t child) {
+    if(i == 0)
+        tree->root = child;
+    else
+        rbtc_set_child(tree, path[i - 1], dirs[i - 1], child);
+}
+
+
+// Insert data into the tree. Returns false (and leaves the tree unchanged) if it is already in the tree
+bool RBT_compact_insert(CompactRBTree tree, void *data) {
+    uint32_t path[RBTC_MAX_HEIGHT + 1];
+    int dirs[RBTC_MAX_HEIGHT + 1], depth = 0;
+    for(uint32_t index = tree->root ; index != 0 ; ) {
+        int result = RBT_compare(tree->compare, data, tree->nodes[index].data);
+        if(result == 0)
+            return false;
+        path[depth] = index;
+        dirs[depth++] = result > 0;
+        index = rbtc_child(tree, index, result > 0);
+    }
+    uint32_t node = rbtc_alloc_node(tree, data);
+    tree->size++;
+    rbtc_set_link(tree, path, dirs, depth, node);
+    path[depth++] = node;
+
+    // Fix a red node with a red parent, as RBT_insert does
+    int i = depth - 1;
+    while(i >= 2 && rbtc_is_red(tree, path[i - 1])) {
+        uint32_t parent = path[i - 1], grandparent = path[i - 2];
+        int dir = dirs[i - 2]; // The side of the parent
+        uint32_t uncle = rbtc_child(tree, grandparent, !dir);
+        if(rbtc_is_red(tree, uncle)) {
+            rbtc_set_color(tree, parent, BLACK);
+            rbtc_set_color(tree, uncle, BLACK);
+            rbtc_set_color(tree, grandparent, RED);
+            i -= 2;
+            continue;
+        }
+        if(dirs[i - 1] != dir) {
+            rbtc_set_child(tree, grandparent, dir, rbtc_rotate(tree, parent, dir));
+            parent = path[i];
+        }
+        rbtc_set_link(tree, path, dirs, i - 2, rbtc_rotate(tree, grandparent, !dir));
+        rbtc_set_color(tree, parent, BLACK);
+        rbtc_set_color(tree, grandparent, RED);
+        break;
+    }
+    rbtc_set_color(tree, tree->root, BLACK);
+    return true;
+}
+
+
+// Fix a missing black node on the dir side of path[k] after a delete, as RBT_delete_fixup does
+static void rbtc_delete_fixup(CompactRBTree tree, uint32_t *path, int *dirs, int k, int dir) {
+    while(k >= 0) {
+        uint32_t parent = path[k];
+        uint32_t sibling = rbtc_child(tree, parent, !dir);
+        // The link of the parent, which changes when the parent is rotated down
+        uint32_t above = k > 0 ? path[k - 1] : 0;
+        int above_dir = k > 0 ? dirs[k - 1] : 0;
+        if(rbtc_is_red(tree, sibling)) {
+            rbtc_set_color(tree, sibling, BLACK);
+            rbtc_set_color(tree, parent, RED);
+            uint32_t root = rbtc_rotate(tree, parent, dir);
+            if(above == 0)
+                tree->root = root;
+            else
+                rbtc_set_child(tree, above, above_dir, root);
+            above = root;
+            above_dir = dir;
+            sibling = rbtc_child(tree, parent, !dir);
+        }
+        uint32_t near = rbtc_child(tree, sibling, dir), far = rbtc_child(tree, sibling, !dir);
+        if(!rbtc_is_red(tree, near) && !rbtc_is_red(tree, far)) {
+            rbtc_set_color(tree, sibling, RED);
+            if(rbtc_is_red(tree, parent)) {
+                rbtc_set_color(tree, parent, BLACK);
+                return;
+            }
+            dir = k > 0 ? dirs[k - 1] : 0;
+            k--;
+            continue;
+        }
+        if(!rbtc_is_red(tree, far)) {
+            rbtc_set_color(tree, near, BLACK);
+            rbtc_set_color(tree, sibling, RED);
+            rbtc_set_child(tree, parent, !dir, rbtc_rotate(tree, sibling, !dir));
+            far = sibling;
+            sibling = near;
+        }
+        rbtc_set_color(tree, sibling, rbtc_is_red(tree, parent) ? RED : BLACK);
+        rbtc_set_color(tree, parent, BLACK);
+        rbtc_set_color(tree, far, BLACK);
+        uint32_t root = rbtc_rotate(tree, parent, dir);
+        if(above == 0)
+            tree->root = root;
+        else
+            rbtc_set_child(tree, above, above_dir, root);
+        return;
+    }
+}
+
+
+// Delete data from the tree and destroy it (if destroy is not NULL). Returns true if data was in the tree
+bool RBT_compact_delete(CompactRBTree tree, void *data, DestroyFunc destroy) {
+    uint32_t path[RBTC_MAX_HEIGHT + 1];
+    int dirs[RBTC_MAX_HEIGHT + 1], depth = 0;
+    uint32_t index = tree->root;
+    while(index != 0) {
+        int result = RBT_compare(tree->compare, data, tree->nodes[index].data);
+        if(result == 0)
+            break;
+        path[depth] = index;
+        dirs[depth++] = result > 0;
+        index = rbtc_child(tree, index, result > 0);
+    }
+    if(index == 0)
+        return false;
+    if(destroy != NULL)
+        destroy(tree->nodes[index].data);
+    if(rbtc_child(tree, index, 0) != 0 && rbtc_child(tree, index, 1) != 0) {
+        // Move the item of the successor here, and remove the successor instead
+        uint32_t found = index;
+        path[depth] = index;
+        dirs[depth++] = 1;
+        index = rbtc_child(tree, index, 1);
+        while(rbtc_child(tree, index, 0) != 0) {
+            path[depth] = index;
+            dirs[depth++] = 0;
+            index = rbtc_child(tree, index, 0);
+        }
+        tree->nodes[found].data = tree->nodes[index].data;
+    }
+    uint32_t child = rbtc_child(tree, index, 0) != 0 ? rbtc_child(tree, index, 0) : rbtc_child(tree, index, 1);
+    bool red = rbtc_is_red(tree, index);
+    rbtc_set_link(tree, path, dirs, depth, child);
+    tree->nodes[index].left = tree->free_list;
+    tree->free_list = index;
+    tree->size--;
+
+    if(!red) {
+        if(rbtc_is_red(tree, child))
+            rbtc_set_color(tree, child, BLACK);
+        else
+            rbtc_delete_fixup(tree, path, dirs, depth - 1, depth > 0 ? dirs[depth - 1] : 0);
+    }
+    if(tree->root != 0)
+        rbtc_set_color(tree, tree->root, BLACK);
+    return true;
+}
+
+
+// Search data in the tree
+bool RBT_compact_search(CompactRBTree tree, void *data) {
+    for(uint32_t index = tree->root ; index != 0 ; ) {
+        int result = RBT_compare(tree->compare, data, tree->nodes[index].data);
+        if(result == 0)
+            return true;
+        index = rbtc_child(tree, index, result > 0);
+    }
+    return false;
+}
+
+
+// Returns the number of items in the tree
+size_t RBT_compact_size(CompactRBTree tree) {
+    return tree->size;
+}
+
+
+// Returns the bytes of the array of the nodes
+size_t RBT_compact_bytes(CompactRBTree tree) {
+    return (size_t)tree->capacity * sizeof(struct rbt_compact_node);
+}
+
+
+// Visit the items of [low, high) of a subtree in order. Returns false if visit stopped the range
+static bool rbtc_range(CompactRBTree tree, uint32_t index, void *low, void *high, RBTRangeFunc visit, void *ctx,
+                       size_t *count) {
+    while(index != 0) {
+        void *data = tree->nodes[index].data;
+        bool above_low = low == NULL || RBT_compare(tree->compare, data, low) >= 0;
+        bool below_high = high == NULL || RBT_compare(tree->compare, data, high) < 0;
+        if(above_low && !rbtc_range(tree, rbtc_child(tree, index, 0), low, below_high ? NULL : high, visit, ctx, count))
+            return false;
+        if(above_low && below_high) {
+            (*count)++;
+            if(!visit(data, ctx))
+                return false;
+        }
+        if(!below_high)
+            return true;
+        // Every item of the right subtree is greater than low when this node is not less than it
+        if(above_low)
+            low = NULL;
+        index = rbtc_child(tree, index, 1);
+    }
+    return true;
+}
+
+
+// Visit the items of [low, high) in order, until visit returns false
+size_t RBT_compact_range(CompactRBTree tree, void *low, void *high, RBTRangeFunc visit, void *ctx) {
+    size_t count = 0;
+    rbtc_range(tree, tree->root, low, high, visit, ctx, &count);
+    return count;
+}
+
+
+// Destroy the tree. Without a destroy function the nodes are freed at once with their array
+void RBT_compact_destroy(CompactRBTree tree, DestroyFunc destroy) {
+    if(destroy != NULL) {
+        // The deleted nodes are marked first, so that only the items of the tree are destroyed
+        for(uint32_t index = tree->free_list ; index != 0 ; ) {
+            uint32_t next = tree->nodes[index].left;
+            tree->nodes[index].data = NULL;
+            index = next;
+        }
+        for(uint32_t index = 1 ; index < tree->used ; index++)
+            if(tree->nodes[index].data != NULL)
+                destroy(tree->nodes[index].data);
+    }
+    RBT_STATS_SUB(bytes_allocated, (size_t)tree->capacity * sizeof(struct rbt_compact_node));
+    free(tree->nodes);
+    free(tree);
+}
+
+
+// Return a snapshot of the instrumentation counters of the red black trees
+RBT_stats RBT_get_stats(void) {
+    RBT_stats snapshot = {0};
+#ifdef DS_STATS
+    snapshot.compares = atomic_load_explicit(&stats.compares, memory_order_relaxed);
+    snapshot.rotations = atomic_load_explicit(&stats.rotations, memory_order_relaxed);
+    snapshot.bytes_allocated = atomic_load_explicit(&stats.bytes_allocated, memory_order_relaxed);
+#endif
+    return snapshot;
+}
+
+
+// Reset the instrumentation counters of the red black trees (bytes_allocated keeps describing the allocated nodes)
+void RBT_reset_stats(void) {
+#ifdef DS_STATS
+    atomic_store_explicit(&stats.compares, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats.rotations, 0, memory_order_relaxed);
+#endif
 }
\ No newline at end of file
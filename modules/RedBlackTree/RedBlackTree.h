@@ -3,10 +3,18 @@
 #define RED_BLACK_TREES_H
 
 #include <stdbool.h>
+#include "../Allocator/Allocator.h"
+#include "../ThreadPool/ThreadPool.h"
 
 
 typedef struct RBTNode *RBTree;
 
+// A version of a persistent red black tree (NULL is the empty tree)
+typedef struct PRBTNode *PRBTree;
+
+// A red black tree whose nodes are stored in one array and linked by 32-bit indices
+typedef struct rbt_compact *CompactRBTree;
+
 // Compare functions for the different data type
 typedef int (*CompareFunc)(void *, void *);
 
@@ -16,11 +24,64 @@ typedef void (*DestroyFunc)(void *);
 // Functions to visit nodes printing their data
 typedef void (*PrintFunc)(void *);
 
+// Functions which visit the items of a range. Returning false stops the range
+typedef bool (*RBTRangeFunc)(void *data, void *ctx);
+
+// Counters of the hot paths of all the red black trees. They are only updated when the library is built with -DDS_STATS
+// (make STATS=1 in lib), so they cost nothing otherwise and stay zero.
+// The counters are updated atomically, so they stay exact when the parallel set operations update them from the
+// threads of their pool, and when versions of persistent trees are created and released on several threads.
+typedef struct {
+    size_t compares;        // Calls of the compare function
+    size_t rotations;       // Left and right rotations
+    size_t bytes_allocated; // Bytes currently allocated by the nodes of the trees (the data is not included)
+} RBT_stats;
+
+// Iterator over the items of a red black tree in order, which follows the parent pointers of the nodes. It stays
+// valid when items are inserted (also the end of a non empty tree, whose root may change), but not when an item is
+// deleted. The end of an empty tree knows no node of the tree, so it must be taken again after an insert
+typedef struct {
+    RBTree root;
+    RBTree node; // NULL at the end
+} RBTIterator;
+
 /* The red black tree should be initialized to NULL before starting to insert data */
 
+// Set the allocator of the nodes of all the red black trees (NULL restores malloc and free). A tree is just a pointer to
+// its root, so the allocator is shared by the whole module and it should only be changed while no tree has nodes
+void RBT_set_allocator(const Allocator *allocator);
+
 // Insert the node into the red black tree
 void RBT_insert(RBTree *root, void *data, CompareFunc compare);
 
+// Build a perfectly balanced red black tree from count items which are sorted in strictly ascending order, in
+// O(count). The order is only checked (with count - 1 calls of compare), and NULL is returned if it is wrong
+RBTree RBT_build_sorted(void **items, size_t count, CompareFunc compare);
+
+// Join two red black trees and an item which is greater than every item of left and less than every item of right, in
+// O(log n). The trees are consumed by the join
+RBTree RBT_join(RBTree left, void *data, RBTree right);
+
+// Split the red black tree into the items which are less than data (left) and the items which are greater than data
+// (right), in O(log n). The tree is consumed by the split. Returns the item which equals data (whose node is freed) or
+// NULL
+void *RBT_split(RBTree root, void *data, CompareFunc compare, RBTree *left, RBTree *right);
+
+/* The set operations consume both trees and return the result, in O(m log(n/m + 1)) where m and n are the sizes of
+   the smaller and the larger tree. The items which are not in the result (for the union, the items of root2 which are
+   also in root1) are destroyed with destroy if it is not NULL. If pool is not NULL, the operation runs on the threads
+   of the pool, which should then only be used by one caller at a time, and the allocator of the module must be
+   thread safe (malloc is) */
+
+// Return the union of two red black trees
+RBTree RBT_union(RBTree root1, RBTree root2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool);
+
+// Return the intersection of two red black trees (the items of root1 are kept)
+RBTree RBT_intersection(RBTree root1, RBTree root2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool);
+
+// Return the items of root1 which are not in root2
+RBTree RBT_difference(RBTree root1, RBTree root2, CompareFunc compare, DestroyFunc destroy, ThreadPool pool);
+
 // Remove node with given data from the red black tree
 bool RBT_delete(RBTree *root, void *data, CompareFunc compare, DestroyFunc destroy);
 
@@ -30,6 +91,35 @@ bool RBT_search(RBTree root, void *data, CompareFunc compare);
 // Returns the data of the k-th item of in the red black tree
 void *RBT_select_k_th_item(RBTree root, size_t k);
 
+// Returns an iterator to the first item of the red black tree
+RBTIterator RBT_begin(RBTree root);
+
+// Returns an iterator to the end of the red black tree (after the last item)
+RBTIterator RBT_end(RBTree root);
+
+// Returns an iterator to the first item of the red black tree which is not less than data (or to the end)
+RBTIterator RBT_lower_bound(RBTree root, void *data, CompareFunc compare);
+
+// Check if the iterator points to an item (and not to the end)
+bool RBT_iterator_valid(RBTIterator it);
+
+// Returns the item of the iterator, or NULL at the end
+void *RBT_iterator_data(RBTIterator it);
+
+// Returns an iterator to the next item, in O(1) amortized
+RBTIterator RBT_next(RBTIterator it);
+
+// Returns an iterator to the previous item. The end moves to the last item and the first item moves to the end
+RBTIterator RBT_prev(RBTIterator it);
+
+// Visit the items of [low, high) in order, until visit returns false. A NULL low starts from the first item and a NULL
+// high goes up to the last one. Returns the number of visited items
+size_t RBT_range(RBTree root, void *low, void *high, CompareFunc compare, RBTRangeFunc visit, void *ctx);
+
+// Copy up to capacity items which are less than high (NULL for no bound), starting from the iterator, and move the
+// iterator after them. Returns the number of copied items, which is 0 at the end of the range
+size_t RBT_range_batch(RBTIterator *it, void *high, CompareFunc compare, void **items, size_t capacity);
+
 // Check if the red black tree is empty
 bool RBT_empty(RBTree root);
 
@@ -54,4 +144,70 @@ void *RBT_max_value(RBTree root);
 // Function which is used to destroy a red black tree
 void RBT_destroy(RBTree node, DestroyFunc destroy);
 
+/* Persistent red black trees: an update returns a new version and leaves the old one unchanged, so readers of a version
+   need no lock. The caller owns a reference to every version which it gets (including the same root, when an update
+   does not change the tree) and releases it with PRBT_release. The items are shared by the versions, so they are never
+   destroyed by the tree. When versions are updated or released on several threads, nodes are allocated and freed by
+   all of them, so the allocator of the module (RBT_set_allocator) must be thread safe (malloc is) */
+
+// Returns a new version of the tree which also holds data (or the same root, if data is already in the tree)
+PRBTree PRBT_insert(PRBTree root, void *data, CompareFunc compare);
+
+// Returns a new version of the tree without data (or the same root, if data is not in the tree)
+PRBTree PRBT_delete(PRBTree root, void *data, CompareFunc compare);
+
+// Search data in a version of the tree
+bool PRBT_search(PRBTree root, void *data, CompareFunc compare);
+
+// Returns a snapshot of a version of the tree, in O(1). It is a new reference to the same root
+PRBTree PRBT_retain(PRBTree root);
+
+// Release a version of the tree. The nodes which are not shared with another version are freed
+void PRBT_release(PRBTree root);
+
+// Visit the items of [low, high) of a version of the tree in order, until visit returns false. A NULL low starts from
+// the first item and a NULL high goes up to the last one. Returns the number of visited items
+size_t PRBT_range(PRBTree root, void *low, void *high, CompareFunc compare, RBTRangeFunc visit, void *ctx);
+
+// Returns the number of items in a version of the tree
+size_t PRBT_count_items(PRBTree root);
+
+/* Compact red black trees: the nodes (an item and two 32-bit links, one of which also holds the color) take 16 bytes and
+   are stored in one array, which grows by doubling, instead of being allocated one by one. There are no parent
+   pointers. A tree holds up to 2^31 - 2 items */
+
+// Create an empty compact red black tree which orders its items with compare
+CompactRBTree RBT_compact_create(CompareFunc compare);
+
+// Make sure that the tree can hold at least capacity items without growing its array
+void RBT_compact_reserve(CompactRBTree tree, size_t capacity);
+
+// Insert data into the tree. Returns false (and leaves the tree unchanged) if it is already in the tree
+bool RBT_compact_insert(CompactRBTree tree, void *data);
+
+// Delete data from the tree and destroy it (if destroy is not NULL). Returns true if data was in the tree
+bool RBT_compact_delete(CompactRBTree tree, void *data, DestroyFunc destroy);
+
+// Search data in the tree
+bool RBT_compact_search(CompactRBTree tree, void *data);
+
+// Returns the number of items in the tree
+size_t RBT_compact_size(CompactRBTree tree);
+
+// Returns the bytes of the array of the nodes
+size_t RBT_compact_bytes(CompactRBTree tree);
+
+// Visit the items of [low, high) in order, until visit returns false. A NULL low starts from the first item and a NULL
+// high goes up to the last one. Returns the number of visited items
+size_t RBT_compact_range(CompactRBTree tree, void *low, void *high, RBTRangeFunc visit, void *ctx);
+
+// Destroy the tree and its items (destroy may be NULL). Without a destroy function the nodes are freed at once
+void RBT_compact_destroy(CompactRBTree tree, DestroyFunc destroy);
+
+// Return a snapshot of the instrumentation counters of the red black trees
+RBT_stats RBT_get_stats(void);
+
+// Reset the instrumentation counters of the red black trees (bytes_allocated keeps describing the allocated nodes)
+void RBT_reset_stats(void);
+
 #endif
\ No newline at end of file
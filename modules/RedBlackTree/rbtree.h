@@ -0,0 +1,413 @@
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "../Allocator/Allocator.h"
+
+// Red black tree which stores its keys and values inside its nodes, generated for a key and a value type:
+//     #define INT_LESS(a, b) ((a) < (b))
+//     DECLARE_RBTREE(int, double, INT_LESS)
+//     rbtree_int_double *tree = rbtree_int_double_create();
+//     rbtree_int_double_insert(tree, 42, 1.5);
+//     double *value = rbtree_int_double_get(tree, 42);
+// LESS(a, b) receives two keys and returns true when a is strictly less than b. It can be a function-like macro or a
+// static inline function, so it is inlined instead of being called through a pointer. Every descent calls it once per
+// level: the search goes left when the key is less than the node and right otherwise, remembering the last node where
+// it went right, and a single extra call at the bottom tells whether that node holds the key. KEY and VALUE must be
+// single-token type names (use a typedef for e.g. unsigned long or char *).
+#define DECLARE_RBTREE(KEY, VALUE, LESS)                                                                                        \
+DECLARE_RBTREE_STRUCT(KEY, VALUE)                                                                                               \
+DEFINE_RBTREE_CREATE(KEY, VALUE)                                                                                                \
+DEFINE_RBTREE_ROTATE(KEY, VALUE)                                                                                                \
+DEFINE_RBTREE_SEARCH(KEY, VALUE, LESS)                                                                                          \
+DEFINE_RBTREE_INSERT(KEY, VALUE, LESS)                                                                                          \
+DEFINE_RBTREE_REMOVE(KEY, VALUE)                                                                                                \
+DEFINE_RBTREE_ITERATE(KEY, VALUE)
+
+
+#define DECLARE_RBTREE_STRUCT(KEY, VALUE)                                                                                       \
+typedef struct rbtree_##KEY##_##VALUE##_node {                                                                                  \
+    KEY key;                                                                                                                    \
+    VALUE value;                                                                                                                \
+    struct rbtree_##KEY##_##VALUE##_node *left;                                                                                 \
+    struct rbtree_##KEY##_##VALUE##_node *right;                                                                                \
+    struct rbtree_##KEY##_##VALUE##_node *parent;                                                                               \
+    bool red;                                                                                                                   \
+} rbtree_##KEY##_##VALUE##_node;                                                                                                \
+                                                                                                                                \
+typedef struct rbtree_##KEY##_##VALUE {                                                                                         \
+    rbtree_##KEY##_##VALUE##_node *root;                                                                                        \
+    size_t size;                                                                                                                \
+    Allocator allocator;                                                                                                        \
+} rbtree_##KEY##_##VALUE;
+
+
+// Create an empty tree whose nodes are allocated with the given allocator (NULL uses malloc and free). Freeing the
+// tree frees its nodes, but keys and values which own memory have to be freed by the caller first (e.g. in for_each).
+#define DEFINE_RBTREE_CREATE(KEY, VALUE)                                                                                        \
+static inline rbtree_##KEY##_##VALUE *rbtree_##KEY##_##VALUE##_create_with_allocator(const Allocator *allocator) {              \
+    rbtree_##KEY##_##VALUE *tree = allocator_alloc(allocator, sizeof(*tree));                                                   \
+    if (tree == NULL) {                                                                                                         \
+        fprintf(stderr, "Failed to allocate the red black tree\n");                                                             \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    tree->root = NULL;                                                                                                          \
+    tree->size = 0;                                                                                                             \
+    tree->allocator = allocator != NULL ? *allocator : (Allocator){0};                                                          \
+    return tree;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline rbtree_##KEY##_##VALUE *rbtree_##KEY##_##VALUE##_create(void) {                                                   \
+    return rbtree_##KEY##_##VALUE##_create_with_allocator(NULL);                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+/* Free the nodes of a subtree, recursing only into the smaller side of every node */                                           \
+static inline void rbtree_##KEY##_##VALUE##_free_nodes(rbtree_##KEY##_##VALUE *tree, rbtree_##KEY##_##VALUE##_node *node) {     \
+    while (node != NULL) {                                                                                                      \
+        rbtree_##KEY##_##VALUE##_free_nodes(tree, node->left);                                                                  \
+        rbtree_##KEY##_##VALUE##_node *right = node->right;                                                                     \
+        allocator_free(&tree->allocator, node, sizeof(*node));                                                                  \
+        node = right;                                                                                                           \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void rbtree_##KEY##_##VALUE##_clear(rbtree_##KEY##_##VALUE *tree) {                                               \
+    rbtree_##KEY##_##VALUE##_free_nodes(tree, tree->root);                                                                      \
+    tree->root = NULL;                                                                                                          \
+    tree->size = 0;                                                                                                             \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void rbtree_##KEY##_##VALUE##_free(rbtree_##KEY##_##VALUE *tree) {                                                \
+    if (tree == NULL)                                                                                                           \
+        return;                                                                                                                 \
+    rbtree_##KEY##_##VALUE##_clear(tree);                                                                                       \
+    Allocator allocator = tree->allocator;                                                                                      \
+    allocator_free(&allocator, tree, sizeof(*tree));                                                                            \
+}                                                                                                                               \
+                                                                                                                                \
+static inline size_t rbtree_##KEY##_##VALUE##_size(const rbtree_##KEY##_##VALUE *tree) {                                        \
+    return tree->size;                                                                                                          \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool rbtree_##KEY##_##VALUE##_empty(const rbtree_##KEY##_##VALUE *tree) {                                         \
+    return tree->size == 0;                                                                                                     \
+}
+
+
+// Left and right rotations around a node, which keep the parent pointers and the root up to date
+#define DEFINE_RBTREE_ROTATE(KEY, VALUE)                                                                                        \
+static inline void rbtree_##KEY##_##VALUE##_replace_child(rbtree_##KEY##_##VALUE *tree,                                         \
+                                                         rbtree_##KEY##_##VALUE##_node *node,                                   \
+                                                         rbtree_##KEY##_##VALUE##_node *child) {                                \
+    rbtree_##KEY##_##VALUE##_node *parent = node->parent;                                                                       \
+    if (parent == NULL)                                                                                                         \
+        tree->root = child;                                                                                                     \
+    else if (parent->left == node)                                                                                              \
+        parent->left = child;                                                                                                   \
+    else                                                                                                                        \
+        parent->right = child;                                                                                                  \
+    if (child != NULL)                                                                                                          \
+        child->parent = parent;                                                                                                 \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void rbtree_##KEY##_##VALUE##_rotate_left(rbtree_##KEY##_##VALUE *tree, rbtree_##KEY##_##VALUE##_node *x) {       \
+    rbtree_##KEY##_##VALUE##_node *y = x->right;                                                                                \
+    x->right = y->left;                                                                                                         \
+    if (y->left != NULL)                                                                                                        \
+        y->left->parent = x;                                                                                                    \
+    rbtree_##KEY##_##VALUE##_replace_child(tree, x, y);                                                                         \
+    y->left = x;                                                                                                                \
+    x->parent = y;                                                                                                              \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void rbtree_##KEY##_##VALUE##_rotate_right(rbtree_##KEY##_##VALUE *tree, rbtree_##KEY##_##VALUE##_node *x) {      \
+    rbtree_##KEY##_##VALUE##_node *y = x->left;                                                                                 \
+    x->left = y->right;                                                                                                         \
+    if (y->right != NULL)                                                                                                       \
+        y->right->parent = x;                                                                                                   \
+    rbtree_##KEY##_##VALUE##_replace_child(tree, x, y);                                                                         \
+    y->right = x;                                                                                                               \
+    x->parent = y;                                                                                                              \
+}
+
+
+// Return a pointer to the value of the given key (NULL if it is not in the tree), or the node with the smallest key
+// which is not less than the given key (lower_bound, NULL if every key is less). Both compare once per level.
+#define DEFINE_RBTREE_SEARCH(KEY, VALUE, LESS)                                                                                  \
+static inline rbtree_##KEY##_##VALUE##_node *rbtree_##KEY##_##VALUE##_find(const rbtree_##KEY##_##VALUE *tree, KEY key) {       \
+    rbtree_##KEY##_##VALUE##_node *candidate = NULL;                                                                            \
+    for (rbtree_##KEY##_##VALUE##_node *node = tree->root; node != NULL; ) {                                                    \
+        if (LESS(key, node->key)) {                                                                                             \
+            node = node->left;                                                                                                  \
+        } else {                                                                                                                \
+            candidate = node;                                                                                                   \
+            node = node->right;                                                                                                 \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    /* candidate holds the largest key which is not greater than key, so it is equal unless it is less */                       \
+    return candidate != NULL && !LESS(candidate->key, key) ? candidate : NULL;                                                  \
+}                                                                                                                               \
+                                                                                                                                \
+static inline VALUE *rbtree_##KEY##_##VALUE##_get(const rbtree_##KEY##_##VALUE *tree, KEY key) {                                \
+    rbtree_##KEY##_##VALUE##_node *node = rbtree_##KEY##_##VALUE##_find(tree, key);                                             \
+    return node != NULL ? &node->value : NULL;                                                                                  \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool rbtree_##KEY##_##VALUE##_contains(const rbtree_##KEY##_##VALUE *tree, KEY key) {                             \
+    return rbtree_##KEY##_##VALUE##_find(tree, key) != NULL;                                                                    \
+}                                                                                                                               \
+                                                                                                                                \
+static inline rbtree_##KEY##_##VALUE##_node *rbtree_##KEY##_##VALUE##_lower_bound(const rbtree_##KEY##_##VALUE *tree,           \
+                                                                                KEY key) {                                      \
+    rbtree_##KEY##_##VALUE##_node *candidate = NULL;                                                                            \
+    for (rbtree_##KEY##_##VALUE##_node *node = tree->root; node != NULL; ) {                                                    \
+        if (LESS(node->key, key)) {                                                                                             \
+            node = node->right;                                                                                                 \
+        } else {                                                                                                                \
+            candidate = node;                                                                                                   \
+            node = node->left;                                                                                                  \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    return candidate;                                                                                                           \
+}
+
+
+// Insert the given key with the given value, or replace the value if the key is already in the tree. Return true if
+// the key was inserted.
+#define DEFINE_RBTREE_INSERT(KEY, VALUE, LESS)                                                                                  \
+static inline void rbtree_##KEY##_##VALUE##_insert_fixup(rbtree_##KEY##_##VALUE *tree, rbtree_##KEY##_##VALUE##_node *z) {      \
+    while (z->parent != NULL && z->parent->red) {                                                                               \
+        rbtree_##KEY##_##VALUE##_node *parent = z->parent;                                                                      \
+        rbtree_##KEY##_##VALUE##_node *grandparent = parent->parent;                                                            \
+        if (parent == grandparent->left) {                                                                                      \
+            rbtree_##KEY##_##VALUE##_node *uncle = grandparent->right;                                                          \
+            if (uncle != NULL && uncle->red) {                                                                                  \
+                parent->red = uncle->red = false;                                                                               \
+                grandparent->red = true;                                                                                        \
+                z = grandparent;                                                                                                \
+                continue;                                                                                                       \
+            }                                                                                                                   \
+            if (z == parent->right) {                                                                                           \
+                z = parent;                                                                                                     \
+                rbtree_##KEY##_##VALUE##_rotate_left(tree, z);                                                                  \
+                parent = z->parent;                                                                                             \
+            }                                                                                                                   \
+            parent->red = false;                                                                                                \
+            grandparent->red = true;                                                                                            \
+            rbtree_##KEY##_##VALUE##_rotate_right(tree, grandparent);                                                           \
+        } else {                                                                                                                \
+            rbtree_##KEY##_##VALUE##_node *uncle = grandparent->left;                                                           \
+            if (uncle != NULL && uncle->red) {                                                                                  \
+                parent->red = uncle->red = false;                                                                               \
+                grandparent->red = true;                                                                                        \
+                z = grandparent;                                                                                                \
+                continue;                                                                                                       \
+            }                                                                                                                   \
+            if (z == parent->left) {                                                                                            \
+                z = parent;                                                                                                     \
+                rbtree_##KEY##_##VALUE##_rotate_right(tree, z);                                                                 \
+                parent = z->parent;                                                                                             \
+            }                                                                                                                   \
+            parent->red = false;                                                                                                \
+            grandparent->red = true;                                                                                            \
+            rbtree_##KEY##_##VALUE##_rotate_left(tree, grandparent);                                                            \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    tree->root->red = false;                                                                                                    \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool rbtree_##KEY##_##VALUE##_insert(rbtree_##KEY##_##VALUE *tree, KEY key, VALUE value) {                        \
+    rbtree_##KEY##_##VALUE##_node *parent = NULL, *candidate = NULL;                                                            \
+    bool left = false;                                                                                                          \
+    for (rbtree_##KEY##_##VALUE##_node *node = tree->root; node != NULL; ) {                                                    \
+        parent = node;                                                                                                          \
+        left = LESS(key, node->key);                                                                                            \
+        if (left) {                                                                                                             \
+            node = node->left;                                                                                                  \
+        } else {                                                                                                                \
+            candidate = node;                                                                                                   \
+            node = node->right;                                                                                                 \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    if (candidate != NULL && !LESS(candidate->key, key)) {                                                                      \
+        candidate->value = value;                                                                                               \
+        return false;                                                                                                           \
+    }                                                                                                                           \
+    rbtree_##KEY##_##VALUE##_node *z = allocator_alloc(&tree->allocator, sizeof(*z));                                           \
+    if (z == NULL) {                                                                                                            \
+        fprintf(stderr, "Failed to allocate a node of the red black tree\n");                                                   \
+        return false;                                                                                                           \
+    }                                                                                                                           \
+    z->key = key;                                                                                                               \
+    z->value = value;                                                                                                           \
+    z->left = z->right = NULL;                                                                                                  \
+    z->parent = parent;                                                                                                         \
+    z->red = true;                                                                                                              \
+    if (parent == NULL)                                                                                                         \
+        tree->root = z;                                                                                                         \
+    else if (left)                                                                                                              \
+        parent->left = z;                                                                                                       \
+    else                                                                                                                        \
+        parent->right = z;                                                                                                      \
+    rbtree_##KEY##_##VALUE##_insert_fixup(tree, z);                                                                             \
+    tree->size++;                                                                                                               \
+    return true;                                                                                                                \
+}
+
+
+// Remove the given key (or a node returned by find or lower_bound) from the tree. Return true if the key was in the
+// tree.
+#define DEFINE_RBTREE_REMOVE(KEY, VALUE)                                                                                        \
+static inline void rbtree_##KEY##_##VALUE##_remove_fixup(rbtree_##KEY##_##VALUE *tree, rbtree_##KEY##_##VALUE##_node *x,        \
+                                                        rbtree_##KEY##_##VALUE##_node *parent) {                                \
+    /* x (which may be NULL) carries an extra black. parent is its parent, since a NULL x has no parent pointer */              \
+    while (x != tree->root && (x == NULL || !x->red)) {                                                                         \
+        if (x == parent->left) {                                                                                                \
+            rbtree_##KEY##_##VALUE##_node *w = parent->right;                                                                   \
+            if (w->red) {                                                                                                       \
+                w->red = false;                                                                                                 \
+                parent->red = true;                                                                                             \
+                rbtree_##KEY##_##VALUE##_rotate_left(tree, parent);                                                             \
+                w = parent->right;                                                                                              \
+            }                                                                                                                   \
+            if ((w->left == NULL || !w->left->red) && (w->right == NULL || !w->right->red)) {                                   \
+                w->red = true;                                                                                                  \
+                x = parent;                                                                                                     \
+                parent = x->parent;                                                                                             \
+                continue;                                                                                                       \
+            }                                                                                                                   \
+            if (w->right == NULL || !w->right->red) {                                                                           \
+                w->left->red = false;                                                                                           \
+                w->red = true;                                                                                                  \
+                rbtree_##KEY##_##VALUE##_rotate_right(tree, w);                                                                 \
+                w = parent->right;                                                                                              \
+            }                                                                                                                   \
+            w->red = parent->red;                                                                                               \
+            parent->red = false;                                                                                                \
+            w->right->red = false;                                                                                              \
+            rbtree_##KEY##_##VALUE##_rotate_left(tree, parent);                                                                 \
+        } else {                                                                                                                \
+            rbtree_##KEY##_##VALUE##_node *w = parent->left;                                                                    \
+            if (w->red) {                                                                                                       \
+                w->red = false;                                                                                                 \
+                parent->red = true;                                                                                             \
+                rbtree_##KEY##_##VALUE##_rotate_right(tree, parent);                                                            \
+                w = parent->left;                                                                                               \
+            }                                                                                                                   \
+            if ((w->left == NULL || !w->left->red) && (w->right == NULL || !w->right->red)) {                                   \
+                w->red = true;                                                                                                  \
+                x = parent;                                                                                                     \
+                parent = x->parent;                                                                                             \
+                continue;                                                                                                       \
+            }                                                                                                                   \
+            if (w->left == NULL || !w->left->red) {                                                                             \
+                w->right->red = false;                                                                                          \
+                w->red = true;                                                                                                  \
+                rbtree_##KEY##_##VALUE##_rotate_left(tree, w);                                                                  \
+                w = parent->left;                                                                                               \
+            }                                                                                                                   \
+            w->red = parent->red;                                                                                               \
+            parent->red = false;                                                                                                \
+            w->left->red = false;                                                                                               \
+            rbtree_##KEY##_##VALUE##_rotate_right(tree, parent);                                                                \
+        }                                                                                                                       \
+        x = tree->root;                                                                                                         \
+    }                                                                                                                           \
+    if (x != NULL)                                                                                                              \
+        x->red = false;                                                                                                         \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void rbtree_##KEY##_##VALUE##_remove_node(rbtree_##KEY##_##VALUE *tree, rbtree_##KEY##_##VALUE##_node *z) {       \
+    rbtree_##KEY##_##VALUE##_node *x, *parent;                                                                                  \
+    bool removed_red = z->red;                                                                                                  \
+    if (z->left == NULL || z->right == NULL) {                                                                                  \
+        x = z->left != NULL ? z->left : z->right;                                                                               \
+        parent = z->parent;                                                                                                     \
+        rbtree_##KEY##_##VALUE##_replace_child(tree, z, x);                                                                     \
+    } else {                                                                                                                    \
+        /* Move the successor y of z into the place of z */                                                                     \
+        rbtree_##KEY##_##VALUE##_node *y = z->right;                                                                            \
+        while (y->left != NULL)                                                                                                 \
+            y = y->left;                                                                                                        \
+        removed_red = y->red;                                                                                                   \
+        x = y->right;                                                                                                           \
+        if (y->parent == z) {                                                                                                   \
+            parent = y;                                                                                                         \
+        } else {                                                                                                                \
+            parent = y->parent;                                                                                                 \
+            rbtree_##KEY##_##VALUE##_replace_child(tree, y, x);                                                                 \
+            y->right = z->right;                                                                                                \
+            y->right->parent = y;                                                                                               \
+        }                                                                                                                       \
+        rbtree_##KEY##_##VALUE##_replace_child(tree, z, y);                                                                     \
+        y->left = z->left;                                                                                                      \
+        y->left->parent = y;                                                                                                    \
+        y->red = z->red;                                                                                                        \
+    }                                                                                                                           \
+    if (!removed_red)                                                                                                           \
+        rbtree_##KEY##_##VALUE##_remove_fixup(tree, x, parent);                                                                 \
+    allocator_free(&tree->allocator, z, sizeof(*z));                                                                            \
+    tree->size--;                                                                                                               \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool rbtree_##KEY##_##VALUE##_remove(rbtree_##KEY##_##VALUE *tree, KEY key) {                                     \
+    rbtree_##KEY##_##VALUE##_node *node = rbtree_##KEY##_##VALUE##_find(tree, key);                                             \
+    if (node == NULL)                                                                                                           \
+        return false;                                                                                                           \
+    rbtree_##KEY##_##VALUE##_remove_node(tree, node);                                                                           \
+    return true;                                                                                                                \
+}
+
+
+// Walk the tree in order: first / last return the nodes with the smallest and the largest key (NULL if the tree is
+// empty) and next / prev step to the following and the preceding node. for_each calls visit for every key and (a
+// pointer to) its value in ascending order of the keys; visit may change the value, but not insert or remove keys.
+#define DEFINE_RBTREE_ITERATE(KEY, VALUE)                                                                                       \
+static inline rbtree_##KEY##_##VALUE##_node *rbtree_##KEY##_##VALUE##_first(const rbtree_##KEY##_##VALUE *tree) {               \
+    rbtree_##KEY##_##VALUE##_node *node = tree->root;                                                                           \
+    while (node != NULL && node->left != NULL)                                                                                  \
+        node = node->left;                                                                                                      \
+    return node;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline rbtree_##KEY##_##VALUE##_node *rbtree_##KEY##_##VALUE##_last(const rbtree_##KEY##_##VALUE *tree) {                \
+    rbtree_##KEY##_##VALUE##_node *node = tree->root;                                                                           \
+    while (node != NULL && node->right != NULL)                                                                                 \
+        node = node->right;                                                                                                     \
+    return node;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline rbtree_##KEY##_##VALUE##_node *rbtree_##KEY##_##VALUE##_next(rbtree_##KEY##_##VALUE##_node *node) {               \
+    if (node->right != NULL) {                                                                                                  \
+        node = node->right;                                                                                                     \
+        while (node->left != NULL)                                                                                              \
+            node = node->left;                                                                                                  \
+        return node;                                                                                                            \
+    }                                                                                                                           \
+    while (node->parent != NULL && node == node->parent->right)                                                                 \
+        node = node->parent;                                                                                                    \
+    return node->parent;                                                                                                        \
+}                                                                                                                               \
+                                                                                                                                \
+static inline rbtree_##KEY##_##VALUE##_node *rbtree_##KEY##_##VALUE##_prev(rbtree_##KEY##_##VALUE##_node *node) {               \
+    if (node->left != NULL) {                                                                                                   \
+        node = node->left;                                                                                                      \
+        while (node->right != NULL)                                                                                             \
+            node = node->right;                                                                                                 \
+        return node;                                                                                                            \
+    }                                                                                                                           \
+    while (node->parent != NULL && node == node->parent->left)                                                                  \
+        node = node->parent;                                                                                                    \
+    return node->parent;                                                                                                        \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void rbtree_##KEY##_##VALUE##_for_each(rbtree_##KEY##_##VALUE *tree,                                              \
+                                                   void (*visit)(KEY key, VALUE *value, void *ctx), void *ctx) {                \
+    for (rbtree_##KEY##_##VALUE##_node *node = rbtree_##KEY##_##VALUE##_first(tree); node != NULL;                              \
+         node = rbtree_##KEY##_##VALUE##_next(node))                                                                            \
+        visit(node->key, &node->value, ctx);                                                                                    \
+}
+
+#endif
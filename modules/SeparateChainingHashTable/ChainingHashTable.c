@@ -3,42 +3,82 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <string.h>
 #include "ChainingHashTable.h"
 #include "./LinkedLists/list.h"
 
 
 #define MAX_LOAD_FACTOR 0.75
 
+// A remove which leaves fewer items than this share of the buckets shrinks the table, so that its load factor becomes
+// about half of the maximum. The gap between the two keeps a table whose size moves around a boundary from growing
+// and shrinking again and again
+#define MIN_LOAD_FACTOR 0.1
+
+// Number of lookups of SChashtable_search_batch whose cache misses overlap
+#define BATCH_GROUP 16
+
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+
+// Instrumentation counters are compiled in only when the library is built with -DDS_STATS
+#ifdef DS_STATS
+#define SC_STATS(statement) statement
+#define SC_WALKED(walked) (&(walked))
+#else
+#define SC_STATS(statement)
+#define SC_WALKED(walked) NULL
+#endif
+
 static int prime_numbers[] = {53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593, 49157, 98317, 196613, 393241,
 	786433, 1572869, 3145739, 6291469, 12582917, 25165843, 50331653, 100663319, 201326611, 402653189, 805306457, 1610612741};
 
+#define PRIMES (sizeof(prime_numbers) / sizeof(prime_numbers[0]))
+
 
 /* Separate chaining hash table */
 struct SChashtable {
     size_t size;
     size_t table_capacity;
+    size_t min_capacity;    // The table does not shrink below the capacity which was reserved
     List *table;
     CompareFunc compare; 
     PrintFunc print; 
     DestroyFunc destroy_key;
     DestroyFunc destroy_value;
     HashFunc hash_function;
+    Allocator allocator;
+#ifdef DS_STATS
+    SChashtable_stats stats;
+#endif
 };
 
 
 // Create a new SChashtable
 SCHashtable* SChashtable_create(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value, HashFunc hash) {
-    SCHashtable *h = malloc(sizeof(SCHashtable));
+    return SChashtable_create_with_allocator(compare, print, destroy_key, destroy_value, hash, NULL);
+}
+
+
+// Create a new SChashtable which allocates its memory with the given allocator (NULL uses malloc and free)
+SCHashtable* SChashtable_create_with_allocator(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value, HashFunc hash, const Allocator *allocator) {
+    SCHashtable *h = allocator_alloc(allocator, sizeof(SCHashtable));
     assert(h != NULL);
-    h->table_capacity = prime_numbers[0];
+    h->allocator = allocator != NULL ? *allocator : (Allocator){0};
+    h->table_capacity = h->min_capacity = prime_numbers[0];
     h->size = 0;
-    h->table = calloc(h->table_capacity, sizeof(List));
+    h->table = allocator_calloc(&h->allocator, h->table_capacity, sizeof(List));
     assert(h->table != NULL);
     h->compare = compare;
     h->print = print;
     h->destroy_key = destroy_key;
     h->destroy_value = destroy_value;
     h->hash_function = hash;
+    SC_STATS(memset(&h->stats, 0, sizeof(h->stats)));
     return h;
 }
 
@@ -53,10 +93,22 @@ size_t SChashtable_size(SCHashtable *h) {
 }
 
 
-// Hash function : returns the hash value according to the given key 
-static inline size_t SChashtable_hash(SCHashtable *h, void *key) {
-    return h->hash_function(key) % h->table_capacity;
+// Returns the bucket of the given full hash value. The full hash of every key is computed once, when the key is
+// inserted or searched, and it is kept in the chain node, so resizes never call the hash function again
+static inline size_t SChashtable_bucket(SCHashtable *h, size_t hash) {
+    return hash % h->table_capacity;
+}
+
+
+#ifdef DS_STATS
+// Count a walk of the given number of chain nodes
+static inline void SChashtable_count_walk(SCHashtable *h, size_t walked) {
+    h->stats.operations++;
+    h->stats.nodes_walked += walked;
+    if(walked > h->stats.longest_walk)
+        h->stats.longest_walk = walked;
 }
+#endif
 
 
 // Check if given number is prime 
@@ -71,50 +123,75 @@ static bool isprime(size_t n) {
 }
 
 
-// Resize the SChashtable
-static SCHashtable* SChashtable_resize(SCHashtable* h) {
+// Returns the smallest capacity which is at least n: a prime of the array, or after its last prime the next prime number
+static size_t SChashtable_prime_capacity(size_t n) {
+    for(size_t i = 0 ; i < PRIMES ; i++)
+        if((size_t)prime_numbers[i] >= n)
+            return prime_numbers[i];
+    while(!isprime(n))
+        n++;
+    return n;
+}
+
+
+// Returns the capacity in which the given number of items stay below the given load factor
+static size_t SChashtable_capacity_for(size_t items, double load_factor) {
+    return SChashtable_prime_capacity((size_t)(items / load_factor) + 1);
+}
+
+
+// Resize the SChashtable to the given capacity
+static SCHashtable* SChashtable_resize(SCHashtable* h, size_t new_capacity) {
     // Save the old table and capacity of the array of the hash table
     List* old_table = h->table;
     size_t old_capacity = h->table_capacity;
 
-    // Find the new capacity for the SChashtable
-    size_t new_capacity = 0;
-    int primes = sizeof(prime_numbers) / sizeof(int);
-    for (int i = 0; i < primes ; i++)
-        if (prime_numbers[i] > old_capacity) {
-            new_capacity = prime_numbers[i];
-            break;
-        }
-    if (new_capacity == 0) {
-        new_capacity = old_capacity * 2;
-        while (!isprime(++new_capacity));
-    }
-
     // Create a new table with the new capacity
     h->table_capacity = new_capacity;
-    List* new_table = calloc(h->table_capacity, sizeof(*new_table));
+    List* new_table = allocator_calloc(&h->allocator, h->table_capacity, sizeof(*new_table));
     assert(new_table != NULL);
     
-    // Rehash and insert all elements from the old table to the new table
-    for(int i = 0 ; i < old_capacity ; i++) {
-        List list = old_table[i];
-        while(list != NULL) {
-            void *key = listnode_get_key(list);
-            void *value = listnode_get_value(list);
-            new_table[SChashtable_hash(h, key)] = list_prepend(new_table[SChashtable_hash(h, key)], key, value);
-            list = list_get_next(list);
+    // Move the nodes of the old table to the new table. Their bucket comes from the hash which they store, so neither the
+    // hash function nor the allocator is called
+    for(size_t i = 0 ; i < old_capacity ; i++) {
+        List node = old_table[i];
+        while(node != NULL) {
+            List next = list_get_next(node);
+            size_t index = SChashtable_bucket(h, listnode_get_hash(node));
+            new_table[index] = list_prepend_node(new_table[index], node);
+            node = next;
         }
-        list_free(old_table[i], NULL, NULL);
     }
 
     // Free the old table and update the SChashtable
-    free(old_table);
+    allocator_free(&h->allocator, old_table, old_capacity * sizeof(*old_table));
     h->table = new_table;
+    SC_STATS(h->stats.resizes++);
 
     return h;
 }
 
 
+// Grow the SChashtable to the next prime capacity (about twice the current one)
+static SCHashtable* SChashtable_grow(SCHashtable* h) {
+    size_t last_prime = prime_numbers[PRIMES - 1];
+    return SChashtable_resize(h, SChashtable_prime_capacity(h->table_capacity < last_prime ? h->table_capacity + 1 : 2 * h->table_capacity + 1));
+}
+
+
+// Shrink the SChashtable after a remove if its items are fewer than MIN_LOAD_FACTOR of the buckets. The new capacity
+// is the one with a load factor of about half of the maximum, but not less than the reserved capacity
+static void SChashtable_shrink_if_sparse(SCHashtable* h) {
+    if(h->table_capacity <= h->min_capacity || (double)h->size >= MIN_LOAD_FACTOR * h->table_capacity)
+        return;
+    size_t capacity = SChashtable_capacity_for(h->size, MAX_LOAD_FACTOR / 2);
+    if(capacity < h->min_capacity)
+        capacity = h->min_capacity;
+    if(capacity < h->table_capacity)
+        SChashtable_resize(h, capacity);
+}
+
+
 // Get the current load factor of the hash table
 static inline float SChashtable_get_load_factor(SCHashtable* h) {
     return ((float) h->size) / ((float) (h->table_capacity));
@@ -123,21 +200,26 @@ static inline float SChashtable_get_load_factor(SCHashtable* h) {
 
 // Function to insert an item with given key and value into the hash table
 SCHashtable *SChashtable_insert(SCHashtable *h, void *key, void *value) {
-    size_t index = SChashtable_hash(h, key);
+    size_t hash = h->hash_function(key);
+    size_t index = SChashtable_bucket(h, hash);
     
     // Delete item with the same key if it exists in the SChashtable
     // Current implementation is an ADTMap, so we do not want to
     // have duplicates
-    h->table[index] = list_delete(h->table[index], key, h->compare, h->destroy_key, h->destroy_value);
-    
-    h->size++;
+    bool replaced;
+    SC_STATS(size_t walked = 0);
+    h->table[index] = list_delete_counted(h->table[index], key, hash, h->compare, h->destroy_key, h->destroy_value, &h->allocator, SC_WALKED(walked), &replaced);
+    SC_STATS(SChashtable_count_walk(h, walked));
+
+    if(!replaced)
+        h->size++;
     // Add the new item in the start of the corresponding list
     // This saves us time, because inserting at sthe start needs
     // only O(1) complexity
-    h->table[index] = list_prepend(h->table[index], key, value);
+    h->table[index] = list_prepend(h->table[index], key, value, hash, &h->allocator);
 
     if(SChashtable_get_load_factor(h) > MAX_LOAD_FACTOR)
-        return SChashtable_resize(h);
+        return SChashtable_grow(h);
     return h;
 }
 
@@ -146,22 +228,127 @@ SCHashtable *SChashtable_insert(SCHashtable *h, void *key, void *value) {
 void *SChashtable_search(SCHashtable *h, void *key) {
     if(h == NULL)
         return NULL;
-    return list_search(h->table[SChashtable_hash(h, key)], key, h->compare);
+    SC_STATS(size_t walked = 0);
+    size_t hash = h->hash_function(key);
+    void *value = list_search_counted(h->table[SChashtable_bucket(h, hash)], key, hash, h->compare, SC_WALKED(walked));
+    SC_STATS(SChashtable_count_walk(h, walked));
+    return value;
+}
+
+
+// State of a lookup of SChashtable_search_batch: the chain node which it waits for (or the bucket, before the first
+// node is known) and whether the key of the node has been prefetched and can be compared
+typedef struct {
+    void *key;
+    size_t hash;
+    size_t index;
+    List node;
+    bool started;
+    bool key_ready;
+    bool done;
+    size_t walked;
+} SChashtable_lookup;
+
+
+// Search the given keys in groups of BATCH_GROUP lookups, which are interleaved (asynchronous memory access chaining).
+// A lookup misses the cache on the bucket, on every node of its chain and on the key of every node whose hash is the
+// hash of the searched key, and each load depends on the previous one. In every round each unfinished lookup uses the
+// memory which it prefetched in the previous round and prefetches its next load, so the misses of the whole group are
+// in flight together
+void SChashtable_search_batch(SCHashtable *h, void **keys, size_t count, void **values) {
+    if(h == NULL)
+        return;
+    SChashtable_lookup lookups[BATCH_GROUP];
+    for(size_t first = 0 ; first < count ; first += BATCH_GROUP) {
+        size_t group = count - first < BATCH_GROUP ? count - first : BATCH_GROUP;
+        for(size_t j = 0 ; j < group ; j++) {
+            SChashtable_lookup *lookup = &lookups[j];
+            lookup->key = keys[first + j];
+            lookup->hash = h->hash_function(lookup->key);
+            lookup->index = SChashtable_bucket(h, lookup->hash);
+            lookup->node = NULL;
+            lookup->started = lookup->key_ready = lookup->done = false;
+            lookup->walked = 0;
+            values[first + j] = NULL;
+            PREFETCH(&h->table[lookup->index]);
+        }
+        for(size_t active = group ; active > 0 ; ) {
+            active = 0;
+            for(size_t j = 0 ; j < group ; j++) {
+                SChashtable_lookup *lookup = &lookups[j];
+                if(lookup->done)
+                    continue;
+                if(!lookup->started) {
+                    lookup->started = true;
+                    lookup->node = h->table[lookup->index];
+                }
+                else if(!lookup->key_ready) {
+                    // The key of a node is only loaded when the hashes match
+                    lookup->walked++;
+                    if(listnode_get_hash(lookup->node) == lookup->hash) {
+                        PREFETCH(listnode_get_key(lookup->node));
+                        lookup->key_ready = true;
+                        active++;
+                        continue;
+                    }
+                    lookup->node = list_get_next(lookup->node);
+                }
+                else {
+                    if(h->compare(listnode_get_key(lookup->node), lookup->key) == 0) {
+                        values[first + j] = listnode_get_value(lookup->node);
+                        lookup->done = true;
+                        SC_STATS(SChashtable_count_walk(h, lookup->walked));
+                        continue;
+                    }
+                    lookup->key_ready = false;
+                    lookup->node = list_get_next(lookup->node);
+                }
+                if(lookup->node == NULL) {
+                    lookup->done = true;
+                    SC_STATS(SChashtable_count_walk(h, lookup->walked));
+                    continue;
+                }
+                PREFETCH(lookup->node);
+                active++;
+            }
+        }
+    }
 }
 
 
 // Delete an item from the hash table
 void SChashtable_remove(SCHashtable *h, void *key) {
-    h->table[SChashtable_hash(h, key)] = list_delete(h->table[SChashtable_hash(h, key)], key, h->compare, h->destroy_key, h->destroy_value);
+    size_t hash = h->hash_function(key);
+    size_t index = SChashtable_bucket(h, hash);
+    bool deleted;
+    SC_STATS(size_t walked = 0);
+    h->table[index] = list_delete_counted(h->table[index], key, hash, h->compare, h->destroy_key, h->destroy_value, &h->allocator, SC_WALKED(walked), &deleted);
+    SC_STATS(SChashtable_count_walk(h, walked));
+    if(deleted) {
+        h->size--;
+        SChashtable_shrink_if_sparse(h);
+    }
+}
+
+
+// Make room for the given number of items, so that inserting them does not resize the hash table. The table does not
+// shrink below this capacity afterwards
+void SChashtable_reserve(SCHashtable *h, size_t items) {
+    if(h == NULL)
+        return;
+    h->min_capacity = items > 0 ? SChashtable_capacity_for(items, MAX_LOAD_FACTOR) : (size_t)prime_numbers[0];
+    if(h->table_capacity < h->min_capacity)
+        SChashtable_resize(h, h->min_capacity);
 }
 
 
 // De-allocate a SChashtable
 void SChashtable_destroy(SCHashtable *h) {
     for(size_t i = 0 ; i < h->table_capacity ; i++)
-        list_free(h->table[i], h->destroy_key, h->destroy_value);
-    free(h->table);
-    free(h);
+        list_free(h->table[i], h->destroy_key, h->destroy_value, &h->allocator);
+    allocator_free(&h->allocator, h->table, h->table_capacity * sizeof(List));
+    Allocator allocator = h->allocator;
+    allocator_free(&allocator, h, sizeof(*h));
 }
 
 
@@ -189,10 +376,32 @@ size_t SChashtable_get_num_empty(SCHashtable* h) {
 // Get the maximum list size
 size_t SChashtable_get_max_chain_size(SCHashtable* h) {
     size_t max = 0;
-    for (int i = 0 ; i < h->size ; i++) {
+    for (size_t i = 0 ; i < h->table_capacity ; i++) {
         size_t size = list_size(h->table[i]);
         if (size > max)
             max = size;
     }
     return max;
+}
+
+
+// Return a snapshot of the instrumentation counters of the hash table
+SChashtable_stats SChashtable_get_stats(SCHashtable *h) {
+    SChashtable_stats stats = {0};
+    if(h == NULL)
+        return stats;
+#ifdef DS_STATS
+    stats = h->stats;
+#endif
+    stats.bytes_allocated = sizeof(*h) + h->table_capacity * sizeof(List) + h->size * listnode_size();
+    return stats;
+}
+
+
+// Reset the instrumentation counters of the hash table
+void SChashtable_reset_stats(SCHashtable *h) {
+#ifdef DS_STATS
+    if(h != NULL)
+        memset(&h->stats, 0, sizeof(h->stats));
+#endif
 }
\ No newline at end of file
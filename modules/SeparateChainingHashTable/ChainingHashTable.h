@@ -1,6 +1,8 @@
 #ifndef CHAINING_HASH_TABLE_H
 #define CHAINING_HASH_TABLE_H
 
+#include "../Allocator/Allocator.h"
+
 typedef struct SChashtable SCHashtable;
 
 // Compare functions for the different data type
@@ -15,9 +17,24 @@ typedef void (*PrintFunc)(void *);
 // Function which returns a hash value according to the given key
 typedef size_t (*HashFunc)(void *);
 
+// Counters of the hot paths of a hash table. They are only updated when the library is built with -DDS_STATS
+// (make STATS=1 in lib), so they cost nothing otherwise and stay zero. bytes_allocated is always filled in.
+// The average chain walk is nodes_walked / operations. The compare function is only called for the walked nodes whose
+// stored hash is the hash of the key, so it runs far fewer times than that.
+typedef struct {
+    size_t operations;      // Searches, inserts and removes (each one walks a chain)
+    size_t nodes_walked;    // Chain nodes walked by the operations
+    size_t longest_walk;    // Longest chain walk of a single operation
+    size_t resizes;         // Times the table has grown or shrunk
+    size_t bytes_allocated; // Bytes currently allocated by the table and its chain nodes (keys and values are not included)
+} SChashtable_stats;
+
 // Create a new SChashtable
 SCHashtable* SChashtable_create(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value, HashFunc hash);
 
+// Create a new SChashtable which allocates its memory with the given allocator (NULL uses malloc and free)
+SCHashtable* SChashtable_create_with_allocator(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value, HashFunc hash, const Allocator *allocator);
+
 // Function which returns the size of the hash table (how many items does it currently store) or -1 if given hash table does not exist
 size_t SChashtable_size(SCHashtable *h);
 
@@ -27,9 +44,19 @@ SCHashtable *SChashtable_insert(SCHashtable *h, void *key, void *value);
 // Searches an item in the SChashtable according to a specific key
 void *SChashtable_search(SCHashtable *h, void *key);
 
-// Delete an item from the hash table
+// Search count keys at once and store the value of keys[i] (NULL if it is not in the hash table) in values[i]. The
+// lookups are interleaved, so it is much faster than count calls of SChashtable_search when the table does not fit
+// in the cache
+void SChashtable_search_batch(SCHashtable *h, void **keys, size_t count, void **values);
+
+// Delete an item from the hash table. If the items become fewer than a tenth of the buckets, the table shrinks to a
+// load factor of about half of the maximum (but not below the reserved capacity)
 void SChashtable_remove(SCHashtable *h, void *key);
 
+// Make room for the given number of items before a bulk load, so that inserting them does not resize the hash table
+// again and again. Removes do not shrink the table below this capacity afterwards (reserving 0 items lifts the limit)
+void SChashtable_reserve(SCHashtable *h, size_t items);
+
 // De-allocate a SChashtable
 void SChashtable_destroy(SCHashtable *h);
 
@@ -42,4 +69,10 @@ size_t SChashtable_get_num_empty(SCHashtable* h);
 // Get the maximum list size
 size_t SChashtable_get_max_chain_size(SCHashtable* h);
 
+// Return a snapshot of the instrumentation counters of the hash table
+SChashtable_stats SChashtable_get_stats(SCHashtable *h);
+
+// Reset the instrumentation counters of the hash table
+void SChashtable_reset_stats(SCHashtable *h);
+
 #endif
\ No newline at end of file
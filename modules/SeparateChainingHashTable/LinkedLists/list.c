@@ -1,6 +1,7 @@
 /* File: list.c */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <assert.h>
 #include "list.h"
 
@@ -8,19 +9,21 @@
 struct listnode {
     void *key;
     void *value;
+    size_t hash;    // Full hash of the key, compared before the keys and reused when the hash table resizes
     List next;
 };
 
 
 // Function to add an element at the end of the list
-List list_append(List list, void *key, void *value) {
+List list_append(List list, void *key, void *value, size_t hash, const Allocator *allocator) {
     
-    List node = malloc(sizeof(*node));
+    List node = allocator_alloc(allocator, sizeof(*node));
     assert(node != NULL);
     
     node->next = NULL;
     node->key = key;
     node->value = value;
+    node->hash = hash;
 
     if(list == NULL)
         list = node;
@@ -35,13 +38,14 @@ List list_append(List list, void *key, void *value) {
 
 
 // Function to add an element at the start of the list
-List list_prepend(List list, void *key, void *value) {
+List list_prepend(List list, void *key, void *value, size_t hash, const Allocator *allocator) {
     
-    List node = malloc(sizeof(*node));
+    List node = allocator_alloc(allocator, sizeof(*node));
     assert(node != NULL);
 
     node->key = key;
     node->value = value;
+    node->hash = hash;
     node->next = list;
 
     return node;
@@ -49,47 +53,67 @@ List list_prepend(List list, void *key, void *value) {
 
 
 // Function to search an item into the list and return a boolean value which demonstrates whether it exists or not
-void *list_search(List list, void *key, CompareFunc compare) {
+void *list_search(List list, void *key, size_t hash, CompareFunc compare) {
+    return list_search_counted(list, key, hash, compare, NULL);
+}
+
+
+// Same as list_search, but also adds the number of nodes which were walked to *visited (if it is not NULL)
+void *list_search_counted(List list, void *key, size_t hash, CompareFunc compare, size_t *visited) {
     List cur = list;
+    size_t count = 0;
 
     while(cur != NULL) {
-        if(!compare(cur->key, key))
+        count++;
+        if(cur->hash == hash && !compare(cur->key, key)) {
+            if(visited != NULL)
+                *visited += count;
             return cur->value;
+        }
         cur = cur->next;
     }
-    
+
+    if(visited != NULL)
+        *visited += count;
     return NULL;
 }
 
 
 // Function to delete an item from the list
-List list_delete(List list, void *key, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value) {
+List list_delete(List list, void *key, size_t hash, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator) {
+    return list_delete_counted(list, key, hash, compare, destroy_key, destroy_value, allocator, NULL, NULL);
+}
+
+
+// Same as list_delete, but also adds the number of nodes which were walked to *visited and stores in *deleted
+// whether an item was deleted (each one only if it is not NULL)
+List list_delete_counted(List list, void *key, size_t hash, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator, size_t *visited, bool *deleted) {
     List cur = list;
     List prev = NULL;
+    size_t count = 0;
     while(cur != NULL) {
-        if(!compare(cur->key, key)) {
-            if(prev == NULL) {
-                List next = cur->next;
-                if(destroy_key)
-                    destroy_key(cur->key);
-                if(destroy_value)
-                    destroy_value(cur->value);
-                free(cur);
-                return next;
-            }
-            else {
-                prev->next = cur->next;
-                if(destroy_key)
-                    destroy_key(cur->key);
-                if(destroy_value)
-                    destroy_value(cur->value);
-                free(cur);
-                return list;
-            }
-        }
+        count++;
+        if(cur->hash == hash && !compare(cur->key, key))
+            break;
         prev = cur;
         cur = cur->next;
     }
+    if(visited != NULL)
+        *visited += count;
+    if(deleted != NULL)
+        *deleted = cur != NULL;
+    if(cur == NULL)
+        return list;
+
+    if(prev == NULL)
+        list = cur->next;
+    else
+        prev->next = cur->next;
+    if(destroy_key)
+        destroy_key(cur->key);
+    if(destroy_value)
+        destroy_value(cur->value);
+    allocator_free(allocator, cur, sizeof(*cur));
     return list;
 }
 
@@ -109,7 +133,7 @@ size_t list_size(List list) {
 
 
 // Function de-allocate a list
-void list_free(List list, DestroyFunc destroy_key, DestroyFunc destroy_value) {
+void list_free(List list, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator) {
     while(list != NULL) {
         List temp = list;
         list = list->next;
@@ -117,7 +141,7 @@ void list_free(List list, DestroyFunc destroy_key, DestroyFunc destroy_value) {
             destroy_key(temp->key);
         if(destroy_value != NULL)
             destroy_value(temp->value);
-        free(temp);
+        allocator_free(allocator, temp, sizeof(*temp));
     }
 }
 
@@ -143,6 +167,12 @@ List list_merge(List list1, List list2) {
 }
 
 
+// Size in bytes of a list node
+size_t listnode_size(void) {
+    return sizeof(struct listnode);
+}
+
+
 // Get the key of the given node
 void *listnode_get_key(List node) {
     return node->key;
@@ -155,6 +185,19 @@ void *listnode_get_value(List node) {
 }
 
 
+// Get the full hash of the key of the given node
+size_t listnode_get_hash(List node) {
+    return node->hash;
+}
+
+
+// Put the given node (which is not in any list) at the start of the list, without allocating a new node
+List list_prepend_node(List list, List node) {
+    node->next = list;
+    return node;
+}
+
+
 // Get next list node
 List list_get_next(List list) {
     return list->next;
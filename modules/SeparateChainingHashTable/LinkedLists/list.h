@@ -2,6 +2,10 @@
 #ifndef LIST_H
 #define LIST_H
 
+#include <stddef.h>
+#include <stdbool.h>
+#include "../../Allocator/Allocator.h"
+
 typedef struct listnode *List;
 
 // Compare functions for the different data type
@@ -14,23 +18,36 @@ typedef void (*DestroyFunc)(void *);
 typedef void (*PrintFunc)(void *);
 
 
+// Nodes are allocated and freed with the given allocator (NULL uses malloc and free). Every node stores the full hash
+// of its key, and the search and delete functions call compare only for the nodes whose hash is the given one
+
 // Function to add an element at the end of the list
-List list_append(List list, void *key, void *value);
+List list_append(List list, void *key, void *value, size_t hash, const Allocator *allocator);
 
 // Function to add an element at the start of the list
-List list_prepend(List list, void *key, void *value);
+List list_prepend(List list, void *key, void *value, size_t hash, const Allocator *allocator);
 
 // Function to search an item into the list and return a boolean value which demonstrates whether it exists or not
-void *list_search(List list, void *key, CompareFunc compare);
+void *list_search(List list, void *key, size_t hash, CompareFunc compare);
+
+// Same as list_search, but also adds the number of nodes which were walked to *visited (if it is not NULL)
+void *list_search_counted(List list, void *key, size_t hash, CompareFunc compare, size_t *visited);
 
 // Function to delete an item from the list
-List list_delete(List list, void *key, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value);
+List list_delete(List list, void *key, size_t hash, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator);
+
+// Same as list_delete, but also adds the number of nodes which were walked to *visited and stores in *deleted
+// whether an item was deleted (each one only if it is not NULL)
+List list_delete_counted(List list, void *key, size_t hash, CompareFunc compare, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator, size_t *visited, bool *deleted);
+
+// Size in bytes of a list node
+size_t listnode_size(void);
 
 // Function to return the size of a list
 size_t list_size(List list);
 
 // Function de-allocate a list
-void list_free(List list, DestroyFunc destroy_key, DestroyFunc destroy_value);
+void list_free(List list, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator);
 
 // Helper function to print a list
 void list_print(List list, PrintFunc print);
@@ -44,6 +61,12 @@ void *listnode_get_key(List node);
 // Get the value of the given node
 void *listnode_get_value(List node);
 
+// Get the full hash of the key of the given node
+size_t listnode_get_hash(List node);
+
+// Put the given node (which is not in any list) at the start of the list, without allocating a new node
+List list_prepend_node(List list, List node);
+
 // Get next list node
 List list_get_next(List list);
 
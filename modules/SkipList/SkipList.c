@@ -23,28 +23,49 @@ struct skiplist {
     PrintFunc print;
     DestroyFunc destroy_key;
     DestroyFunc destroy_value;
+    Allocator allocator;
 };
 
 
+// Size of a node of the given level. The forward array is allocated right after the node
+static inline size_t node_size(int level) {
+    return sizeof(struct skiplist_node) + (level + 1) * sizeof(link);
+}
+
+
 // Create a new node
-static inline link create_node(void *value, void *key, int level) {
-    link new_node = malloc(sizeof(*new_node));
+static inline link create_node(skiplist *list, void *value, void *key, int level) {
+    link new_node = allocator_alloc(&list->allocator, node_size(level));
+    assert(new_node != NULL);
     new_node->value = value;
     new_node->key = key;
     new_node->level = level;
-    new_node->forward = calloc(sizeof(link), new_node->level + 1);
+    new_node->forward = (link *)(new_node + 1);
     for(int i = 0 ; i <= level ; i++)
         new_node->forward[i] = NULL;
     return new_node;
 }
 
 
+// Free a node (and its forward array)
+static inline void free_node(skiplist *list, link node) {
+    allocator_free(&list->allocator, node, node_size(node->level));
+}
+
+
 // Function to initialize the skip list
 skiplist *skiplist_initialize(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value) {
+    return skiplist_initialize_with_allocator(compare, print, destroy_key, destroy_value, NULL);
+}
+
+
+// Function to initialize a skip list which allocates its memory with the given allocator (NULL uses malloc and free)
+skiplist *skiplist_initialize_with_allocator(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator) {
     srand(time(NULL));
-    skiplist *list = malloc(sizeof(*list));
+    skiplist *list = allocator_alloc(allocator, sizeof(*list));
     assert(list != NULL);
-    list->header = create_node(NULL, NULL, SKIPLIST_MAX_LEVEL);
+    list->allocator = allocator != NULL ? *allocator : (Allocator){0};
+    list->header = create_node(list, NULL, NULL, SKIPLIST_MAX_LEVEL);
     list->level = list->size = 0;
     list->compare = compare;
     list->print = print;
@@ -105,7 +126,7 @@ void skiplist_insert(skiplist *list, void *key, void *value) {
             list->level = level;
         }
         
-        current = create_node(value, key, level);
+        current = create_node(list, value, key, level);
         list->size++;
 
         // Insert the new node at the correct positions on each level using the 'update' array
@@ -158,8 +179,7 @@ void *skiplist_delete(skiplist *list, void *key) {
         void *value = current->value;
         if(list->destroy_key)
             list->destroy_key(current->key);
-        free(current->forward);
-        free(current);
+        free_node(list, current);
         
         return value;
     }
@@ -185,92 +205,125 @@ void skiplist_print(skiplist *list) {
 }
 
 
-// Function to merge two skiplists and return the new one
+// Find the first node whose key is not less than the given key (NULL if there is none)
+static link skiplist_lower_bound(skiplist *list, void *key) {
+    link current = list->header;
+    for(int i = list->level ; i >= 0 ; i--) {
+        while(current->forward[i] != NULL && list->compare(current->forward[i]->key, key) < 0)
+            current = current->forward[i];
+    }
+    return current->forward[0];
+}
+
+
+// Returns a cursor to the first node whose key is not less than the given key (a NULL key seeks the first node)
+skiplist_cursor skiplist_seek(skiplist *list, void *key) {
+    return key != NULL ? skiplist_lower_bound(list, key) : list->header->forward[0];
+}
+
+
+// Returns a cursor to the next node of the bottom level
+skiplist_cursor skiplist_cursor_next(skiplist_cursor cursor) {
+    return cursor != NULL ? cursor->forward[0] : NULL;
+}
+
+
+// Returns the key of the node of the cursor
+void *skiplist_cursor_key(skiplist_cursor cursor) {
+    assert(cursor != NULL);
+    return cursor->key;
+}
+
+
+// Returns the value of the node of the cursor
+void *skiplist_cursor_value(skiplist_cursor cursor) {
+    assert(cursor != NULL);
+    return cursor->value;
+}
+
+
+// Visit the keys of [low, high) in order, until visit returns false
+size_t skiplist_range(skiplist *list, void *low, void *high, SkipListRangeFunc visit, void *ctx) {
+    size_t count = 0;
+    for(link current = skiplist_seek(list, low) ; current != NULL ; current = current->forward[0]) {
+        if(high != NULL && list->compare(current->key, high) >= 0)
+            break;
+        count++;
+        if(!visit(current->key, current->value, ctx))
+            break;
+    }
+    return count;
+}
+
+
+// Copy the keys and the values of up to capacity nodes from the cursor which are less than high, and advance the cursor
+size_t skiplist_range_batch(skiplist *list, skiplist_cursor *cursor, void *high, void **keys, void **values, size_t capacity) {
+    link current = *cursor;
+    size_t count = 0;
+    while(count < capacity && current != NULL && (high == NULL || list->compare(current->key, high) < 0)) {
+        if(keys != NULL)
+            keys[count] = current->key;
+        if(values != NULL)
+            values[count] = current->value;
+        count++;
+        current = current->forward[0];
+    }
+    *cursor = current;
+    return count;
+}
+
+
+// Function to merge two skiplists and return the new one. The nodes are moved to the new list in key order, keeping
+// their levels, so the merge takes O(n + m). When a key is in both lists, the value of list2 is kept
 skiplist *skiplist_merge(skiplist *list1, skiplist *list2) {
-    if (list1 == NULL && list2 == NULL)
-        return NULL;
-    else if (list1 == NULL)
+    if (list1 == NULL)
         return list2;
     else if (list2 == NULL)
         return list1;
-    link *update = calloc(SKIPLIST_MAX_LEVEL + 1, sizeof(link));
-    int unflipped = 1;
-    skiplist *list = skiplist_initialize(list1->compare, list1->print, list1->destroy_key, list1->destroy_value);
-    list->size = list1->size + list2->size;
-    list->level = (list1->level > list2->level) ? list1->level : list2->level;
-    for (int i = 0; i <= list->level; i++)
+    skiplist *list = skiplist_initialize_with_allocator(list1->compare, list1->print, list1->destroy_key, list1->destroy_value, &list1->allocator);
+    // update[i] is the last node of level i in the new list
+    link update[SKIPLIST_MAX_LEVEL + 1];
+    for (int i = 0; i <= SKIPLIST_MAX_LEVEL; i++)
         update[i] = list->header;
-    while ((list1 != NULL && list1->header != NULL && list1->header->forward[0] != NULL) && (list2 != NULL && list2->header != NULL && list2->header->forward[0] != NULL)) {
-        void *key1 = list1->header->forward[0]->key;
-        void *key2 = list2->header->forward[0]->key;
-        // assume w.l.g that key1 <= key2 (i.e. if key1 > key2 exchange list1 and list2, key1 and key2)
-        if (list1->compare(key1, key2) > 0) {
-            skiplist* temp = list1;
-            list1 = list2;
-            list2 = temp;
-            void *temp_key = key1;
-            key1 = key2;
-            key2 = temp_key;
-            unflipped = !unflipped;
+    link x = list1->header->forward[0], y = list2->header->forward[0];
+    while (x != NULL || y != NULL) {
+        int result = (x == NULL) ? 1 : (y == NULL) ? -1 : list->compare(x->key, y->key);
+        link next;
+        if (result <= 0) {
+            next = x;
+            x = x->forward[0];
         }
-        // merge step: remove from list1 elements with keys <= key2 and connect them on the output list
-        // for all lvl s.t. list1->header->forward[lvl]->key <= key2, connect output list to list1
-        int lvl = 0;
-        while (lvl < list->level && list1->header->forward[lvl] != NULL && list1->compare(list1->header->forward[lvl]->key, key2) <= 0) {
-            update[lvl]->forward[lvl] = list1->header->forward[lvl];
-            lvl++;
+        else {
+            next = y;
+            y = y->forward[0];
         }
-        lvl--;
-        //for each level attached to output list, find endpoint at that level (i.e. last element with key <= key2)
-        link x = list1->header->forward[lvl];
-        for (int i = lvl ; i >= 0; i--) {
-            while (x->forward[i] != NULL) {
-                if(list1->compare(x->forward[i]->key, key2) > 0)
-                    break;
-                x = x->forward[i];
-                //x->key <= key2 < x->forward[i]->key
-            }
-            update[i] = x;
-            list1->header->forward[i] = x->forward[i];
+        if (result == 0) {
+            // the key is in both lists, so keep the node of list1 with the value of list2
+            link duplicate = y;
+            y = y->forward[0];
+            if (list->destroy_value)
+                list->destroy_value(next->value);
+            next->value = duplicate->value;
+            if (list->destroy_key)
+                list->destroy_key(duplicate->key);
+            free_node(list2, duplicate);
         }
-        // x = last element moved to output list
-        if (list1->compare(x->key, key2) == 0) {
-            // if the element at the front of list2 is a duplicate of an element already moved to output list, eliminate it
-            list->size--;
-            if (unflipped) {
-                list1->destroy_value(x->value);
-                x->value = list2->header->forward[0]->value;
-            }
-            else {
-                list2->destroy_value(list2->header->forward[0]->value);
-            }
-            link y = list2->header->forward[0];
-            free(list2->header->value);
-            for (int i = 0 ; i <= y->level ; i++)
-                list2->header->forward[i] = y->forward[i];
-            list1->destroy_key(y->key);
-            free(y->forward);
-            free(y);
+        for (int i = 0; i <= next->level; i++) {
+            update[i]->forward[i] = next;
+            update[i] = next;
         }
+        if (next->level > list->level)
+            list->level = next->level;
+        list->size++;
     }
-    skiplist *leftOver = NULL;
-    if (list2->header->forward[0] == NULL)
-        leftOver = list1;
-    else
-        leftOver = list2;
-    for (int i = 0; i < leftOver->level; i++)
-        update[i]->forward[i] = leftOver->header->forward[i];
-    for (int i = leftOver->level ; i <= list->level ; i++)
+    for (int i = 0; i <= list->level; i++)
         update[i]->forward[i] = NULL;
-    while (list->header->forward[list->level] == NULL && list->level > 0)
-        list->level--;
-    free(list1->header->forward);
-    free(list1->header);
-    free(list1);
-    free(list2->header->forward);
-    free(list2->header);
-    free(list2);
-    free(update);
+    free_node(list1, list1->header);
+    Allocator allocator = list1->allocator;
+    allocator_free(&allocator, list1, sizeof(*list1));
+    free_node(list2, list2->header);
+    allocator = list2->allocator;
+    allocator_free(&allocator, list2, sizeof(*list2));
     return list;
 }
 
@@ -284,9 +337,9 @@ void skiplist_destroy(skiplist *list) {
             list->destroy_key(curr->key);
         if(list->destroy_value)
             list->destroy_value(curr->value);
-        free(curr->forward);
-        free(curr);
+        free_node(list, curr);
         curr = next;
     }
-    free(list);
+    Allocator allocator = list->allocator;
+    allocator_free(&allocator, list, sizeof(*list));
 }
\ No newline at end of file
@@ -2,11 +2,18 @@
 #ifndef SKIPLIST_H
 #define SKIPLIST_H
 
+#include "../Allocator/Allocator.h"
 
-#define SKIPLIST_MAX_LEVEL 6
+#include <stdbool.h>
+
+// Nodes have at most SKIPLIST_MAX_LEVEL + 1 levels, so searches stay logarithmic up to about 2^SKIPLIST_MAX_LEVEL keys
+#define SKIPLIST_MAX_LEVEL 24
 
 typedef struct skiplist skiplist;
 
+// A cursor points to a node of the skip list (NULL at the end). It is invalidated when its node is deleted
+typedef struct skiplist_node *skiplist_cursor;
+
 
 // Compare functions for the different data type
 typedef int (*CompareFunc)(void *, void *);
@@ -17,10 +24,16 @@ typedef void (*DestroyFunc)(void *);
 // Functions to visit nodes printing their data
 typedef void (*PrintFunc)(void *);
 
+// Functions which visit the keys and the values of a range. Returning false stops the range
+typedef bool (*SkipListRangeFunc)(void *key, void *value, void *ctx);
+
 
 // Function to initialize the skip list
 skiplist *skiplist_initialize(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value);
 
+// Function to initialize a skip list which allocates its memory with the given allocator (NULL uses malloc and free)
+skiplist *skiplist_initialize_with_allocator(CompareFunc compare, PrintFunc print, DestroyFunc destroy_key, DestroyFunc destroy_value, const Allocator *allocator);
+
 // Returns the size ofthe list
 size_t skiplist_get_size(skiplist *list);
 
@@ -33,10 +46,32 @@ void *skiplist_search(skiplist *list, void *key);
 // Delete the node -which holds the given key- from the skiplist
 void *skiplist_delete(skiplist *list, void *key);
 
+// Returns a cursor to the first node whose key is not less than the given key, or to the first node if key is NULL
+skiplist_cursor skiplist_seek(skiplist *list, void *key);
+
+// Returns a cursor to the next node (NULL at the end)
+skiplist_cursor skiplist_cursor_next(skiplist_cursor cursor);
+
+// Returns the key of the node of the cursor
+void *skiplist_cursor_key(skiplist_cursor cursor);
+
+// Returns the value of the node of the cursor
+void *skiplist_cursor_value(skiplist_cursor cursor);
+
+// Visit the keys of [low, high) and their values in order, until visit returns false. A NULL low starts from the first
+// key and a NULL high goes up to the last one. Returns the number of visited keys
+size_t skiplist_range(skiplist *list, void *low, void *high, SkipListRangeFunc visit, void *ctx);
+
+// Copy the keys and the values (each array can be NULL) of up to capacity nodes which are less than high (NULL for no
+// bound), starting from the cursor, and move the cursor after them. Returns the number of copied nodes, which is 0 at
+// the end of the range
+size_t skiplist_range_batch(skiplist *list, skiplist_cursor *cursor, void *high, void **keys, void **values, size_t capacity);
+
 // Display Skip List (node's are printed with their levels)
 void skiplist_print(skiplist *list);
 
-// Function to merge two skiplists and return the new one
+// Function to merge two skiplists and return the new one, in O(n + m). When a key is in both lists the value of list2 is
+// kept (both of them should use the same allocator)
 skiplist *skiplist_merge(skiplist *list1, skiplist *list2);
 
 // Free the memory which is allocated by the skip list
@@ -19,14 +19,22 @@ struct stack{
     unsigned int size;
     PrintFunc print;
     DestroyFunc destroy;
+    Allocator allocator;
 };
 
 
 // Create a stack
 Stack stack_create(PrintFunc print, DestroyFunc destroy) {
-    Stack stack = malloc(sizeof(*stack));
+    return stack_create_with_allocator(print, destroy, NULL);
+}
+
+
+// Create a stack which allocates its memory with the given allocator (NULL uses malloc and free)
+Stack stack_create_with_allocator(PrintFunc print, DestroyFunc destroy, const Allocator *allocator) {
+    Stack stack = allocator_alloc(allocator, sizeof(*stack));
     assert(stack != NULL);
-    
+    stack->allocator = allocator != NULL ? *allocator : (Allocator){0};
+
     stack->top = NULL;
     stack->size = 0;
 
@@ -43,7 +51,7 @@ void stack_push(Stack stack, void *new_item) {
         fprintf(stderr, "Stack should be initialized first\n");
         return;
     }
-    stack_node *new_node = malloc(sizeof(*new_node));
+    stack_node *new_node = allocator_alloc(&stack->allocator, sizeof(*new_node));
     assert(new_node != NULL);
 
     new_node->data = new_item;
@@ -62,7 +70,7 @@ void *stack_pop(Stack stack) {
     void *item = stack->top->data;
     stack_node *temp = stack->top;
     stack->top = stack->top->next;
-    free(temp);
+    allocator_free(&stack->allocator, temp, sizeof(*temp));
     stack->size--;
     return item;
 }
@@ -89,7 +97,7 @@ void *stack_top(Stack stack) {
 static Stack stack_reverse_copy(Stack stack) {
     if(stack == NULL || stack->top == NULL)
         return NULL;
-    Stack new_stack = stack_create(stack->print, stack->destroy);
+    Stack new_stack = stack_create_with_allocator(stack->print, stack->destroy, &stack->allocator);
     stack_node *temp = stack->top;
     while(temp != NULL) {
         void *cpy_data = malloc(sizeof(void *));
@@ -152,7 +160,8 @@ void stack_destroy(Stack stack) {
         stack_node *temp = top;
         top = top->next;
         stack->destroy(temp->data);
-        free(temp);
+        allocator_free(&stack->allocator, temp, sizeof(*temp));
     }
-    free(stack);
+    Allocator allocator = stack->allocator;
+    allocator_free(&allocator, stack, sizeof(*stack));
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #ifndef STACK_H
 #define STACK_H
 
+#include "../Allocator/Allocator.h"
+
 typedef struct stack *Stack;
 
 //Functions to destroy values inserted in the hash table
@@ -13,6 +15,9 @@ typedef void (*PrintFunc)(void *);
 // Create a stack
 Stack stack_create(PrintFunc, DestroyFunc);
 
+// Create a stack which allocates its memory with the given allocator (NULL uses malloc and free)
+Stack stack_create_with_allocator(PrintFunc, DestroyFunc, const Allocator *);
+
 // Push the given item at the top of the stack
 void stack_push(Stack, void *);
 
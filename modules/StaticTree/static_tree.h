@@ -0,0 +1,286 @@
+#ifndef STATIC_TREE_H
+#define STATIC_TREE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../Allocator/Allocator.h"
+
+// Static ordered set which is built once from sorted items and then only searched, generated for an item type:
+//     #define INT_LESS(a, b) ((a) < (b))
+//     DECLARE_STATIC_TREE(int, INT_LESS)
+//     static_tree_int *tree = static_tree_int_build(sorted, n);
+//     const int *item = static_tree_int_lower_bound(tree, 42);
+// LESS(a, b) receives two items and returns true when a is strictly less than b. It can be a function-like macro or a
+// static inline function. The items are stored in one array in the Eytzinger (breadth first) order of a complete
+// binary search tree: the root is at index 1 and the children of the item at index k are at 2k and 2k + 1. A search
+// has no pointers to follow and no branches to mispredict, and the 16 (for 4-byte items) descendants of an item four
+// levels below it share a cache line, which is prefetched while the next levels are compared. TYPE must be a
+// single-token type name.
+#define DECLARE_STATIC_TREE(TYPE, LESS)                                                                                         \
+DECLARE_STATIC_TREE_STRUCT(TYPE)                                                                                                \
+DEFINE_STATIC_TREE_BUILD(TYPE)                                                                                                  \
+DEFINE_STATIC_TREE_SEARCH(TYPE, LESS)                                                                                           \
+DEFINE_STATIC_TREE_BATCH(TYPE, LESS)                                                                                            \
+DEFINE_STATIC_TREE_ITERATE(TYPE)
+
+
+// Alignment of the array of the items, so that the descendants of an item which are prefetched together start a line
+#define STATIC_TREE_LINE_BYTES 64
+
+// Number of items (a power of two) of a line. The search prefetches the item STATIC_TREE_LINE_ITEMS times further than
+// the current one, which is the first of its descendants that many levels below
+#define STATIC_TREE_LINE_ITEMS(ITEM_SIZE)                                                                               \
+    ((ITEM_SIZE) <= 1 ? 64 : (ITEM_SIZE) <= 2 ? 32 : (ITEM_SIZE) <= 4 ? 16 : (ITEM_SIZE) <= 8 ? 8 :                     \
+     (ITEM_SIZE) <= 16 ? 4 : (ITEM_SIZE) <= 32 ? 2 : 1)
+
+// Number of searches which the batched lookups run side by side. Every level of the group of searches is issued before
+// the next one, so the cache misses of the group overlap instead of being paid one after the other
+#ifndef STATIC_TREE_BATCH
+#define STATIC_TREE_BATCH 16
+#endif
+
+#if defined(__GNUC__)
+#define STATIC_TREE_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define STATIC_TREE_PREFETCH(address) ((void)(address))
+#endif
+
+
+// items has size + 1 entries: items[1..size] are the tree and items[0] is a copy of an item, which the last level of
+// the batched searches reads instead of a missing child. levels is the number of levels of the tree, all of them
+// complete except the last one. memory is the block of memory_bytes bytes which holds items, allocated with allocator
+// one line larger than the items so that items can start at a line boundary.
+#define DECLARE_STATIC_TREE_STRUCT(TYPE)                                                                                        \
+typedef struct static_tree_##TYPE {                                                                                             \
+    TYPE *items;                                                                                                                \
+    size_t size;                                                                                                                \
+    size_t levels;                                                                                                              \
+    void *memory;                                                                                                               \
+    size_t memory_bytes;                                                                                                        \
+    Allocator allocator;                                                                                                        \
+} static_tree_##TYPE;
+
+
+// Build the tree from size items in ascending order (equal items are allowed), e.g. the array of a sorted vector_TYPE,
+// or from the items which next returns one by one in ascending order, e.g. from the iterators of a red black tree or an
+// AVL tree. The items are copied into the tree, so items which own memory must outlive it. The tree is allocated with
+// the given allocator (NULL uses malloc and free). Returns NULL if the memory cannot be allocated.
+#define DEFINE_STATIC_TREE_BUILD(TYPE)                                                                                          \
+static inline static_tree_##TYPE *static_tree_##TYPE##_allocate(size_t size, const Allocator *allocator) {                      \
+    static_tree_##TYPE *tree = allocator_alloc(allocator, sizeof(*tree));                                                       \
+    if (tree == NULL) {                                                                                                         \
+        fprintf(stderr, "Failed to allocate the static tree\n");                                                                \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    tree->allocator = allocator != NULL ? *allocator : (Allocator){0};                                                          \
+    tree->memory_bytes = (size + 1) * sizeof(TYPE) + STATIC_TREE_LINE_BYTES - 1;                                                \
+    tree->memory = allocator_alloc(&tree->allocator, tree->memory_bytes);                                                       \
+    if (tree->memory == NULL) {                                                                                                 \
+        fprintf(stderr, "Failed to allocate the items of the static tree\n");                                                   \
+        Allocator copy = tree->allocator;                                                                                       \
+        allocator_free(&copy, tree, sizeof(*tree));                                                                             \
+        return NULL;                                                                                                            \
+    }                                                                                                                           \
+    uintptr_t address = ((uintptr_t)tree->memory + STATIC_TREE_LINE_BYTES - 1) & ~(uintptr_t)(STATIC_TREE_LINE_BYTES - 1);      \
+    tree->items = (TYPE *)address;                                                                                              \
+    tree->size = size;                                                                                                          \
+    tree->levels = 0;                                                                                                           \
+    while (tree->levels < 64 && ((size_t)1 << tree->levels) <= size)                                                            \
+        tree->levels++;                                                                                                         \
+    return tree;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+/* The items are placed with an in-order walk of the implicit tree, which visits the indices in ascending order of */          \
+/* their items. The walk goes down the left children and climbs back with the shifts of the index, so it needs no stack */    \
+static inline void static_tree_##TYPE##_fill(static_tree_##TYPE *tree, const TYPE *sorted, TYPE (*next)(void *ctx),           \
+                                             void *ctx) {                                                                       \
+    size_t size = tree->size, k = 1, i = 0;                                                                                     \
+    if (size == 0)                                                                                                              \
+        return;                                                                                                                 \
+    while (2 * k <= size)                                                                                                       \
+        k = 2 * k;                                                                                                              \
+    for (;;) {                                                                                                                  \
+        tree->items[k] = sorted != NULL ? sorted[i] : next(ctx);                                                                \
+        i++;                                                                                                                    \
+        if (2 * k + 1 <= size) {                                                                                                \
+            k = 2 * k + 1;                                                                                                      \
+            while (2 * k <= size)                                                                                               \
+                k = 2 * k;                                                                                                      \
+        }                                                                                                                       \
+        else {                                                                                                                  \
+            /* Climb while k is a right child, then once more to the parent whose left subtree is done */                      \
+            while (k & 1)                                                                                                       \
+                k >>= 1;                                                                                                        \
+            k >>= 1;                                                                                                            \
+            if (k == 0)                                                                                                         \
+                break;                                                                                                          \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    tree->items[0] = tree->items[1];                                                                                            \
+}                                                                                                                               \
+                                                                                                                                \
+static inline static_tree_##TYPE *static_tree_##TYPE##_build_with_allocator(const TYPE *sorted, size_t size,                    \
+                                                                         const Allocator *allocator) {                          \
+    static_tree_##TYPE *tree = static_tree_##TYPE##_allocate(size, allocator);                                                  \
+    if (tree != NULL)                                                                                                           \
+        static_tree_##TYPE##_fill(tree, sorted, NULL, NULL);                                                                    \
+    return tree;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline static_tree_##TYPE *static_tree_##TYPE##_build(const TYPE *sorted, size_t size) {                                 \
+    return static_tree_##TYPE##_build_with_allocator(sorted, size, NULL);                                                       \
+}                                                                                                                               \
+                                                                                                                                \
+static inline static_tree_##TYPE *static_tree_##TYPE##_build_from_with_allocator(size_t size, TYPE (*next)(void *ctx),          \
+                                                                              void *ctx, const Allocator *allocator) {          \
+    static_tree_##TYPE *tree = static_tree_##TYPE##_allocate(size, allocator);                                                  \
+    if (tree != NULL)                                                                                                           \
+        static_tree_##TYPE##_fill(tree, NULL, next, ctx);                                                                       \
+    return tree;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline static_tree_##TYPE *static_tree_##TYPE##_build_from(size_t size, TYPE (*next)(void *ctx), void *ctx) {            \
+    return static_tree_##TYPE##_build_from_with_allocator(size, next, ctx, NULL);                                               \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void static_tree_##TYPE##_free(static_tree_##TYPE *tree) {                                                        \
+    if (tree == NULL)                                                                                                           \
+        return;                                                                                                                 \
+    Allocator allocator = tree->allocator;                                                                                      \
+    allocator_free(&allocator, tree->memory, tree->memory_bytes);                                                               \
+    allocator_free(&allocator, tree, sizeof(*tree));                                                                            \
+}                                                                                                                               \
+                                                                                                                                \
+                                                                                                                                \
+static inline size_t static_tree_##TYPE##_size(const static_tree_##TYPE *tree) {                                              \
+    return tree->size;                                                                                                          \
+}                                                                                                                               \
+                                                                                                                                \
+static inline size_t static_tree_##TYPE##_height(const static_tree_##TYPE *tree) {                                            \
+    return tree->levels;                                                                                                        \
+}
+
+
+// lower_bound returns the first item which is not less than key and upper_bound the first item which is greater than
+// key (NULL if there is none), search returns an item equal to key (NULL if there is none). Every step of the descent
+// is k = 2k + LESS(items[k], key), which the compiler turns into an add instead of a branch. When the walk falls off
+// the tree, the answer is the last item where it went left: the trailing 1 bits of k are the right turns after it, so
+// it is found by shifting them and the 0 bit of that left turn out of k.
+#define DEFINE_STATIC_TREE_SEARCH(TYPE, LESS)                                                                                   \
+static inline size_t static_tree_##TYPE##_answer(size_t k) {                                                                   \
+    return k >> (__builtin_ctzll(~(unsigned long long)k) + 1);                                                                  \
+}                                                                                                                               \
+                                                                                                                                \
+static inline const TYPE *static_tree_##TYPE##_lower_bound(const static_tree_##TYPE *tree, TYPE key) {                         \
+    const TYPE *items = tree->items;                                                                                            \
+    size_t size = tree->size, k = 1;                                                                                            \
+    while (k <= size) {                                                                                                         \
+        STATIC_TREE_PREFETCH(items + (k * STATIC_TREE_LINE_ITEMS(sizeof(TYPE)) <= size ?                                        \
+                                      k * STATIC_TREE_LINE_ITEMS(sizeof(TYPE)) : 0));                                           \
+        k = 2 * k + (LESS(items[k], key) ? 1 : 0);                                                                              \
+    }                                                                                                                           \
+    k = static_tree_##TYPE##_answer(k);                                                                                         \
+    return k != 0 ? &items[k] : NULL;                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline const TYPE *static_tree_##TYPE##_upper_bound(const static_tree_##TYPE *tree, TYPE key) {                         \
+    const TYPE *items = tree->items;                                                                                            \
+    size_t size = tree->size, k = 1;                                                                                            \
+    while (k <= size) {                                                                                                         \
+        STATIC_TREE_PREFETCH(items + (k * STATIC_TREE_LINE_ITEMS(sizeof(TYPE)) <= size ?                                        \
+                                      k * STATIC_TREE_LINE_ITEMS(sizeof(TYPE)) : 0));                                           \
+        k = 2 * k + (LESS(key, items[k]) ? 0 : 1);                                                                              \
+    }                                                                                                                           \
+    k = static_tree_##TYPE##_answer(k);                                                                                         \
+    return k != 0 ? &items[k] : NULL;                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline const TYPE *static_tree_##TYPE##_search(const static_tree_##TYPE *tree, TYPE key) {                              \
+    const TYPE *item = static_tree_##TYPE##_lower_bound(tree, key);                                                             \
+    return item != NULL && !LESS(key, *item) ? item : NULL;                                                                     \
+}                                                                                                                               \
+                                                                                                                                \
+static inline bool static_tree_##TYPE##_contains(const static_tree_##TYPE *tree, TYPE key) {                                   \
+    return static_tree_##TYPE##_search(tree, key) != NULL;                                                                      \
+}
+
+
+// Batched lookups: results[i] is the lower bound of (or the item equal to) keys[i]. The keys are searched in groups of
+// STATIC_TREE_BATCH, which go down the tree together one level at a time. The complete levels take the same steps for
+// every key, and on the last level a search whose child is missing reads items[0] and keeps its index, so the loops
+// have no data dependent branches.
+#define DEFINE_STATIC_TREE_BATCH(TYPE, LESS)                                                                                    \
+static inline void static_tree_##TYPE##_lower_bound_group(const static_tree_##TYPE *tree, const TYPE *keys, size_t count,      \
+                                                          const TYPE **results, bool exact) {                                   \
+    const TYPE *items = tree->items;                                                                                            \
+    size_t size = tree->size, positions[STATIC_TREE_BATCH];                                                                     \
+    if (size == 0) {                                                                                                            \
+        for (size_t j = 0; j < count; j++)                                                                                      \
+            results[j] = NULL;                                                                                                  \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    for (size_t j = 0; j < count; j++)                                                                                          \
+        positions[j] = 1;                                                                                                       \
+    for (size_t level = 1; level < tree->levels; level++) {                                                                     \
+        for (size_t j = 0; j < count; j++) {                                                                                    \
+            size_t k = positions[j];                                                                                            \
+            STATIC_TREE_PREFETCH(items + (k * STATIC_TREE_LINE_ITEMS(sizeof(TYPE)) <= size ?                                    \
+                                          k * STATIC_TREE_LINE_ITEMS(sizeof(TYPE)) : 0));                                       \
+            positions[j] = 2 * k + (LESS(items[k], keys[j]) ? 1 : 0);                                                           \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    for (size_t j = 0; j < count; j++) {                                                                                        \
+        size_t k = positions[j], present = k <= size;                                                                           \
+        size_t turn = LESS(items[present ? k : 0], keys[j]) ? 1 : 0;                                                            \
+        k = present ? 2 * k + turn : k;                                                                                         \
+        k = static_tree_##TYPE##_answer(k);                                                                                     \
+        results[j] = k != 0 && (!exact || !LESS(keys[j], items[k])) ? &items[k] : NULL;                                         \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void static_tree_##TYPE##_lower_bound_batch(const static_tree_##TYPE *tree, const TYPE *keys, size_t count,      \
+                                                          const TYPE **results) {                                               \
+    for (size_t i = 0; i < count; i += STATIC_TREE_BATCH)                                                                       \
+        static_tree_##TYPE##_lower_bound_group(tree, keys + i, count - i < STATIC_TREE_BATCH ? count - i : STATIC_TREE_BATCH,   \
+                                               results + i, false);                                                             \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void static_tree_##TYPE##_search_batch(const static_tree_##TYPE *tree, const TYPE *keys, size_t count,           \
+                                                     const TYPE **results) {                                                    \
+    for (size_t i = 0; i < count; i += STATIC_TREE_BATCH)                                                                       \
+        static_tree_##TYPE##_lower_bound_group(tree, keys + i, count - i < STATIC_TREE_BATCH ? count - i : STATIC_TREE_BATCH,   \
+                                               results + i, true);                                                              \
+}
+
+
+// Visit the items in ascending order, with the same in-order walk which placed them
+#define DEFINE_STATIC_TREE_ITERATE(TYPE)                                                                                        \
+static inline void static_tree_##TYPE##_for_each(const static_tree_##TYPE *tree, void (*visit)(const TYPE *item, void *ctx),   \
+                                                 void *ctx) {                                                                   \
+    size_t size = tree->size, k = 1;                                                                                            \
+    if (size == 0)                                                                                                              \
+        return;                                                                                                                 \
+    while (2 * k <= size)                                                                                                       \
+        k = 2 * k;                                                                                                              \
+    for (;;) {                                                                                                                  \
+        visit(&tree->items[k], ctx);                                                                                            \
+        if (2 * k + 1 <= size) {                                                                                                \
+            k = 2 * k + 1;                                                                                                      \
+            while (2 * k <= size)                                                                                               \
+                k = 2 * k;                                                                                                      \
+        }                                                                                                                       \
+        else {                                                                                                                  \
+            while (k & 1)                                                                                                       \
+                k >>= 1;                                                                                                        \
+            k >>= 1;                                                                                                            \
+            if (k == 0)                                                                                                         \
+                break;                                                                                                          \
+        }                                                                                                                       \
+    }                                                                                                                           \
+}
+
+#endif
@@ -0,0 +1,188 @@
+/* File: ThreadPool.c */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "ThreadPool.h"
+
+
+typedef struct task task;
+
+struct task {
+    TaskFunc function;
+    void *arg;
+    task *next;
+};
+
+
+struct threadpool {
+    pthread_t *threads;
+    unsigned int num_threads;
+    task *head;             // Tasks which wait to be executed (FIFO)
+    task *tail;
+    size_t pending;         // Tasks which have been submitted and have not finished yet
+    bool shutdown;
+    pthread_mutex_t lock;
+    pthread_cond_t task_available;
+    pthread_cond_t all_done;
+};
+
+
+// Arguments of the tasks of threadpool_parallel_for
+typedef struct {
+    RangeFunc body;
+    void *ctx;
+    size_t begin;
+    size_t end;
+} range_task;
+
+
+// Function which is executed by every thread of the pool
+static void *threadpool_worker(void *arg) {
+    ThreadPool pool = arg;
+    while(true) {
+        pthread_mutex_lock(&pool->lock);
+        while(pool->head == NULL && !pool->shutdown)
+            pthread_cond_wait(&pool->task_available, &pool->lock);
+        if(pool->head == NULL) {
+            // The pool is shutting down and there is nothing left to do
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        task *t = pool->head;
+        pool->head = t->next;
+        if(pool->head == NULL)
+            pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        t->function(t->arg);
+        free(t);
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->pending == 0)
+            pthread_cond_broadcast(&pool->all_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+
+// Create a thread pool with the given number of threads (0 uses one thread per online processor)
+ThreadPool threadpool_create(unsigned int num_threads) {
+    if(num_threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? online : 1;
+    }
+    ThreadPool pool = malloc(sizeof(*pool));
+    assert(pool != NULL);
+    pool->threads = malloc(num_threads * sizeof(*pool->threads));
+    assert(pool->threads != NULL);
+    pool->num_threads = num_threads;
+    pool->head = pool->tail = NULL;
+    pool->pending = 0;
+    pool->shutdown = false;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->task_available, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+    for(unsigned int i = 0 ; i < num_threads ; i++) {
+        int error = pthread_create(&pool->threads[i], NULL, threadpool_worker, pool);
+        assert(error == 0);
+        (void)error;
+    }
+    return pool;
+}
+
+
+// Return the number of threads of the pool
+unsigned int threadpool_size(ThreadPool pool) {
+    assert(pool != NULL);
+    return pool->num_threads;
+}
+
+
+// Submit a task to the pool. The task is executed by one of the threads of the pool
+void threadpool_submit(ThreadPool pool, TaskFunc function, void *arg) {
+    assert(pool != NULL && function != NULL);
+    task *t = malloc(sizeof(*t));
+    assert(t != NULL);
+    t->function = function;
+    t->arg = arg;
+    t->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if(pool->tail == NULL)
+        pool->head = pool->tail = t;
+    else {
+        pool->tail->next = t;
+        pool->tail = t;
+    }
+    pool->pending++;
+    pthread_cond_signal(&pool->task_available);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+// Wait until every task which has been submitted to the pool has finished
+void threadpool_wait(ThreadPool pool) {
+    assert(pool != NULL);
+    pthread_mutex_lock(&pool->lock);
+    while(pool->pending > 0)
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+static void threadpool_range_task(void *arg) {
+    range_task *range = arg;
+    range->body(range->begin, range->end, range->ctx);
+}
+
+
+// Split the indices [0, n) into ranges of at least grain indices, process them in parallel and wait for all of them
+void threadpool_parallel_for(ThreadPool pool, size_t n, size_t grain, RangeFunc body, void *ctx) {
+    assert(pool != NULL && body != NULL);
+    if(n == 0)
+        return;
+    if(grain == 0)
+        grain = 1;
+    // A few ranges per thread balance the load when some ranges are slower than others
+    size_t num_ranges = n / grain;
+    if(num_ranges > 4 * (size_t)pool->num_threads)
+        num_ranges = 4 * (size_t)pool->num_threads;
+    if(num_ranges <= 1) {
+        body(0, n, ctx);
+        return;
+    }
+    range_task *ranges = malloc(num_ranges * sizeof(*ranges));
+    assert(ranges != NULL);
+    for(size_t i = 0 ; i < num_ranges ; i++) {
+        ranges[i].body = body;
+        ranges[i].ctx = ctx;
+        ranges[i].begin = n * i / num_ranges;
+        ranges[i].end = n * (i + 1) / num_ranges;
+        threadpool_submit(pool, threadpool_range_task, &ranges[i]);
+    }
+    threadpool_wait(pool);
+    free(ranges);
+}
+
+
+// Wait for the submitted tasks, stop the threads and free the pool
+void threadpool_destroy(ThreadPool pool) {
+    if(pool == NULL)
+        return;
+    threadpool_wait(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->task_available);
+    pthread_mutex_unlock(&pool->lock);
+    for(unsigned int i = 0 ; i < pool->num_threads ; i++)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->task_available);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->threads);
+    free(pool);
+}
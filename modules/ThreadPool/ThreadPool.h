@@ -0,0 +1,33 @@
+/* File: ThreadPool.h */
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stddef.h>
+
+typedef struct threadpool *ThreadPool;
+
+// Functions which are executed by the threads of the pool
+typedef void (*TaskFunc)(void *);
+
+// Functions which process the indices [begin, end) of a parallel loop
+typedef void (*RangeFunc)(size_t begin, size_t end, void *ctx);
+
+// Create a thread pool with the given number of threads (0 uses one thread per online processor)
+ThreadPool threadpool_create(unsigned int num_threads);
+
+// Return the number of threads of the pool
+unsigned int threadpool_size(ThreadPool pool);
+
+// Submit a task to the pool. The task is executed by one of the threads of the pool
+void threadpool_submit(ThreadPool pool, TaskFunc task, void *arg);
+
+// Wait until every task which has been submitted to the pool has finished
+void threadpool_wait(ThreadPool pool);
+
+// Split the indices [0, n) into ranges of at least grain indices, process them in parallel and wait for all of them
+void threadpool_parallel_for(ThreadPool pool, size_t n, size_t grain, RangeFunc body, void *ctx);
+
+// Wait for the submitted tasks, stop the threads and free the pool
+void threadpool_destroy(ThreadPool pool);
+
+#endif
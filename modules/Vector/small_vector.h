@@ -0,0 +1,180 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Vector which stores up to N items inside its own struct and moves them to the heap only when it grows past N.
+//     DECLARE_SMALL_VECTOR(int, 8)
+//     small_vector_int v;
+//     small_vector_int_init(&v);
+//     small_vector_int_push_back(&v, 42);
+//     small_vector_int_release(&v, NULL);
+// A small vector on the stack needs no allocation at all until it spills. The items are found through the capacity
+// (capacity == N means inline) instead of a pointer into the struct, so an inline small vector can be copied by
+// assignment. A copy of a spilled one shares its heap array. Only one N can be used per TYPE.
+#define DECLARE_SMALL_VECTOR(TYPE, N)                                                                                           \
+DECLARE_SMALL_VECTOR_STRUCT(TYPE, N)                                                                                            \
+DEFINE_SMALL_VECTOR_INIT(TYPE, N)                                                                                               \
+DEFINE_SMALL_VECTOR_DATA(TYPE, N)                                                                                               \
+DEFINE_SMALL_VECTOR_RESERVE(TYPE, N)                                                                                            \
+DEFINE_SMALL_VECTOR_RELEASE(TYPE, N)                                                                                            \
+DEFINE_SMALL_VECTOR_ACCESS(TYPE, N)                                                                                             \
+DEFINE_SMALL_VECTOR_PUSH_BACK(TYPE, N)                                                                                          \
+DEFINE_SMALL_VECTOR_CLEAR_AT(TYPE, N)
+
+
+#define DECLARE_SMALL_VECTOR_STRUCT(TYPE, N)                                                                                    \
+typedef struct small_vector_##TYPE {                                                                                            \
+    size_t size;                                                                                                                \
+    size_t capacity;                                                                                                            \
+    union {                                                                                                                     \
+        TYPE *heap;                                                                                                             \
+        TYPE items[N];                                                                                                          \
+    } storage;                                                                                                                  \
+} small_vector_##TYPE;
+
+
+// Initialize a small vector which is allocated by the caller (e.g. on the stack). No memory is allocated.
+// small_vector_TYPE_create allocates the struct itself on the heap, which costs a single malloc.
+#define DEFINE_SMALL_VECTOR_INIT(TYPE, N)                                                                                       \
+static inline void small_vector_##TYPE##_init(small_vector_##TYPE *vector) {                                                    \
+    vector->size = 0;                                                                                                           \
+    vector->capacity = N;                                                                                                       \
+}                                                                                                                               \
+                                                                                                                                \
+static inline small_vector_##TYPE *small_vector_##TYPE##_create(void) {                                                         \
+    small_vector_##TYPE *vector = malloc(sizeof(small_vector_##TYPE));                                                          \
+    if (vector != NULL) {                                                                                                       \
+        small_vector_##TYPE##_init(vector);                                                                                     \
+    }                                                                                                                           \
+    return vector;                                                                                                              \
+}
+
+
+// Return the array which holds the items (inline while the vector has not spilled to the heap)
+#define DEFINE_SMALL_VECTOR_DATA(TYPE, N)                                                                                       \
+static inline bool small_vector_##TYPE##_is_inline(const small_vector_##TYPE *vector) {                                         \
+    return vector->capacity == N;                                                                                               \
+}                                                                                                                               \
+                                                                                                                                \
+static inline TYPE *small_vector_##TYPE##_data(small_vector_##TYPE *vector) {                                                   \
+    return small_vector_##TYPE##_is_inline(vector) ? vector->storage.items : vector->storage.heap;                              \
+}                                                                                                                               \
+                                                                                                                                \
+static inline size_t small_vector_##TYPE##_size(const small_vector_##TYPE *vector) {                                            \
+    return vector->size;                                                                                                        \
+}                                                                                                                               \
+                                                                                                                                \
+static inline size_t small_vector_##TYPE##_capacity(const small_vector_##TYPE *vector) {                                        \
+    return vector->capacity;                                                                                                    \
+}
+
+
+// Make sure that the vector can hold at least capacity items. Growing past N moves the items to the heap.
+#define DEFINE_SMALL_VECTOR_RESERVE(TYPE, N)                                                                                    \
+static inline void small_vector_##TYPE##_reserve(small_vector_##TYPE *vector, size_t capacity) {                                \
+    if (capacity <= vector->capacity)                                                                                           \
+        return;                                                                                                                 \
+    TYPE *array;                                                                                                                \
+    if (small_vector_##TYPE##_is_inline(vector)) {                                                                              \
+        array = malloc(capacity * sizeof(TYPE));                                                                                \
+        if (array != NULL)                                                                                                      \
+            memcpy(array, vector->storage.items, vector->size * sizeof(TYPE));                                                  \
+    } else {                                                                                                                    \
+        array = realloc(vector->storage.heap, capacity * sizeof(TYPE));                                                         \
+    }                                                                                                                           \
+    if (array == NULL) {                                                                                                        \
+        fprintf(stderr, "Failed to reserve %zu items for the small vector\n", capacity);                                        \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    vector->storage.heap = array;                                                                                               \
+    vector->capacity = capacity;                                                                                                \
+}
+
+
+// Destroy the items and free the heap array (if the vector has spilled). The vector is left empty and inline, so it
+// can be reused. small_vector_TYPE_free also frees a vector returned by small_vector_TYPE_create.
+#define DEFINE_SMALL_VECTOR_RELEASE(TYPE, N)                                                                                    \
+static inline void small_vector_##TYPE##_release(small_vector_##TYPE *vector, void (*destroy)(TYPE)) {                          \
+    TYPE *array = small_vector_##TYPE##_data(vector);                                                                           \
+    if (destroy != NULL) {                                                                                                      \
+        for (size_t i = 0; i < vector->size; i++) {                                                                             \
+            destroy(array[i]);                                                                                                  \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    if (!small_vector_##TYPE##_is_inline(vector)) {                                                                             \
+        free(vector->storage.heap);                                                                                             \
+    }                                                                                                                           \
+    small_vector_##TYPE##_init(vector);                                                                                         \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void small_vector_##TYPE##_free(small_vector_##TYPE *vector, void (*destroy)(TYPE)) {                             \
+    if (vector != NULL) {                                                                                                       \
+        small_vector_##TYPE##_release(vector, destroy);                                                                         \
+        free(vector);                                                                                                           \
+    }                                                                                                                           \
+}
+
+
+// Return or set the value stored at the given index. Setting an index past the end grows the size up to it.
+#define DEFINE_SMALL_VECTOR_ACCESS(TYPE, N)                                                                                     \
+static inline TYPE small_vector_##TYPE##_at(small_vector_##TYPE *vector, size_t index) {                                        \
+    return small_vector_##TYPE##_data(vector)[index];                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void small_vector_##TYPE##_set_at(small_vector_##TYPE *vector, size_t index, TYPE data) {                         \
+    if (index >= vector->capacity) {                                                                                            \
+        fprintf(stderr, "Index does not exist in the small vector array\n");                                                    \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    small_vector_##TYPE##_data(vector)[index] = data;                                                                           \
+    if (index >= vector->size) {                                                                                                \
+        vector->size = index + 1;                                                                                               \
+    }                                                                                                                           \
+}
+
+
+// Add a new value (or count values with a single copy) at the end of the vector. The capacity grows by 1.5x.
+#define DEFINE_SMALL_VECTOR_PUSH_BACK(TYPE, N)                                                                                  \
+static inline void small_vector_##TYPE##_push_back(small_vector_##TYPE *vector, TYPE data) {                                    \
+    if (vector->size == vector->capacity) {                                                                                     \
+        small_vector_##TYPE##_reserve(vector, vector->capacity + vector->capacity / 2 + 1);                                     \
+        if (vector->size == vector->capacity)                                                                                   \
+            return;                                                                                                             \
+    }                                                                                                                           \
+    small_vector_##TYPE##_data(vector)[vector->size++] = data;                                                                  \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void small_vector_##TYPE##_append_array(small_vector_##TYPE *vector, const TYPE *items, size_t count) {           \
+    if (count == 0)                                                                                                             \
+        return;                                                                                                                 \
+    if (vector->size + count > vector->capacity) {                                                                              \
+        size_t capacity = vector->capacity + vector->capacity / 2;                                                              \
+        small_vector_##TYPE##_reserve(vector, capacity > vector->size + count ? capacity : vector->size + count);               \
+        if (vector->size + count > vector->capacity)                                                                            \
+            return;                                                                                                             \
+    }                                                                                                                           \
+    memcpy(small_vector_##TYPE##_data(vector) + vector->size, items, count * sizeof(TYPE));                                     \
+    vector->size += count;                                                                                                      \
+}
+
+
+// Clear the value stored at the given index and move the following items one position back.
+#define DEFINE_SMALL_VECTOR_CLEAR_AT(TYPE, N)                                                                                   \
+static inline void small_vector_##TYPE##_clear_at(small_vector_##TYPE *vector, size_t index, void (*destroy)(TYPE)) {           \
+    if (index >= vector->size) {                                                                                                \
+        fprintf(stderr, "Invalid index: %zu\n", index);                                                                         \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    TYPE *array = small_vector_##TYPE##_data(vector);                                                                           \
+    if (destroy != NULL) {                                                                                                      \
+        destroy(array[index]);                                                                                                  \
+    }                                                                                                                           \
+    memmove(array + index, array + index + 1, (vector->size - index - 1) * sizeof(TYPE));                                       \
+    --vector->size;                                                                                                             \
+}
+
+#endif
@@ -3,6 +3,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #define DECLARE_VECTOR_ALL(TYPE)      \
 DECLARE_VECTOR(TYPE)                  \
@@ -10,6 +16,32 @@ DECLARE_VECTOR_FUNCTIONS(TYPE)        \
 DEFINE_VECTOR_ALL(TYPE)
 
 
+// Companion of DECLARE_VECTOR_ALL for vectors with a fixed ordering. LESS(a, b) is called with two items (not pointers)
+// and must return true when a is strictly less than b. It can be a function-like macro or the name of a static inline
+// function, e.g.
+//     #define INT_LESS(a, b) ((a) < (b))
+//     DECLARE_VECTOR_ALL(int)
+//     DECLARE_VECTOR_ORDERED(int, INT_LESS)
+// The generated sort and binary searches are static inline and compare the items directly, so no comparison goes
+// through a function pointer.
+#define DECLARE_VECTOR_ORDERED(TYPE, LESS)                                                                              \
+DEFINE_VECTOR_PDQSORT_ENGINE(TYPE, vector_##TYPE##_ordered, LESS)                                                       \
+DEFINE_VECTOR_ORDERED_SORT(TYPE)                                                                                        \
+DEFINE_VECTOR_LOWER_BOUND(TYPE, LESS)                                                                                   \
+DEFINE_VECTOR_UPPER_BOUND(TYPE, LESS)                                                                                   \
+DEFINE_VECTOR_BINARY_SEARCH(TYPE, LESS)
+
+
+// Companion of DECLARE_VECTOR_ALL for the primitive types. KIND describes the representation of TYPE:
+// I32 (32-bit signed integers, e.g. int), U32 (32-bit unsigned integers, e.g. unsigned), F32 (float) or F64 (double).
+//     DECLARE_VECTOR_ALL(unsigned)
+//     DECLARE_VECTOR_PRIMITIVE(unsigned, U32)
+// It generates a radix sort and a linear search which compares many items per instruction (SSE2/AVX2).
+#define DECLARE_VECTOR_PRIMITIVE(TYPE, KIND)                                                                            \
+DEFINE_VECTOR_RADIX_SORT(TYPE, KIND)                                                                                    \
+DEFINE_VECTOR_FIND(TYPE, KIND)
+
+
 #define DECLARE_VECTOR(TYPE)      \
 typedef struct vector_##TYPE{     \
     TYPE *array;                  \
@@ -25,6 +57,10 @@ void vector_##TYPE##_free(vector_##TYPE *vector, void (*destroy)(TYPE));
 TYPE vector_##TYPE##_at(vector_##TYPE *vector, int index);                                                                  \
 void vector_##TYPE##_set_at(vector_##TYPE *vector, int index, TYPE data);                                                   \
 void vector_##TYPE##_push_back(vector_##TYPE *vector, TYPE data);                                                           \
+void vector_##TYPE##_reserve(vector_##TYPE *vector, size_t capacity);                                                       \
+void vector_##TYPE##_shrink_to_fit(vector_##TYPE *vector);                                                                  \
+void vector_##TYPE##_append_array(vector_##TYPE *vector, const TYPE *items, size_t count);                                  \
+void vector_##TYPE##_erase(vector_##TYPE *vector, size_t first, size_t last, void (*destroy)(TYPE));                        \
 void vector_##TYPE##_clear_at(vector_##TYPE *vector, int index, void (*destroy)(TYPE));                                     \
 void vector_##TYPE##_delete(vector_##TYPE *vector, TYPE data, void (*destroy)(TYPE));                                       \
 size_t vector_##TYPE##_partition(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*), size_t low, size_t high); \
@@ -41,8 +77,13 @@ DEFINE_VECTOR_FREE(TYPE)        \
 DEFINE_VECTOR_AT(TYPE)          \
 DEFINE_VECTOR_SET_AT(TYPE)      \
 DEFINE_VECTOR_PUSH_BACK(TYPE)   \
+DEFINE_VECTOR_RESERVE(TYPE)     \
+DEFINE_VECTOR_SHRINK(TYPE)      \
+DEFINE_VECTOR_APPEND(TYPE)      \
+DEFINE_VECTOR_ERASE(TYPE)       \
 DEFINE_VECTOR_CLEAR_AT(TYPE)    \
 DEFINE_VECTOR_DELETE(TYPE)      \
+DEFINE_VECTOR_PDQSORT(TYPE)     \
 DEFINE_VECTOR_PARTITION(TYPE)   \
 DEFINE_VECTOR_QUICKSORT(TYPE)   \
 DEFINE_VECTOR_SORT(TYPE)        \
@@ -94,22 +135,94 @@ void vector_##TYPE##_set_at(vector_##TYPE *vector, int index, TYPE data){
     else{                                                                                                                       \
         vector->array[index] = data;                                                                                            \
         if(index >= vector->size){                                                                                              \
-            vector->size = index;                                                                                               \
+            vector->size = index + 1;                                                                                           \
         }                                                                                                                       \
     }                                                                                                                           \
 }
 
+// Capacity after growing a vector which needs room for at least min_capacity items.
+// The capacity grows by 1.5x, so the memory freed by older arrays can be reused by the allocator.
+#define VECTOR_GROWN_CAPACITY(capacity, min_capacity)                                                                           \
+    ((capacity) + (capacity) / 2 > (min_capacity) ? (capacity) + (capacity) / 2 : (min_capacity))
+
 // Add a new value at the end of the vector. This can grow the size of the vector.
 #define DEFINE_VECTOR_PUSH_BACK(TYPE)                                                                                           \
 void vector_##TYPE##_push_back(vector_##TYPE *vector, TYPE data) {                                                              \
     if(vector->size == vector->capacity){                                                                                       \
-        vector->array = realloc(vector->array, 2 * vector->capacity * sizeof(TYPE));                                            \
-        vector->capacity *= 2;                                                                                                  \
+        vector_##TYPE##_reserve(vector, VECTOR_GROWN_CAPACITY(vector->capacity, vector->size + 1));                             \
+        if(vector->size == vector->capacity)                                                                                    \
+            return;                                                                                                             \
     }                                                                                                                           \
     vector->array[vector->size++] = data;                                                                                       \
 }
 
 
+// Make sure that the vector can hold at least capacity items without reallocating its array.
+#define DEFINE_VECTOR_RESERVE(TYPE)                                                                                             \
+void vector_##TYPE##_reserve(vector_##TYPE *vector, size_t capacity) {                                                          \
+    if (capacity <= vector->capacity)                                                                                           \
+        return;                                                                                                                 \
+    TYPE *array = realloc(vector->array, capacity * sizeof(TYPE));                                                              \
+    if (array == NULL) {                                                                                                        \
+        fprintf(stderr, "Failed to reserve %zu items for the vector\n", capacity);                                              \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    vector->array = array;                                                                                                      \
+    vector->capacity = capacity;                                                                                                \
+}
+
+
+// Release the unused capacity of the vector.
+#define DEFINE_VECTOR_SHRINK(TYPE)                                                                                              \
+void vector_##TYPE##_shrink_to_fit(vector_##TYPE *vector) {                                                                     \
+    if (vector->size == vector->capacity)                                                                                       \
+        return;                                                                                                                 \
+    if (vector->size == 0) {                                                                                                    \
+        free(vector->array);                                                                                                    \
+        vector->array = NULL;                                                                                                   \
+        vector->capacity = 0;                                                                                                   \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    TYPE *array = realloc(vector->array, vector->size * sizeof(TYPE));                                                          \
+    if (array != NULL) {                                                                                                        \
+        vector->array = array;                                                                                                  \
+        vector->capacity = vector->size;                                                                                        \
+    }                                                                                                                           \
+}
+
+
+// Add count items at the end of the vector with at most one reallocation and a single copy.
+#define DEFINE_VECTOR_APPEND(TYPE)                                                                                              \
+void vector_##TYPE##_append_array(vector_##TYPE *vector, const TYPE *items, size_t count) {                                     \
+    if (count == 0)                                                                                                             \
+        return;                                                                                                                 \
+    if (vector->size + count > vector->capacity) {                                                                              \
+        vector_##TYPE##_reserve(vector, VECTOR_GROWN_CAPACITY(vector->capacity, vector->size + count));                         \
+        if (vector->size + count > vector->capacity)                                                                            \
+            return;                                                                                                             \
+    }                                                                                                                           \
+    memcpy(vector->array + vector->size, items, count * sizeof(TYPE));                                                          \
+    vector->size += count;                                                                                                      \
+}
+
+
+// Remove the items at the indices [first, last) and move the following items in their place with a single move.
+#define DEFINE_VECTOR_ERASE(TYPE)                                                                                               \
+void vector_##TYPE##_erase(vector_##TYPE *vector, size_t first, size_t last, void (*destroy)(TYPE)) {                           \
+    if (first > last || last > vector->size) {                                                                                  \
+        fprintf(stderr, "Invalid range: [%zu, %zu)\n", first, last);                                                            \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    if (destroy != NULL) {                                                                                                      \
+        for (size_t i = first; i < last; i++) {                                                                                 \
+            destroy(vector->array[i]);                                                                                          \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    memmove(vector->array + first, vector->array + last, (vector->size - last) * sizeof(TYPE));                                 \
+    vector->size -= last - first;                                                                                               \
+}
+
+
 // Clear the value stored at the given index. It should handle out of bounds indices without crashing.
 #define DEFINE_VECTOR_CLEAR_AT(TYPE)                                                                                            \
 void vector_##TYPE##_clear_at(vector_##TYPE *vector, int index, void (*destroy)(TYPE)) {                                       \
@@ -120,9 +233,7 @@ void vector_##TYPE##_clear_at(vector_##TYPE *vector, int index, void (*destroy)(
     if (destroy != NULL) {                                                                                                      \
         destroy(vector->array[index]);                                                                                          \
     }                                                                                                                           \
-    for (int i = index ; i < vector->size - 1 ; ++i) {                                                                          \
-        vector->array[i] = vector->array[i + 1];                                                                                \
-    }                                                                                                                           \
+    memmove(vector->array + index, vector->array + index + 1, (vector->size - index - 1) * sizeof(TYPE));                       \
     --vector->size;                                                                                                             \
 }
 
@@ -141,57 +252,659 @@ void vector_##TYPE##_delete(vector_##TYPE *vector, TYPE data, void (*destroy)(TY
         if (destroy != NULL) {                                                                                                  \
             destroy(vector->array[index]);                                                                                      \
         }                                                                                                                       \
-        for (size_t i = index ; i < vector->size - 1 ; i++) {                                                                   \
-            vector->array[i] = vector->array[i + 1];                                                                            \
-        }                                                                                                                       \
+        memmove(vector->array + index, vector->array + index + 1, (vector->size - index - 1) * sizeof(TYPE));                   \
         --vector->size;                                                                                                         \
     }                                                                                                                           \
 }
 
 
+// Pattern-defeating quicksort (pdqsort) engine used by the sort functions.
+// NAME prefixes the generated helpers and LESS(a, b) is the strict ordering that is used for every comparison.
+// Every helper takes the compare function of the vector API, so LESS may be built on top of it.
+#define VECTOR_PDQ_INSERTION_SORT_THRESHOLD 24
+#define VECTOR_PDQ_NINTHER_THRESHOLD 128
+#define VECTOR_PDQ_PARTIAL_INSERTION_SORT_LIMIT 8
+#define VECTOR_PDQ_BLOCK_SIZE 64
+
+// Strict ordering on top of a compare function (used by vector_TYPE_sort)
+#define VECTOR_COMPARE_LESS(a, b) (compare(&(a), &(b)) < 0)
+
+#define DEFINE_VECTOR_PDQSORT_ENGINE(TYPE, NAME, LESS)                                                                          \
+static inline void NAME##_swap(TYPE *a, TYPE *b) {                                                                              \
+    TYPE temp = *a;                                                                                                             \
+    *a = *b;                                                                                                                    \
+    *b = temp;                                                                                                                  \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void NAME##_sort2(TYPE *a, TYPE *b, int (*compare)(const TYPE*, const TYPE*)) {                                   \
+    if (LESS(*b, *a)) {                                                                                                         \
+        NAME##_swap(a, b);                                                                                                      \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void NAME##_sort3(TYPE *a, TYPE *b, TYPE *c, int (*compare)(const TYPE*, const TYPE*)) {                          \
+    NAME##_sort2(a, b, compare);                                                                                                \
+    NAME##_sort2(b, c, compare);                                                                                                \
+    NAME##_sort2(a, b, compare);                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+/* Insertion sort which is used for small ranges */                                                                             \
+static inline void NAME##_insertion_sort(TYPE *begin, TYPE *end, int (*compare)(const TYPE*, const TYPE*)) {                    \
+    if (begin == end) {                                                                                                         \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    for (TYPE *cur = begin + 1; cur != end; cur++) {                                                                            \
+        if (LESS(*cur, *(cur - 1))) {                                                                                           \
+            TYPE temp = *cur;                                                                                                   \
+            TYPE *sift = cur;                                                                                                   \
+            do {                                                                                                                \
+                *sift = *(sift - 1);                                                                                            \
+                sift--;                                                                                                         \
+            } while (sift != begin && LESS(temp, *(sift - 1)));                                                                 \
+            *sift = temp;                                                                                                       \
+        }                                                                                                                       \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+/* Insertion sort which assumes that *(begin - 1) is not greater than any item of the range */                                  \
+static inline void NAME##_unguarded_insertion_sort(TYPE *begin, TYPE *end, int (*compare)(const TYPE*, const TYPE*)) {          \
+    if (begin == end) {                                                                                                         \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    for (TYPE *cur = begin + 1; cur != end; cur++) {                                                                            \
+        if (LESS(*cur, *(cur - 1))) {                                                                                           \
+            TYPE temp = *cur;                                                                                                   \
+            TYPE *sift = cur;                                                                                                   \
+            do {                                                                                                                \
+                *sift = *(sift - 1);                                                                                            \
+                sift--;                                                                                                         \
+            } while (LESS(temp, *(sift - 1)));                                                                                  \
+            *sift = temp;                                                                                                       \
+        }                                                                                                                       \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+/* Insertion sort which gives up (returns false) when it has to move too many items */                                          \
+static inline bool NAME##_partial_insertion_sort(TYPE *begin, TYPE *end, int (*compare)(const TYPE*, const TYPE*)) {            \
+    if (begin == end) {                                                                                                         \
+        return true;                                                                                                            \
+    }                                                                                                                           \
+    size_t limit = 0;                                                                                                           \
+    for (TYPE *cur = begin + 1; cur != end; cur++) {                                                                            \
+        if (LESS(*cur, *(cur - 1))) {                                                                                           \
+            TYPE temp = *cur;                                                                                                   \
+            TYPE *sift = cur;                                                                                                   \
+            do {                                                                                                                \
+                *sift = *(sift - 1);                                                                                            \
+                sift--;                                                                                                         \
+            } while (sift != begin && LESS(temp, *(sift - 1)));                                                                 \
+            *sift = temp;                                                                                                       \
+            limit += cur - sift;                                                                                                \
+        }                                                                                                                       \
+        if (limit > VECTOR_PDQ_PARTIAL_INSERTION_SORT_LIMIT) {                                                                  \
+            return false;                                                                                                       \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    return true;                                                                                                                \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void NAME##_sift_down(TYPE *base, size_t root, size_t size, int (*compare)(const TYPE*, const TYPE*)) {           \
+    TYPE temp = base[root];                                                                                                     \
+    size_t child;                                                                                                               \
+    while ((child = 2 * root + 1) < size) {                                                                                     \
+        if (child + 1 < size && LESS(base[child], base[child + 1])) {                                                           \
+            child++;                                                                                                            \
+        }                                                                                                                       \
+        if (!LESS(temp, base[child])) {                                                                                         \
+            break;                                                                                                              \
+        }                                                                                                                       \
+        base[root] = base[child];                                                                                               \
+        root = child;                                                                                                           \
+    }                                                                                                                           \
+    base[root] = temp;                                                                                                          \
+}                                                                                                                               \
+                                                                                                                                \
+/* Heapsort fallback which bounds the worst case to O(n log n) */                                                               \
+static inline void NAME##_heapsort(TYPE *begin, TYPE *end, int (*compare)(const TYPE*, const TYPE*)) {                          \
+    size_t size = end - begin;                                                                                                  \
+    if (size < 2) {                                                                                                             \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    for (size_t i = size / 2; i-- > 0;) {                                                                                       \
+        NAME##_sift_down(begin, i, size, compare);                                                                              \
+    }                                                                                                                           \
+    for (size_t i = size - 1; i > 0; i--) {                                                                                     \
+        NAME##_swap(begin, begin + i);                                                                                          \
+        NAME##_sift_down(begin, 0, i, compare);                                                                                 \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void NAME##_swap_offsets(TYPE *first, TYPE *last, unsigned char *offsets_l, unsigned char *offsets_r,             \
+                                       size_t num, bool use_swaps) {                                                            \
+    if (use_swaps) {                                                                                                            \
+        for (size_t i = 0; i < num; i++) {                                                                                      \
+            NAME##_swap(first + offsets_l[i], last - offsets_r[i]);                                                             \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    else if (num > 0) {                                                                                                         \
+        TYPE *l = first + offsets_l[0];                                                                                         \
+        TYPE *r = last - offsets_r[0];                                                                                          \
+        TYPE temp = *l;                                                                                                         \
+        *l = *r;                                                                                                                \
+        for (size_t i = 1; i < num; i++) {                                                                                      \
+            l = first + offsets_l[i];                                                                                           \
+            *r = *l;                                                                                                            \
+            r = last - offsets_r[i];                                                                                            \
+            *l = *r;                                                                                                            \
+        }                                                                                                                       \
+        *r = temp;                                                                                                              \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+/* Partition [begin, end) around *begin, putting items equal to the pivot in the right part. */                                 \
+/* The comparisons are recorded as offsets in blocks, so the swaps do not depend on branch prediction. */                       \
+/* Requires an item which is not less than the pivot at end - 1 (median of 3 guarantees that). */                               \
+static inline TYPE *NAME##_partition_right(TYPE *begin, TYPE *end, bool *already_partitioned,                                   \
+                                           int (*compare)(const TYPE*, const TYPE*)) {                                          \
+    TYPE pivot = *begin;                                                                                                        \
+    TYPE *first = begin;                                                                                                        \
+    TYPE *last = end;                                                                                                           \
+    do {                                                                                                                        \
+        first++;                                                                                                                \
+    } while (LESS(*first, pivot));                                                                                              \
+    if (first - 1 == begin) {                                                                                                   \
+        while (first < last) {                                                                                                  \
+            last--;                                                                                                             \
+            if (LESS(*last, pivot)) {                                                                                           \
+                break;                                                                                                          \
+            }                                                                                                                   \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    else {                                                                                                                      \
+        do {                                                                                                                    \
+            last--;                                                                                                             \
+        } while (!LESS(*last, pivot));                                                                                          \
+    }                                                                                                                           \
+    *already_partitioned = first >= last;                                                                                       \
+    if (!*already_partitioned) {                                                                                                \
+        NAME##_swap(first, last);                                                                                               \
+        first++;                                                                                                                \
+        unsigned char offsets_l[VECTOR_PDQ_BLOCK_SIZE];                                                                         \
+        unsigned char offsets_r[VECTOR_PDQ_BLOCK_SIZE];                                                                         \
+        TYPE *offsets_l_base = first;                                                                                           \
+        TYPE *offsets_r_base = last;                                                                                            \
+        size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;                                                                  \
+        while (first < last) {                                                                                                  \
+            size_t num_unknown = last - first;                                                                                  \
+            size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;                                  \
+            size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;                                                   \
+            if (left_split > VECTOR_PDQ_BLOCK_SIZE) {                                                                           \
+                left_split = VECTOR_PDQ_BLOCK_SIZE;                                                                             \
+            }                                                                                                                   \
+            if (right_split > VECTOR_PDQ_BLOCK_SIZE) {                                                                          \
+                right_split = VECTOR_PDQ_BLOCK_SIZE;                                                                            \
+            }                                                                                                                   \
+            for (size_t i = 0; i < left_split; i++) {                                                                           \
+                offsets_l[num_l] = i;                                                                                           \
+                num_l += !LESS(*first, pivot);                                                                                  \
+                first++;                                                                                                        \
+            }                                                                                                                   \
+            for (size_t i = 0; i < right_split; i++) {                                                                          \
+                last--;                                                                                                         \
+                offsets_r[num_r] = i + 1;                                                                                       \
+                num_r += LESS(*last, pivot);                                                                                    \
+            }                                                                                                                   \
+            size_t num = num_l < num_r ? num_l : num_r;                                                                         \
+            NAME##_swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r); \
+            num_l -= num;                                                                                                       \
+            num_r -= num;                                                                                                       \
+            start_l += num;                                                                                                     \
+            start_r += num;                                                                                                     \
+            if (num_l == 0) {                                                                                                   \
+                start_l = 0;                                                                                                    \
+                offsets_l_base = first;                                                                                         \
+            }                                                                                                                   \
+            if (num_r == 0) {                                                                                                   \
+                start_r = 0;                                                                                                    \
+                offsets_r_base = last;                                                                                          \
+            }                                                                                                                   \
+        }                                                                                                                       \
+        if (num_l) {                                                                                                            \
+            while (num_l--) {                                                                                                   \
+                last--;                                                                                                         \
+                NAME##_swap(offsets_l_base + offsets_l[start_l + num_l], last);                                                 \
+            }                                                                                                                   \
+            first = last;                                                                                                       \
+        }                                                                                                                       \
+        if (num_r) {                                                                                                            \
+            while (num_r--) {                                                                                                   \
+                NAME##_swap(offsets_r_base - offsets_r[start_r + num_r], first);                                                \
+                first++;                                                                                                        \
+            }                                                                                                                   \
+            last = first;                                                                                                       \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    TYPE *pivot_pos = first - 1;                                                                                                \
+    *begin = *pivot_pos;                                                                                                        \
+    *pivot_pos = pivot;                                                                                                         \
+    return pivot_pos;                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+/* Partition [begin, end) around *begin, putting items equal to the pivot in the left part */                                   \
+static inline TYPE *NAME##_partition_left(TYPE *begin, TYPE *end, int (*compare)(const TYPE*, const TYPE*)) {                   \
+    TYPE pivot = *begin;                                                                                                        \
+    TYPE *first = begin;                                                                                                        \
+    TYPE *last = end;                                                                                                           \
+    do {                                                                                                                        \
+        last--;                                                                                                                 \
+    } while (LESS(pivot, *last));                                                                                               \
+    if (last + 1 == end) {                                                                                                      \
+        while (first < last) {                                                                                                  \
+            first++;                                                                                                            \
+            if (LESS(pivot, *first)) {                                                                                          \
+                break;                                                                                                          \
+            }                                                                                                                   \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    else {                                                                                                                      \
+        do {                                                                                                                    \
+            first++;                                                                                                            \
+        } while (!LESS(pivot, *first));                                                                                         \
+    }                                                                                                                           \
+    while (first < last) {                                                                                                      \
+        NAME##_swap(first, last);                                                                                               \
+        do {                                                                                                                    \
+            last--;                                                                                                             \
+        } while (LESS(pivot, *last));                                                                                           \
+        do {                                                                                                                    \
+            first++;                                                                                                            \
+        } while (!LESS(pivot, *first));                                                                                         \
+    }                                                                                                                           \
+    TYPE *pivot_pos = last;                                                                                                     \
+    *begin = *pivot_pos;                                                                                                        \
+    *pivot_pos = pivot;                                                                                                         \
+    return pivot_pos;                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void NAME##_loop(TYPE *begin, TYPE *end, int bad_allowed, bool leftmost,                                          \
+                               int (*compare)(const TYPE*, const TYPE*)) {                                                      \
+    while (true) {                                                                                                              \
+        size_t size = end - begin;                                                                                              \
+        if (size < VECTOR_PDQ_INSERTION_SORT_THRESHOLD) {                                                                       \
+            if (leftmost) {                                                                                                     \
+                NAME##_insertion_sort(begin, end, compare);                                                                     \
+            }                                                                                                                   \
+            else {                                                                                                              \
+                NAME##_unguarded_insertion_sort(begin, end, compare);                                                           \
+            }                                                                                                                   \
+            return;                                                                                                             \
+        }                                                                                                                       \
+        /* Choose the pivot as the median of 3 (or the pseudomedian of 9 for large ranges) and move it to begin */              \
+        size_t s2 = size / 2;                                                                                                   \
+        if (size > VECTOR_PDQ_NINTHER_THRESHOLD) {                                                                              \
+            NAME##_sort3(begin, begin + s2, end - 1, compare);                                                                  \
+            NAME##_sort3(begin + 1, begin + (s2 - 1), end - 2, compare);                                                        \
+            NAME##_sort3(begin + 2, begin + (s2 + 1), end - 3, compare);                                                        \
+            NAME##_sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), compare);                                              \
+            NAME##_swap(begin, begin + s2);                                                                                     \
+        }                                                                                                                       \
+        else {                                                                                                                  \
+            NAME##_sort3(begin + s2, begin, end - 1, compare);                                                                  \
+        }                                                                                                                       \
+        /* If the pivot equals the item before the range, every item of the range is greater than or equal to it. */            \
+        /* Put the equal items on the left (they are sorted already) and continue with the rest of the range. */                \
+        if (!leftmost && !LESS(*(begin - 1), *begin)) {                                                                         \
+            begin = NAME##_partition_left(begin, end, compare) + 1;                                                             \
+            continue;                                                                                                           \
+        }                                                                                                                       \
+        bool already_partitioned;                                                                                               \
+        TYPE *pivot_pos = NAME##_partition_right(begin, end, &already_partitioned, compare);                                    \
+        size_t l_size = pivot_pos - begin;                                                                                      \
+        size_t r_size = end - (pivot_pos + 1);                                                                                  \
+        if (l_size < size / 8 || r_size < size / 8) {                                                                           \
+            /* Too many bad partitions, switch to heapsort to guarantee O(n log n) */                                           \
+            if (--bad_allowed == 0) {                                                                                           \
+                NAME##_heapsort(begin, end, compare);                                                                           \
+                return;                                                                                                         \
+            }                                                                                                                   \
+            /* Break the patterns which led to the bad partition by swapping a few items */                                     \
+            if (l_size >= VECTOR_PDQ_INSERTION_SORT_THRESHOLD) {                                                                \
+                NAME##_swap(begin, begin + l_size / 4);                                                                         \
+                NAME##_swap(pivot_pos - 1, pivot_pos - l_size / 4);                                                             \
+                if (l_size > VECTOR_PDQ_NINTHER_THRESHOLD) {                                                                    \
+                    NAME##_swap(begin + 1, begin + (l_size / 4 + 1));                                                           \
+                    NAME##_swap(begin + 2, begin + (l_size / 4 + 2));                                                           \
+                    NAME##_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));                                                   \
+                    NAME##_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));                                                   \
+                }                                                                                                               \
+            }                                                                                                                   \
+            if (r_size >= VECTOR_PDQ_INSERTION_SORT_THRESHOLD) {                                                                \
+                NAME##_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));                                                       \
+                NAME##_swap(end - 1, end - r_size / 4);                                                                         \
+                if (r_size > VECTOR_PDQ_NINTHER_THRESHOLD) {                                                                    \
+                    NAME##_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));                                                   \
+                    NAME##_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));                                                   \
+                    NAME##_swap(end - 2, end - (1 + r_size / 4));                                                               \
+                    NAME##_swap(end - 3, end - (2 + r_size / 4));                                                               \
+                }                                                                                                               \
+            }                                                                                                                   \
+        }                                                                                                                       \
+        else if (already_partitioned && NAME##_partial_insertion_sort(begin, pivot_pos, compare)                                \
+                 && NAME##_partial_insertion_sort(pivot_pos + 1, end, compare)) {                                               \
+            /* The range was (almost) sorted already */                                                                         \
+            return;                                                                                                             \
+        }                                                                                                                       \
+        /* Recurse into the left part and loop on the right part */                                                             \
+        NAME##_loop(begin, pivot_pos, bad_allowed, leftmost, compare);                                                          \
+        begin = pivot_pos + 1;                                                                                                  \
+        leftmost = false;                                                                                                       \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+/* Sort [begin, end) */                                                                                                         \
+static inline void NAME##_sort(TYPE *begin, TYPE *end, int (*compare)(const TYPE*, const TYPE*)) {                              \
+    size_t size = end - begin;                                                                                                  \
+    if (size > 1) {                                                                                                             \
+        int log2_size = 0;                                                                                                      \
+        while (size >>= 1) {                                                                                                    \
+            log2_size++;                                                                                                        \
+        }                                                                                                                       \
+        NAME##_loop(begin, end, log2_size, true, compare);                                                                      \
+    }                                                                                                                           \
+}
+
+
+// The pdqsort engine behind vector_TYPE_sort, vector_TYPE_quicksort and vector_TYPE_partition
+#define DEFINE_VECTOR_PDQSORT(TYPE)                                                                                             \
+DEFINE_VECTOR_PDQSORT_ENGINE(TYPE, vector_##TYPE##_pdq, VECTOR_COMPARE_LESS)
+
+
 // Helper function for QuickSort - Partition
-#define DEFINE_VECTOR_PARTITION(TYPE)                                                                                              \
-size_t vector_##TYPE##_partition(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*), size_t low, size_t high) {       \
-    if (low >= high || high >= vector->size) {                                                                                     \
-        return low;                                                                                                                \
-    }                                                                                                                              \
-    TYPE pivot = vector->array[high];                                                                                              \
-    size_t i = low - 1;                                                                                                            \
-    for (size_t j = low; j < high; j++) {                                                                                          \
-        if (compare(&vector->array[j], &pivot) < 0) {                                                                              \
-            i++;                                                                                                                   \
-            TYPE temp = vector->array[i];                                                                                          \
-            vector->array[i] = vector->array[j];                                                                                   \
-            vector->array[j] = temp;                                                                                               \
-        }                                                                                                                          \
-    }                                                                                                                              \
-    TYPE temp = vector->array[i + 1];                                                                                              \
-    vector->array[i + 1] = vector->array[high];                                                                                    \
-    vector->array[high] = temp;                                                                                                    \
-    return i + 1;                                                                                                                  \
-}
-
-
-// Helper function for QuickSort - Recursive QuickSort
-#define DEFINE_VECTOR_QUICKSORT(TYPE)                                                                                            \
-void vector_##TYPE##_quicksort(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*), size_t low, size_t high) {       \
-    if (low < high) {                                                                                                            \
-        size_t pi = vector_##TYPE##_partition(vector, compare, low, high);                                                       \
-        if (pi > 0)                                                                                                              \
-            vector_##TYPE##_quicksort(vector, compare, low, pi - 1);                                                             \
-        vector_##TYPE##_quicksort(vector, compare, pi + 1, high);                                                                \
-    }                                                                                                                            \
-}
-
-
-
-// Sort the elements in the vector using the QuickSort algorithm and a custom compare function.
-#define DEFINE_VECTOR_SORT(TYPE)                                                                                                  \
-void vector_##TYPE##_sort(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*)) {                                      \
-    size_t size = vector->size;                                                                                                   \
-    if (size > 1) {                                                                                                               \
-        vector_##TYPE##_quicksort(vector, compare, 0, size - 1);                                                                  \
-    }                                                                                                                             \
+// The pivot is the median of the first, the middle and the last item. Returns the final index of the pivot.
+#define DEFINE_VECTOR_PARTITION(TYPE)                                                                                           \
+size_t vector_##TYPE##_partition(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*), size_t low, size_t high) {    \
+    if (low >= high || high >= vector->size) {                                                                                  \
+        return low;                                                                                                             \
+    }                                                                                                                           \
+    TYPE *begin = vector->array + low;                                                                                          \
+    if (high - low == 1) {                                                                                                      \
+        vector_##TYPE##_pdq_sort2(begin, begin + 1, compare);                                                                   \
+        return low;                                                                                                             \
+    }                                                                                                                           \
+    bool already_partitioned;                                                                                                   \
+    vector_##TYPE##_pdq_sort3(begin + (high - low) / 2, begin, vector->array + high, compare);                                  \
+    return vector_##TYPE##_pdq_partition_right(begin, vector->array + high + 1, &already_partitioned, compare) - vector->array; \
+}
+
+
+// Helper function for QuickSort - Sort the items between low and high (inclusive) with pattern-defeating quicksort
+#define DEFINE_VECTOR_QUICKSORT(TYPE)                                                                                           \
+void vector_##TYPE##_quicksort(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*), size_t low, size_t high) {      \
+    if (low < high && high < vector->size) {                                                                                    \
+        vector_##TYPE##_pdq_sort(vector->array + low, vector->array + high + 1, compare);                                       \
+    }                                                                                                                           \
+}
+
+
+
+// Sort the elements in the vector using pattern-defeating quicksort and a custom compare function.
+// Sorted, reversed and equal items are handled in linear time and the worst case is O(n log n).
+#define DEFINE_VECTOR_SORT(TYPE)                                                                                                \
+void vector_##TYPE##_sort(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*)) {                                    \
+    size_t size = vector->size;                                                                                                 \
+    if (size > 1) {                                                                                                             \
+        vector_##TYPE##_quicksort(vector, compare, 0, size - 1);                                                                \
+    }                                                                                                                           \
+}
+
+
+
+// ORDERED VECTOR FUNCTIONS (generated by DECLARE_VECTOR_ORDERED)
+
+// Sort the elements in the vector using pattern-defeating quicksort and the ordering of the instantiation.
+#define DEFINE_VECTOR_ORDERED_SORT(TYPE)                                                                                        \
+static inline void vector_##TYPE##_sort_inline(vector_##TYPE *vector) {                                                          \
+    vector_##TYPE##_ordered_sort(vector->array, vector->array + vector->size, NULL);                                            \
+}
+
+
+// Return the index of the first item which is not less than data, or the size of the vector if there is none.
+// The vector must be sorted. The search has no data dependent branches.
+#define DEFINE_VECTOR_LOWER_BOUND(TYPE, LESS)                                                                                   \
+static inline size_t vector_##TYPE##_lower_bound(vector_##TYPE *vector, TYPE data) {                                            \
+    TYPE *base = vector->array;                                                                                                 \
+    size_t n = vector->size;                                                                                                    \
+    if (n == 0) {                                                                                                               \
+        return 0;                                                                                                               \
+    }                                                                                                                           \
+    while (n > 1) {                                                                                                             \
+        size_t half = n / 2;                                                                                                    \
+        base = LESS(base[half], data) ? base + half : base;                                                                     \
+        n -= half;                                                                                                              \
+    }                                                                                                                           \
+    return (base - vector->array) + LESS(*base, data);                                                                          \
+}
+
+
+// Return the index of the first item which is greater than data, or the size of the vector if there is none.
+// The vector must be sorted.
+#define DEFINE_VECTOR_UPPER_BOUND(TYPE, LESS)                                                                                   \
+static inline size_t vector_##TYPE##_upper_bound(vector_##TYPE *vector, TYPE data) {                                            \
+    TYPE *base = vector->array;                                                                                                 \
+    size_t n = vector->size;                                                                                                    \
+    if (n == 0) {                                                                                                               \
+        return 0;                                                                                                               \
+    }                                                                                                                           \
+    while (n > 1) {                                                                                                             \
+        size_t half = n / 2;                                                                                                    \
+        base = !LESS(data, base[half]) ? base + half : base;                                                                    \
+        n -= half;                                                                                                              \
+    }                                                                                                                           \
+    return (base - vector->array) + !LESS(data, *base);                                                                         \
+}
+
+
+// Search a sorted vector for an item. Returns the index of the first occurrence if found, otherwise -1.
+#define DEFINE_VECTOR_BINARY_SEARCH(TYPE, LESS)                                                                                 \
+static inline int vector_##TYPE##_binary_search(vector_##TYPE *vector, TYPE data) {                                             \
+    size_t index = vector_##TYPE##_lower_bound(vector, data);                                                                   \
+    if (index < vector->size && !LESS(data, vector->array[index])) {                                                            \
+        return index;                                                                                                           \
+    }                                                                                                                           \
+    return -1;                                                                                                                  \
+}
+
+
+
+// PRIMITIVE VECTOR FUNCTIONS (generated by DECLARE_VECTOR_PRIMITIVE)
+
+// Order preserving maps of the primitive types to unsigned keys (used by the radix sort).
+// Negative floating point numbers have all their bits flipped and positive ones only their sign bit.
+#define VECTOR_RADIX_KEY_TYPE_I32 uint32_t
+#define VECTOR_RADIX_KEY_TYPE_U32 uint32_t
+#define VECTOR_RADIX_KEY_TYPE_F32 uint32_t
+#define VECTOR_RADIX_KEY_TYPE_F64 uint64_t
+#define VECTOR_RADIX_KEY_I32(value) ((uint32_t)(value) ^ UINT32_C(0x80000000))
+#define VECTOR_RADIX_KEY_U32(value) ((uint32_t)(value))
+#define VECTOR_RADIX_KEY_F32(value) vector_radix_key_float(value)
+#define VECTOR_RADIX_KEY_F64(value) vector_radix_key_double(value)
+
+static inline uint32_t vector_radix_key_float(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits ^ ((uint32_t)-(int32_t)(bits >> 31) | UINT32_C(0x80000000));
+}
+
+static inline uint64_t vector_radix_key_double(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits ^ ((uint64_t)-(int64_t)(bits >> 63) | UINT64_C(0x8000000000000000));
+}
+
+#define VECTOR_RADIX_BITS 8
+#define VECTOR_RADIX_BUCKETS (1 << VECTOR_RADIX_BITS)
+
+
+// Sort the elements in the vector using LSD radix sort with 8-bit digits.
+// Passes in which every item has the same digit are skipped. Floating point numbers are ordered as
+// -NaN < -inf < ... < -0.0 < 0.0 < ... < inf < NaN.
+#define DEFINE_VECTOR_RADIX_SORT(TYPE, KIND)                                                                                    \
+static inline void vector_##TYPE##_radix_sort(vector_##TYPE *vector) {                                                          \
+    size_t size = vector->size;                                                                                                 \
+    if (size < 2) {                                                                                                             \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    /* The scratch buffer has the capacity of the vector, so it can replace the array after an odd number of passes */          \
+    TYPE *scratch = malloc(sizeof(TYPE) * vector->capacity);                                                                    \
+    if (scratch == NULL) {                                                                                                      \
+        fprintf(stderr, "Not enough memory for the radix sort of the vector\n");                                                \
+        return;                                                                                                                 \
+    }                                                                                                                           \
+    enum { DIGITS = sizeof(VECTOR_RADIX_KEY_TYPE_##KIND) * 8 / VECTOR_RADIX_BITS };                                             \
+    size_t counts[DIGITS][VECTOR_RADIX_BUCKETS] = {{0}};                                                                        \
+    for (size_t i = 0; i < size; i++) {                                                                                         \
+        VECTOR_RADIX_KEY_TYPE_##KIND key = VECTOR_RADIX_KEY_##KIND(vector->array[i]);                                           \
+        for (int digit = 0; digit < DIGITS; digit++) {                                                                          \
+            counts[digit][(key >> (digit * VECTOR_RADIX_BITS)) & (VECTOR_RADIX_BUCKETS - 1)]++;                                 \
+        }                                                                                                                       \
+    }                                                                                                                           \
+    TYPE *src = vector->array;                                                                                                  \
+    TYPE *dst = scratch;                                                                                                        \
+    for (int digit = 0; digit < DIGITS; digit++) {                                                                              \
+        int shift = digit * VECTOR_RADIX_BITS;                                                                                  \
+        size_t *count = counts[digit];                                                                                          \
+        if (count[(VECTOR_RADIX_KEY_##KIND(src[0]) >> shift) & (VECTOR_RADIX_BUCKETS - 1)] == size) {                           \
+            continue;                                                                                                           \
+        }                                                                                                                       \
+        size_t offset = 0;                                                                                                      \
+        for (int bucket = 0; bucket < VECTOR_RADIX_BUCKETS; bucket++) {                                                         \
+            size_t bucket_size = count[bucket];                                                                                 \
+            count[bucket] = offset;                                                                                             \
+            offset += bucket_size;                                                                                              \
+        }                                                                                                                       \
+        for (size_t i = 0; i < size; i++) {                                                                                     \
+            dst[count[(VECTOR_RADIX_KEY_##KIND(src[i]) >> shift) & (VECTOR_RADIX_BUCKETS - 1)]++] = src[i];                     \
+        }                                                                                                                       \
+        TYPE *temp = src;                                                                                                       \
+        src = dst;                                                                                                              \
+        dst = temp;                                                                                                             \
+    }                                                                                                                           \
+    vector->array = src;                                                                                                        \
+    free(dst);                                                                                                                  \
+}
+
+
+// Linear searches which compare 16 items per iteration using AVX2 (or SSE2) when the compiler targets it.
+// They return the index of the first occurrence of value, or n if it does not exist.
+static inline size_t vector_find_bits32(const uint32_t *array, size_t n, uint32_t value) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi32(value);
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(array + i)), needle);
+        __m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(array + i + 8)), needle);
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(a)) | (_mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i needle = _mm_set1_epi32(value);
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = 0;
+        for (int j = 0; j < 4; j++) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(array + i + 4 * j)), needle);
+            mask |= _mm_movemask_ps(_mm_castsi128_ps(eq)) << (4 * j);
+        }
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (array[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static inline size_t vector_find_float(const float *array, size_t n, float value) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256 needle = _mm256_set1_ps(value);
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_cmp_ps(_mm256_loadu_ps(array + i), needle, _CMP_EQ_OQ);
+        __m256 b = _mm256_cmp_ps(_mm256_loadu_ps(array + i + 8), needle, _CMP_EQ_OQ);
+        unsigned mask = _mm256_movemask_ps(a) | (_mm256_movemask_ps(b) << 8);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128 needle = _mm_set1_ps(value);
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = 0;
+        for (int j = 0; j < 4; j++) {
+            mask |= _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(array + i + 4 * j), needle)) << (4 * j);
+        }
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (array[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static inline size_t vector_find_double(const double *array, size_t n, double value) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256d needle = _mm256_set1_pd(value);
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = 0;
+        for (int j = 0; j < 4; j++) {
+            mask |= _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(array + i + 4 * j), needle, _CMP_EQ_OQ)) << (4 * j);
+        }
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128d needle = _mm_set1_pd(value);
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = 0;
+        for (int j = 0; j < 8; j++) {
+            mask |= _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(array + i + 2 * j), needle)) << (2 * j);
+        }
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (array[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+#define VECTOR_FIND_I32(array, n, value) vector_find_bits32((const uint32_t *)(array), n, (uint32_t)(value))
+#define VECTOR_FIND_U32(array, n, value) vector_find_bits32((const uint32_t *)(array), n, (uint32_t)(value))
+#define VECTOR_FIND_F32(array, n, value) vector_find_float(array, n, value)
+#define VECTOR_FIND_F64(array, n, value) vector_find_double(array, n, value)
+
+
+// Search the vector for an item (using ==). Returns the index of the first occurrence if found, otherwise -1.
+#define DEFINE_VECTOR_FIND(TYPE, KIND)                                                                                          \
+static inline int vector_##TYPE##_find(vector_##TYPE *vector, TYPE data) {                                                      \
+    size_t index = VECTOR_FIND_##KIND(vector->array, vector->size, data);                                                       \
+    return index < vector->size ? (int)index : -1;                                                                              \
 }
 
 
@@ -0,0 +1,243 @@
+#ifndef VECTOR_PARALLEL_H
+#define VECTOR_PARALLEL_H
+
+#include "vector.h"
+#include "../ThreadPool/ThreadPool.h"
+
+// Companion of DECLARE_VECTOR_ALL which runs the vector operations on the threads of a ThreadPool.
+//     DECLARE_VECTOR_ALL(int)
+//     DECLARE_VECTOR_PARALLEL(int)
+// The generated functions wait for every task of the pool, so a pool should be used by one caller at a time.
+// Programs which use them must be linked with -pthread.
+#define DECLARE_VECTOR_PARALLEL(TYPE)                                                                                           \
+DEFINE_VECTOR_PARALLEL_SORT(TYPE)                                                                                               \
+DEFINE_VECTOR_PARALLEL_FOR_EACH(TYPE)                                                                                           \
+DEFINE_VECTOR_PARALLEL_TRANSFORM(TYPE)                                                                                          \
+DEFINE_VECTOR_PARALLEL_REDUCE(TYPE)
+
+
+// Ranges which are smaller than the grain sizes are processed by a single thread
+#define VECTOR_PARALLEL_GRAIN 4096
+#define VECTOR_PARALLEL_SORT_GRAIN 65536
+
+
+// Sort the elements in the vector in parallel using a custom compare function.
+// Every thread sorts a run of the vector with pattern-defeating quicksort, then the runs are merged in pairs.
+// Every pairwise merge is split in independent parts (by binary searching the merge path) which run in parallel.
+#define DEFINE_VECTOR_PARALLEL_SORT(TYPE)                                                                                            \
+typedef struct {                                                                                                                     \
+    TYPE *src;                                                                                                                       \
+    TYPE *dst;                                                                                                                       \
+    size_t a_begin, a_end;                                                                                                           \
+    size_t b_begin, b_end;                                                                                                           \
+    size_t out;                                                                                                                      \
+    int (*compare)(const TYPE*, const TYPE*);                                                                                        \
+} vector_##TYPE##_merge_task;                                                                                                        \
+                                                                                                                                     \
+static inline void vector_##TYPE##_parallel_sort_run(void *arg) {                                                                    \
+    vector_##TYPE##_merge_task *task = arg;                                                                                          \
+    vector_##TYPE##_pdq_sort(task->src + task->a_begin, task->src + task->a_end, task->compare);                                     \
+}                                                                                                                                    \
+                                                                                                                                     \
+static inline void vector_##TYPE##_parallel_merge_run(void *arg) {                                                                   \
+    vector_##TYPE##_merge_task *task = arg;                                                                                          \
+    int (*compare)(const TYPE*, const TYPE*) = task->compare;                                                                        \
+    TYPE *src = task->src, *out = task->dst + task->out;                                                                             \
+    size_t i = task->a_begin, j = task->b_begin;                                                                                     \
+    while (i < task->a_end && j < task->b_end) {                                                                                     \
+        /* Take the item of the second run only when it is strictly less (stable merge) */                                           \
+        if (compare(&src[j], &src[i]) < 0) {                                                                                         \
+            *out++ = src[j++];                                                                                                       \
+        }                                                                                                                            \
+        else {                                                                                                                       \
+            *out++ = src[i++];                                                                                                       \
+        }                                                                                                                            \
+    }                                                                                                                                \
+    memcpy(out, src + i, (task->a_end - i) * sizeof(TYPE));                                                                          \
+    out += task->a_end - i;                                                                                                          \
+    memcpy(out, src + j, (task->b_end - j) * sizeof(TYPE));                                                                          \
+}                                                                                                                                    \
+                                                                                                                                     \
+/* Number of items of the run a which are among the first diagonal items of the merge of runs a and b */                             \
+static inline size_t vector_##TYPE##_merge_path(TYPE *a, size_t a_size, TYPE *b, size_t b_size, size_t diagonal,                     \
+                                                int (*compare)(const TYPE*, const TYPE*)) {                                          \
+    size_t low = diagonal > b_size ? diagonal - b_size : 0;                                                                          \
+    size_t high = diagonal < a_size ? diagonal : a_size;                                                                             \
+    while (low < high) {                                                                                                             \
+        size_t i = low + (high - low) / 2;                                                                                           \
+        if (compare(&b[diagonal - i - 1], &a[i]) >= 0) {                                                                             \
+            low = i + 1;                                                                                                             \
+        }                                                                                                                            \
+        else {                                                                                                                       \
+            high = i;                                                                                                                \
+        }                                                                                                                            \
+    }                                                                                                                                \
+    return low;                                                                                                                      \
+}                                                                                                                                    \
+                                                                                                                                     \
+static inline void vector_##TYPE##_parallel_sort(vector_##TYPE *vector, int (*compare)(const TYPE*, const TYPE*), ThreadPool pool) { \
+    size_t size = vector->size;                                                                                                      \
+    size_t num_runs = threadpool_size(pool);                                                                                         \
+    if (num_runs > size / VECTOR_PARALLEL_SORT_GRAIN) {                                                                              \
+        num_runs = size / VECTOR_PARALLEL_SORT_GRAIN;                                                                                \
+    }                                                                                                                                \
+    if (num_runs <= 1) {                                                                                                             \
+        vector_##TYPE##_sort(vector, compare);                                                                                       \
+        return;                                                                                                                      \
+    }                                                                                                                                \
+    /* The buffer has the capacity of the vector, so it can replace the array after an odd number of merge rounds */                 \
+    TYPE *buffer = malloc(sizeof(TYPE) * vector->capacity);                                                                          \
+    size_t *bounds = malloc((num_runs + 1) * sizeof(size_t));                                                                        \
+    vector_##TYPE##_merge_task *tasks = malloc(2 * (size_t)threadpool_size(pool) * sizeof(*tasks) + num_runs * sizeof(*tasks));      \
+    if (buffer == NULL || bounds == NULL || tasks == NULL) {                                                                         \
+        free(buffer);                                                                                                                \
+        free(bounds);                                                                                                                \
+        free(tasks);                                                                                                                 \
+        vector_##TYPE##_sort(vector, compare);                                                                                       \
+        return;                                                                                                                      \
+    }                                                                                                                                \
+    /* Sort the runs */                                                                                                              \
+    for (size_t r = 0; r <= num_runs; r++) {                                                                                         \
+        bounds[r] = size * r / num_runs;                                                                                             \
+    }                                                                                                                                \
+    for (size_t r = 0; r < num_runs; r++) {                                                                                          \
+        tasks[r] = (vector_##TYPE##_merge_task){ .src = vector->array, .a_begin = bounds[r], .a_end = bounds[r + 1],                 \
+                                                 .compare = compare };                                                               \
+        threadpool_submit(pool, vector_##TYPE##_parallel_sort_run, &tasks[r]);                                                       \
+    }                                                                                                                                \
+    threadpool_wait(pool);                                                                                                           \
+    /* Merge pairs of runs until a single run is left */                                                                             \
+    TYPE *src = vector->array, *dst = buffer;                                                                                        \
+    while (num_runs > 1) {                                                                                                           \
+        size_t pairs = num_runs / 2;                                                                                                 \
+        size_t parts = (threadpool_size(pool) + pairs - 1) / pairs;                                                                  \
+        size_t num_tasks = 0;                                                                                                        \
+        for (size_t p = 0; p < pairs; p++) {                                                                                         \
+            size_t a_begin = bounds[2 * p], b_begin = bounds[2 * p + 1], b_end = bounds[2 * p + 2];                                  \
+            size_t a_size = b_begin - a_begin, b_size = b_end - b_begin;                                                             \
+            size_t prev_i = 0, prev_diagonal = 0;                                                                                    \
+            for (size_t part = 1; part <= parts; part++) {                                                                           \
+                size_t diagonal = (a_size + b_size) * part / parts;                                                                  \
+                size_t i = part == parts ? a_size : vector_##TYPE##_merge_path(src + a_begin, a_size, src + b_begin, b_size,         \
+                                                                               diagonal, compare);                                   \
+                tasks[num_tasks++] = (vector_##TYPE##_merge_task){ .src = src, .dst = dst,                                           \
+                    .a_begin = a_begin + prev_i, .a_end = a_begin + i,                                                               \
+                    .b_begin = b_begin + (prev_diagonal - prev_i), .b_end = b_begin + (diagonal - i),                                \
+                    .out = a_begin + prev_diagonal, .compare = compare };                                                            \
+                prev_i = i;                                                                                                          \
+                prev_diagonal = diagonal;                                                                                            \
+            }                                                                                                                        \
+        }                                                                                                                            \
+        if (num_runs % 2 == 1) {                                                                                                     \
+            /* The last run has no pair, so it is just copied */                                                                     \
+            size_t last = bounds[num_runs - 1];                                                                                      \
+            tasks[num_tasks++] = (vector_##TYPE##_merge_task){ .src = src, .dst = dst, .a_begin = last, .a_end = size,               \
+                .b_begin = size, .b_end = size, .out = last, .compare = compare };                                                   \
+        }                                                                                                                            \
+        for (size_t t = 0; t < num_tasks; t++) {                                                                                     \
+            threadpool_submit(pool, vector_##TYPE##_parallel_merge_run, &tasks[t]);                                                  \
+        }                                                                                                                            \
+        threadpool_wait(pool);                                                                                                       \
+        for (size_t r = 0; r <= pairs; r++) {                                                                                        \
+            bounds[r] = bounds[2 * r < num_runs ? 2 * r : num_runs];                                                                 \
+        }                                                                                                                            \
+        num_runs = (num_runs + 1) / 2;                                                                                               \
+        bounds[num_runs] = size;                                                                                                     \
+        TYPE *temp = src;                                                                                                            \
+        src = dst;                                                                                                                   \
+        dst = temp;                                                                                                                  \
+    }                                                                                                                                \
+    vector->array = src;                                                                                                             \
+    free(dst);                                                                                                                       \
+    free(bounds);                                                                                                                    \
+    free(tasks);                                                                                                                     \
+}
+
+
+// Call the given function for every item of the vector in parallel
+#define DEFINE_VECTOR_PARALLEL_FOR_EACH(TYPE)                                                                                   \
+typedef struct {                                                                                                                \
+    vector_##TYPE *vector;                                                                                                      \
+    void (*function)(TYPE *);                                                                                                   \
+} vector_##TYPE##_for_each_ctx;                                                                                                 \
+                                                                                                                                \
+static inline void vector_##TYPE##_for_each_range(size_t begin, size_t end, void *arg) {                                        \
+    vector_##TYPE##_for_each_ctx *ctx = arg;                                                                                    \
+    for (size_t i = begin; i < end; i++) {                                                                                      \
+        ctx->function(&ctx->vector->array[i]);                                                                                  \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void vector_##TYPE##_parallel_for_each(vector_##TYPE *vector, void (*function)(TYPE *), ThreadPool pool) {        \
+    vector_##TYPE##_for_each_ctx ctx = { vector, function };                                                                    \
+    threadpool_parallel_for(pool, vector->size, VECTOR_PARALLEL_GRAIN, vector_##TYPE##_for_each_range, &ctx);                   \
+}
+
+
+// Replace every item of the vector with the result of the given function for it, in parallel
+#define DEFINE_VECTOR_PARALLEL_TRANSFORM(TYPE)                                                                                  \
+typedef struct {                                                                                                                \
+    vector_##TYPE *vector;                                                                                                      \
+    TYPE (*function)(TYPE);                                                                                                     \
+} vector_##TYPE##_transform_ctx;                                                                                                \
+                                                                                                                                \
+static inline void vector_##TYPE##_transform_range(size_t begin, size_t end, void *arg) {                                       \
+    vector_##TYPE##_transform_ctx *ctx = arg;                                                                                   \
+    for (size_t i = begin; i < end; i++) {                                                                                      \
+        ctx->vector->array[i] = ctx->function(ctx->vector->array[i]);                                                           \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline void vector_##TYPE##_parallel_transform(vector_##TYPE *vector, TYPE (*function)(TYPE), ThreadPool pool) {         \
+    vector_##TYPE##_transform_ctx ctx = { vector, function };                                                                   \
+    threadpool_parallel_for(pool, vector->size, VECTOR_PARALLEL_GRAIN, vector_##TYPE##_transform_range, &ctx);                  \
+}
+
+
+// Combine all the items of the vector with an associative function, in parallel.
+// Every thread combines a range of items and the results of the ranges are combined in order, starting from initial.
+#define DEFINE_VECTOR_PARALLEL_REDUCE(TYPE)                                                                                     \
+typedef struct {                                                                                                                \
+    vector_##TYPE *vector;                                                                                                      \
+    TYPE (*combine)(TYPE, TYPE);                                                                                                \
+    size_t range_size;                                                                                                          \
+    TYPE *results;                                                                                                              \
+} vector_##TYPE##_reduce_ctx;                                                                                                   \
+                                                                                                                                \
+static inline void vector_##TYPE##_reduce_range(size_t begin, size_t end, void *arg) {                                          \
+    vector_##TYPE##_reduce_ctx *ctx = arg;                                                                                      \
+    for (size_t range = begin; range < end; range++) {                                                                          \
+        size_t first = range * ctx->range_size;                                                                                 \
+        size_t last = first + ctx->range_size < ctx->vector->size ? first + ctx->range_size : ctx->vector->size;                \
+        TYPE result = ctx->vector->array[first];                                                                                \
+        for (size_t i = first + 1; i < last; i++) {                                                                             \
+            result = ctx->combine(result, ctx->vector->array[i]);                                                               \
+        }                                                                                                                       \
+        ctx->results[range] = result;                                                                                           \
+    }                                                                                                                           \
+}                                                                                                                               \
+                                                                                                                                \
+static inline TYPE vector_##TYPE##_parallel_reduce(vector_##TYPE *vector, TYPE initial, TYPE (*combine)(TYPE, TYPE),            \
+                                                   ThreadPool pool) {                                                           \
+    TYPE result = initial;                                                                                                      \
+    if (vector->size == 0) {                                                                                                    \
+        return result;                                                                                                          \
+    }                                                                                                                           \
+    size_t num_ranges = (vector->size + VECTOR_PARALLEL_GRAIN - 1) / VECTOR_PARALLEL_GRAIN;                                     \
+    TYPE *results = malloc(num_ranges * sizeof(TYPE));                                                                          \
+    if (results == NULL) {                                                                                                      \
+        for (size_t i = 0; i < vector->size; i++) {                                                                             \
+            result = combine(result, vector->array[i]);                                                                         \
+        }                                                                                                                       \
+        return result;                                                                                                          \
+    }                                                                                                                           \
+    vector_##TYPE##_reduce_ctx ctx = { vector, combine, VECTOR_PARALLEL_GRAIN, results };                                       \
+    threadpool_parallel_for(pool, num_ranges, 1, vector_##TYPE##_reduce_range, &ctx);                                           \
+    for (size_t range = 0; range < num_ranges; range++) {                                                                       \
+        result = combine(result, results[range]);                                                                               \
+    }                                                                                                                           \
+    free(results);                                                                                                              \
+    return result;                                                                                                              \
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include "acutest/acutest.h"
 #include "../modules/AVLTree/AVLTree.h"
+#include "../modules/ThreadPool/ThreadPool.h"
 
 /* Helper function to create a sample integer value */
 int *create_int(int value) {
@@ -122,11 +123,401 @@ void test_avl_tree_min_max_values() {
     AVLTree_destroy(avl, free);
 }
 
+void test_avl_tree_build_sorted() {
+    int values[100];
+    void *items[100];
+    for (int i = 0; i < 100; i++) {
+        values[i] = 2 * i;
+        items[i] = &values[i];
+    }
+
+    TEST_CHECK(AVLTree_build_sorted(items, 0, compare_ints) == NULL);
+    for (int count = 1; count <= 100; count++) {
+        AVLTree avl = AVLTree_build_sorted(items, count, compare_ints);
+        TEST_CHECK(AVL_count_items(avl) == count);
+        for (int i = 0; i < count; i++) {
+            TEST_CHECK(*(int *)AVLTree_select_k_th_item(avl, i + 1) == 2 * i);
+            TEST_CHECK(!AVLTree_search(avl, &(int){2 * i + 1}, compare_ints));
+        }
+
+        // The heights of the built nodes are used by the rebalancing of later updates
+        for (int i = 0; i < count; i += 2)
+            avl = AVLTree_delete(avl, &values[i], compare_ints, NULL);
+        avl = AVLTree_insert(avl, create_int(-1), compare_ints);
+        TEST_CHECK(*(int *)AVLTree_min_value(avl) == -1);
+        TEST_CHECK(AVL_count_items(avl) == count / 2 + 1);
+        for (int i = 1; i < count; i += 2)
+            TEST_CHECK(AVLTree_search(avl, &values[i], compare_ints));
+        avl = AVLTree_delete(avl, &(int){-1}, compare_ints, free);
+        AVLTree_destroy(avl, NULL);
+    }
+
+    // Items which are not in strictly ascending order are rejected
+    void *unsorted[] = {&values[0], &values[2], &values[1]};
+    TEST_CHECK(AVLTree_build_sorted(unsorted, 3, compare_ints) == NULL);
+    void *duplicates[] = {&values[0], &values[1], &values[1]};
+    TEST_CHECK(AVLTree_build_sorted(duplicates, 3, compare_ints) == NULL);
+}
+
+/* Helpers which check the items of an AVL tree in order */
+int visited[200];
+int visited_count;
+
+void visit_item(void *data) {
+    visited[visited_count++] = *(int *)data;
+}
+
+/* Check that the tree holds exactly the values of [0, 200) for which expected is true */
+bool avl_tree_holds(AVLTree avl, bool *expected) {
+    visited_count = 0;
+    AVLTree_inorder_traversal(avl, visit_item);
+    int count = 0;
+    for (int i = 0; i < 200; i++) {
+        if (expected[i]) {
+            if (count >= visited_count || visited[count] != i)
+                return false;
+            count++;
+        }
+    }
+    return count == visited_count;
+}
+
+/* Check the result of a set operation, and that it is still balanced correctly by updating it */
+bool avl_tree_check_result(AVLTree avl, bool *expected, int *values) {
+    if (!avl_tree_holds(avl, expected))
+        return false;
+    for (int i = 0; i < 200; i += 3) {
+        if (expected[i])
+            avl = AVLTree_delete(avl, &values[i], compare_ints, NULL);
+        else
+            avl = AVLTree_insert(avl, &values[i], compare_ints);
+        expected[i] = !expected[i];
+    }
+    bool valid = avl_tree_holds(avl, expected);
+    AVLTree_destroy(avl, NULL);
+    return valid;
+}
+
+AVLTree avl_tree_from(bool *in_tree, int *values) {
+    AVLTree avl = NULL;
+    for (int i = 0; i < 200; i++)
+        if (in_tree[i])
+            avl = AVLTree_insert(avl, &values[i], compare_ints);
+    return avl;
+}
+
+void test_avl_tree_join_and_split() {
+    int values[200];
+    bool expected[200];
+    for (int i = 0; i < 200; i++)
+        values[i] = i;
+
+    // Join trees of very different heights
+    for (int middle = 0; middle < 200; middle += 13) {
+        AVLTree left = NULL, right = NULL;
+        for (int i = 0; i < middle; i++)
+            left = AVLTree_insert(left, &values[i], compare_ints);
+        for (int i = middle + 1; i < 200; i++)
+            right = AVLTree_insert(right, &values[i], compare_ints);
+        for (int i = 0; i < 200; i++)
+            expected[i] = true;
+        TEST_CHECK(avl_tree_check_result(AVLTree_join(left, &values[middle], right), expected, values));
+    }
+
+    // Split at items which are and which are not in the tree
+    for (int key = 0; key < 200; key += 7) {
+        bool in_tree[200];
+        for (int i = 0; i < 200; i++)
+            in_tree[i] = i % 2 == 0;
+        AVLTree left, right;
+        int *found = AVLTree_split(avl_tree_from(in_tree, values), &values[key], compare_ints, &left, &right);
+        TEST_CHECK((found != NULL) == (key % 2 == 0));
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree[i] && i < key;
+        TEST_CHECK(avl_tree_check_result(left, expected, values));
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree[i] && i > key;
+        TEST_CHECK(avl_tree_check_result(right, expected, values));
+    }
+}
+
+void test_avl_tree_set_operations() {
+    int values[200];
+    bool in_tree1[200], in_tree2[200], expected[200];
+    for (int i = 0; i < 200; i++)
+        values[i] = i;
+    ThreadPool pool = threadpool_create(2);
+
+    srand(11);
+    for (int round = 0; round < 40; round++) {
+        // Trees of different densities, sometimes empty, sequentially and on the pool
+        int density1 = rand() % 101, density2 = rand() % 101;
+        ThreadPool parallel = round % 2 ? pool : NULL;
+        for (int i = 0; i < 200; i++) {
+            in_tree1[i] = rand() % 100 < density1;
+            in_tree2[i] = rand() % 100 < density2;
+        }
+
+        AVLTree result = AVLTree_union(avl_tree_from(in_tree1, values), avl_tree_from(in_tree2, values), compare_ints,
+                                       NULL, parallel);
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree1[i] || in_tree2[i];
+        TEST_CHECK(avl_tree_check_result(result, expected, values));
+
+        result = AVLTree_intersection(avl_tree_from(in_tree1, values), avl_tree_from(in_tree2, values), compare_ints,
+                                      NULL, parallel);
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree1[i] && in_tree2[i];
+        TEST_CHECK(avl_tree_check_result(result, expected, values));
+
+        result = AVLTree_difference(avl_tree_from(in_tree1, values), avl_tree_from(in_tree2, values), compare_ints,
+                                    NULL, parallel);
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree1[i] && !in_tree2[i];
+        TEST_CHECK(avl_tree_check_result(result, expected, values));
+    }
+
+    // The items which are dropped are destroyed (checked by running the tests under valgrind or ASan)
+    AVLTree avl1 = NULL, avl2 = NULL;
+    for (int i = 0; i < 100; i++) {
+        if (i % 2 == 1)
+            avl1 = AVLTree_insert(avl1, create_int(i), compare_ints);
+        if (i % 3 == 0)
+            avl2 = AVLTree_insert(avl2, create_int(i), compare_ints);
+    }
+    AVLTree result = AVLTree_difference(avl1, avl2, compare_ints, free, pool);
+    TEST_CHECK(AVL_count_items(result) == 33);
+    AVLTree_destroy(result, free);
+
+    threadpool_destroy(pool);
+}
+
+void test_avl_tree_iterators() {
+    AVLTree avl = NULL;
+    AVLTreeIterator it;
+    AVLTree_begin(avl, &it);
+    TEST_CHECK(!AVLTree_iterator_valid(&it));
+
+    // Sorted insertions, which make the iterative insertion rebalance on every level
+    int values[1000];
+    for (int i = 0; i < 1000; i++) {
+        values[i] = 2 * i;
+        avl = AVLTree_insert(avl, &values[i], compare_ints);
+    }
+
+    int expected = 0;
+    for (AVLTree_begin(avl, &it); AVLTree_iterator_valid(&it); AVLTree_next(&it)) {
+        TEST_CHECK(*(int *)AVLTree_iterator_data(&it) == expected);
+        expected += 2;
+    }
+    TEST_CHECK(expected == 2000);
+
+    expected = 1998;
+    AVLTree_end(avl, &it);
+    for (AVLTree_prev(&it); AVLTree_iterator_valid(&it); AVLTree_prev(&it)) {
+        TEST_CHECK(*(int *)AVLTree_iterator_data(&it) == expected);
+        expected -= 2;
+    }
+    TEST_CHECK(expected == -2);
+
+    // Range scan over [501, 521), which stops without visiting the rest of the tree
+    int count = 0;
+    for (AVLTree_lower_bound(avl, &(int){501}, compare_ints, &it);
+         AVLTree_iterator_valid(&it) && *(int *)AVLTree_iterator_data(&it) < 521; AVLTree_next(&it))
+        TEST_CHECK(*(int *)AVLTree_iterator_data(&it) == 502 + 2 * count++);
+    TEST_CHECK(count == 10);
+
+    AVLTree_lower_bound(avl, &(int){-5}, compare_ints, &it);
+    TEST_CHECK(*(int *)AVLTree_iterator_data(&it) == 0);
+    AVLTree_lower_bound(avl, &(int){1000}, compare_ints, &it);
+    TEST_CHECK(*(int *)AVLTree_iterator_data(&it) == 1000);
+    AVLTree_lower_bound(avl, &(int){1999}, compare_ints, &it);
+    TEST_CHECK(!AVLTree_iterator_valid(&it));
+    AVLTree_begin(avl, &it);
+    AVLTree_prev(&it);
+    TEST_CHECK(!AVLTree_iterator_valid(&it));
+
+    // Delete the odd positions in sorted order and iterate again
+    for (int i = 1; i < 1000; i += 2) {
+        avl = AVLTree_delete(avl, &values[i], compare_ints, NULL);
+        TEST_CHECK(!AVLTree_search(avl, &values[i], compare_ints));
+    }
+    TEST_CHECK(AVL_count_items(avl) == 500);
+    expected = 0;
+    for (AVLTree_begin(avl, &it); AVLTree_iterator_valid(&it); AVLTree_next(&it)) {
+        TEST_CHECK(*(int *)AVLTree_iterator_data(&it) == expected);
+        expected += 4;
+    }
+    TEST_CHECK(expected == 2000);
+
+    AVLTree_destroy(avl, NULL);
+}
+
+/* Collects the items of a range, and stops after limit items */
+typedef struct {
+    int items[1000];
+    int count;
+    int limit;
+} range_result;
+
+bool collect_item(void *data, void *ctx) {
+    range_result *result = ctx;
+    result->items[result->count++] = *(int *)data;
+    return result->count < result->limit;
+}
+
+void test_avl_tree_range() {
+    AVLTree avl = NULL;
+    range_result result = { .count = 0, .limit = 1000 };
+    TEST_CHECK(AVLTree_range(avl, NULL, NULL, compare_ints, collect_item, &result) == 0);
+
+    int values[1000];
+    for (int i = 0; i < 1000; i++) {
+        values[i] = 2 * i;
+        avl = AVLTree_insert(avl, &values[i], compare_ints);
+    }
+
+    TEST_CHECK(AVLTree_range(avl, &(int){501}, &(int){521}, compare_ints, collect_item, &result) == 10);
+    for (int i = 0; i < result.count; i++)
+        TEST_CHECK(result.items[i] == 502 + 2 * i);
+
+    // The callback stops the range
+    result = (range_result){ .count = 0, .limit = 3 };
+    TEST_CHECK(AVLTree_range(avl, &(int){100}, NULL, compare_ints, collect_item, &result) == 3);
+    TEST_CHECK(result.items[0] == 100 && result.items[2] == 104);
+
+    result = (range_result){ .count = 0, .limit = 1000 };
+    TEST_CHECK(AVLTree_range(avl, NULL, NULL, compare_ints, collect_item, &result) == 1000);
+    result.count = 0;
+    TEST_CHECK(AVLTree_range(avl, NULL, &(int){10}, compare_ints, collect_item, &result) == 5);
+    TEST_CHECK(AVLTree_range(avl, &(int){700}, &(int){700}, compare_ints, collect_item, &result) == 0);
+    TEST_CHECK(AVLTree_range(avl, &(int){5000}, NULL, compare_ints, collect_item, &result) == 0);
+
+    // Batches of 64 items over [100, 1100)
+    void *items[64];
+    int expected = 100;
+    size_t count;
+    AVLTreeIterator it;
+    AVLTree_lower_bound(avl, &(int){100}, compare_ints, &it);
+    while ((count = AVLTree_range_batch(&it, &(int){1100}, compare_ints, items, 64)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            TEST_CHECK(*(int *)items[i] == expected);
+            expected += 2;
+        }
+    }
+    TEST_CHECK(expected == 1100);
+
+    AVLTree_destroy(avl, NULL);
+}
+
+bool count_compact_item(void *data, void *ctx) {
+    TEST_CHECK(*(int *)data > *(int *)ctx);
+    *(int *)ctx = *(int *)data;
+    return true;
+}
+
+void test_compact_avl_tree() {
+    CompactAVLTree tree = AVLTree_compact_create(compare_ints);
+    AVLTree_compact_reserve(tree, 1000);
+    size_t bytes = AVLTree_compact_bytes(tree);
+    TEST_CHECK(bytes >= 1000 * 16);
+
+    // Insert 0, 7, 14, ... in an order which is not sorted
+    int *items[1000];
+    for (int i = 0; i < 1000; i++) {
+        items[i] = malloc(sizeof(int));
+        *items[i] = (i * 367 % 1000) * 7;
+        TEST_CHECK(AVLTree_compact_insert(tree, items[i]));
+    }
+    TEST_CHECK(!AVLTree_compact_insert(tree, &(int){70}));
+    TEST_CHECK(AVLTree_compact_size(tree) == 1000);
+    // The nodes fit in the reserved array, 16 bytes each
+    TEST_CHECK(AVLTree_compact_bytes(tree) == bytes);
+    TEST_CHECK(AVLTree_compact_search(tree, &(int){6993}));
+    TEST_CHECK(!AVLTree_compact_search(tree, &(int){6994}));
+
+    // Delete the multiples of 14, which destroys their items
+    for (int i = 0; i < 1000; i += 2)
+        TEST_CHECK(AVLTree_compact_delete(tree, &(int){i * 7}, free));
+    TEST_CHECK(!AVLTree_compact_delete(tree, &(int){0}, free));
+    TEST_CHECK(AVLTree_compact_size(tree) == 500);
+    int last = -1;
+    TEST_CHECK(AVLTree_compact_range(tree, NULL, NULL, count_compact_item, &last) == 500);
+    TEST_CHECK(last == 6993);
+    last = 100;
+    TEST_CHECK(AVLTree_compact_range(tree, &(int){101}, &(int){200}, count_compact_item, &last) == 7);
+    TEST_CHECK(last == 189);
+
+    // The deleted nodes are reused
+    for (int i = 0; i < 1000; i += 2) {
+        int *item = malloc(sizeof(int));
+        *item = i * 7;
+        TEST_CHECK(AVLTree_compact_insert(tree, item));
+    }
+    TEST_CHECK(AVLTree_compact_size(tree) == 1000);
+    TEST_CHECK(AVLTree_compact_bytes(tree) == bytes);
+
+    AVLTree_compact_destroy(tree, free);
+}
+
+void test_avl_tree_stats() {
+    AVLTree avl = NULL;
+
+    AVLTree_reset_stats();
+    size_t bytes_allocated = AVLTree_get_stats().bytes_allocated;
+
+    // Inserting sorted values needs rotations to keep the tree balanced
+    for (int i = 0; i < 100; i++)
+        avl = AVLTree_insert(avl, create_int(i), compare_ints);
+    TEST_CHECK(AVLTree_search(avl, &(int){50}, compare_ints));
+
+    AVLTree_stats stats = AVLTree_get_stats();
+#ifdef DS_STATS
+    TEST_CHECK(stats.rotations > 0);
+    TEST_CHECK(stats.compares > 0);
+    TEST_CHECK(stats.bytes_allocated > bytes_allocated);
+#else
+    // Without DS_STATS the counters are never updated
+    TEST_CHECK(stats.rotations == 0 && stats.compares == 0 && stats.bytes_allocated == 0);
+#endif
+
+    // Every node is accounted for when it is freed
+    avl = AVLTree_delete(avl, &(int){0}, compare_ints, free);
+    AVLTree_destroy(avl, free);
+    TEST_CHECK(AVLTree_get_stats().bytes_allocated == bytes_allocated);
+
+    // The threads of a parallel set operation update the counters together, and no update is lost
+    AVLTree avl1 = NULL, avl2 = NULL;
+    for (int i = 0; i < 20000; i++) {
+        if (i % 2)
+            avl1 = AVLTree_insert(avl1, create_int(i), compare_ints);
+        else
+            avl2 = AVLTree_insert(avl2, create_int(i), compare_ints);
+    }
+    ThreadPool pool = threadpool_create(4);
+    avl = AVLTree_union(avl1, avl2, compare_ints, free, pool);
+    TEST_CHECK(AVL_count_items(avl) == 20000);
+    AVLTree_destroy(avl, free);
+    threadpool_destroy(pool);
+    TEST_CHECK(AVLTree_get_stats().bytes_allocated == bytes_allocated);
+
+    AVLTree_reset_stats();
+    stats = AVLTree_get_stats();
+    TEST_CHECK(stats.rotations == 0 && stats.compares == 0);
+}
+
 TEST_LIST = {
     {"test_avl_tree_insert_and_search", test_avl_tree_insert_and_search},
     {"test_avl_tree_delete", test_avl_tree_delete},
     {"test_avl_tree_select_k_th_item", test_avl_tree_select_k_th_item},
     {"test_avl_tree_count_items", test_avl_tree_count_items},
     {"test_avl_tree_min_max_values", test_avl_tree_min_max_values},
+    {"test_avl_tree_build_sorted", test_avl_tree_build_sorted},
+    {"test_avl_tree_join_and_split", test_avl_tree_join_and_split},
+    {"test_avl_tree_set_operations", test_avl_tree_set_operations},
+    {"test_avl_tree_iterators", test_avl_tree_iterators},
+    {"test_avl_tree_range", test_avl_tree_range},
+    {"test_compact_avl_tree", test_compact_avl_tree},
+    {"test_avl_tree_stats", test_avl_tree_stats},
     {NULL, NULL} // Terminate the test list
 };
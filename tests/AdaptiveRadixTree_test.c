@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "acutest/acutest.h"
+#include "../modules/AdaptiveRadixTree/AdaptiveRadixTree.h"
+
+
+// Collects the visited keys as NUL-terminated strings
+typedef struct {
+    char keys[64][64];
+    int count;
+    int limit;
+} Visited;
+
+static bool collect(const unsigned char *key, size_t key_len, void *value, void *ctx) {
+    Visited *visited = ctx;
+    memcpy(visited->keys[visited->count], key, key_len);
+    visited->keys[visited->count][key_len] = '\0';
+    visited->count++;
+    return visited->count != visited->limit;
+}
+
+static bool insert_string(ART *art, const char *key, void *value) {
+    return ART_insert(art, key, strlen(key), value);
+}
+
+static void *search_string(ART *art, const char *key) {
+    return ART_search(art, key, strlen(key));
+}
+
+static void test_art_insert_and_search() {
+    ART *art = ART_create(NULL);
+    TEST_CHECK(ART_size(art) == 0);
+    TEST_CHECK(search_string(art, "a") == NULL);
+
+    // Keys which are prefixes of each other, and keys with long shared prefixes
+    const char *keys[] = {"a", "ab", "abc", "abd", "b", "", "http://example.com/index.html",
+                          "http://example.com/images/logo.png", "http://example.com/images/icon.png",
+                          "http://example.org/", "metric.cpu.user", "metric.cpu.system", "metric.memory"};
+    int n = sizeof(keys) / sizeof(keys[0]);
+    int values[13];
+    for (int i = 0; i < n; i++) {
+        values[i] = i;
+        TEST_CHECK(insert_string(art, keys[i], &values[i]));
+    }
+    TEST_CHECK(ART_size(art) == (size_t)n);
+    for (int i = 0; i < n; i++)
+        TEST_CHECK(search_string(art, keys[i]) == &values[i]);
+    TEST_CHECK(search_string(art, "abe") == NULL);
+    TEST_CHECK(search_string(art, "http://example.com/") == NULL);
+    TEST_CHECK(search_string(art, "metric.cpu.user.total") == NULL);
+    TEST_CHECK(search_string(art, "metric") == NULL);
+
+    // Inserting an existing key replaces its value
+    int other = 42;
+    TEST_CHECK(!insert_string(art, "ab", &other));
+    TEST_CHECK(search_string(art, "ab") == &other);
+    TEST_CHECK(ART_size(art) == (size_t)n);
+
+    ART_destroy(art);
+}
+
+static void test_art_grow_and_shrink() {
+    // 256 children under the same node grow it through every node type, and deleting them shrinks it back
+    ART *art = ART_create(NULL);
+    unsigned char key[2] = {'x', 0};
+    for (int b = 0; b < 256; b++) {
+        key[1] = b;
+        TEST_CHECK(ART_insert(art, key, 2, (void *)(intptr_t)(b + 1)));
+    }
+    TEST_CHECK(ART_size(art) == 256);
+    for (int b = 0; b < 256; b++) {
+        key[1] = b;
+        TEST_CHECK(ART_search(art, key, 2) == (void *)(intptr_t)(b + 1));
+    }
+    for (int b = 0; b < 256; b += 2) {
+        key[1] = b;
+        TEST_CHECK(ART_delete(art, key, 2));
+    }
+    TEST_CHECK(!ART_delete(art, key, 2));
+    for (int b = 0; b < 256; b++) {
+        key[1] = b;
+        TEST_CHECK((ART_search(art, key, 2) != NULL) == (b % 2 == 1));
+    }
+    for (int b = 1; b < 256; b += 2) {
+        key[1] = b;
+        TEST_CHECK(ART_delete(art, key, 2));
+    }
+    TEST_CHECK(ART_size(art) == 0);
+    ART_destroy(art);
+}
+
+static void test_art_delete() {
+    ART *art = ART_create(free);
+    const char *keys[] = {"romane", "romanus", "romulus", "rubens", "ruber", "rubicon", "rubicundus", "rom"};
+    for (int i = 0; i < 8; i++) {
+        int *value = malloc(sizeof(int));
+        *value = i;
+        insert_string(art, keys[i], value);
+    }
+    TEST_CHECK(ART_delete(art, "rom", 3));
+    TEST_CHECK(!ART_delete(art, "ro", 2));
+    TEST_CHECK(!ART_delete(art, "romanes", 7));
+    TEST_CHECK(ART_delete(art, "romane", 6));
+    TEST_CHECK(ART_delete(art, "rubicon", 7));
+    TEST_CHECK(ART_size(art) == 5);
+    TEST_CHECK(*(int *)search_string(art, "romanus") == 1);
+    TEST_CHECK(*(int *)search_string(art, "rubicundus") == 6);
+    TEST_CHECK(search_string(art, "rubicon") == NULL);
+
+    // Replaced values are destroyed too (checked by running the tests under valgrind or ASan)
+    int *value = malloc(sizeof(int));
+    *value = 100;
+    TEST_CHECK(!insert_string(art, "ruber", value));
+    TEST_CHECK(*(int *)search_string(art, "ruber") == 100);
+    ART_destroy(art);
+}
+
+static void test_art_iterate() {
+    ART *art = ART_create(NULL);
+    const char *keys[] = {"metric.mem", "b", "metric.cpu.user", "a", "metric.cpu", "ab", "metric.cpu.system"};
+    for (int i = 0; i < 7; i++)
+        insert_string(art, keys[i], NULL);
+
+    // Keys are visited in lexicographic order, shorter keys before the keys which extend them
+    Visited visited = {.count = 0, .limit = -1};
+    ART_iterate(art, collect, &visited);
+    const char *sorted[] = {"a", "ab", "b", "metric.cpu", "metric.cpu.system", "metric.cpu.user", "metric.mem"};
+    TEST_CHECK(visited.count == 7);
+    for (int i = 0; i < 7; i++)
+        TEST_CHECK(strcmp(visited.keys[i], sorted[i]) == 0);
+
+    visited.count = 0;
+    ART_prefix_iterate(art, "metric.cpu", 10, collect, &visited);
+    TEST_CHECK(visited.count == 3);
+    TEST_CHECK(strcmp(visited.keys[0], "metric.cpu") == 0);
+    TEST_CHECK(strcmp(visited.keys[2], "metric.cpu.user") == 0);
+
+    visited.count = 0;
+    ART_prefix_iterate(art, "metric.c", 8, collect, &visited);
+    TEST_CHECK(visited.count == 3);
+    visited.count = 0;
+    ART_prefix_iterate(art, "metric.x", 8, collect, &visited);
+    TEST_CHECK(visited.count == 0);
+
+    // Returning false stops the iteration
+    visited.count = 0;
+    visited.limit = 2;
+    ART_iterate(art, collect, &visited);
+    TEST_CHECK(visited.count == 2);
+
+    ART_destroy(art);
+}
+
+static void test_art_integer_keys() {
+    // Big endian keys are visited in numeric order
+    ART *art = ART_create(NULL);
+    unsigned char key[8];
+    uint64_t numbers[] = {1000000, 5, 1ULL << 40, 255, 256, 0};
+    for (int i = 0; i < 6; i++) {
+        ART_encode_u64(numbers[i], key);
+        ART_insert(art, key, 8, &numbers[i]);
+    }
+    ART_encode_u64(256, key);
+    TEST_CHECK(*(uint64_t *)ART_search(art, key, 8) == 256);
+
+    Visited visited = {.count = 0, .limit = -1};
+    ART_iterate(art, collect, &visited);
+    uint64_t previous = 0;
+    for (int i = 0; i < visited.count; i++) {
+        uint64_t number = 0;
+        for (int j = 0; j < 8; j++)
+            number = (number << 8) | (unsigned char)visited.keys[i][j];
+        TEST_CHECK(i == 0 || number > previous);
+        previous = number;
+    }
+    TEST_CHECK(visited.count == 6);
+    ART_destroy(art);
+}
+
+TEST_LIST = {
+    {"test_art_insert_and_search", test_art_insert_and_search},
+    {"test_art_grow_and_shrink", test_art_grow_and_shrink},
+    {"test_art_delete", test_art_delete},
+    {"test_art_iterate", test_art_iterate},
+    {"test_art_integer_keys", test_art_integer_keys},
+    {NULL, NULL}
+};
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "acutest/acutest.h"
+#include "../modules/Allocator/Allocator.h"
+#include "../modules/Stack/Stack.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+
+
+// Allocator which counts the blocks it has handed out and checks the sizes it gets back
+typedef struct {
+    size_t live;
+    size_t bytes;
+} Counter;
+
+static void *counting_alloc(void *ctx, size_t size) {
+    Counter *counter = ctx;
+    counter->live++;
+    counter->bytes += size;
+    return malloc(size);
+}
+
+static void counting_free(void *ctx, void *ptr, size_t size) {
+    Counter *counter = ctx;
+    counter->live--;
+    counter->bytes -= size;
+    free(ptr);
+}
+
+static int compare_ints(void *a, void *b) {
+    return (*(int *)a) - (*(int *)b);
+}
+
+static void destroy_nothing(void *data) {
+}
+
+static void test_allocator_default() {
+    // A NULL or zeroed allocator means malloc and free
+    int *ptr = allocator_alloc(NULL, sizeof(int));
+    TEST_CHECK(ptr != NULL);
+    allocator_free(NULL, ptr, sizeof(int));
+
+    Allocator allocator = {0};
+    int *array = allocator_calloc(&allocator, 10, sizeof(int));
+    TEST_CHECK(array != NULL);
+    for (int i = 0; i < 10; i++)
+        TEST_CHECK(array[i] == 0);
+    allocator_free(&allocator, array, 10 * sizeof(int));
+}
+
+static void test_arena() {
+    Arena arena = arena_create(256);
+    TEST_CHECK(arena_used(arena) == 0);
+
+    // Every allocation is aligned for any type and they do not overlap
+    char *blocks[100];
+    for (int i = 0; i < 100; i++) {
+        blocks[i] = arena_alloc(arena, 24);
+        TEST_CHECK(blocks[i] != NULL);
+        TEST_CHECK((uintptr_t)blocks[i] % _Alignof(max_align_t) == 0);
+        memset(blocks[i], i, 24);
+    }
+    for (int i = 0; i < 100; i++)
+        TEST_CHECK(blocks[i][0] == i && blocks[i][23] == i);
+
+    // Allocations larger than a block get a block of their own
+    char *large = arena_alloc(arena, 1000);
+    TEST_CHECK(large != NULL);
+    memset(large, 1, 1000);
+    TEST_CHECK(arena_used(arena) >= 100 * 24 + 1000);
+
+    arena_reset(arena);
+    TEST_CHECK(arena_used(arena) == 0);
+    TEST_CHECK(arena_alloc(arena, 16) != NULL);
+
+    arena_destroy(arena);
+}
+
+static void test_slab() {
+    Slab slab = slab_create(20, 8);
+    TEST_CHECK(slab_object_size(slab) >= 20);
+
+    void *objects[50];
+    for (int i = 0; i < 50; i++) {
+        objects[i] = slab_alloc(slab);
+        TEST_CHECK(objects[i] != NULL);
+        memset(objects[i], i, 20);
+    }
+    for (int i = 0; i < 50; i++)
+        TEST_CHECK(((char *)objects[i])[19] == i);
+
+    // Freed objects are reused first
+    slab_free(slab, objects[10]);
+    TEST_CHECK(slab_alloc(slab) == objects[10]);
+
+    // The slab allocator serves larger requests with malloc
+    Allocator allocator = slab_allocator(slab);
+    char *large = allocator_alloc(&allocator, 1000);
+    TEST_CHECK(large != NULL);
+    memset(large, 0, 1000);
+    allocator_free(&allocator, large, 1000);
+
+    slab_destroy(slab);
+}
+
+static void test_allocator_with_stack() {
+    Counter counter = {0, 0};
+    Allocator allocator = { .alloc = counting_alloc, .free = counting_free, .ctx = &counter };
+
+    int values[10];
+    Stack stack = stack_create_with_allocator(NULL, destroy_nothing, &allocator);
+    for (int i = 0; i < 10; i++)
+        stack_push(stack, &values[i]);
+    // The handle and one node per item
+    TEST_CHECK(counter.live == 11);
+
+    stack_pop(stack);
+    TEST_CHECK(counter.live == 10);
+
+    // Every block is given back with the size it was allocated with
+    stack_destroy(stack);
+    TEST_CHECK(counter.live == 0);
+    TEST_CHECK(counter.bytes == 0);
+}
+
+static void test_allocator_with_red_black_tree() {
+    Slab slab = slab_create(64, 16);
+    Allocator allocator = slab_allocator(slab);
+    RBT_set_allocator(&allocator);
+
+    RBTree root = NULL;
+    int values[100];
+    for (int i = 0; i < 100; i++) {
+        values[i] = i;
+        RBT_insert(&root, &values[i], compare_ints);
+    }
+    for (int i = 0; i < 100; i += 2)
+        TEST_CHECK(RBT_delete(&root, &values[i], compare_ints, NULL));
+    for (int i = 0; i < 100; i++)
+        TEST_CHECK(RBT_search(root, &values[i], compare_ints) == (i % 2 == 1));
+    RBT_destroy(root, NULL);
+
+    RBT_set_allocator(NULL);
+    slab_destroy(slab);
+}
+
+TEST_LIST = {
+    {"test_allocator_default", test_allocator_default},
+    {"test_arena", test_arena},
+    {"test_slab", test_slab},
+    {"test_allocator_with_stack", test_allocator_with_stack},
+    {"test_allocator_with_red_black_tree", test_allocator_with_red_black_tree},
+    {NULL, NULL}
+};
@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "acutest/acutest.h"
+// Small nodes, so that a few hundred keys already give a tree with several levels
+#define BTREE_NODE_BYTES 64
+#include "../modules/BTree/btree.h"
+
+
+#define INT_LESS(a, b) ((a) < (b))
+
+DECLARE_BTREE(int, int, INT_LESS)
+
+
+// Check the order of the keys, the fill of the nodes and the sizes of the subtrees, and return the number of items
+static size_t check_node(void *node, size_t level, const int *low, const int *high, bool root) {
+    if (level == 0) {
+        btree_int_int_leaf *leaf = node;
+        TEST_CHECK(root || leaf->count >= btree_int_int_LEAF / 2);
+        for (unsigned int i = 0; i < leaf->count; i++) {
+            TEST_CHECK(low == NULL || leaf->keys[i] >= *low);
+            TEST_CHECK(high == NULL || leaf->keys[i] < *high);
+            TEST_CHECK(i == 0 || leaf->keys[i - 1] < leaf->keys[i]);
+        }
+        return leaf->count;
+    }
+    btree_int_int_inner *inner = node;
+    TEST_CHECK(inner->count <= btree_int_int_INNER);
+    TEST_CHECK(root ? inner->count >= 1 : inner->count >= btree_int_int_INNER / 2);
+    size_t total = 0;
+    for (unsigned int i = 0; i <= inner->count; i++) {
+        size_t size = check_node(inner->children[i], level - 1, i > 0 ? &inner->keys[i - 1] : low,
+                                 i < inner->count ? &inner->keys[i] : high, false);
+        TEST_CHECK(size == inner->sizes[i]);
+        total += size;
+    }
+    return total;
+}
+
+static void check_tree(btree_int_int *tree) {
+    TEST_CHECK(check_node(tree->root, tree->height, NULL, NULL, true) == btree_int_int_size(tree));
+    size_t count = 0;
+    for (btree_int_int_leaf *leaf = tree->first; leaf != NULL; leaf = leaf->next) {
+        TEST_CHECK(leaf->next != NULL ? leaf->next->prev == leaf : tree->last == leaf);
+        count += leaf->count;
+    }
+    TEST_CHECK(count == btree_int_int_size(tree));
+}
+
+static void sum_keys(int key, int *value, void *ctx) {
+    *(long *)ctx += key;
+}
+
+static void test_btree_insert_and_search() {
+    btree_int_int *tree = btree_int_int_create();
+    TEST_CHECK(btree_int_int_empty(tree));
+    TEST_CHECK(btree_int_int_search(tree, 1) == NULL);
+
+    // Insert the keys 0, 2, ..., 1998 in a scrambled order
+    for (int i = 0; i < 1000; i++)
+        TEST_CHECK(btree_int_int_insert(tree, (i * 379) % 1000 * 2, i));
+    TEST_CHECK(btree_int_int_size(tree) == 1000);
+    TEST_CHECK(btree_int_int_height(tree) > 1);
+    check_tree(tree);
+
+    for (int i = 0; i < 1000; i++) {
+        int *value = btree_int_int_search(tree, (i * 379) % 1000 * 2);
+        TEST_CHECK(value != NULL && *value == i);
+        TEST_CHECK(!btree_int_int_contains(tree, 2 * i + 1));
+    }
+
+    // Inserting an existing key replaces its value
+    TEST_CHECK(!btree_int_int_insert(tree, 10, -1));
+    TEST_CHECK(*btree_int_int_search(tree, 10) == -1);
+    TEST_CHECK(btree_int_int_size(tree) == 1000);
+
+    btree_int_int_free(tree);
+}
+
+static void test_btree_remove() {
+    btree_int_int *tree = btree_int_int_create();
+    for (int i = 0; i < 1000; i++)
+        btree_int_int_insert(tree, i, i);
+
+    // Remove every key which is not a multiple of 3, checking the tree along the way
+    for (int i = 0; i < 1000; i++) {
+        int key = (i * 617) % 1000;
+        if (key % 3 != 0)
+            TEST_CHECK(btree_int_int_remove(tree, key));
+        if (i % 100 == 0)
+            check_tree(tree);
+    }
+    TEST_CHECK(!btree_int_int_remove(tree, 1));
+    TEST_CHECK(btree_int_int_size(tree) == 334);
+    check_tree(tree);
+    for (int i = 0; i < 1000; i++)
+        TEST_CHECK(btree_int_int_contains(tree, i) == (i % 3 == 0));
+
+    // Removing everything shrinks the tree back to a single leaf
+    for (int i = 0; i < 1000; i += 3)
+        TEST_CHECK(btree_int_int_remove(tree, i));
+    TEST_CHECK(btree_int_int_empty(tree));
+    TEST_CHECK(btree_int_int_height(tree) == 0);
+    TEST_CHECK(!btree_int_int_iterator_valid(btree_int_int_begin(tree)));
+
+    btree_int_int_free(tree);
+}
+
+static void test_btree_build_sorted() {
+    int keys[1000], values[1000];
+    for (int i = 0; i < 1000; i++) {
+        keys[i] = 2 * i;
+        values[i] = -i;
+    }
+    for (size_t count = 0; count <= 1000; count += 125) {
+        btree_int_int *tree = btree_int_int_build_sorted(keys, values, count, NULL);
+        TEST_CHECK(tree != NULL);
+        TEST_CHECK(btree_int_int_size(tree) == count);
+        check_tree(tree);
+        for (size_t i = 0; i < count; i++)
+            TEST_CHECK(*btree_int_int_search(tree, keys[i]) == values[i]);
+
+        // The tree stays valid when it is modified after the bulk load
+        for (size_t i = 0; i < count; i += 4)
+            btree_int_int_remove(tree, keys[i]);
+        for (size_t i = 0; i < count; i += 3)
+            btree_int_int_insert(tree, keys[i] + 1, 0);
+        check_tree(tree);
+        btree_int_int_free(tree);
+    }
+
+    // Keys which are not strictly ascending are rejected
+    keys[10] = keys[11];
+    TEST_CHECK(btree_int_int_build_sorted(keys, values, 1000, NULL) == NULL);
+}
+
+static void test_btree_select_and_range() {
+    btree_int_int *tree = btree_int_int_create();
+    for (int i = 0; i < 500; i++)
+        btree_int_int_insert(tree, (i * 211) % 500 * 2, i);
+
+    // The k-th item (starting at 1) has the key 2 * (k - 1)
+    for (size_t k = 1; k <= 500; k++) {
+        btree_int_int_iterator it = btree_int_int_select_k_th_item(tree, k);
+        TEST_CHECK(btree_int_int_iterator_valid(it));
+        TEST_CHECK(btree_int_int_iterator_key(it) == 2 * ((int)k - 1));
+    }
+    TEST_CHECK(!btree_int_int_iterator_valid(btree_int_int_select_k_th_item(tree, 0)));
+    TEST_CHECK(!btree_int_int_iterator_valid(btree_int_int_select_k_th_item(tree, 501)));
+
+    // Iterate from a lower bound to the end through the linked leaves
+    int expected = 100;
+    for (btree_int_int_iterator it = btree_int_int_lower_bound(tree, 99); btree_int_int_iterator_valid(it);
+         it = btree_int_int_iterator_next(it)) {
+        TEST_CHECK(btree_int_int_iterator_key(it) == expected);
+        expected += 2;
+    }
+    TEST_CHECK(expected == 1000);
+    TEST_CHECK(!btree_int_int_iterator_valid(btree_int_int_lower_bound(tree, 999)));
+
+    // range visits [low, high)
+    long sum = 0;
+    btree_int_int_range(tree, 10, 20, sum_keys, &sum);
+    TEST_CHECK(sum == 10 + 12 + 14 + 16 + 18);
+    sum = 0;
+    btree_int_int_for_each(tree, sum_keys, &sum);
+    TEST_CHECK(sum == 2L * (499 * 500 / 2));
+
+    *btree_int_int_iterator_value(btree_int_int_begin(tree)) = 42;
+    TEST_CHECK(*btree_int_int_search(tree, 0) == 42);
+    btree_int_int_free(tree);
+}
+
+// Allocator which fails once its budget of allocations is used up
+static void *limited_alloc(void *ctx, size_t size) {
+    int *budget = ctx;
+    if (*budget == 0)
+        return NULL;
+    (*budget)--;
+    return malloc(size);
+}
+
+static void limited_free(void *ctx, void *ptr, size_t size) {
+    free(ptr);
+}
+
+static void test_btree_allocation_failure() {
+    int budget = -1;
+    Allocator allocator = {limited_alloc, limited_free, &budget};
+    btree_int_int *tree = btree_int_int_create_with_allocator(&allocator);
+    srand(11);
+    for (int i = 0; i < 3000; i++) {
+        int key = (i * 7919) % 3000;
+        // Some inserts may allocate fewer nodes than their splits need, and they must leave the tree unchanged
+        if (i % 13 == 0) {
+            budget = rand() % 3;
+            if (!btree_int_int_insert(tree, key, key)) {
+                TEST_CHECK(btree_int_int_search(tree, key) == NULL);
+                TEST_CHECK(btree_int_int_size(tree) == (size_t)i);
+                check_tree(tree);
+            }
+            budget = -1;
+        }
+        if (btree_int_int_search(tree, key) == NULL)
+            TEST_CHECK(btree_int_int_insert(tree, key, key));
+    }
+    TEST_CHECK(btree_int_int_size(tree) == 3000);
+    check_tree(tree);
+    for (int key = 0; key < 3000; key++)
+        TEST_CHECK(btree_int_int_search(tree, key) != NULL && *btree_int_int_search(tree, key) == key);
+    btree_int_int_free(tree);
+}
+
+TEST_LIST = {
+    {"test_btree_insert_and_search", test_btree_insert_and_search},
+    {"test_btree_remove", test_btree_remove},
+    {"test_btree_build_sorted", test_btree_build_sorted},
+    {"test_btree_select_and_range", test_btree_select_and_range},
+    {"test_btree_allocation_failure", test_btree_allocation_failure},
+    {NULL, NULL}
+};
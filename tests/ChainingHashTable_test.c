@@ -114,8 +114,206 @@ static void test_separate_chaining_hash_table_remove() {
 }
 
 
+static void test_separate_chaining_hash_table_size() {
+    SCHashtable *hash_table = SChashtable_create(compare_strings, mock_print, NULL, NULL, DJB2_hash);
+    int values[] = {100, 200};
+
+    SChashtable_insert(hash_table, "key1", &values[0]);
+    SChashtable_insert(hash_table, "key2", &values[0]);
+    TEST_CHECK(SChashtable_size(hash_table) == 2);
+
+    // Replacing the value of an existing key does not add an item
+    SChashtable_insert(hash_table, "key1", &values[1]);
+    TEST_CHECK(SChashtable_size(hash_table) == 2);
+    TEST_CHECK(*(int *)SChashtable_search(hash_table, "key1") == 200);
+
+    // Removing a key which does not exist does not remove an item
+    SChashtable_remove(hash_table, "key3");
+    TEST_CHECK(SChashtable_size(hash_table) == 2);
+    SChashtable_remove(hash_table, "key1");
+    TEST_CHECK(SChashtable_size(hash_table) == 1);
+
+    SChashtable_destroy(hash_table);
+}
+
+
+static void test_separate_chaining_hash_table_stats() {
+    SCHashtable *hash_table = SChashtable_create(compare_strings, mock_print, free, NULL, DJB2_hash);
+    char key[16];
+
+    // Insert enough items to resize the table and search all of them
+    for (int i = 0; i < 100; i++) {
+        sprintf(key, "key%d", i);
+        char *key_copy = malloc(strlen(key) + 1);
+        strcpy(key_copy, key);
+        SChashtable_insert(hash_table, key_copy, NULL);
+    }
+    for (int i = 0; i < 100; i++) {
+        sprintf(key, "key%d", i);
+        SChashtable_remove(hash_table, key);
+    }
+    TEST_CHECK(SChashtable_search(hash_table, "key0") == NULL);
+
+    SChashtable_stats stats = SChashtable_get_stats(hash_table);
+    TEST_CHECK(stats.bytes_allocated > 0);
+#ifdef DS_STATS
+    TEST_CHECK(stats.operations == 201);
+    // Every remove finds its key, so it walks at least one node
+    TEST_CHECK(stats.nodes_walked >= 100);
+    TEST_CHECK(stats.longest_walk >= 1 && stats.longest_walk <= stats.nodes_walked);
+    TEST_CHECK(stats.resizes > 0);
+
+    SChashtable_reset_stats(hash_table);
+    stats = SChashtable_get_stats(hash_table);
+#endif
+    // Without DS_STATS the counters are never updated
+    TEST_CHECK(stats.operations == 0 && stats.nodes_walked == 0 && stats.longest_walk == 0 && stats.resizes == 0);
+
+    SChashtable_destroy(hash_table);
+}
+
+
+static void test_separate_chaining_hash_table_search_batch() {
+    SCHashtable *hash_table = SChashtable_create(compare_strings, mock_print, free, NULL, DJB2_hash);
+    int count = 1000, values[1000];
+    char (*names)[16] = malloc(2 * count * sizeof(*names));
+    void **keys = malloc(2 * count * sizeof(void *));
+    void **found = malloc(2 * count * sizeof(void *));
+
+    // Every other key is inserted, so half of the lookups miss, and the buckets have chains after the resizes
+    for (int i = 0; i < count; i += 2) {
+        char *key = malloc(16);
+        sprintf(key, "key%d", i);
+        values[i] = i;
+        SChashtable_insert(hash_table, key, &values[i]);
+    }
+    // The number of keys is not a multiple of the group size, and some keys are repeated
+    for (int i = 0; i < 2 * count - 5; i++) {
+        sprintf(names[i], "key%d", (i * 3) % count);
+        keys[i] = names[i];
+    }
+    SChashtable_search_batch(hash_table, keys, 2 * count - 5, found);
+    for (int i = 0; i < 2 * count - 5; i++) {
+        int id = (i * 3) % count;
+        TEST_CHECK(found[i] == SChashtable_search(hash_table, keys[i]));
+        TEST_CHECK(id % 2 == 0 ? found[i] == &values[id] : found[i] == NULL);
+    }
+
+    free(names);
+    free(keys);
+    free(found);
+    SChashtable_destroy(hash_table);
+}
+
+
+static size_t hash_calls, compare_calls;
+
+// Keys 2k and 2k + 1 have the same hash, so the compare function must still tell them apart
+static size_t counting_hash(void *key) {
+    hash_calls++;
+    return (size_t)(*(int *)key / 2);
+}
+
+static int counting_compare(void *a, void *b) {
+    compare_calls++;
+    return *(int *)a - *(int *)b;
+}
+
+static void test_separate_chaining_hash_table_cached_hash() {
+    SCHashtable *hash_table = SChashtable_create(counting_compare, mock_print, NULL, NULL, counting_hash);
+    int keys[2000];
+    hash_calls = 0;
+    // The table resizes many times, but the hash of every key is computed only when it is inserted
+    for (int i = 0; i < 2000; i++) {
+        keys[i] = i;
+        SChashtable_insert(hash_table, &keys[i], &keys[i]);
+    }
+    TEST_CHECK(hash_calls == 2000);
+    TEST_CHECK(SChashtable_size(hash_table) == 2000);
+
+    // Only the node with the same key and its twin with the same hash can be compared
+    for (int i = 0; i < 2000; i++) {
+        compare_calls = 0;
+        TEST_CHECK(SChashtable_search(hash_table, &keys[i]) == &keys[i]);
+        TEST_CHECK(compare_calls >= 1 && compare_calls <= 2);
+    }
+    int missing = 5000;
+    compare_calls = 0;
+    TEST_CHECK(SChashtable_search(hash_table, &missing) == NULL);
+    TEST_CHECK(compare_calls == 0);
+
+    // The batched search and remove use the stored hashes as well
+    void *lookups[4] = {&keys[10], &keys[11], &missing, &keys[1999]};
+    void *found[4];
+    compare_calls = 0;
+    SChashtable_search_batch(hash_table, lookups, 4, found);
+    TEST_CHECK(found[0] == &keys[10] && found[1] == &keys[11] && found[2] == NULL && found[3] == &keys[1999]);
+    TEST_CHECK(compare_calls <= 6);
+    for (int i = 0; i < 2000; i += 2)
+        SChashtable_remove(hash_table, &keys[i]);
+    TEST_CHECK(SChashtable_size(hash_table) == 1000);
+    for (int i = 0; i < 2000; i++)
+        TEST_CHECK(SChashtable_search(hash_table, &keys[i]) == (i % 2 == 0 ? NULL : &keys[i]));
+
+    SChashtable_destroy(hash_table);
+}
+
+
+static void test_separate_chaining_hash_table_shrink_and_reserve() {
+    SCHashtable *hash_table = SChashtable_create(counting_compare, mock_print, NULL, NULL, counting_hash);
+    int *keys = malloc(10000 * sizeof(int));
+    size_t empty_bytes = SChashtable_get_stats(hash_table).bytes_allocated, bytes = 0;
+    for (int i = 0; i < 10000; i++) {
+        keys[i] = i;
+        SChashtable_insert(hash_table, &keys[i], &keys[i]);
+        if (i == 9)
+            bytes = SChashtable_get_stats(hash_table).bytes_allocated;
+    }
+
+    // Removing most of the keys gives the buckets back (down to the capacity of the table with 10 items), and
+    // shrinking does not hash the keys again
+    hash_calls = 0;
+    for (int i = 10; i < 10000; i++)
+        SChashtable_remove(hash_table, &keys[i]);
+    TEST_CHECK(hash_calls == 9990);
+    TEST_CHECK(SChashtable_get_stats(hash_table).bytes_allocated == bytes);
+    for (int i = 0; i < 10000; i++)
+        TEST_CHECK(SChashtable_search(hash_table, &keys[i]) == (i < 10 ? &keys[i] : NULL));
+    for (int i = 0; i < 10; i++)
+        SChashtable_remove(hash_table, &keys[i]);
+    TEST_CHECK(SChashtable_get_stats(hash_table).bytes_allocated == empty_bytes);
+
+    // After a reserve the bulk load does not resize the table, and removing the keys does not shrink it
+    SChashtable_reserve(hash_table, 10000);
+    bytes = SChashtable_get_stats(hash_table).bytes_allocated;
+    SChashtable_reset_stats(hash_table);
+    for (int i = 0; i < 10000; i++)
+        SChashtable_insert(hash_table, &keys[i], &keys[i]);
+    TEST_CHECK(SChashtable_size(hash_table) == 10000);
+    for (int i = 0; i < 10000; i++)
+        SChashtable_remove(hash_table, &keys[i]);
+    TEST_CHECK(SChashtable_size(hash_table) == 0);
+    TEST_CHECK(SChashtable_get_stats(hash_table).bytes_allocated == bytes);
+    TEST_CHECK(SChashtable_get_stats(hash_table).resizes == 0);
+
+    // Without the reserve the empty table shrinks to its first capacity with the next remove
+    SChashtable_reserve(hash_table, 0);
+    SChashtable_insert(hash_table, &keys[0], &keys[0]);
+    SChashtable_remove(hash_table, &keys[0]);
+    TEST_CHECK(SChashtable_get_stats(hash_table).bytes_allocated == empty_bytes);
+
+    free(keys);
+    SChashtable_destroy(hash_table);
+}
+
+
 TEST_LIST = {
     {"test_separate_chaining_hash_table_insert_and_search", test_separate_chaining_hash_table_insert_and_search},
     {"test_separate_chaining_hash_table_remove", test_separate_chaining_hash_table_remove},
+    {"test_separate_chaining_hash_table_size", test_separate_chaining_hash_table_size},
+    {"test_separate_chaining_hash_table_stats", test_separate_chaining_hash_table_stats},
+    {"test_separate_chaining_hash_table_search_batch", test_separate_chaining_hash_table_search_batch},
+    {"test_separate_chaining_hash_table_cached_hash", test_separate_chaining_hash_table_cached_hash},
+    {"test_separate_chaining_hash_table_shrink_and_reserve", test_separate_chaining_hash_table_shrink_and_reserve},
     {NULL, NULL}
 };
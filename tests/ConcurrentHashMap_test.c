@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "acutest/acutest.h"
+#include "../modules/ConcurrentHashMap/ConcurrentHashMap.h"
+
+
+#define THREADS 8
+#define KEYS_PER_THREAD 5000
+
+
+static int compare_ints(void *a, void *b) {
+    return *(int *)a - *(int *)b;
+}
+
+static size_t hash_int(void *key) {
+    return (size_t)*(int *)key;
+}
+
+static atomic_int computed;
+
+static void *compute_square(void *key, void *ctx) {
+    atomic_fetch_add(&computed, 1);
+    int *value = malloc(sizeof(int));
+    *value = *(int *)key * *(int *)key;
+    return value;
+}
+
+static void *compute_nothing(void *key, void *ctx) {
+    return NULL;
+}
+
+static void read_value(void *value, void *ctx) {
+    *(int *)ctx = *(int *)value;
+}
+
+
+static void test_concurrent_hash_map_operations() {
+    ConcurrentHashMap *map = CHM_create(5, compare_ints, NULL, NULL, hash_int);
+    TEST_CHECK(CHM_shards(map) == 8);
+    int keys[100], values[100];
+    for (int i = 0; i < 100; i++) {
+        keys[i] = i;
+        values[i] = 10 * i;
+        CHM_put(map, &keys[i], &values[i]);
+    }
+    TEST_CHECK(CHM_size(map) == 100);
+    for (int i = 0; i < 100; i++)
+        TEST_CHECK(CHM_get(map, &keys[i]) == &values[i]);
+
+    // Replacing a value does not add a key
+    CHM_put(map, &keys[7], &values[8]);
+    TEST_CHECK(CHM_size(map) == 100);
+    int value = 0;
+    TEST_CHECK(CHM_get_with(map, &keys[7], read_value, &value) && value == 80);
+
+    for (int i = 0; i < 100; i += 2)
+        TEST_CHECK(CHM_remove(map, &keys[i]));
+    TEST_CHECK(!CHM_remove(map, &keys[0]));
+    TEST_CHECK(CHM_size(map) == 50);
+    TEST_CHECK(CHM_get(map, &keys[0]) == NULL);
+    TEST_CHECK(!CHM_get_with(map, &keys[0], read_value, &value));
+
+    // compute_if_absent only computes the missing keys, and a NULL result is not inserted
+    atomic_store(&computed, 0);
+    int key = 1;
+    TEST_CHECK(CHM_compute_if_absent(map, &key, compute_square, NULL) == &values[1]);
+    TEST_CHECK(CHM_compute_if_absent(map, &keys[0], compute_nothing, NULL) == NULL);
+    TEST_CHECK(CHM_size(map) == 50);
+    TEST_CHECK(atomic_load(&computed) == 0);
+    CHM_destroy(map);
+
+    // 16 shards per online processor by default
+    map = CHM_create(0, compare_ints, NULL, NULL, hash_int);
+    TEST_CHECK(CHM_shards(map) >= 16);
+    CHM_destroy(map);
+}
+
+
+typedef struct {
+    ConcurrentHashMap *map;
+    int *keys;
+    int thread;
+    int failures;   // The checks of the threads are counted here, since TEST_CHECK is not thread safe
+} worker_args;
+
+// Every thread puts its own keys (which makes the shards resize while the other threads use them), reads the keys of
+// all the threads and removes half of its own keys
+static void *put_and_remove(void *arg) {
+    worker_args *args = arg;
+    int *keys = args->keys + args->thread * KEYS_PER_THREAD;
+    for (int i = 0; i < KEYS_PER_THREAD; i++)
+        CHM_put(args->map, &keys[i], &keys[i]);
+    for (int i = 0; i < THREADS * KEYS_PER_THREAD; i++) {
+        int *value = CHM_get(args->map, &args->keys[i]);
+        args->failures += value != NULL && value != &args->keys[i];
+    }
+    for (int i = 0; i < KEYS_PER_THREAD; i += 2)
+        args->failures += !CHM_remove(args->map, &keys[i]);
+    return NULL;
+}
+
+// Every thread asks for the same keys, so compute_if_absent races for each of them
+static void *compute_all(void *arg) {
+    worker_args *args = arg;
+    for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        int k = (i + args->thread * 37) % KEYS_PER_THREAD;
+        int *value = CHM_compute_if_absent(args->map, &args->keys[k], compute_square, NULL);
+        args->failures += value == NULL || *value != k * k;
+    }
+    return NULL;
+}
+
+static void run_threads(void *(*worker)(void *), ConcurrentHashMap *map, int *keys) {
+    pthread_t threads[THREADS];
+    worker_args args[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        args[t] = (worker_args){map, keys, t, 0};
+        pthread_create(&threads[t], NULL, worker, &args[t]);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        TEST_CHECK(args[t].failures == 0);
+    }
+}
+
+static void test_concurrent_hash_map_threads() {
+    int *keys = malloc(THREADS * KEYS_PER_THREAD * sizeof(int));
+    for (int i = 0; i < THREADS * KEYS_PER_THREAD; i++)
+        keys[i] = i;
+
+    ConcurrentHashMap *map = CHM_create(4, compare_ints, NULL, NULL, hash_int);
+    run_threads(put_and_remove, map, keys);
+    TEST_CHECK(CHM_size(map) == THREADS * KEYS_PER_THREAD / 2);
+    for (int i = 0; i < THREADS * KEYS_PER_THREAD; i++)
+        TEST_CHECK(CHM_get(map, &keys[i]) == (i % KEYS_PER_THREAD % 2 == 0 ? NULL : &keys[i]));
+    CHM_destroy(map);
+
+    // Every key is computed exactly once, whichever thread gets it first
+    map = CHM_create(16, compare_ints, NULL, free, hash_int);
+    atomic_store(&computed, 0);
+    run_threads(compute_all, map, keys);
+    TEST_CHECK(atomic_load(&computed) == KEYS_PER_THREAD);
+    TEST_CHECK(CHM_size(map) == KEYS_PER_THREAD);
+    CHM_destroy(map);
+    free(keys);
+}
+
+
+TEST_LIST = {
+    {"test_concurrent_hash_map_operations", test_concurrent_hash_map_operations},
+    {"test_concurrent_hash_map_threads", test_concurrent_hash_map_threads},
+    {NULL, NULL}
+};
@@ -127,8 +127,288 @@ void test_hash_table_collision() {
     DHhashtable_destroy(table);
 }
 
+void test_hash_table_stats() {
+    DHHashtable *table = DHhashtable_create(compare_test_data, NULL, free, NULL, SDBM_hash, h1);
+    TestData probe;
+
+    // Insert enough items to resize the table, search all of them and remove half of them
+    for (int i = 1; i <= 100; i++) {
+        TestData *data = create_test_data(i, "Item");
+        DHhashtable_insert(table, &data->id, data);
+    }
+    for (probe.id = 1; probe.id <= 100; probe.id++)
+        TEST_CHECK(DHhashtable_search(table, &probe.id) != NULL);
+    for (probe.id = 1; probe.id <= 50; probe.id++)
+        TEST_CHECK(DHhashtable_remove(table, &probe.id) == true);
+
+    // Searching the removed items walks over their tombstones
+    for (probe.id = 1; probe.id <= 50; probe.id++)
+        TEST_CHECK(DHhashtable_search(table, &probe.id) == NULL);
+
+    DHhashtable_stats stats = DHhashtable_get_stats(table);
+    TEST_CHECK(stats.bytes_allocated > 0);
+#ifdef DS_STATS
+    TEST_CHECK(stats.operations == 300);
+    TEST_CHECK(stats.probes >= stats.operations);
+    TEST_CHECK(stats.compares >= 150);
+    TEST_CHECK(stats.tombstones >= 50);
+    TEST_CHECK(stats.resizes > 0);
+
+    DHhashtable_reset_stats(table);
+    stats = DHhashtable_get_stats(table);
+#endif
+    // Without DS_STATS the counters are never updated
+    TEST_CHECK(stats.operations == 0 && stats.probes == 0 && stats.tombstones == 0);
+    TEST_CHECK(stats.compares == 0 && stats.resizes == 0);
+
+    DHhashtable_destroy(table);
+}
+
+void test_hash_table_search_batch() {
+    DHHashtable *table = DHhashtable_create(compare_test_data, NULL, free, NULL, SDBM_hash, h1);
+    int count = 1000;
+    TestData *probes = malloc(2 * count * sizeof(TestData));
+    void **keys = malloc(2 * count * sizeof(void *));
+    void **values = malloc(2 * count * sizeof(void *));
+
+    // The even ids are inserted and half of them removed again, so the batch walks over tombstones and misses
+    for (int i = 0; i < count; i += 2) {
+        TestData *data = create_test_data(i, "Item");
+        DHhashtable_insert(table, &data->id, data);
+    }
+    for (int i = 0; i < count; i += 4) {
+        TestData probe = {.id = i};
+        TEST_CHECK(DHhashtable_remove(table, &probe.id) == true);
+    }
+    // The number of keys is not a multiple of the group size, and some keys are repeated
+    for (int i = 0; i < 2 * count - 3; i++) {
+        probes[i].id = (i * 7) % count;
+        keys[i] = &probes[i].id;
+    }
+    DHhashtable_search_batch(table, keys, 2 * count - 3, values);
+    for (int i = 0; i < 2 * count - 3; i++) {
+        TEST_CHECK(values[i] == DHhashtable_search(table, keys[i]));
+        TEST_CHECK((values[i] != NULL) == (probes[i].id % 4 == 2));
+        TEST_CHECK(values[i] == NULL || ((TestData *)values[i])->id == probes[i].id);
+    }
+
+    // An empty batch does nothing
+    DHhashtable_search_batch(table, keys, 0, values);
+
+    free(probes);
+    free(keys);
+    free(values);
+    DHhashtable_destroy(table);
+}
+
+static size_t hash_int(void *key) {
+    return (size_t)(*(int *)key * 2654435761u);
+}
+
+// Robin Hood tables with a weak hash, so the probe sequences of many keys overlap and wrap around the table
+static size_t hash_int_weak(void *key) {
+    return (size_t)(*(int *)key / 8);
+}
+
+void test_hash_table_robin_hood() {
+    HashFunc hashes[] = {hash_int, hash_int_weak};
+    for (int h = 0; h < 2; h++) {
+        DHHashtable *table = DHhashtable_create_robin_hood(compare_test_data, NULL, free, NULL, hashes[h], NULL);
+        int count = 2000;
+        bool *present = calloc(count, sizeof(bool));
+        TestData probe;
+        // A replaced value is destroyed but the key which is in the table is kept, so the keys are not in the values
+        TestData *ids = malloc(count * sizeof(TestData));
+        for (int i = 0; i < count; i++)
+            ids[i].id = i;
+
+        // Random inserts (which replace the values of existing keys) and removes, checked against an array
+        srand(42);
+        size_t size = 0;
+        for (int i = 0; i < 20000; i++) {
+            int id = rand() % count;
+            if (rand() % 3 != 0) {
+                DHhashtable_insert(table, &ids[id], create_test_data(id, "Item"));
+                size += !present[id];
+                present[id] = true;
+            }
+            else {
+                probe.id = id;
+                TEST_CHECK(DHhashtable_remove(table, &probe.id) == present[id]);
+                size -= present[id];
+                present[id] = false;
+            }
+        }
+        TEST_CHECK(DHhashtable_size(table) == size);
+        for (probe.id = 0; probe.id < count; probe.id++) {
+            TestData *found = DHhashtable_search(table, &probe.id);
+            TEST_CHECK(present[probe.id] ? found != NULL && found->id == probe.id : found == NULL);
+        }
+
+        // The batched search takes the same probe sequences
+        void *keys[100], *values[100];
+        int lookups[100];
+        for (int i = 0; i < 100; i++) {
+            lookups[i] = rand() % count;
+            keys[i] = &lookups[i];
+        }
+        DHhashtable_search_batch(table, keys, 100, values);
+        for (int i = 0; i < 100; i++)
+            TEST_CHECK(values[i] == DHhashtable_search(table, keys[i]));
+
+        for (probe.id = 0; probe.id < count; probe.id++)
+            TEST_CHECK(DHhashtable_remove(table, &probe.id) == present[probe.id]);
+        TEST_CHECK(DHhashtable_size(table) == 0);
+        free(present);
+        free(ids);
+        DHhashtable_destroy(table);
+    }
+}
+
+void test_hash_table_churn() {
+    // Removes leave no tombstones in the Robin Hood mode, so inserting and removing keys at a steady size does not
+    // grow the table. The keys of the table stay in [i, i + 100) while i goes up to 100000
+    DHHashtable *table = DHhashtable_create_robin_hood(compare_test_data, NULL, free, NULL, hash_int, NULL);
+    TestData probe;
+    for (int i = 0; i < 100; i++) {
+        TestData *data = create_test_data(i, "Item");
+        DHhashtable_insert(table, &data->id, data);
+    }
+    size_t bytes = DHhashtable_get_stats(table).bytes_allocated;
+    DHhashtable_reset_stats(table);
+    for (int i = 0; i < 100000; i++) {
+        probe.id = i;
+        TEST_CHECK(DHhashtable_remove(table, &probe.id) == true);
+        TestData *data = create_test_data(i + 100, "Item");
+        DHhashtable_insert(table, &data->id, data);
+    }
+    TEST_CHECK(DHhashtable_size(table) == 100);
+    TEST_CHECK(DHhashtable_get_stats(table).bytes_allocated == bytes);
+    for (probe.id = 100000; probe.id < 100100; probe.id++)
+        TEST_CHECK(DHhashtable_search(table, &probe.id) != NULL);
+#ifdef DS_STATS
+    TEST_CHECK(DHhashtable_get_stats(table).tombstones == 0);
+    TEST_CHECK(DHhashtable_get_stats(table).resizes == 0);
+#endif
+    DHhashtable_destroy(table);
+}
+
+static int compare_ints(void *a, void *b) {
+    return *(int *)a - *(int *)b;
+}
+
+void test_hash_table_shrink() {
+    int *keys = malloc(10000 * sizeof(int));
+    for (int i = 0; i < 10000; i++)
+        keys[i] = i;
+    for (int mode = 0; mode < 2; mode++) {
+        DHHashtable *table = mode == 0 ? DHhashtable_create(compare_ints, NULL, NULL, NULL, hash_int, hash_int_weak)
+                                       : DHhashtable_create_robin_hood(compare_ints, NULL, NULL, NULL, hash_int, NULL);
+        size_t empty_bytes = DHhashtable_get_stats(table).bytes_allocated;
+        for (int i = 0; i < 10000; i++)
+            DHhashtable_insert(table, &keys[i], &keys[i]);
+        size_t peak_bytes = DHhashtable_get_stats(table).bytes_allocated;
+
+        // Removing most of the keys gives the memory back
+        for (int i = 10; i < 10000; i++)
+            TEST_CHECK(DHhashtable_remove(table, &keys[i]));
+        size_t bytes = DHhashtable_get_stats(table).bytes_allocated;
+        TEST_CHECK(bytes < peak_bytes / 10);
+        TEST_CHECK(DHhashtable_size(table) == 10);
+        for (int i = 0; i < 10000; i++)
+            TEST_CHECK(DHhashtable_search(table, &keys[i]) == (i < 10 ? &keys[i] : NULL));
+
+        // A key which is inserted and removed again and again does not resize the table
+        for (int i = 0; i < 1000; i++) {
+            DHhashtable_insert(table, &keys[5000], &keys[5000]);
+            DHhashtable_remove(table, &keys[5000]);
+        }
+        TEST_CHECK(DHhashtable_get_stats(table).bytes_allocated == bytes);
+
+        // The table never shrinks below its first capacity
+        for (int i = 0; i < 10; i++)
+            DHhashtable_remove(table, &keys[i]);
+        TEST_CHECK(DHhashtable_get_stats(table).bytes_allocated == empty_bytes);
+        DHhashtable_destroy(table);
+    }
+    free(keys);
+}
+
+void test_hash_table_reserve() {
+    int *keys = malloc(10000 * sizeof(int));
+    for (int i = 0; i < 10000; i++)
+        keys[i] = i;
+    for (int mode = 0; mode < 2; mode++) {
+        DHHashtable *table = mode == 0 ? DHhashtable_create(compare_ints, NULL, NULL, NULL, hash_int, hash_int_weak)
+                                       : DHhashtable_create_robin_hood(compare_ints, NULL, NULL, NULL, hash_int, NULL);
+        size_t empty_bytes = DHhashtable_get_stats(table).bytes_allocated;
+        DHhashtable_reserve(table, 10000);
+        size_t bytes = DHhashtable_get_stats(table).bytes_allocated;
+        TEST_CHECK(bytes > empty_bytes);
+        DHhashtable_reset_stats(table);
+
+        // The bulk load does not resize the table, and removing the keys does not shrink it below the reserve
+        for (int i = 0; i < 10000; i++)
+            DHhashtable_insert(table, &keys[i], &keys[i]);
+        TEST_CHECK(DHhashtable_get_stats(table).bytes_allocated == bytes);
+        for (int i = 0; i < 10000; i++)
+            DHhashtable_remove(table, &keys[i]);
+        TEST_CHECK(DHhashtable_get_stats(table).bytes_allocated == bytes);
+        TEST_CHECK(DHhashtable_get_stats(table).resizes == 0);
+
+        // A smaller reserve lifts the limit, so the next remove shrinks the empty table
+        DHhashtable_reserve(table, 0);
+        DHhashtable_insert(table, &keys[0], &keys[0]);
+        DHhashtable_remove(table, &keys[0]);
+        TEST_CHECK(DHhashtable_get_stats(table).bytes_allocated == empty_bytes);
+        DHhashtable_destroy(table);
+    }
+    free(keys);
+}
+
+void test_hash_table_compact() {
+    int *keys = malloc(2000 * sizeof(int));
+    for (int i = 0; i < 2000; i++)
+        keys[i] = i;
+    // With the weak first hash many keys share their probe sequences, so items are swapped while they are placed
+    HashFunc hashes[] = {hash_int, hash_int_weak};
+    for (int h = 0; h < 2; h++) {
+        DHHashtable *table = DHhashtable_create(compare_ints, NULL, NULL, NULL, hashes[h], hash_int);
+        DHhashtable_reserve(table, 2000);
+        for (int i = 0; i < 2000; i++)
+            DHhashtable_insert(table, &keys[i], &keys[i]);
+        for (int i = 0; i < 2000; i += 2)
+            DHhashtable_remove(table, &keys[i]);
+        size_t bytes = DHhashtable_get_stats(table).bytes_allocated;
+
+        DHhashtable_compact(table);
+        DHhashtable_reset_stats(table);
+        TEST_CHECK(DHhashtable_size(table) == 1000);
+        TEST_CHECK(DHhashtable_get_stats(table).bytes_allocated == bytes);
+        for (int i = 0; i < 2000; i++)
+            TEST_CHECK(DHhashtable_search(table, &keys[i]) == (i % 2 == 0 ? NULL : &keys[i]));
+        TEST_CHECK(DHhashtable_get_stats(table).tombstones == 0);
+
+        // The table works as before after the compaction
+        for (int i = 0; i < 2000; i += 2)
+            DHhashtable_insert(table, &keys[i], &keys[i]);
+        TEST_CHECK(DHhashtable_size(table) == 2000);
+        for (int i = 0; i < 2000; i++)
+            TEST_CHECK(DHhashtable_search(table, &keys[i]) == &keys[i]);
+        DHhashtable_destroy(table);
+    }
+    free(keys);
+}
+
 TEST_LIST = {
     {"test_hash_table_operations", test_hash_table_operations},
     {"test_hash_table_collision", test_hash_table_collision},
+    {"test_hash_table_stats", test_hash_table_stats},
+    {"test_hash_table_search_batch", test_hash_table_search_batch},
+    {"test_hash_table_robin_hood", test_hash_table_robin_hood},
+    {"test_hash_table_churn", test_hash_table_churn},
+    {"test_hash_table_shrink", test_hash_table_shrink},
+    {"test_hash_table_reserve", test_hash_table_reserve},
+    {"test_hash_table_compact", test_hash_table_compact},
     {NULL, NULL} // marks the end of the test list
 };
\ No newline at end of file
@@ -83,7 +83,34 @@ void test_double_linked_list_operations() {
     DLL_freelist(head, tail, destroy_test_data);
 }
 
+void test_double_linked_list_remove() {
+    Listptr head = NULL;
+    Listptr tail = NULL;
+    DLL_Create(&head, &tail);
+
+    TestData *data[6];
+    for (int i = 0; i < 6; i++) {
+        data[i] = create_test_data(i, "Item");
+        DLL_AddLast(&tail, &head, data[i]);
+    }
+
+    // Remove a middle item, the last item and the first item
+    DLL_Remove(&head, &tail, data[3], compare_test_data, destroy_test_data);
+    DLL_Remove(&head, &tail, data[5], compare_test_data, destroy_test_data);
+    DLL_Remove(&head, &tail, data[0], compare_test_data, destroy_test_data);
+    TEST_CHECK(DLL_Size(head, tail) == 3);
+    TEST_CHECK(DLL_GetFirst(head) == data[1]);
+    TEST_CHECK(DLL_GetLast(tail) == data[4]);
+    TEST_CHECK(DLL_GetNode(head, data[2], compare_test_data) != NULL);
+
+    // Free a list with an even number of items
+    DLL_Remove(&head, &tail, data[2], compare_test_data, destroy_test_data);
+    TEST_CHECK(DLL_Size(head, tail) == 2);
+    DLL_freelist(head, tail, destroy_test_data);
+}
+
 TEST_LIST = {
     {"test_double_linked_list_operations", test_double_linked_list_operations},
+    {"test_double_linked_list_remove", test_double_linked_list_remove},
     {NULL, NULL} // marks the end of the test list
 };
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "acutest/acutest.h"
+#include "../modules/HashMap/hashmap.h"
+
+
+typedef const char *string;
+
+#define U64_HASH(key) hashmap_hash_u64(key)
+#define U64_EQ(a, b) ((a) == (b))
+#define STRING_HASH(key) hashmap_hash_string(key)
+#define STRING_EQ(a, b) (strcmp((a), (b)) == 0)
+// A hash which sends every key to the same slot, so every operation walks one long probe sequence
+#define CONSTANT_HASH(key) ((void)(key), (size_t)0)
+
+DECLARE_HASHMAP(uint64_t, uint32_t, U64_HASH, U64_EQ)
+DECLARE_HASHMAP(string, int, STRING_HASH, STRING_EQ)
+DECLARE_HASHMAP(int, int, CONSTANT_HASH, U64_EQ)
+
+
+static void sum_values(uint64_t key, uint32_t *value, void *ctx) {
+    *(uint64_t *)ctx += *value;
+}
+
+static void test_hashmap_put_and_get() {
+    hashmap_uint64_t_uint32_t *map = hashmap_uint64_t_uint32_t_create(0);
+    TEST_CHECK(map != NULL);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_size(map) == 0);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_get(map, 1) == NULL);
+
+    // The map grows many times while the keys are inserted
+    for (uint64_t i = 0; i < 10000; i++)
+        TEST_CHECK(hashmap_uint64_t_uint32_t_put(map, i * 7919, (uint32_t)i));
+    TEST_CHECK(hashmap_uint64_t_uint32_t_size(map) == 10000);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_capacity(map) >= 10000);
+
+    for (uint64_t i = 0; i < 10000; i++) {
+        uint32_t *value = hashmap_uint64_t_uint32_t_get(map, i * 7919);
+        TEST_CHECK(value != NULL && *value == i);
+    }
+    TEST_CHECK(!hashmap_uint64_t_uint32_t_contains(map, 1));
+
+    // Putting an existing key replaces its value
+    TEST_CHECK(!hashmap_uint64_t_uint32_t_put(map, 7919, 42));
+    TEST_CHECK(*hashmap_uint64_t_uint32_t_get(map, 7919) == 42);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_size(map) == 10000);
+
+    // Values can be changed through the returned pointer
+    *hashmap_uint64_t_uint32_t_get(map, 0) = 5;
+    TEST_CHECK(*hashmap_uint64_t_uint32_t_get(map, 0) == 5);
+
+    hashmap_uint64_t_uint32_t_free(map);
+}
+
+static void test_hashmap_remove() {
+    hashmap_uint64_t_uint32_t *map = hashmap_uint64_t_uint32_t_create(100);
+    size_t capacity = hashmap_uint64_t_uint32_t_capacity(map);
+    for (uint64_t i = 0; i < 100; i++)
+        hashmap_uint64_t_uint32_t_put(map, i, (uint32_t)i);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_capacity(map) == capacity);
+
+    for (uint64_t i = 0; i < 100; i += 2)
+        TEST_CHECK(hashmap_uint64_t_uint32_t_remove(map, i));
+    TEST_CHECK(!hashmap_uint64_t_uint32_t_remove(map, 0));
+    TEST_CHECK(hashmap_uint64_t_uint32_t_size(map) == 50);
+
+    // The keys which were shifted back by the removals can still be found
+    for (uint64_t i = 0; i < 100; i++)
+        TEST_CHECK(hashmap_uint64_t_uint32_t_contains(map, i) == (i % 2 == 1));
+
+    uint64_t sum = 0;
+    hashmap_uint64_t_uint32_t_for_each(map, sum_values, &sum);
+    TEST_CHECK(sum == 2500);
+
+    hashmap_uint64_t_uint32_t_clear(map);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_size(map) == 0);
+    TEST_CHECK(!hashmap_uint64_t_uint32_t_contains(map, 1));
+
+    hashmap_uint64_t_uint32_t_free(map);
+}
+
+static void test_hashmap_collisions() {
+    hashmap_int_int *map = hashmap_int_int_create(0);
+    for (int i = 0; i < 200; i++)
+        hashmap_int_int_put(map, i, -i);
+
+    // Remove keys from the middle of the single probe sequence and check that the rest can still be found
+    for (int i = 50; i < 150; i++)
+        TEST_CHECK(hashmap_int_int_remove(map, i));
+    for (int i = 0; i < 200; i++) {
+        int *value = hashmap_int_int_get(map, i);
+        TEST_CHECK((value != NULL) == (i < 50 || i >= 150));
+        if (value != NULL)
+            TEST_CHECK(*value == -i);
+    }
+    TEST_CHECK(hashmap_int_int_size(map) == 100);
+    hashmap_int_int_free(map);
+}
+
+static void test_hashmap_strings() {
+    hashmap_string_int *map = hashmap_string_int_create(0);
+    const char *words[] = {"alpha", "beta", "gamma", "delta", "epsilon"};
+    for (int i = 0; i < 5; i++)
+        hashmap_string_int_put(map, words[i], i);
+
+    // Keys are compared with EQ, so a different pointer to the same string finds the key
+    char key[16];
+    strcpy(key, "gamma");
+    TEST_CHECK(*hashmap_string_int_get(map, key) == 2);
+    TEST_CHECK(hashmap_string_int_get(map, "zeta") == NULL);
+    hashmap_string_int_free(map);
+}
+
+static void test_hashmap_reserve() {
+    hashmap_uint64_t_uint32_t *map = hashmap_uint64_t_uint32_t_create(0);
+    hashmap_uint64_t_uint32_t_reserve(map, 1000);
+    size_t capacity = hashmap_uint64_t_uint32_t_capacity(map);
+    TEST_CHECK(capacity >= 1000);
+    TEST_CHECK((capacity & (capacity - 1)) == 0);
+
+    for (uint64_t i = 0; i < 1000; i++)
+        hashmap_uint64_t_uint32_t_put(map, i, (uint32_t)i);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_capacity(map) == capacity);
+    TEST_CHECK(hashmap_uint64_t_uint32_t_memory(map) ==
+               sizeof(*map) + capacity * (1 + sizeof(uint64_t) + sizeof(uint32_t)));
+    hashmap_uint64_t_uint32_t_free(map);
+}
+
+TEST_LIST = {
+    {"test_hashmap_put_and_get", test_hashmap_put_and_get},
+    {"test_hashmap_remove", test_hashmap_remove},
+    {"test_hashmap_collisions", test_hashmap_collisions},
+    {"test_hashmap_strings", test_hashmap_strings},
+    {"test_hashmap_reserve", test_hashmap_reserve},
+    {NULL, NULL}
+};
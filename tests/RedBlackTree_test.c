@@ -2,6 +2,13 @@
 #include <stdlib.h>
 #include "acutest/acutest.h"
 #include "../modules/RedBlackTree/RedBlackTree.h"
+#include "../modules/RedBlackTree/rbtree.h"
+#include "../modules/ThreadPool/ThreadPool.h"
+
+
+#define INT_LESS(a, b) ((a) < (b))
+
+DECLARE_RBTREE(int, int, INT_LESS)
 
 static int compare_ints(void *a, void *b) {
     return (*(int *)a) - (*(int *)b);
@@ -60,6 +67,42 @@ static void test_red_black_tree_delete() {
 }
 
 
+static void test_red_black_tree_delete_all() {
+    RBTree root = NULL;
+    int size = 10000;
+    int *values = malloc(size * sizeof(int));
+    for (int i = 0; i < size; i++)
+        values[i] = (i * 7919) % size;
+
+    for (int i = 0; i < size; i++)
+        RBT_insert(&root, (void *)&values[i], compare_ints);
+    TEST_CHECK(RBT_count_items(root) == size);
+
+    // Delete the items in a different order than they were inserted
+    int found = 1;
+    for (int i = 0; i < size; i++) {
+        int value = (i * 4273) % size;
+        found &= RBT_delete(&root, (void *)&value, compare_ints, NULL);
+        found &= !RBT_search(root, (void *)&value, compare_ints);
+        if (i % 1000 == 0)
+            found &= (RBT_count_items(root) == size - i - 1);
+    }
+    TEST_CHECK(found);
+    TEST_CHECK(RBT_empty(root));
+
+    // Deleting from the tree which has just been emptied, and from a tree which never had items, finds nothing
+    int value = 0;
+    TEST_CHECK(!RBT_delete(&root, (void *)&value, compare_ints, NULL));
+    TEST_CHECK(RBT_empty(root));
+    RBTree empty = NULL;
+    TEST_CHECK(!RBT_delete(&empty, (void *)&value, compare_ints, NULL));
+    TEST_CHECK(empty == NULL);
+
+    free(values);
+    RBT_destroy(root, NULL);
+}
+
+
 static void test_red_black_tree_select_k_th_item() {
     RBTree root = NULL;
     int values[] = {5, 10, 3, 15, 7};
@@ -117,12 +160,621 @@ static void test_red_black_tree_min_and_max_values() {
 }
 
 
+static void test_red_black_tree_build_sorted() {
+    int values[100];
+    void *items[100];
+    for (int i = 0; i < 100; i++) {
+        values[i] = 2 * i;
+        items[i] = &values[i];
+    }
+
+    TEST_CHECK(RBT_build_sorted(items, 0, compare_ints) == NULL);
+    for (int count = 1; count <= 100; count++) {
+        RBTree root = RBT_build_sorted(items, count, compare_ints);
+        TEST_CHECK(RBT_count_items(root) == count);
+        for (int i = 0; i < count; i++) {
+            TEST_CHECK(*(int *)RBT_select_k_th_item(root, i + 1) == 2 * i);
+            TEST_CHECK(!RBT_search(root, &(int){2 * i + 1}, compare_ints));
+        }
+
+        // The colors and the parents of the built nodes are used by the fix ups of later updates
+        int odd[100];
+        for (int i = 0; i < count; i++) {
+            odd[i] = 2 * i + 1;
+            RBT_insert(&root, &odd[i], compare_ints);
+        }
+        for (int i = 0; i < count; i += 2)
+            TEST_CHECK(RBT_delete(&root, &values[i], compare_ints, NULL));
+        TEST_CHECK(RBT_count_items(root) == count + count / 2);
+        for (int i = 1; i < count; i += 2)
+            TEST_CHECK(RBT_search(root, &values[i], compare_ints));
+        TEST_CHECK(*(int *)RBT_max_value(root) == 2 * count - 1);
+        RBT_destroy(root, NULL);
+    }
+
+    // Items which are not in strictly ascending order are rejected
+    void *unsorted[] = {&values[0], &values[2], &values[1]};
+    TEST_CHECK(RBT_build_sorted(unsorted, 3, compare_ints) == NULL);
+    void *duplicates[] = {&values[0], &values[1], &values[1]};
+    TEST_CHECK(RBT_build_sorted(duplicates, 3, compare_ints) == NULL);
+}
+
+
+// Items of the trees which are visited in order
+static int visited[200];
+static int visited_count;
+
+static void visit_item(void *data) {
+    visited[visited_count++] = *(int *)data;
+}
+
+// Check that the tree holds exactly the values of [0, 200) for which expected is true
+static bool red_black_tree_holds(RBTree root, bool *expected) {
+    visited_count = 0;
+    RBT_inorder_traversal(root, visit_item);
+    int count = 0;
+    for (int i = 0; i < 200; i++) {
+        if (expected[i]) {
+            if (count >= visited_count || visited[count] != i)
+                return false;
+            count++;
+        }
+    }
+    return count == visited_count;
+}
+
+// Check the result of a set operation, and that it is still a valid red black tree by updating it
+static bool red_black_tree_check_result(RBTree root, bool *expected, int *values) {
+    if (!red_black_tree_holds(root, expected))
+        return false;
+    for (int i = 0; i < 200; i += 3) {
+        if (expected[i])
+            RBT_delete(&root, &values[i], compare_ints, NULL);
+        else
+            RBT_insert(&root, &values[i], compare_ints);
+        expected[i] = !expected[i];
+    }
+    bool valid = red_black_tree_holds(root, expected);
+    RBT_destroy(root, NULL);
+    return valid;
+}
+
+static RBTree red_black_tree_from(bool *in_tree, int *values) {
+    RBTree root = NULL;
+    for (int i = 0; i < 200; i++)
+        if (in_tree[i])
+            RBT_insert(&root, &values[i], compare_ints);
+    return root;
+}
+
+
+static void test_red_black_tree_join_and_split() {
+    int values[200];
+    bool expected[200];
+    for (int i = 0; i < 200; i++)
+        values[i] = i;
+
+    // Join trees of very different sizes
+    for (int middle = 0; middle < 200; middle += 13) {
+        RBTree left = NULL, right = NULL;
+        for (int i = 0; i < middle; i++)
+            RBT_insert(&left, &values[i], compare_ints);
+        for (int i = middle + 1; i < 200; i++)
+            RBT_insert(&right, &values[i], compare_ints);
+        for (int i = 0; i < 200; i++)
+            expected[i] = true;
+        TEST_CHECK(red_black_tree_check_result(RBT_join(left, &values[middle], right), expected, values));
+    }
+
+    // Split at items which are and which are not in the tree
+    for (int key = 0; key < 200; key += 7) {
+        bool in_tree[200];
+        for (int i = 0; i < 200; i++)
+            in_tree[i] = i % 2 == 0;
+        RBTree left, right;
+        int *found = RBT_split(red_black_tree_from(in_tree, values), &values[key], compare_ints, &left, &right);
+        TEST_CHECK((found != NULL) == (key % 2 == 0));
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree[i] && i < key;
+        TEST_CHECK(red_black_tree_check_result(left, expected, values));
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree[i] && i > key;
+        TEST_CHECK(red_black_tree_check_result(right, expected, values));
+    }
+}
+
+
+static void test_red_black_tree_set_operations() {
+    int values[200];
+    bool in_tree1[200], in_tree2[200], expected[200];
+    for (int i = 0; i < 200; i++)
+        values[i] = i;
+    ThreadPool pool = threadpool_create(2);
+
+    srand(7);
+    for (int round = 0; round < 40; round++) {
+        // Trees of different densities, sometimes empty, sequentially and on the pool
+        int density1 = rand() % 101, density2 = rand() % 101;
+        ThreadPool parallel = round % 2 ? pool : NULL;
+        for (int i = 0; i < 200; i++) {
+            in_tree1[i] = rand() % 100 < density1;
+            in_tree2[i] = rand() % 100 < density2;
+        }
+
+        RBTree result = RBT_union(red_black_tree_from(in_tree1, values), red_black_tree_from(in_tree2, values),
+                                  compare_ints, NULL, parallel);
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree1[i] || in_tree2[i];
+        TEST_CHECK(red_black_tree_check_result(result, expected, values));
+
+        result = RBT_intersection(red_black_tree_from(in_tree1, values), red_black_tree_from(in_tree2, values),
+                                  compare_ints, NULL, parallel);
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree1[i] && in_tree2[i];
+        TEST_CHECK(red_black_tree_check_result(result, expected, values));
+
+        result = RBT_difference(red_black_tree_from(in_tree1, values), red_black_tree_from(in_tree2, values),
+                                compare_ints, NULL, parallel);
+        for (int i = 0; i < 200; i++)
+            expected[i] = in_tree1[i] && !in_tree2[i];
+        TEST_CHECK(red_black_tree_check_result(result, expected, values));
+    }
+
+    // The items which are dropped are destroyed (checked by running the tests under valgrind or ASan)
+    RBTree root1 = NULL, root2 = NULL;
+    for (int i = 0; i < 100; i++) {
+        if (i % 2 == 1) {
+            int *item = malloc(sizeof(int));
+            *item = i;
+            RBT_insert(&root1, item, compare_ints);
+        }
+        if (i % 3 == 0) {
+            int *item = malloc(sizeof(int));
+            *item = i;
+            RBT_insert(&root2, item, compare_ints);
+        }
+    }
+    RBTree result = RBT_intersection(root1, root2, compare_ints, free, pool);
+    TEST_CHECK(RBT_count_items(result) == 17);
+    RBT_destroy(result, free);
+
+    threadpool_destroy(pool);
+}
+
+
+static void test_red_black_tree_iterators() {
+    RBTree root = NULL;
+    TEST_CHECK(!RBT_iterator_valid(RBT_begin(root)));
+    TEST_CHECK(!RBT_iterator_valid(RBT_prev(RBT_end(root))));
+
+    int values[1000];
+    for (int i = 0; i < 1000; i++) {
+        values[i] = 2 * i;
+        RBT_insert(&root, &values[i], compare_ints);
+    }
+    // Inserting an item which is already in the tree does not change it
+    RBT_insert(&root, &(int){10}, compare_ints);
+    TEST_CHECK(RBT_count_items(root) == 1000);
+
+    int expected = 0;
+    for (RBTIterator it = RBT_begin(root); RBT_iterator_valid(it); it = RBT_next(it)) {
+        TEST_CHECK(*(int *)RBT_iterator_data(it) == expected);
+        expected += 2;
+    }
+    TEST_CHECK(expected == 2000);
+
+    expected = 1998;
+    for (RBTIterator it = RBT_prev(RBT_end(root)); RBT_iterator_valid(it); it = RBT_prev(it)) {
+        TEST_CHECK(*(int *)RBT_iterator_data(it) == expected);
+        expected -= 2;
+    }
+    TEST_CHECK(expected == -2);
+
+    // Range scan over [501, 521), which stops without visiting the rest of the tree
+    int count = 0;
+    for (RBTIterator it = RBT_lower_bound(root, &(int){501}, compare_ints);
+         RBT_iterator_valid(it) && *(int *)RBT_iterator_data(it) < 521; it = RBT_next(it))
+        TEST_CHECK(*(int *)RBT_iterator_data(it) == 502 + 2 * count++);
+    TEST_CHECK(count == 10);
+
+    TEST_CHECK(*(int *)RBT_iterator_data(RBT_lower_bound(root, &(int){-5}, compare_ints)) == 0);
+    TEST_CHECK(*(int *)RBT_iterator_data(RBT_lower_bound(root, &(int){1000}, compare_ints)) == 1000);
+    TEST_CHECK(!RBT_iterator_valid(RBT_lower_bound(root, &(int){1999}, compare_ints)));
+    TEST_CHECK(!RBT_iterator_valid(RBT_prev(RBT_begin(root))));
+    TEST_CHECK(!RBT_iterator_valid(RBT_next(RBT_end(root))));
+
+    // Delete the odd positions and iterate again
+    for (int i = 1; i < 1000; i += 2)
+        TEST_CHECK(RBT_delete(&root, &values[i], compare_ints, NULL));
+    expected = 0;
+    for (RBTIterator it = RBT_begin(root); RBT_iterator_valid(it); it = RBT_next(it)) {
+        TEST_CHECK(*(int *)RBT_iterator_data(it) == expected);
+        expected += 4;
+    }
+    TEST_CHECK(expected == 2000);
+    RBT_destroy(root, NULL);
+
+    // The end stays valid while inserts rebalance the tree and change its root
+    RBTree small = NULL;
+    int items[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    for (int i = 0; i < 3; i++)
+        RBT_insert(&small, &items[i], compare_ints);
+    RBTIterator end = RBT_end(small);
+    RBTree old_root = small;
+    for (int i = 3; i < 10; i++)
+        RBT_insert(&small, &items[i], compare_ints);
+    TEST_CHECK(small != old_root);
+    TEST_CHECK(*(int *)RBT_iterator_data(RBT_prev(end)) == 10);
+    RBT_destroy(small, NULL);
+}
+
+/* Collects the items of a range, and stops after limit items */
+typedef struct {
+    int items[1000];
+    int count;
+    int limit;
+} range_result;
+
+static bool collect_item(void *data, void *ctx) {
+    range_result *result = ctx;
+    result->items[result->count++] = *(int *)data;
+    return result->count < result->limit;
+}
+
+static void test_red_black_tree_range() {
+    RBTree root = NULL;
+    range_result result = { .count = 0, .limit = 1000 };
+    TEST_CHECK(RBT_range(root, NULL, NULL, compare_ints, collect_item, &result) == 0);
+
+    int values[1000];
+    for (int i = 0; i < 1000; i++) {
+        values[i] = 2 * i;
+        RBT_insert(&root, &values[i], compare_ints);
+    }
+
+    TEST_CHECK(RBT_range(root, &(int){501}, &(int){521}, compare_ints, collect_item, &result) == 10);
+    for (int i = 0; i < result.count; i++)
+        TEST_CHECK(result.items[i] == 502 + 2 * i);
+
+    // The callback stops the range
+    result = (range_result){ .count = 0, .limit = 3 };
+    TEST_CHECK(RBT_range(root, &(int){100}, NULL, compare_ints, collect_item, &result) == 3);
+    TEST_CHECK(result.items[0] == 100 && result.items[2] == 104);
+
+    result = (range_result){ .count = 0, .limit = 1000 };
+    TEST_CHECK(RBT_range(root, NULL, NULL, compare_ints, collect_item, &result) == 1000);
+    result.count = 0;
+    TEST_CHECK(RBT_range(root, NULL, &(int){10}, compare_ints, collect_item, &result) == 5);
+    TEST_CHECK(RBT_range(root, &(int){700}, &(int){700}, compare_ints, collect_item, &result) == 0);
+    TEST_CHECK(RBT_range(root, &(int){5000}, NULL, compare_ints, collect_item, &result) == 0);
+
+    // Batches of 64 items over [100, 1100)
+    void *items[64];
+    int expected = 100;
+    size_t count;
+    RBTIterator it = RBT_lower_bound(root, &(int){100}, compare_ints);
+    while ((count = RBT_range_batch(&it, &(int){1100}, compare_ints, items, 64)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            TEST_CHECK(*(int *)items[i] == expected);
+            expected += 2;
+        }
+    }
+    TEST_CHECK(expected == 1100);
+
+    RBT_destroy(root, NULL);
+}
+
+static bool sum_persistent_item(void *data, void *ctx) {
+    *(long *)ctx += *(int *)data;
+    return true;
+}
+
+static void test_persistent_red_black_tree() {
+    int values[1000];
+    PRBTree versions[1001];
+    versions[0] = NULL;
+    for (int i = 0; i < 1000; i++) {
+        values[i] = i;
+        versions[i + 1] = PRBT_insert(versions[i], &values[i], compare_ints);
+    }
+    // Every version still holds exactly the items which were inserted before it
+    for (int i = 100; i < 1000; i += 100) {
+        TEST_CHECK(PRBT_count_items(versions[i]) == (size_t)i);
+        TEST_CHECK(PRBT_search(versions[i], &values[i - 1], compare_ints));
+        TEST_CHECK(!PRBT_search(versions[i], &values[i], compare_ints));
+    }
+
+    // Updates which do not change the tree return the same root
+    PRBTree same = PRBT_insert(versions[1000], &values[10], compare_ints);
+    TEST_CHECK(same == versions[1000]);
+    PRBT_release(same);
+    same = PRBT_delete(versions[500], &values[700], compare_ints);
+    TEST_CHECK(same == versions[500]);
+    PRBT_release(same);
+
+    // Delete the even items from the last version
+    PRBTree snapshot = PRBT_retain(versions[1000]);
+    PRBTree odd = PRBT_retain(versions[1000]);
+    for (int i = 0; i < 1000; i += 2) {
+        PRBTree next = PRBT_delete(odd, &values[i], compare_ints);
+        PRBT_release(odd);
+        odd = next;
+    }
+    TEST_CHECK(PRBT_count_items(odd) == 500);
+    TEST_CHECK(!PRBT_search(odd, &values[500], compare_ints) && PRBT_search(odd, &values[501], compare_ints));
+    TEST_CHECK(PRBT_count_items(snapshot) == 1000);
+    TEST_CHECK(PRBT_search(snapshot, &values[500], compare_ints));
+
+    // Release the versions in a different order than they were created
+    for (int i = 1000; i >= 0; i--)
+        PRBT_release(versions[i]);
+    long sum = 0;
+    TEST_CHECK(PRBT_range(snapshot, &values[10], &values[20], compare_ints, sum_persistent_item, &sum) == 10);
+    TEST_CHECK(sum == 145);
+    sum = 0;
+    TEST_CHECK(PRBT_range(odd, NULL, &values[20], compare_ints, sum_persistent_item, &sum) == 10);
+    TEST_CHECK(sum == 100);
+    PRBT_release(snapshot);
+    PRBT_release(odd);
+}
+
+// A reader of a snapshot of a persistent tree, which runs while the writer creates new versions
+typedef struct {
+    PRBTree snapshot;
+    size_t expected;
+    bool valid;
+} persistent_reader;
+
+static void read_snapshot(void *arg) {
+    persistent_reader *reader = arg;
+    reader->valid = true;
+    for (int round = 0; round < 20; round++) {
+        long sum = 0;
+        if (PRBT_range(reader->snapshot, NULL, NULL, compare_ints, sum_persistent_item, &sum) != reader->expected)
+            reader->valid = false;
+    }
+    PRBT_release(reader->snapshot);
+}
+
+static void test_persistent_red_black_tree_readers() {
+    static int values[2000];
+    size_t bytes_allocated = RBT_get_stats().bytes_allocated;
+    ThreadPool pool = threadpool_create(4);
+    persistent_reader readers[20];
+    PRBTree current = NULL;
+    for (int i = 0; i < 2000; i++) {
+        values[i] = i;
+        PRBTree next = PRBT_insert(current, &values[i], compare_ints);
+        PRBT_release(current);
+        current = next;
+        if (i % 100 == 99) {
+            persistent_reader *reader = &readers[i / 100];
+            reader->snapshot = PRBT_retain(current);
+            reader->expected = i + 1;
+            threadpool_submit(pool, read_snapshot, reader);
+        }
+    }
+    for (int i = 0; i < 2000; i += 3) {
+        PRBTree next = PRBT_delete(current, &values[i], compare_ints);
+        PRBT_release(current);
+        current = next;
+    }
+    threadpool_wait(pool);
+    for (int i = 0; i < 20; i++)
+        TEST_CHECK(readers[i].valid);
+    TEST_CHECK(PRBT_count_items(current) == 1333);
+    PRBT_release(current);
+    threadpool_destroy(pool);
+    // The readers released their versions on the threads of the pool, and every freed node is accounted for
+    TEST_CHECK(RBT_get_stats().bytes_allocated == bytes_allocated);
+}
+
+static bool count_compact_item(void *data, void *ctx) {
+    TEST_CHECK(*(int *)data > *(int *)ctx);
+    *(int *)ctx = *(int *)data;
+    return true;
+}
+
+static void test_compact_red_black_tree() {
+    CompactRBTree tree = RBT_compact_create(compare_ints);
+    RBT_compact_reserve(tree, 1000);
+    size_t bytes = RBT_compact_bytes(tree);
+    TEST_CHECK(bytes >= 1000 * 16);
+
+    // Insert 0, 7, 14, ... in an order which is not sorted
+    int *items[1000];
+    for (int i = 0; i < 1000; i++) {
+        items[i] = malloc(sizeof(int));
+        *items[i] = (i * 367 % 1000) * 7;
+        TEST_CHECK(RBT_compact_insert(tree, items[i]));
+    }
+    TEST_CHECK(!RBT_compact_insert(tree, &(int){70}));
+    TEST_CHECK(RBT_compact_size(tree) == 1000);
+    // The nodes fit in the reserved array, 16 bytes each
+    TEST_CHECK(RBT_compact_bytes(tree) == bytes);
+    TEST_CHECK(RBT_compact_search(tree, &(int){6993}));
+    TEST_CHECK(!RBT_compact_search(tree, &(int){6994}));
+
+    // Delete the multiples of 14, which destroys their items
+    for (int i = 0; i < 1000; i += 2)
+        TEST_CHECK(RBT_compact_delete(tree, &(int){i * 7}, free));
+    TEST_CHECK(!RBT_compact_delete(tree, &(int){0}, free));
+    TEST_CHECK(RBT_compact_size(tree) == 500);
+    int last = -1;
+    TEST_CHECK(RBT_compact_range(tree, NULL, NULL, count_compact_item, &last) == 500);
+    TEST_CHECK(last == 6993);
+    last = 100;
+    TEST_CHECK(RBT_compact_range(tree, &(int){101}, &(int){200}, count_compact_item, &last) == 7);
+    TEST_CHECK(last == 189);
+
+    // The deleted nodes are reused
+    for (int i = 0; i < 1000; i += 2) {
+        int *item = malloc(sizeof(int));
+        *item = i * 7;
+        TEST_CHECK(RBT_compact_insert(tree, item));
+    }
+    TEST_CHECK(RBT_compact_size(tree) == 1000);
+    TEST_CHECK(RBT_compact_bytes(tree) == bytes);
+
+    RBT_compact_destroy(tree, free);
+}
+
+static void test_red_black_tree_stats() {
+    RBTree root = NULL;
+    int values[100];
+
+    RBT_reset_stats();
+    size_t bytes_allocated = RBT_get_stats().bytes_allocated;
+
+    // Inserting sorted values needs rotations to keep the tree balanced
+    for (int i = 0; i < 100; i++) {
+        values[i] = i;
+        RBT_insert(&root, &values[i], compare_ints);
+    }
+    TEST_CHECK(RBT_search(root, &values[50], compare_ints));
+
+    RBT_stats stats = RBT_get_stats();
+#ifdef DS_STATS
+    TEST_CHECK(stats.rotations > 0);
+    TEST_CHECK(stats.compares > 0);
+    TEST_CHECK(stats.bytes_allocated > bytes_allocated);
+#else
+    // Without DS_STATS the counters are never updated
+    TEST_CHECK(stats.rotations == 0 && stats.compares == 0 && stats.bytes_allocated == 0);
+#endif
+
+    // Every node is accounted for when it is freed
+    RBT_delete(&root, &values[0], compare_ints, NULL);
+    RBT_destroy(root, NULL);
+    TEST_CHECK(RBT_get_stats().bytes_allocated == bytes_allocated);
+
+    // The threads of a parallel set operation update the counters together, and no update is lost
+    int *items = malloc(20000 * sizeof(int));
+    RBTree root1 = NULL, root2 = NULL;
+    for (int i = 0; i < 20000; i++) {
+        items[i] = i;
+        RBT_insert(i % 2 ? &root1 : &root2, &items[i], compare_ints);
+    }
+    ThreadPool pool = threadpool_create(4);
+    root = RBT_union(root1, root2, compare_ints, NULL, pool);
+    TEST_CHECK(RBT_count_items(root) == 20000);
+    RBT_destroy(root, NULL);
+    threadpool_destroy(pool);
+    free(items);
+    TEST_CHECK(RBT_get_stats().bytes_allocated == bytes_allocated);
+
+    RBT_reset_stats();
+    stats = RBT_get_stats();
+    TEST_CHECK(stats.rotations == 0 && stats.compares == 0);
+}
+
+// Check the red black properties of a subtree and return its black height (-1 if they are violated)
+static int typed_black_height(rbtree_int_int_node *node, rbtree_int_int_node *parent) {
+    if (node == NULL)
+        return 1;
+    if (node->parent != parent || (node->red && parent != NULL && parent->red))
+        return -1;
+    if ((node->left != NULL && node->left->key >= node->key) || (node->right != NULL && node->right->key <= node->key))
+        return -1;
+    int left = typed_black_height(node->left, node);
+    int right = typed_black_height(node->right, node);
+    if (left < 0 || left != right)
+        return -1;
+    return left + !node->red;
+}
+
+static void sum_values(int key, int *value, void *ctx) {
+    *(long *)ctx += *value;
+}
+
+static void test_typed_red_black_tree() {
+    rbtree_int_int *tree = rbtree_int_int_create();
+    TEST_CHECK(rbtree_int_int_empty(tree));
+    TEST_CHECK(rbtree_int_int_first(tree) == NULL);
+
+    // Insert the keys 0, 2, ..., 1998 in a scrambled order
+    for (int i = 0; i < 1000; i++)
+        TEST_CHECK(rbtree_int_int_insert(tree, (i * 379) % 1000 * 2, i));
+    TEST_CHECK(rbtree_int_int_size(tree) == 1000);
+    TEST_CHECK(!tree->root->red);
+    TEST_CHECK(typed_black_height(tree->root, NULL) > 0);
+
+    for (int i = 0; i < 1000; i++) {
+        int *value = rbtree_int_int_get(tree, (i * 379) % 1000 * 2);
+        TEST_CHECK(value != NULL && *value == i);
+        TEST_CHECK(!rbtree_int_int_contains(tree, 2 * i + 1));
+    }
+
+    // Inserting an existing key replaces its value
+    TEST_CHECK(!rbtree_int_int_insert(tree, 10, -1));
+    TEST_CHECK(*rbtree_int_int_get(tree, 10) == -1);
+    TEST_CHECK(rbtree_int_int_size(tree) == 1000);
+
+    // The nodes are visited in ascending order of their keys
+    int expected = 0;
+    for (rbtree_int_int_node *node = rbtree_int_int_first(tree); node != NULL; node = rbtree_int_int_next(node)) {
+        TEST_CHECK(node->key == expected);
+        expected += 2;
+    }
+    TEST_CHECK(expected == 2000);
+    TEST_CHECK(rbtree_int_int_last(tree)->key == 1998);
+    TEST_CHECK(rbtree_int_int_prev(rbtree_int_int_last(tree))->key == 1996);
+
+    TEST_CHECK(rbtree_int_int_lower_bound(tree, 7)->key == 8);
+    TEST_CHECK(rbtree_int_int_lower_bound(tree, 8)->key == 8);
+    TEST_CHECK(rbtree_int_int_lower_bound(tree, 1999) == NULL);
+
+    rbtree_int_int_free(tree);
+}
+
+static void test_typed_red_black_tree_remove() {
+    rbtree_int_int *tree = rbtree_int_int_create();
+    for (int i = 0; i < 1000; i++)
+        rbtree_int_int_insert(tree, i, i);
+
+    // Remove every key which is not a multiple of 3, checking the properties along the way
+    for (int i = 0; i < 1000; i++) {
+        int key = (i * 617) % 1000;
+        if (key % 3 != 0)
+            TEST_CHECK(rbtree_int_int_remove(tree, key));
+        if (i % 100 == 0)
+            TEST_CHECK(typed_black_height(tree->root, NULL) > 0);
+    }
+    TEST_CHECK(!rbtree_int_int_remove(tree, 1));
+    TEST_CHECK(rbtree_int_int_size(tree) == 334);
+    TEST_CHECK(typed_black_height(tree->root, NULL) > 0);
+
+    long sum = 0;
+    rbtree_int_int_for_each(tree, sum_values, &sum);
+    TEST_CHECK(sum == 3L * (333 * 334 / 2));
+
+    for (int i = 0; i < 1000; i++)
+        TEST_CHECK(rbtree_int_int_contains(tree, i) == (i % 3 == 0));
+
+    rbtree_int_int_clear(tree);
+    TEST_CHECK(rbtree_int_int_empty(tree));
+    TEST_CHECK(tree->root == NULL);
+    rbtree_int_int_free(tree);
+}
+
 TEST_LIST = {
     {"test_red_black_tree_empty", test_red_black_tree_empty},
     {"test_red_black_tree_insert_and_search", test_red_black_tree_insert_and_search},
     {"test_red_black_tree_delete", test_red_black_tree_delete},
+    {"test_red_black_tree_delete_all", test_red_black_tree_delete_all},
     {"test_red_black_tree_select_k_th_item", test_red_black_tree_select_k_th_item},
     {"test_red_black_tree_count_items", test_red_black_tree_count_items},
     {"test_red_black_tree_min_and_max_values", test_red_black_tree_min_and_max_values},
+    {"test_red_black_tree_build_sorted", test_red_black_tree_build_sorted},
+    {"test_red_black_tree_join_and_split", test_red_black_tree_join_and_split},
+    {"test_red_black_tree_set_operations", test_red_black_tree_set_operations},
+    {"test_red_black_tree_iterators", test_red_black_tree_iterators},
+    {"test_red_black_tree_range", test_red_black_tree_range},
+    {"test_persistent_red_black_tree", test_persistent_red_black_tree},
+    {"test_persistent_red_black_tree_readers", test_persistent_red_black_tree_readers},
+    {"test_compact_red_black_tree", test_compact_red_black_tree},
+    {"test_red_black_tree_stats", test_red_black_tree_stats},
+    {"test_typed_red_black_tree", test_typed_red_black_tree},
+    {"test_typed_red_black_tree_remove", test_typed_red_black_tree_remove},
     {NULL, NULL}
 };
\ No newline at end of file
@@ -182,6 +182,106 @@ static void test_skiplist_merge() {
     skiplist_destroy(merged_list);
 }
 
+// Collects the keys of a range, and stops after limit keys
+typedef struct {
+    int keys[1000];
+    int count;
+    int limit;
+} range_result;
+
+static bool collect_key(void *key, void *value, void *ctx) {
+    range_result *result = ctx;
+    TEST_CHECK(*(int *)value == 10 * *(int *)key);
+    result->keys[result->count++] = *(int *)key;
+    return result->count < result->limit;
+}
+
+static void test_skiplist_range() {
+    skiplist *list = skiplist_initialize(compare_ints, NULL, free, free);
+    // The even keys of [0, 2000)
+    for (int i = 0; i < 1000; i++) {
+        int *key = (int *)malloc(sizeof(int));
+        *key = 2 * i;
+        int *value = (int *)malloc(sizeof(int));
+        *value = 20 * i;
+        skiplist_insert(list, key, value);
+    }
+
+    range_result result = { .count = 0, .limit = 1000 };
+    TEST_CHECK(skiplist_range(list, &(int){501}, &(int){521}, collect_key, &result) == 10);
+    TEST_CHECK(result.count == 10);
+    for (int i = 0; i < result.count; i++)
+        TEST_CHECK(result.keys[i] == 502 + 2 * i);
+
+    // The callback stops the range
+    result = (range_result){ .count = 0, .limit = 3 };
+    TEST_CHECK(skiplist_range(list, &(int){100}, NULL, collect_key, &result) == 3);
+    TEST_CHECK(result.keys[0] == 100 && result.keys[2] == 104);
+
+    result = (range_result){ .count = 0, .limit = 1000 };
+    TEST_CHECK(skiplist_range(list, NULL, NULL, collect_key, &result) == 1000);
+    TEST_CHECK(skiplist_range(list, &(int){700}, &(int){700}, collect_key, &result) == 0);
+    TEST_CHECK(skiplist_range(list, &(int){5000}, NULL, collect_key, &result) == 0);
+
+    // Cursors
+    skiplist_cursor cursor = skiplist_seek(list, &(int){1997});
+    TEST_CHECK(cursor != NULL && *(int *)skiplist_cursor_key(cursor) == 1998);
+    TEST_CHECK(*(int *)skiplist_cursor_value(cursor) == 19980);
+    TEST_CHECK(skiplist_cursor_next(cursor) == NULL);
+    TEST_CHECK(*(int *)skiplist_cursor_key(skiplist_seek(list, NULL)) == 0);
+
+    // Batches of 64 keys over [100, 1100)
+    void *keys[64], *values[64];
+    int expected = 100;
+    size_t count;
+    cursor = skiplist_seek(list, &(int){100});
+    while ((count = skiplist_range_batch(list, &cursor, &(int){1100}, keys, values, 64)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            TEST_CHECK(*(int *)keys[i] == expected);
+            TEST_CHECK(*(int *)values[i] == 10 * expected);
+            expected += 2;
+        }
+    }
+    TEST_CHECK(expected == 1100);
+    TEST_CHECK(*(int *)skiplist_cursor_key(cursor) == 1100);
+
+    skiplist_destroy(list);
+}
+
+static void test_skiplist_merge_large() {
+    skiplist *list1 = skiplist_initialize(compare_ints, NULL, free, free);
+    skiplist *list2 = skiplist_initialize(compare_ints, NULL, free, free);
+    // list1 holds the multiples of 2 and list2 the multiples of 3 of [0, 3000), so the multiples of 6 are in both
+    for (int i = 0; i < 3000; i++) {
+        for (int j = 2; j <= 3; j++) {
+            if (i % j != 0)
+                continue;
+            int *key = (int *)malloc(sizeof(int));
+            *key = i;
+            int *value = (int *)malloc(sizeof(int));
+            *value = j;
+            skiplist_insert(j == 2 ? list1 : list2, key, value);
+        }
+    }
+
+    skiplist *merged_list = skiplist_merge(list1, list2);
+    TEST_CHECK(skiplist_get_size(merged_list) == 2000);
+    int expected = 0;
+    for (skiplist_cursor cursor = skiplist_seek(merged_list, NULL); cursor != NULL; cursor = skiplist_cursor_next(cursor)) {
+        while (expected % 2 != 0 && expected % 3 != 0)
+            expected++;
+        TEST_CHECK(*(int *)skiplist_cursor_key(cursor) == expected);
+        // The value of list2 is kept for the keys of both lists
+        TEST_CHECK(*(int *)skiplist_cursor_value(cursor) == (expected % 3 == 0 ? 3 : 2));
+        expected++;
+    }
+    TEST_CHECK(expected == 2999);
+    for (int i = 0; i < 3000; i += 7)
+        TEST_CHECK((skiplist_search(merged_list, &i) != NULL) == (i % 2 == 0 || i % 3 == 0));
+
+    skiplist_destroy(merged_list);
+}
+
 // Add more test cases for other functions if needed
 
 TEST_LIST = {
@@ -189,5 +289,7 @@ TEST_LIST = {
     {"test_skiplist_delete", test_skiplist_delete},
     {"test_skiplist_get_size", test_skiplist_get_size},
     {"test_skiplist_merge", test_skiplist_merge},
+    {"test_skiplist_merge_large", test_skiplist_merge_large},
+    {"test_skiplist_range", test_skiplist_range},
     {NULL, NULL}
 };
\ No newline at end of file
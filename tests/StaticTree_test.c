@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "acutest/acutest.h"
+#include "../modules/StaticTree/static_tree.h"
+#include "../modules/RedBlackTree/RedBlackTree.h"
+
+
+#define INT_LESS(a, b) ((a) < (b))
+
+DECLARE_STATIC_TREE(int, INT_LESS)
+
+
+static int compare_ints(void *a, void *b) {
+    return *(int *)a - *(int *)b;
+}
+
+static void append_item(const int *item, void *ctx) {
+    int **out = ctx;
+    *(*out)++ = *item;
+}
+
+static int next_rbt_item(void *ctx) {
+    RBTIterator *it = ctx;
+    int item = *(int *)RBT_iterator_data(*it);
+    *it = RBT_next(*it);
+    return item;
+}
+
+
+// Compare every kind of lookup with a binary search over the sorted items, for all the keys around them
+static void check_against_sorted(static_tree_int *tree, const int *sorted, size_t size) {
+    TEST_CHECK(static_tree_int_size(tree) == size);
+    int *visited = malloc((size + 1) * sizeof(int)), *out = visited;
+    static_tree_int_for_each(tree, append_item, &out);
+    TEST_CHECK((size_t)(out - visited) == size);
+    TEST_CHECK(size == 0 || memcmp(visited, sorted, size * sizeof(int)) == 0);
+    free(visited);
+
+    int high = size > 0 ? sorted[size - 1] + 2 : 2;
+    for (int key = -2; key <= high; key++) {
+        size_t lower = 0, upper = 0;
+        while (lower < size && sorted[lower] < key)
+            lower++;
+        upper = lower;
+        while (upper < size && sorted[upper] <= key)
+            upper++;
+        const int *item = static_tree_int_lower_bound(tree, key);
+        TEST_CHECK(lower == size ? item == NULL : item != NULL && *item == sorted[lower]);
+        item = static_tree_int_upper_bound(tree, key);
+        TEST_CHECK(upper == size ? item == NULL : item != NULL && *item == sorted[upper]);
+        TEST_CHECK(static_tree_int_contains(tree, key) == (upper > lower));
+    }
+}
+
+
+void test_static_tree_build_and_search(void) {
+    // Every size up to a few complete trees, so that the last level is empty, partial and full
+    int sorted[300];
+    for (size_t size = 0; size <= 300; size++) {
+        for (size_t i = 0; i < size; i++)
+            sorted[i] = (int)(3 * i);
+        static_tree_int *tree = static_tree_int_build(sorted, size);
+        TEST_ASSERT(tree != NULL);
+        TEST_CHECK(size == 0 || static_tree_int_height(tree) == (size_t)(64 - __builtin_clzll(size)));
+        check_against_sorted(tree, sorted, size);
+        static_tree_int_free(tree);
+    }
+
+    // Equal items: lower_bound finds the first of them and upper_bound the item after the last one
+    int duplicates[] = {1, 2, 2, 2, 2, 5, 5, 9, 9, 9, 9, 9};
+    static_tree_int *tree = static_tree_int_build(duplicates, 12);
+    check_against_sorted(tree, duplicates, 12);
+    static_tree_int_free(tree);
+}
+
+void test_static_tree_batch(void) {
+    int size = 1000, count = 5000;
+    int *sorted = malloc(size * sizeof(int));
+    int *keys = malloc(count * sizeof(int));
+    const int **results = malloc(count * sizeof(int *));
+    for (int i = 0; i < size; i++)
+        sorted[i] = 2 * i;
+    static_tree_int *tree = static_tree_int_build(sorted, size);
+
+    // The count is not a multiple of the group size, so the last group is shorter
+    srand(42);
+    for (int i = 0; i < count; i++)
+        keys[i] = rand() % (2 * size + 4) - 2;
+    static_tree_int_lower_bound_batch(tree, keys, count, results);
+    for (int i = 0; i < count; i++)
+        TEST_CHECK(results[i] == static_tree_int_lower_bound(tree, keys[i]));
+    static_tree_int_search_batch(tree, keys, count, results);
+    for (int i = 0; i < count; i++)
+        TEST_CHECK(results[i] == static_tree_int_search(tree, keys[i]));
+    static_tree_int_free(tree);
+
+    // An empty tree and a tree with a single item
+    tree = static_tree_int_build(sorted, 0);
+    static_tree_int_lower_bound_batch(tree, keys, 20, results);
+    for (int i = 0; i < 20; i++)
+        TEST_CHECK(results[i] == NULL);
+    static_tree_int_free(tree);
+    tree = static_tree_int_build(sorted + 5, 1);
+    static_tree_int_search_batch(tree, keys, count, results);
+    for (int i = 0; i < count; i++)
+        TEST_CHECK(keys[i] == 10 ? results[i] != NULL && *results[i] == 10 : results[i] == NULL);
+    static_tree_int_free(tree);
+
+    free(sorted);
+    free(keys);
+    free(results);
+}
+
+void test_static_tree_build_from_tree(void) {
+    int size = 777;
+    int *items = malloc(size * sizeof(int));
+    int *sorted = malloc(size * sizeof(int));
+    RBTree root = NULL;
+    for (int i = 0; i < size; i++) {
+        items[i] = (i * 389) % size;
+        RBT_insert(&root, &items[i], compare_ints);
+    }
+    for (int i = 0; i < size; i++)
+        sorted[i] = i;
+
+    // The in-order traversal of the red black tree feeds the items without copying them into an array first
+    RBTIterator it = RBT_begin(root);
+    static_tree_int *tree = static_tree_int_build_from(size, next_rbt_item, &it);
+    TEST_CHECK(!RBT_iterator_valid(it));
+    check_against_sorted(tree, sorted, size);
+    static_tree_int_free(tree);
+
+    RBT_destroy(root, NULL);
+    free(items);
+    free(sorted);
+}
+
+// Counts the bytes which are allocated and not freed yet, and fails once its budget of allocations is spent
+typedef struct {
+    size_t bytes;
+    int budget;
+} counting_ctx;
+
+static void *counting_alloc(void *ctx, size_t size) {
+    counting_ctx *counts = ctx;
+    if (counts->budget == 0)
+        return NULL;
+    counts->budget--;
+    counts->bytes += size;
+    return malloc(size);
+}
+
+static void counting_free(void *ctx, void *ptr, size_t size) {
+    counting_ctx *counts = ctx;
+    counts->bytes -= size;
+    free(ptr);
+}
+
+void test_static_tree_allocator(void) {
+    int size = 1000;
+    int *sorted = malloc(size * sizeof(int));
+    for (int i = 0; i < size; i++)
+        sorted[i] = 2 * i;
+    counting_ctx counts = {0, -1};
+    Allocator allocator = {counting_alloc, counting_free, &counts};
+
+    // Every block of the tree comes from the allocator, and the items still start at a line boundary
+    static_tree_int *tree = static_tree_int_build_with_allocator(sorted, size, &allocator);
+    TEST_ASSERT(tree != NULL);
+    TEST_CHECK(counts.bytes >= sizeof(*tree) + (size + 1) * sizeof(int));
+    TEST_CHECK((uintptr_t)tree->items % STATIC_TREE_LINE_BYTES == 0);
+    check_against_sorted(tree, sorted, size);
+    static_tree_int_free(tree);
+    TEST_CHECK(counts.bytes == 0);
+
+    // A failed allocation of the items gives back the tree which was already allocated
+    counts.budget = 1;
+    TEST_CHECK(static_tree_int_build_with_allocator(sorted, size, &allocator) == NULL);
+    TEST_CHECK(counts.bytes == 0);
+    counts.budget = 0;
+    TEST_CHECK(static_tree_int_build_with_allocator(sorted, size, &allocator) == NULL);
+    TEST_CHECK(counts.bytes == 0);
+    free(sorted);
+}
+
+TEST_LIST = {
+    {"test_static_tree_build_and_search", test_static_tree_build_and_search},
+    {"test_static_tree_batch", test_static_tree_batch},
+    {"test_static_tree_build_from_tree", test_static_tree_build_from_tree},
+    {"test_static_tree_allocator", test_static_tree_allocator},
+    {NULL, NULL}
+};
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "acutest/acutest.h"
+#include "../modules/ThreadPool/ThreadPool.h"
+
+
+static pthread_mutex_t counter_lock = PTHREAD_MUTEX_INITIALIZER;
+static int counter = 0;
+
+static void increment_counter(void *arg) {
+    int amount = *(int *)arg;
+    pthread_mutex_lock(&counter_lock);
+    counter += amount;
+    pthread_mutex_unlock(&counter_lock);
+}
+
+static void fill_range(size_t begin, size_t end, void *ctx) {
+    int *array = ctx;
+    for (size_t i = begin; i < end; i++)
+        array[i]++;
+}
+
+static void test_threadpool_create() {
+    ThreadPool pool = threadpool_create(3);
+    TEST_CHECK(pool != NULL);
+    TEST_CHECK(threadpool_size(pool) == 3);
+    threadpool_destroy(pool);
+
+    // One thread per online processor
+    pool = threadpool_create(0);
+    TEST_CHECK(pool != NULL);
+    TEST_CHECK(threadpool_size(pool) >= 1);
+    threadpool_destroy(pool);
+}
+
+static void test_threadpool_submit_and_wait() {
+    ThreadPool pool = threadpool_create(4);
+    int amounts[100];
+
+    counter = 0;
+    for (int i = 0; i < 100; i++) {
+        amounts[i] = i;
+        threadpool_submit(pool, increment_counter, &amounts[i]);
+    }
+    threadpool_wait(pool);
+    TEST_CHECK(counter == 4950);
+
+    // The pool can be reused after waiting
+    threadpool_submit(pool, increment_counter, &amounts[50]);
+    threadpool_wait(pool);
+    TEST_CHECK(counter == 5000);
+
+    threadpool_destroy(pool);
+}
+
+static void test_threadpool_parallel_for() {
+    ThreadPool pool = threadpool_create(4);
+    int n = 100000;
+    int *array = calloc(n, sizeof(int));
+
+    threadpool_parallel_for(pool, n, 1000, fill_range, array);
+    // Ranges smaller than the grain run in the calling thread
+    threadpool_parallel_for(pool, 10, 1000, fill_range, array);
+
+    int correct = 1;
+    for (int i = 0; i < n; i++)
+        if (array[i] != (i < 10 ? 2 : 1))
+            correct = 0;
+    TEST_CHECK(correct);
+
+    free(array);
+    threadpool_destroy(pool);
+}
+
+
+TEST_LIST = {
+    {"test_threadpool_create", test_threadpool_create},
+    {"test_threadpool_submit_and_wait", test_threadpool_submit_and_wait},
+    {"test_threadpool_parallel_for", test_threadpool_parallel_for},
+    {NULL, NULL}
+};
@@ -2,9 +2,23 @@
 #include <stdlib.h>
 #include "acutest/acutest.h"
 #include "../modules/Vector/vector.h"
+#include "../modules/Vector/vector_parallel.h"
+#include "../modules/Vector/small_vector.h"
 
 
+#define INT_LESS(a, b) ((a) < (b))
+
 DECLARE_VECTOR_ALL(int)
+DECLARE_VECTOR_ORDERED(int, INT_LESS)
+DECLARE_VECTOR_PRIMITIVE(int, I32)
+DECLARE_VECTOR_PARALLEL(int)
+DECLARE_VECTOR_ALL(unsigned)
+DECLARE_VECTOR_PRIMITIVE(unsigned, U32)
+DECLARE_VECTOR_ALL(float)
+DECLARE_VECTOR_PRIMITIVE(float, F32)
+DECLARE_VECTOR_ALL(double)
+DECLARE_VECTOR_PRIMITIVE(double, F64)
+DECLARE_SMALL_VECTOR(int, 4)
 
 
 static int compare_int(const int *a, const int *b) {
@@ -34,7 +48,7 @@ static void test_vector_push_back_and_at() {
     TEST_CHECK(vector_int_at(vector, 1) == value2);
     TEST_CHECK(vector_int_at(vector, 2) == value3);
     TEST_CHECK(vector_int_size(vector) == 3);
-    TEST_CHECK(vector_int_capacity(vector) == 4);
+    TEST_CHECK(vector_int_capacity(vector) == 3);
     
     vector_int_free(vector, NULL);
 }
@@ -58,8 +72,80 @@ static void test_vector_set_at() {
     int new_value = 100;
     vector_int_set_at(vector, 1, new_value);
     TEST_CHECK(vector_int_at(vector, 1) == new_value);
+    TEST_CHECK(vector_int_size(vector) == 3);
     
     vector_int_free(vector, NULL);
+
+    // Setting an item past the end grows the size up to it
+    vector = vector_int_create(4);
+    vector_int_set_at(vector, 2, value3);
+    TEST_CHECK(vector_int_at(vector, 2) == value3);
+    TEST_CHECK(vector_int_size(vector) == 3);
+
+    vector_int_free(vector, NULL);
+}
+
+static void test_vector_growth() {
+    // A vector created without capacity grows on the first push
+    vector_int *vector = vector_int_create(0);
+    TEST_CHECK(vector != NULL);
+    for (int i = 0; i < 1000; i++)
+        vector_int_push_back(vector, i);
+    TEST_CHECK(vector_int_size(vector) == 1000);
+    TEST_CHECK(vector_int_capacity(vector) >= 1000);
+    for (int i = 0; i < 1000; i++)
+        TEST_CHECK(vector_int_at(vector, i) == i);
+
+    vector_int_reserve(vector, 5000);
+    TEST_CHECK(vector_int_capacity(vector) == 5000);
+    TEST_CHECK(vector_int_at(vector, 999) == 999);
+    // Reserving less than the capacity does nothing
+    vector_int_reserve(vector, 10);
+    TEST_CHECK(vector_int_capacity(vector) == 5000);
+
+    vector_int_shrink_to_fit(vector);
+    TEST_CHECK(vector_int_capacity(vector) == 1000);
+    TEST_CHECK(vector_int_size(vector) == 1000);
+
+    vector_int_erase(vector, 0, 1000, NULL);
+    vector_int_shrink_to_fit(vector);
+    TEST_CHECK(vector_int_capacity(vector) == 0);
+    vector_int_push_back(vector, 7);
+    TEST_CHECK(vector_int_at(vector, 0) == 7);
+
+    vector_int_free(vector, NULL);
+}
+
+static void test_vector_append_and_erase() {
+    int items[100];
+    for (int i = 0; i < 100; i++)
+        items[i] = i;
+
+    vector_int *vector = vector_int_create(10);
+    vector_int_append_array(vector, items, 50);
+    vector_int_append_array(vector, items + 50, 50);
+    vector_int_append_array(vector, items, 0);
+    TEST_CHECK(vector_int_size(vector) == 100);
+    for (int i = 0; i < 100; i++)
+        TEST_CHECK(vector_int_at(vector, i) == i);
+
+    vector_int_erase(vector, 10, 20, NULL);
+    TEST_CHECK(vector_int_size(vector) == 90);
+    TEST_CHECK(vector_int_at(vector, 9) == 9);
+    TEST_CHECK(vector_int_at(vector, 10) == 20);
+    TEST_CHECK(vector_int_at(vector, 89) == 99);
+
+    // Empty and invalid ranges leave the vector unchanged
+    vector_int_erase(vector, 5, 5, NULL);
+    vector_int_erase(vector, 50, 40, NULL);
+    vector_int_erase(vector, 80, 91, NULL);
+    TEST_CHECK(vector_int_size(vector) == 90);
+
+    vector_int_erase(vector, 80, 90, NULL);
+    TEST_CHECK(vector_int_size(vector) == 80);
+    TEST_CHECK(vector_int_at(vector, 79) == 89);
+
+    vector_int_free(vector, NULL);
 }
 
 static void test_vector_clear_at() {
@@ -155,13 +241,320 @@ static void test_vector_sort() {
     vector_int_free(vector, NULL);
 }
 
+static bool vector_int_is_sorted(vector_int *vector) {
+    for (size_t i = 1; i < vector_int_size(vector); i++) {
+        if (vector_int_at(vector, i - 1) > vector_int_at(vector, i))
+            return false;
+    }
+    return true;
+}
+
+static void test_vector_sort_patterns() {
+    int n = 10000;
+    for (int pattern = 0; pattern < 5; pattern++) {
+        vector_int *vector = vector_int_create(n);
+        TEST_CHECK(vector != NULL);
+        long long sum = 0;
+        srand(pattern);
+        for (int i = 0; i < n; i++) {
+            int value;
+            switch (pattern) {
+                case 0: value = rand() % 1000000; break;   // random
+                case 1: value = i; break;                  // sorted
+                case 2: value = n - i; break;              // reversed
+                case 3: value = i % 100; break;            // sawtooth
+                default: value = rand() % 4; break;        // few unique
+            }
+            sum += value;
+            vector_int_push_back(vector, value);
+        }
+
+        vector_int_sort(vector, compare_int);
+
+        TEST_CHECK(vector_int_size(vector) == n);
+        TEST_CHECK(vector_int_is_sorted(vector));
+        for (int i = 0; i < n; i++)
+            sum -= vector_int_at(vector, i);
+        TEST_CHECK(sum == 0);
+        TEST_MSG("pattern %d", pattern);
+
+        vector_int_free(vector, NULL);
+    }
+}
+
+static void test_vector_partition() {
+    vector_int *vector = vector_int_create(8);
+    TEST_CHECK(vector != NULL);
+
+    int values[] = {40, 10, 70, 20, 50, 30, 60, 0};
+    for (int i = 0; i < 8; i++)
+        vector_int_push_back(vector, values[i]);
+
+    size_t pivot = vector_int_partition(vector, compare_int, 0, 7);
+    TEST_CHECK(pivot <= 7);
+    for (size_t i = 0; i < pivot; i++)
+        TEST_CHECK(vector_int_at(vector, i) < vector_int_at(vector, pivot));
+    for (size_t i = pivot + 1; i < 8; i++)
+        TEST_CHECK(vector_int_at(vector, i) >= vector_int_at(vector, pivot));
+
+    vector_int_free(vector, NULL);
+}
+
+static void test_vector_sort_inline() {
+    vector_int *vector = vector_int_create(1000);
+    TEST_CHECK(vector != NULL);
+
+    srand(7);
+    for (int i = 0; i < 1000; i++)
+        vector_int_push_back(vector, rand() % 100);
+
+    vector_int_sort_inline(vector);
+
+    TEST_CHECK(vector_int_size(vector) == 1000);
+    TEST_CHECK(vector_int_is_sorted(vector));
+
+    vector_int_free(vector, NULL);
+}
+
+static void test_vector_bounds_and_binary_search() {
+    vector_int *vector = vector_int_create(8);
+    TEST_CHECK(vector != NULL);
+
+    TEST_CHECK(vector_int_lower_bound(vector, 10) == 0);
+    TEST_CHECK(vector_int_upper_bound(vector, 10) == 0);
+    TEST_CHECK(vector_int_binary_search(vector, 10) == -1);
+
+    int values[] = {10, 20, 20, 20, 30, 40};
+    for (int i = 0; i < 6; i++)
+        vector_int_push_back(vector, values[i]);
+
+    TEST_CHECK(vector_int_lower_bound(vector, 5) == 0);
+    TEST_CHECK(vector_int_lower_bound(vector, 20) == 1);
+    TEST_CHECK(vector_int_upper_bound(vector, 20) == 4);
+    TEST_CHECK(vector_int_lower_bound(vector, 25) == 4);
+    TEST_CHECK(vector_int_upper_bound(vector, 25) == 4);
+    TEST_CHECK(vector_int_lower_bound(vector, 50) == 6);
+    TEST_CHECK(vector_int_upper_bound(vector, 40) == 6);
+
+    TEST_CHECK(vector_int_binary_search(vector, 10) == 0);
+    TEST_CHECK(vector_int_binary_search(vector, 20) == 1);
+    TEST_CHECK(vector_int_binary_search(vector, 40) == 5);
+    TEST_CHECK(vector_int_binary_search(vector, 35) == -1);
+
+    vector_int_free(vector, NULL);
+}
+
+static void test_vector_radix_sort() {
+    vector_int *vector_i = vector_int_create(1);
+    vector_unsigned *vector_u = vector_unsigned_create(1);
+    vector_float *vector_f = vector_float_create(1);
+    vector_double *vector_d = vector_double_create(1);
+
+    srand(11);
+    for (int i = 0; i < 5000; i++) {
+        int value = rand() - RAND_MAX / 2;
+        vector_int_push_back(vector_i, value);
+        vector_unsigned_push_back(vector_u, (unsigned)value * 2654435761u);
+        vector_float_push_back(vector_f, value / 1000.0f);
+        vector_double_push_back(vector_d, value / 3.0);
+    }
+    vector_float_push_back(vector_f, -0.0f);
+    vector_double_push_back(vector_d, 1e300);
+    vector_double_push_back(vector_d, -1e300);
+
+    vector_int_radix_sort(vector_i);
+    vector_unsigned_radix_sort(vector_u);
+    vector_float_radix_sort(vector_f);
+    vector_double_radix_sort(vector_d);
+
+    TEST_CHECK(vector_int_size(vector_i) == 5000);
+    TEST_CHECK(vector_int_is_sorted(vector_i));
+    for (size_t i = 1; i < vector_unsigned_size(vector_u); i++)
+        TEST_CHECK(vector_unsigned_at(vector_u, i - 1) <= vector_unsigned_at(vector_u, i));
+    for (size_t i = 1; i < vector_float_size(vector_f); i++)
+        TEST_CHECK(vector_float_at(vector_f, i - 1) <= vector_float_at(vector_f, i));
+    for (size_t i = 1; i < vector_double_size(vector_d); i++)
+        TEST_CHECK(vector_double_at(vector_d, i - 1) <= vector_double_at(vector_d, i));
+    TEST_CHECK(vector_double_at(vector_d, 0) == -1e300);
+    TEST_CHECK(vector_double_at(vector_d, vector_double_size(vector_d) - 1) == 1e300);
+
+    vector_int_free(vector_i, NULL);
+    vector_unsigned_free(vector_u, NULL);
+    vector_float_free(vector_f, NULL);
+    vector_double_free(vector_d, NULL);
+}
+
+static void test_vector_find() {
+    vector_int *vector_i = vector_int_create(100);
+    vector_float *vector_f = vector_float_create(100);
+    vector_double *vector_d = vector_double_create(100);
+
+    for (int i = 0; i < 100; i++) {
+        vector_int_push_back(vector_i, i * 3);
+        vector_float_push_back(vector_f, i * 0.5f);
+        vector_double_push_back(vector_d, i * 0.25);
+    }
+
+    // Items in the vectorized part and in the scalar tail of the search
+    TEST_CHECK(vector_int_find(vector_i, 0) == 0);
+    TEST_CHECK(vector_int_find(vector_i, 3 * 37) == 37);
+    TEST_CHECK(vector_int_find(vector_i, 3 * 99) == 99);
+    TEST_CHECK(vector_int_find(vector_i, 1) == -1);
+    TEST_CHECK(vector_float_find(vector_f, 20.5f) == 41);
+    TEST_CHECK(vector_float_find(vector_f, 0.25f) == -1);
+    TEST_CHECK(vector_double_find(vector_d, 24.5) == 98);
+    TEST_CHECK(vector_double_find(vector_d, -1.0) == -1);
+
+    // Same results as the search which uses a compare function
+    for (int value = -5; value < 310; value++)
+        TEST_CHECK(vector_int_find(vector_i, value) == vector_int_search(vector_i, value, compare_int));
+
+    vector_int_free(vector_i, NULL);
+    vector_float_free(vector_f, NULL);
+    vector_double_free(vector_d, NULL);
+}
+
+static void increment_int(int *item) {
+    (*item)++;
+}
+
+static int square_int(int item) {
+    return item * item;
+}
+
+static int add_ints(int a, int b) {
+    return a + b;
+}
+
+static void test_vector_parallel_sort() {
+    ThreadPool pool = threadpool_create(4);
+    TEST_CHECK(pool != NULL);
+
+    // Sizes below and above the grain of the parallel sort
+    int sizes[] = {1000, 300000, 1000003};
+    for (int s = 0; s < 3; s++) {
+        vector_int *vector = vector_int_create(sizes[s]);
+        long long sum = 0;
+        srand(s);
+        for (int i = 0; i < sizes[s]; i++) {
+            int value = (s == 2) ? sizes[s] - i : rand() % 1000000;
+            sum += value;
+            vector_int_push_back(vector, value);
+        }
+
+        vector_int_parallel_sort(vector, compare_int, pool);
+
+        TEST_CHECK(vector_int_size(vector) == sizes[s]);
+        TEST_CHECK(vector_int_is_sorted(vector));
+        for (int i = 0; i < sizes[s]; i++)
+            sum -= vector_int_at(vector, i);
+        TEST_CHECK(sum == 0);
+
+        vector_int_free(vector, NULL);
+    }
+
+    threadpool_destroy(pool);
+}
+
+static void test_vector_parallel_bulk_operations() {
+    ThreadPool pool = threadpool_create(3);
+    vector_int *vector = vector_int_create(100000);
+    for (int i = 0; i < 100000; i++)
+        vector_int_push_back(vector, i % 10);
+
+    vector_int_parallel_for_each(vector, increment_int, pool);
+    TEST_CHECK(vector_int_at(vector, 0) == 1);
+    TEST_CHECK(vector_int_at(vector, 99999) == 10);
+
+    vector_int_parallel_transform(vector, square_int, pool);
+    TEST_CHECK(vector_int_at(vector, 1) == 4);
+    TEST_CHECK(vector_int_at(vector, 99999) == 100);
+
+    // (1 + 4 + ... + 100) for every 10 items
+    TEST_CHECK(vector_int_parallel_reduce(vector, 7, add_ints, pool) == 7 + 385 * 10000);
+
+    vector_int_free(vector, NULL);
+    threadpool_destroy(pool);
+}
+
+static void test_small_vector_inline() {
+    small_vector_int vector;
+    small_vector_int_init(&vector);
+    TEST_CHECK(small_vector_int_size(&vector) == 0);
+    TEST_CHECK(small_vector_int_capacity(&vector) == 4);
+
+    for (int i = 0; i < 4; i++)
+        small_vector_int_push_back(&vector, i * 10);
+    TEST_CHECK(small_vector_int_is_inline(&vector));
+    TEST_CHECK(small_vector_int_at(&vector, 3) == 30);
+
+    // An inline small vector can be copied by assignment
+    small_vector_int copy = vector;
+    small_vector_int_set_at(&copy, 0, 100);
+    TEST_CHECK(small_vector_int_at(&copy, 0) == 100);
+    TEST_CHECK(small_vector_int_at(&vector, 0) == 0);
+    TEST_CHECK(small_vector_int_at(&copy, 1) == 10);
+
+    small_vector_int_clear_at(&vector, 1, NULL);
+    TEST_CHECK(small_vector_int_size(&vector) == 3);
+    TEST_CHECK(small_vector_int_at(&vector, 1) == 20);
+    TEST_CHECK(small_vector_int_at(&vector, 2) == 30);
+
+    small_vector_int_release(&vector, NULL);
+    small_vector_int_release(&copy, NULL);
+}
+
+static void test_small_vector_spill() {
+    small_vector_int *vector = small_vector_int_create();
+    TEST_CHECK(vector != NULL);
+
+    for (int i = 0; i < 100; i++)
+        small_vector_int_push_back(vector, i);
+    TEST_CHECK(!small_vector_int_is_inline(vector));
+    TEST_CHECK(small_vector_int_size(vector) == 100);
+    TEST_CHECK(small_vector_int_capacity(vector) >= 100);
+    int correct = 1;
+    for (int i = 0; i < 100; i++)
+        if (small_vector_int_at(vector, i) != i)
+            correct = 0;
+    TEST_CHECK(correct);
+
+    // Releasing makes the vector inline and empty again
+    small_vector_int_release(vector, NULL);
+    TEST_CHECK(small_vector_int_is_inline(vector));
+    TEST_CHECK(small_vector_int_size(vector) == 0);
+
+    int items[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    small_vector_int_append_array(vector, items, 3);
+    TEST_CHECK(small_vector_int_is_inline(vector));
+    small_vector_int_append_array(vector, items + 3, 7);
+    TEST_CHECK(!small_vector_int_is_inline(vector));
+    TEST_CHECK(small_vector_int_size(vector) == 10);
+    TEST_CHECK(small_vector_int_at(vector, 0) == 0);
+    TEST_CHECK(small_vector_int_at(vector, 9) == 9);
+
+    small_vector_int_free(vector, NULL);
+}
+
 
 TEST_LIST = {
     {"test_vector_push_back_and_at", test_vector_push_back_and_at},
     {"test_vector_set_at", test_vector_set_at},
+    {"test_vector_growth", test_vector_growth},
+    {"test_vector_append_and_erase", test_vector_append_and_erase},
     {"test_vector_clear_at", test_vector_clear_at},
     {"test_vector_delete", test_vector_delete},
     {"test_vector_search", test_vector_search},
     {"test_vector_sort", test_vector_sort},
+    {"test_vector_sort_patterns", test_vector_sort_patterns},
+    {"test_vector_partition", test_vector_partition},
+    {"test_vector_sort_inline", test_vector_sort_inline},
+    {"test_vector_bounds_and_binary_search", test_vector_bounds_and_binary_search},
+    {"test_vector_radix_sort", test_vector_radix_sort},
+    {"test_vector_find", test_vector_find},
+    {"test_vector_parallel_sort", test_vector_parallel_sort},
+    {"test_vector_parallel_bulk_operations", test_vector_parallel_bulk_operations},
+    {"test_small_vector_inline", test_small_vector_inline},
+    {"test_small_vector_spill", test_small_vector_spill},
     {NULL, NULL}
 };
\ No newline at end of file